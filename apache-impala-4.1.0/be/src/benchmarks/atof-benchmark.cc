@@ -17,6 +17,7 @@
 
 #include <stdlib.h>
 #include <stdio.h>
+#include <iomanip>
 #include <iostream>
 #include <vector>
 #include <sstream>
@@ -103,6 +104,22 @@ void TestImpala(int batch_size, void* d) {
   }
 }
 
+// Parses the data as DECIMAL(18, 6), which is how text tables typically store
+// fixed-point values.
+void TestImpalaDecimal(int batch_size, void* d) {
+  TestData* data = reinterpret_cast<TestData*>(d);
+  for (int i = 0; i < batch_size; ++i) {
+    int n = data->data.size();
+    for (int j = 0; j < n; ++j) {
+      const StringValue& str = data->data[j];
+      StringParser::ParseResult dummy;
+      Decimal8Value val = StringParser::StringToDecimal<int64_t>(
+          str.ptr, str.len, 18, 6, false, &dummy);
+      data->result[j] = val.value();
+    }
+  }
+}
+
 void TestStrtod(int batch_size, void* d) {
   TestData* data = reinterpret_cast<TestData*>(d);
   for (int i = 0; i < batch_size; ++i) {
@@ -131,5 +148,20 @@ int main(int argc, char **argv) {
   suite.AddBenchmark("Impala", TestImpala, &data);
   cout << suite.Measure();
 
+  // Fixed-point values with 12 digits, which are partly parsed 8 digits at a time.
+  TestData decimal_data;
+  for (int i = 0; i < 1000; ++i) {
+    stringstream ss;
+    ss << rand() % 1000000 << "." << setw(6) << setfill('0') << rand() % 1000000;
+    AddTestData(&decimal_data, ss.str());
+  }
+  decimal_data.result.resize(decimal_data.data.size());
+
+  Benchmark decimal_suite("atof_decimal");
+  decimal_suite.AddBenchmark("Strtod", TestStrtod, &decimal_data);
+  decimal_suite.AddBenchmark("ImpalaDouble", TestImpala, &decimal_data);
+  decimal_suite.AddBenchmark("ImpalaDecimal", TestImpalaDecimal, &decimal_data);
+  cout << endl << decimal_suite.Measure();
+
   return 0;
 }
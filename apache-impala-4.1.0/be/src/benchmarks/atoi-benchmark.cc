@@ -269,6 +269,13 @@ int main(int argc, char **argv) {
   }
   data_garbage.result.resize(data_garbage.data.size());
 
+  // Values with 9 or 10 digits, which are partly parsed 8 digits at a time.
+  TestData data_large;
+  for (int i = 0; i < 1000; ++i) {
+    AddTestData(&data_large, std::to_string(100000000 + rand() % 2000000000));
+  }
+  data_large.result.resize(data_large.data.size());
+
   TestData data_trailing_garbage;
   for (int i = 0; i < 1000; ++i) {
     AddTestData(&data_trailing_garbage, "123    a");
@@ -288,6 +295,8 @@ int main(int argc, char **argv) {
   suite.AddBenchmark("impala_both_space", TestImpala, &data_both_space);
   suite.AddBenchmark("impala_garbage", TestImpala, &data_garbage);
   suite.AddBenchmark("impala_trailing_garbage", TestImpala, &data_trailing_garbage);
+  suite.AddBenchmark("impala_unsafe_large", TestImpalaUnsafe, &data_large);
+  suite.AddBenchmark("impala_large", TestImpala, &data_large);
 
   cout << suite.Measure();
 
@@ -22,6 +22,8 @@
 //    of 32 values.
 // * UnpackScalar - an implementation that can unpack a variable number of values, using
 //   Unpack32Scalar internally.
+// * UnpackAVX2 - the same function as UnpackScalar, which unpacks full batches with AVX2
+//   instructions if the CPU supports them. Only run on CPUs with AVX2 support.
 //
 //
 // Machine Info: Intel(R) Core(TM) i7-7700 CPU @ 3.60GHz
@@ -447,6 +449,12 @@ void UnpackBenchmark(int batch_size, void* data) {
   }
 }
 
+/// Same as UnpackBenchmark() with AVX2 instructions disabled.
+void UnpackScalarBenchmark(int batch_size, void* data) {
+  CpuInfo::TempDisable disable_avx2(CpuInfo::AVX2);
+  UnpackBenchmark(batch_size, data);
+}
+
 int main(int argc, char **argv) {
   CpuInfo::Init();
   cout << endl << Benchmark::GetMachineInfo() << endl;
@@ -460,7 +468,11 @@ int main(int argc, char **argv) {
     suite.AddBenchmark(Substitute("BitReader", bit_width), BitReaderBenchmark, &params);
     suite.AddBenchmark(
         Substitute("Unpack32Scalar", bit_width), Unpack32Benchmark, &params);
-    suite.AddBenchmark(Substitute("UnpackScalar", bit_width), UnpackBenchmark, &params);
+    suite.AddBenchmark(
+        Substitute("UnpackScalar", bit_width), UnpackScalarBenchmark, &params);
+    if (CpuInfo::IsSupported(CpuInfo::AVX2)) {
+      suite.AddBenchmark(Substitute("UnpackAVX2", bit_width), UnpackBenchmark, &params);
+    }
     cout << suite.Measure() << endl;
   }
   return 0;
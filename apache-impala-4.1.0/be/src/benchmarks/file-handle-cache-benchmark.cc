@@ -0,0 +1,135 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include <fcntl.h>
+#include <iostream>
+#include <string>
+#include <vector>
+#include <boost/thread/thread.hpp>
+
+#include "common/init.h"
+#include "gutil/strings/substitute.h"
+#include "runtime/hdfs-fs-cache.h"
+#include "runtime/io/handle-cache.h"
+#include "runtime/io/hdfs-monitored-ops.h"
+#include "runtime/test-env.h"
+#include "service/fe-support.h"
+#include "util/benchmark.h"
+#include "util/cpu-info.h"
+
+#include "common/names.h"
+
+using namespace impala;
+using namespace impala::io;
+using strings::Substitute;
+
+// Benchmark for the lookups of the file handle cache when many threads read a few hot
+// files at the same time, as happens when thousands of scan ranges of the same files
+// are scheduled at once. Each thread repeatedly checks out a handle of one of the files
+// from a FileHandleCache and returns it, which unbuffers the handle like the scanners
+// do. "N per file" spreads the handles of each file over N partitions
+// (--file_handle_cache_partitions_per_file), "1 per file" keeps them in one partition.
+//
+// The handles are opened on the HDFS of the minicluster, which must be running. The
+// files are written to HDFS_DIR and deleted afterwards.
+
+const char* NAMENODE = "hdfs://localhost:20500";
+const char* HDFS_DIR = "/tmp/file-handle-cache-benchmark";
+const int NUM_PARTITIONS = 16;
+const int NUM_FILES = 4;
+const int64_t MTIME = 1;
+const int64_t LOOKUPS_PER_ITER = 1000;
+
+struct TestData {
+  hdfsFS fs;
+  HdfsMonitor* monitor;
+  int num_threads;
+  int partitions_per_file;
+  vector<string> files;
+  // Created on the first run, so that every configuration starts with an empty cache.
+  unique_ptr<FileHandleCache> cache;
+};
+
+static void LookUpThread(TestData* data, int thread_idx, int64_t num_lookups) {
+  for (int64_t i = 0; i < num_lookups; ++i) {
+    string* fname = &data->files[(thread_idx + i) % data->files.size()];
+    FileHandleCache::Accessor accessor;
+    bool cache_hit;
+    ABORT_IF_ERROR(
+        data->cache->GetFileHandle(data->fs, fname, MTIME, false, &accessor, &cache_hit));
+  }
+}
+
+void TestLookUps(int batch_size, void* d) {
+  TestData* data = reinterpret_cast<TestData*>(d);
+  if (data->cache == nullptr) {
+    data->cache.reset(new FileHandleCache(NUM_PARTITIONS * 1024, NUM_PARTITIONS,
+        data->partitions_per_file, 0, data->monitor));
+  }
+  int64_t num_lookups = batch_size * LOOKUPS_PER_ITER / data->num_threads;
+  thread_group threads;
+  for (int i = 0; i < data->num_threads; ++i) {
+    threads.add_thread(new thread(LookUpThread, data, i, num_lookups));
+  }
+  threads.join_all();
+}
+
+int main(int argc, char **argv) {
+  InitCommonRuntime(argc, argv, true, TestInfo::BE_TEST);
+  InitFeSupport();
+  TestEnv test_env;
+  ABORT_IF_ERROR(test_env.Init());
+  cout << Benchmark::GetMachineInfo() << endl;
+
+  hdfsFS fs;
+  ABORT_IF_ERROR(HdfsFsCache::instance()->GetConnection(NAMENODE, &fs));
+  HdfsMonitor monitor;
+  ABORT_IF_ERROR(monitor.Init(16));
+  vector<string> files;
+  for (int i = 0; i < NUM_FILES; ++i) {
+    files.push_back(Substitute("$0$1/file_$2", NAMENODE, HDFS_DIR, i));
+    hdfsFile file = hdfsOpenFile(fs, files.back().c_str(), O_WRONLY, 0, 0, 0);
+    if (file == nullptr || hdfsWrite(fs, file, "data", 4) != 4
+        || hdfsCloseFile(fs, file) != 0) {
+      cerr << "Could not write " << files.back() << endl;
+      return 1;
+    }
+  }
+
+  vector<unique_ptr<TestData>> data;
+  for (int num_threads : {1, 16, 64, 128}) {
+    Benchmark suite(Substitute("file handle cache $0 threads", num_threads),
+        /* micro = */ false);
+    int baseline = -1;
+    for (int partitions_per_file : {1, 4, 16}) {
+      data.emplace_back(new TestData());
+      data.back()->fs = fs;
+      data.back()->monitor = &monitor;
+      data.back()->num_threads = num_threads;
+      data.back()->partitions_per_file = partitions_per_file;
+      data.back()->files = files;
+      int id = suite.AddBenchmark(Substitute("$0 per file", partitions_per_file),
+          TestLookUps, data.back().get(), baseline);
+      if (baseline == -1) baseline = id;
+    }
+    cout << suite.Measure() << endl;
+  }
+  // Close the cached handles before deleting the files.
+  data.clear();
+  hdfsDelete(fs, HDFS_DIR, 1);
+  return 0;
+}
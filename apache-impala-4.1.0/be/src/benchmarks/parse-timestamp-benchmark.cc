@@ -119,6 +119,19 @@ void AddTestDataDateTimes(TestData* data, int n, const string& startstr) {
   }
 }
 
+// Adds timestamps in the default format "yyyy-MM-dd HH:mm:ss.SSSSSSSSS" with fractional
+// seconds of varying length.
+void AddTestDataDefaultDateTimes(TestData* data, int n, const string& startstr) {
+  ptime start(boost::posix_time::time_from_string(startstr));
+  for (int i = 0; i < n; ++i) {
+    start += gregorian::date_duration(rand() % 100);
+    start += nanoseconds(rand());
+    string s = to_iso_extended_string(start);
+    s[10] = ' ';
+    AddTestData(data, s);
+  }
+}
+
 void AddTestDataTZDateTimes(TestData* data, int n, const string& startstr) {
   ptime start(boost::posix_time::time_from_string(startstr));
   for (int i = 0; i < n; ++i) {
@@ -236,17 +249,19 @@ int main(int argc, char **argv) {
 
   SimpleDateFormatTokenizer::InitCtx();
 
-  TestData dates, times, datetimes, tzdatetimes;
+  TestData dates, times, datetimes, tzdatetimes, default_datetimes;
 
   AddTestDataDates(&dates, 700, "1953-04-22");
   AddTestDataTimes(&times, 700, "01:02:03.45678");
   AddTestDataDateTimes(&datetimes, 700, "1953-04-22 01:02:03");
   AddTestDataTZDateTimes(&tzdatetimes, 700, "1990-04-22 01:10:03");
+  AddTestDataDefaultDateTimes(&default_datetimes, 700, "1953-04-22 01:02:03");
 
   dates.result.resize(dates.data.size());
   times.result.resize(times.data.size());
   datetimes.result.resize(datetimes.data.size());
   tzdatetimes.result.resize(tzdatetimes.data.size());
+  default_datetimes.result.resize(default_datetimes.data.size());
 
   Benchmark date_suite("ParseDate");
   date_suite.AddBenchmark("BoostStringDate", TestBoostStringDate, &dates);
@@ -257,6 +272,13 @@ int main(int argc, char **argv) {
   timestamp_suite.AddBenchmark("BoostTime", TestBoostTime, &times);
   timestamp_suite.AddBenchmark("Impala", TestImpalaSimpleDateFormat, &times);
 
+  // Date and time in the default format, as typically found in text files.
+  Benchmark default_format_suite("ParseDefaultFormatTimestamp");
+  default_format_suite.AddBenchmark("BoostDateTime", TestBoostDateTime,
+      &default_datetimes);
+  default_format_suite.AddBenchmark("Impala", TestImpalaSimpleDateFormat,
+      &default_datetimes);
+
   dt_ctx_simple_date_format.Reset("yyyy-MM-dd HH:mm:ss", 19);
   SimpleDateFormatTokenizer::Tokenize(&dt_ctx_simple_date_format, PARSE);
   dt_ctx_tz_simple_date_format.Reset("yyyy-MM-dd HH:mm:ss+hh:mm", 25);
@@ -287,6 +309,8 @@ int main(int argc, char **argv) {
   cout << endl;
   cout << timestamp_suite.Measure();
   cout << endl;
+  cout << default_format_suite.Measure();
+  cout << endl;
   cout << timestamp_with_format_suite.Measure();
 
   return 0;
@@ -30,7 +30,9 @@
 #include "runtime/mem-tracker.h"
 #include "runtime/row-batch.h"
 #include "runtime/runtime-state.h"
+#include "runtime/thread-resource-mgr.h"
 #include "udf/udf-internal.h"
+#include "util/counting-barrier.h"
 #include "util/runtime-profile-counters.h"
 
 #include "common/names.h"
@@ -172,6 +174,9 @@ Status AnalyticEvalNode::Prepare(RuntimeState* state) {
   prev_tuple_pool_.reset(new MemPool(mem_tracker()));
   prev_input_tuple_pool_.reset(new MemPool(mem_tracker()));
   evaluation_timer_ = ADD_TIMER(runtime_profile(), "EvaluationTime");
+  num_parallel_partitions_counter_ =
+      ADD_COUNTER(runtime_profile(), "PartitionsEvaluatedInParallel", TUnit::UNIT);
+  helper_wait_timer_ = ADD_TIMER(runtime_profile(), "HelperThreadWaitTime");
 
   DCHECK_EQ(result_tuple_desc_->slots().size(), analytic_fns_.size());
   RETURN_IF_ERROR(AggFnEvaluator::Create(analytic_fns_, state, pool_, expr_perm_pool(),
@@ -240,6 +245,15 @@ Status AnalyticEvalNode::Open(RuntimeState* state) {
     RETURN_IF_ERROR(order_by_eq_expr_eval_->Open(state));
   }
 
+  // Helpers are only useful if the partitions are independent of each other and a
+  // result tuple is produced once per partition.
+  const int num_helper_threads = state->query_options().num_analytic_eval_threads;
+  if (!helpers_created_ && num_helper_threads > 0 && fn_scope_ == PARTITION
+      && partition_by_eq_expr_eval_ != nullptr) {
+    helpers_created_ = true;
+    RETURN_IF_ERROR(CreatePartitionEvalHelpers(state, num_helper_threads));
+  }
+
   // Initialize the tuple that was allocated in Prepare().
   // TODO: zeroing out curr_tuple_ shouldn't be strictly necessary.
   curr_tuple_->Init(intermediate_tuple_desc_->byte_size());
@@ -257,6 +271,47 @@ Status AnalyticEvalNode::Open(RuntimeState* state) {
   return Status::OK();
 }
 
+Status AnalyticEvalNode::CreatePartitionEvalHelpers(
+    RuntimeState* state, int num_threads) {
+  DCHECK(helpers_.empty());
+  // The planner reserves the helper threads for admission control, but like the
+  // optional scanner threads they are only started if the thread quota of the process
+  // allows it. Without any helpers, the partitions are evaluated serially.
+  ThreadResourcePool* thread_pool = state->resource_pool();
+  while (num_helper_thread_tokens_ < num_threads
+      && thread_pool->TryAcquireThreadToken()) {
+    ++num_helper_thread_tokens_;
+  }
+  num_threads = num_helper_thread_tokens_;
+  runtime_profile()->AddInfoString("AnalyticEvalThreads", std::to_string(num_threads));
+  if (num_threads == 0) return Status::OK();
+  for (int i = 0; i < num_threads; ++i) {
+    unique_ptr<PartitionEvalHelper> helper = make_unique<PartitionEvalHelper>();
+    helper->expr_perm_pool.reset(new MemPool(mem_tracker()));
+    helper->expr_results_pool.reset(new MemPool(mem_tracker()));
+    helper->result_tuple_pool.reset(new MemPool(mem_tracker()));
+    PartitionEvalHelper* h = helper.get();
+    helpers_.push_back(move(helper));
+    RETURN_IF_ERROR(AggFnEvaluator::Create(analytic_fns_, state, pool_,
+        h->expr_perm_pool.get(), h->expr_results_pool.get(), &h->evals));
+    RETURN_IF_ERROR(AggFnEvaluator::Open(h->evals, state));
+    h->intermediate_tuple =
+        Tuple::Create(intermediate_tuple_desc_->byte_size(), h->expr_perm_pool.get());
+    h->dummy_result_tuple =
+        Tuple::Create(result_tuple_desc_->byte_size(), h->expr_perm_pool.get());
+  }
+  // Each batch dispatches at most one work item per partition, which is bounded by the
+  // batch size.
+  helper_pool_.reset(new ThreadPool<int>("analytic-eval",
+      Substitute("analytic-eval-helper (node $0)", id()), num_threads,
+      state->batch_size(),
+      [this](int thread_id, int partition_idx) {
+        EvaluatePartition(thread_id, partition_idx);
+      }));
+  RETURN_IF_ERROR(helper_pool_->Init());
+  return Status::OK();
+}
+
 string DebugWindowBoundString(const TAnalyticWindowBoundary& b) {
   if (b.type == TAnalyticWindowBoundaryType::CURRENT_ROW) {
     return "CURRENT_ROW";
@@ -358,6 +413,10 @@ inline Status AnalyticEvalNode::AddRow(int64_t stream_idx, TupleRow* row) {
     }
   }
 
+  return AddRowToStream(stream_idx, row);
+}
+
+inline Status AnalyticEvalNode::AddRowToStream(int64_t stream_idx, TupleRow* row) {
   Status status;
   // Buffer the entire input row to be returned later with the analytic eval results.
   if (UNLIKELY(!input_stream_->AddRow(row, &status))) {
@@ -380,29 +439,35 @@ inline Status AnalyticEvalNode::AddRow(int64_t stream_idx, TupleRow* row) {
   return Status::OK();
 }
 
-Status AnalyticEvalNode::AddResultTuple(int64_t stream_idx) {
-  VLOG_ROW << id() << " AddResultTuple idx=" << stream_idx;
-  DCHECK(curr_tuple_ != nullptr);
-  MemPool* curr_tuple_pool = curr_tuple_pool_.get();
-  Tuple* result_tuple = Tuple::Create(result_tuple_desc_->byte_size(), curr_tuple_pool);
+Status AnalyticEvalNode::CreateResultTuple(const vector<AggFnEvaluator*>& evals,
+    Tuple* src_tuple, MemPool* pool, Tuple** result_tuple) {
+  *result_tuple = Tuple::Create(result_tuple_desc_->byte_size(), pool);
 
-  AggFnEvaluator::GetValue(analytic_fn_evals_, curr_tuple_, result_tuple);
-  // Copy any string data in 'result_tuple' into 'curr_tuple_pool'. The var-len data
-  // returned by GetValue() may be backed by an allocation from
-  // 'expr_results_pool_' that will be recycled so it must be copied out.
+  AggFnEvaluator::GetValue(evals, src_tuple, *result_tuple);
+  // Copy any string data in 'result_tuple' into 'pool'. The var-len data returned by
+  // GetValue() may be backed by an allocation from the evaluators' results pool that
+  // will be recycled so it must be copied out.
   for (const SlotDescriptor* slot_desc : result_tuple_desc_->string_slots()) {
-    if (result_tuple->IsNull(slot_desc->null_indicator_offset())) continue;
-    StringValue* sv = result_tuple->GetStringSlot(slot_desc->tuple_offset());
+    if ((*result_tuple)->IsNull(slot_desc->null_indicator_offset())) continue;
+    StringValue* sv = (*result_tuple)->GetStringSlot(slot_desc->tuple_offset());
     if (sv->len == 0) continue;
-    char* new_ptr = reinterpret_cast<char*>(
-        curr_tuple_pool->TryAllocateUnaligned(sv->len));
+    char* new_ptr = reinterpret_cast<char*>(pool->TryAllocateUnaligned(sv->len));
     if (UNLIKELY(new_ptr == nullptr)) {
-      return curr_tuple_pool->mem_tracker()->MemLimitExceeded(nullptr,
+      return pool->mem_tracker()->MemLimitExceeded(nullptr,
           "Failed to allocate memory for analytic function's result.", sv->len);
     }
     memcpy(new_ptr, sv->ptr, sv->len);
     sv->ptr = new_ptr;
   }
+  return Status::OK();
+}
+
+Status AnalyticEvalNode::AddResultTuple(int64_t stream_idx) {
+  VLOG_ROW << id() << " AddResultTuple idx=" << stream_idx;
+  DCHECK(curr_tuple_ != nullptr);
+  Tuple* result_tuple;
+  RETURN_IF_ERROR(CreateResultTuple(
+      analytic_fn_evals_, curr_tuple_, curr_tuple_pool_.get(), &result_tuple));
 
   DCHECK_GT(stream_idx, last_result_idx_);
   result_tuples_.emplace_back(stream_idx, result_tuple);
@@ -649,7 +714,12 @@ Status AnalyticEvalNode::ProcessChildBatch(RuntimeState* state) {
   // row to compare and we cannot rely on PrevRowCompare() returning true even for the
   // same row pointers if there are NaN values.
   int batch_idx = 0;
-  if (UNLIKELY(stream_idx == 0 && curr_child_batch_->num_rows() > 0)) {
+  if (helper_pool_ != nullptr) {
+    // All rows of the batch are consumed by the parallel path.
+    RETURN_IF_ERROR(ProcessChildBatchParallel(state));
+    batch_idx = curr_child_batch_->num_rows();
+    stream_idx = input_stream_->num_rows();
+  } else if (UNLIKELY(stream_idx == 0 && curr_child_batch_->num_rows() > 0)) {
     TupleRow* row = curr_child_batch_->GetRow(0);
     RETURN_IF_ERROR(AddRow(0, row));
     RETURN_IF_ERROR(TryAddResultTupleForCurrRow(0));
@@ -723,6 +793,118 @@ Status AnalyticEvalNode::ProcessChildBatch(RuntimeState* state) {
   return Status::OK();
 }
 
+Status AnalyticEvalNode::ProcessChildBatchParallel(RuntimeState* state) {
+  DCHECK_EQ(fn_scope_, PARTITION);
+  DCHECK(partition_by_eq_expr_eval_ != nullptr);
+  const int num_rows = curr_child_batch_->num_rows();
+  const int64_t first_stream_idx = input_stream_->num_rows();
+
+  // Find the rows that start a new partition. As in ProcessChildBatch(), the very first
+  // row in the stream belongs to the partition initialized in Open() and is not compared.
+  partition_starts_.clear();
+  int batch_idx = 0;
+  if (UNLIKELY(first_stream_idx == 0 && num_rows > 0)) {
+    prev_input_tuple_ = curr_child_batch_->GetRow(0)->GetTuple(0);
+    ++batch_idx;
+  }
+  Tuple* child_tuple_cmp_row_tuples[2] = {nullptr, nullptr};
+  TupleRow* child_tuple_cmp_row =
+      reinterpret_cast<TupleRow*>(child_tuple_cmp_row_tuples);
+  for (; batch_idx < num_rows; ++batch_idx) {
+    Tuple* tuple = curr_child_batch_->GetRow(batch_idx)->GetTuple(0);
+    child_tuple_cmp_row->SetTuple(0, prev_input_tuple_);
+    child_tuple_cmp_row->SetTuple(1, tuple);
+    if (!PrevRowCompare(partition_by_eq_expr_eval_, child_tuple_cmp_row)) {
+      partition_starts_.push_back(batch_idx);
+    }
+    prev_input_tuple_ = tuple;
+  }
+
+  // Every partition that starts and ends within this batch can be evaluated on its own.
+  const int num_complete = max<int>(0, partition_starts_.size() - 1);
+  Status status;
+  if (num_complete > 0) {
+    pending_partitions_.clear();
+    pending_partitions_.resize(num_complete);
+    partitions_barrier_.reset(new CountingBarrier(num_complete));
+    for (int i = 0; i < num_complete; ++i) {
+      pending_partitions_[i].start_row = partition_starts_[i];
+      pending_partitions_[i].end_row = partition_starts_[i + 1];
+      if (UNLIKELY(!helper_pool_->Offer(i))) {
+        pending_partitions_[i].status =
+            Status("Analytic eval helper thread pool was shut down.");
+        partitions_barrier_->Notify();
+      }
+    }
+  }
+
+  // Meanwhile, add the rows that continue the current partition to 'curr_tuple_' and
+  // buffer the rows of the complete partitions.
+  const int first_boundary = partition_starts_.empty() ? num_rows : partition_starts_[0];
+  const int last_boundary =
+      partition_starts_.empty() ? num_rows : partition_starts_.back();
+  for (int i = 0; i < first_boundary && status.ok(); ++i) {
+    status = AddRow(first_stream_idx + i, curr_child_batch_->GetRow(i));
+  }
+  if (status.ok() && !partition_starts_.empty()) {
+    status = AddResultTuple(first_stream_idx + first_boundary - 1);
+  }
+  for (int i = first_boundary; i < last_boundary && status.ok(); ++i) {
+    status = AddRowToStream(first_stream_idx + i, curr_child_batch_->GetRow(i));
+  }
+
+  if (num_complete > 0) {
+    // The helpers reference 'curr_child_batch_', so always wait for them, even on error.
+    {
+      SCOPED_TIMER(helper_wait_timer_);
+      partitions_barrier_->Wait();
+    }
+    for (const PendingPartition& partition : pending_partitions_) {
+      if (!status.ok()) break;
+      status = partition.status;
+      if (!status.ok()) break;
+      int64_t result_idx = first_stream_idx + partition.end_row - 1;
+      DCHECK_GT(result_idx, last_result_idx_);
+      result_tuples_.emplace_back(result_idx, partition.result_tuple);
+      last_result_idx_ = result_idx;
+    }
+    for (unique_ptr<PartitionEvalHelper>& helper : helpers_) {
+      curr_tuple_pool_->AcquireData(helper->result_tuple_pool.get(), false);
+      helper->expr_results_pool->Clear();
+    }
+    COUNTER_ADD(num_parallel_partitions_counter_, num_complete);
+  }
+  RETURN_IF_ERROR(status);
+  // Errors from AggFnEvaluator::Init() in the helpers are reported via the query status.
+  RETURN_IF_ERROR(state->GetQueryStatus());
+
+  // The remaining rows start the partition that may continue in the next batch.
+  if (!partition_starts_.empty()) {
+    RETURN_IF_ERROR(InitNextPartition(state, first_stream_idx + last_boundary));
+    for (int i = last_boundary; i < num_rows; ++i) {
+      RETURN_IF_ERROR(AddRow(first_stream_idx + i, curr_child_batch_->GetRow(i)));
+    }
+  }
+  return Status::OK();
+}
+
+void AnalyticEvalNode::EvaluatePartition(int thread_id, int partition_idx) {
+  DCHECK_LT(thread_id, helpers_.size());
+  PartitionEvalHelper* helper = helpers_[thread_id].get();
+  PendingPartition* partition = &pending_partitions_[partition_idx];
+  Tuple* tuple = helper->intermediate_tuple;
+  tuple->Init(intermediate_tuple_desc_->byte_size());
+  AggFnEvaluator::Init(helper->evals, tuple);
+  for (int i = partition->start_row; i < partition->end_row; ++i) {
+    AggFnEvaluator::Add(helper->evals, curr_child_batch_->GetRow(i), tuple);
+  }
+  partition->status = CreateResultTuple(helper->evals, tuple,
+      helper->result_tuple_pool.get(), &partition->result_tuple);
+  // Release the resources of the intermediate tuple; the result is not needed.
+  AggFnEvaluator::Finalize(helper->evals, tuple, helper->dummy_result_tuple);
+  partitions_barrier_->Notify();
+}
+
 Status AnalyticEvalNode::GetNextOutputBatch(
     RuntimeState* state, RowBatch* output_batch, bool* eos) {
   SCOPED_TIMER(evaluation_timer_);
@@ -868,6 +1050,20 @@ Status AnalyticEvalNode::Reset(RuntimeState* state, RowBatch* row_batch) {
 
 void AnalyticEvalNode::Close(RuntimeState* state) {
   if (is_closed()) return;
+  if (helper_pool_ != nullptr) {
+    helper_pool_->Shutdown();
+    helper_pool_->Join();
+  }
+  for (int i = 0; i < num_helper_thread_tokens_; ++i) {
+    state->resource_pool()->ReleaseThreadToken(false);
+  }
+  num_helper_thread_tokens_ = 0;
+  for (unique_ptr<PartitionEvalHelper>& helper : helpers_) {
+    AggFnEvaluator::Close(helper->evals, state);
+    helper->result_tuple_pool->FreeAll();
+    helper->expr_results_pool->FreeAll();
+    helper->expr_perm_pool->FreeAll();
+  }
   // We may need to clean up input_stream_ if an error occurred at some point.
   if (input_stream_ != nullptr) {
     input_stream_->Close(nullptr, RowBatch::FlushMode::NO_FLUSH_RESOURCES);
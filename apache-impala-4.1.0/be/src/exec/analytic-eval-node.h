@@ -24,11 +24,13 @@
 #include "exec/exec-node.h"
 #include "runtime/buffered-tuple-stream.h"
 #include "runtime/tuple.h"
+#include "util/thread-pool.h"
 
 namespace impala {
 
 class AggFn;
 class AggFnEvaluator;
+class CountingBarrier;
 class ScalarExpr;
 class ScalarExprEvaluator;
 
@@ -83,6 +85,16 @@ class AnalyticEvalPlanNode : public PlanNode {
 /// multiple rows have the same values for the order by exprs. The number of buffered
 /// rows may be an entire partition or even the entire input. Therefore, the output
 /// rows are buffered and may spill to disk via the BufferedTupleStream.
+///
+/// If the NUM_ANALYTIC_EVAL_THREADS query option is set and the functions are evaluated
+/// over entire partitions (PARTITION BY without ORDER BY), partitions that start and end
+/// within the same input batch are independent of each other and of the partition that
+/// is currently being built up. ProcessChildBatchParallel() hands these complete
+/// partitions to helper threads, each with its own set of evaluators, while the
+/// fragment instance thread buffers the input rows in 'input_stream_'. The result tuples
+/// are then added to 'result_tuples_' in input order, so the output is identical to the
+/// serial evaluation. This lets queries with many small partitions, e.g. per-user window
+/// aggregates in reports, use more than one core per fragment instance.
 
 class AnalyticEvalNode : public ExecNode {
  public:
@@ -143,6 +155,24 @@ class AnalyticEvalNode : public ExecNode {
   /// That tuple gets set in the associated output row(s) later in GetNextOutputBatch().
   Status ProcessChildBatch(RuntimeState* state);
 
+  /// Variant of ProcessChildBatch() used when helper threads are available. Finds the
+  /// partition boundaries in curr_child_batch_, dispatches the complete partitions to
+  /// 'helper_pool_' and evaluates the rows belonging to the current and the last
+  /// (possibly incomplete) partition in this thread. Only valid if 'fn_scope_' is
+  /// PARTITION and there are partition exprs.
+  Status ProcessChildBatchParallel(RuntimeState* state);
+
+  /// Work function for 'helper_pool_'. Evaluates the analytic functions over the complete
+  /// partition 'pending_partitions_[partition_idx]' using the evaluators of the helper
+  /// with index 'thread_id' and notifies 'partitions_barrier_' when done.
+  void EvaluatePartition(int thread_id, int partition_idx);
+
+  /// Creates up to 'num_threads' helpers with their own evaluators and starts
+  /// 'helper_pool_'. One optional thread token is acquired from the fragment instance's
+  /// ThreadResourcePool per helper, and no helpers are created if none is available.
+  /// Called from Open() the first time the node is opened.
+  Status CreatePartitionEvalHelpers(RuntimeState* state, int num_threads);
+
   /// Processes child batches (calling ProcessChildBatch()) until enough output rows
   /// are ready to return an output batch.
   Status ProcessChildBatches(RuntimeState* state);
@@ -154,6 +184,10 @@ class AnalyticEvalNode : public ExecNode {
   /// Adds the row to the evaluators and the tuple stream.
   Status AddRow(int64_t stream_idx, TupleRow* row);
 
+  /// Adds the row to 'input_stream_', unpinning the stream if there is not enough
+  /// memory to keep it pinned.
+  Status AddRowToStream(int64_t stream_idx, TupleRow* row);
+
   /// Determines if there is a window ending at the previous row by evaluating
   /// 'child_tuple_cmp_row', and if so, calls AddResultTuple() with the index
   /// of the previous row in 'input_stream_'. 'next_partition' indicates if
@@ -191,6 +225,12 @@ class AnalyticEvalNode : public ExecNode {
   /// Returns an error when memory limit is exceeded.
   Status AddResultTuple(int64_t stream_idx);
 
+  /// Creates a result tuple from 'pool' and fills it in by calling GetValue() for
+  /// 'src_tuple' on 'evals'. Var-len results are copied into 'pool'. Returns an error
+  /// when memory limit is exceeded.
+  Status CreateResultTuple(const std::vector<AggFnEvaluator*>& evals, Tuple* src_tuple,
+      MemPool* pool, Tuple** result_tuple);
+
   /// Gets the number of rows that are ready to be returned by subsequent calls to
   /// GetNextOutputBatch().
   int64_t NumOutputRowsReady() const;
@@ -374,8 +414,63 @@ class AnalyticEvalNode : public ExecNode {
   /// END: Members that must be Reset()
   /////////////////////////////////////////
 
+  /// State owned by a single helper thread of 'helper_pool_'. The evaluators are created
+  /// from 'analytic_fns_' like 'analytic_fn_evals_' but are backed by their own pools so
+  /// that they can be used concurrently with the fragment instance thread.
+  struct PartitionEvalHelper {
+    std::unique_ptr<MemPool> expr_perm_pool;
+    std::unique_ptr<MemPool> expr_results_pool;
+
+    /// Pool that backs the result tuples produced by this helper. Its resources are
+    /// transferred to 'curr_tuple_pool_' after each batch.
+    std::unique_ptr<MemPool> result_tuple_pool;
+
+    std::vector<AggFnEvaluator*> evals;
+
+    /// Intermediate and dummy result tuples, analogous to 'curr_tuple_' and
+    /// 'dummy_result_tuple_'. Owned by 'expr_perm_pool'.
+    Tuple* intermediate_tuple = nullptr;
+    Tuple* dummy_result_tuple = nullptr;
+  };
+
+  /// A complete partition consisting of rows [start_row, end_row) of
+  /// 'curr_child_batch_' and the result tuple produced for it by a helper thread.
+  struct PendingPartition {
+    int start_row = 0;
+    int end_row = 0;
+    Tuple* result_tuple = nullptr;
+    Status status;
+  };
+
+  /// Helper threads used by ProcessChildBatchParallel(). Only created if
+  /// NUM_ANALYTIC_EVAL_THREADS is set and the functions are evaluated over entire
+  /// partitions. NULL otherwise.
+  boost::scoped_ptr<ThreadPool<int>> helper_pool_;
+  std::vector<std::unique_ptr<PartitionEvalHelper>> helpers_;
+
+  /// True once CreatePartitionEvalHelpers() was called.
+  bool helpers_created_ = false;
+
+  /// Number of thread tokens acquired for the helper threads. Released in Close().
+  int num_helper_thread_tokens_ = 0;
+
+  /// Complete partitions of the current child batch that are evaluated by helpers.
+  std::vector<PendingPartition> pending_partitions_;
+
+  /// Indices of the rows in the current child batch that start a new partition.
+  std::vector<int> partition_starts_;
+
+  /// Signalled by the helpers once all of 'pending_partitions_' are evaluated.
+  std::unique_ptr<CountingBarrier> partitions_barrier_;
+
   /// Time spent processing the child rows.
   RuntimeProfile::Counter* evaluation_timer_ = nullptr;
+
+  /// Number of partitions evaluated by helper threads.
+  RuntimeProfile::Counter* num_parallel_partitions_counter_ = nullptr;
+
+  /// Time the fragment instance thread spent waiting for helper threads.
+  RuntimeProfile::Counter* helper_wait_timer_ = nullptr;
 };
 
 }
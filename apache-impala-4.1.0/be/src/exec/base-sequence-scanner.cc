@@ -214,9 +214,14 @@ Status BaseSequenceScanner::GetNextInternal(RowBatch* row_batch) {
   return Status::OK();
 }
 
+bool BaseSequenceScanner::SyncStartsInRange(int64_t sync_offset) {
+  DCHECK_GE(sync_offset, 0);
+  return !stream_->eosr() && sync_offset < stream_->bytes_left();
+}
+
 Status BaseSequenceScanner::ReadSync() {
   DCHECK(!eos_);
-  if (stream_->eosr()) {
+  if (!SyncStartsInRange(0)) {
     // Either we're at the end of file or the next sync marker is completely in the next
     // scan range.
     eos_ = true;
@@ -123,6 +123,11 @@ class BaseSequenceScanner : public HdfsScanner {
   /// records.
   Status ReadSync() WARN_UNUSED_RESULT;
 
+  /// Returns true if a sync marker that starts 'sync_offset' bytes past the current
+  /// position of 'stream_' starts inside the scan range, i.e. this scanner is responsible
+  /// for the block following it. ReadSync() uses this with the offset 0 to set 'eos_'.
+  bool SyncStartsInRange(int64_t sync_offset);
+
   /// Utility function to advance 'stream_' past the next sync marker. If no sync is
   /// found in the scan range, returns OK and sets 'eos_' to true. It is safe to call
   /// this function past eosr.
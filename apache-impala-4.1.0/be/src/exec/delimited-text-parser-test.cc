@@ -15,10 +15,12 @@
 // specific language governing permissions and limitations
 // under the License.
 
+#include <random>
 #include <string>
 
 #include "exec/delimited-text-parser.inline.h"
 #include "testutil/gtest-util.h"
+#include "util/cpu-info.h"
 
 #include "common/names.h"
 
@@ -215,6 +217,67 @@ TEST(DelimitedTextParser, SpecialDelimiters) {
   Validate(&nul_field_parser, field2, 5, TUPLE_DELIM, 3, 6);
 }
 
+// Parses all of 'data' in calls of at most 'max_tuples' tuples and returns the field
+// locations and row ends as offsets into 'data'.
+static void ParseAll(TupleDelimitedTextParser* parser, int num_cols, const string& data,
+    int max_tuples, vector<pair<int64_t, int32_t>>* fields, vector<int64_t>* row_ends) {
+  parser->ParserReset();
+  char* data_ptr = const_cast<char*>(data.data());
+  int64_t remaining_len = data.size();
+  vector<char*> row_end_locs(max_tuples);
+  vector<FieldLocation> field_locations((max_tuples + 1) * num_cols);
+  while (remaining_len > 0) {
+    char* batch_start = data_ptr;
+    int num_tuples = 0;
+    int num_fields = 0;
+    char* next_column_start;
+    ASSERT_OK(parser->ParseFieldLocations(max_tuples, remaining_len, &data_ptr,
+        row_end_locs.data(), field_locations.data(), &num_tuples, &num_fields,
+        &next_column_start));
+    for (int i = 0; i < num_fields; ++i) {
+      fields->emplace_back(
+          field_locations[i].start - data.data(), field_locations[i].len);
+    }
+    for (int i = 0; i < num_tuples; ++i) {
+      row_ends->push_back(row_end_locs[i] - data.data());
+    }
+    remaining_len -= data_ptr - batch_start;
+  }
+}
+
+// Checks that the AVX2 parsing path produces the same results as the SSE path on random
+// input with plenty of delimiters, escapes and \r\n sequences spanning the 16 and 32
+// byte chunk boundaries.
+TEST(DelimitedTextParser, Avx2MatchesSse) {
+  if (!CpuInfo::IsSupported(CpuInfo::AVX2)) return;
+  const int NUM_COLS = 4;
+  bool is_materialized_col[NUM_COLS] = {true, false, true, true};
+  const char ALPHABET[] = "aaaaaaaabbbbbbbb,,,::@\n\r";
+  std::mt19937 rng(42);
+  std::uniform_int_distribution<int> dist(0, sizeof(ALPHABET) - 2);
+  string data;
+  for (int i = 0; i < 16 * 1024; ++i) data.push_back(ALPHABET[dist(rng)]);
+
+  for (char escape_char : {'\0', '@'}) {
+    TupleDelimitedTextParser parser(
+        NUM_COLS, 0, is_materialized_col, '\n', ',', ':', escape_char);
+    for (int max_tuples : {1, 7, 1024}) {
+      vector<pair<int64_t, int32_t>> avx2_fields, sse_fields;
+      vector<int64_t> avx2_row_ends, sse_row_ends;
+      ParseAll(&parser, NUM_COLS, data, max_tuples, &avx2_fields, &avx2_row_ends);
+      {
+        CpuInfo::TempDisable disable_avx2(CpuInfo::AVX2);
+        ParseAll(&parser, NUM_COLS, data, max_tuples, &sse_fields, &sse_row_ends);
+      }
+      EXPECT_GT(avx2_row_ends.size(), 0);
+      EXPECT_EQ(sse_fields, avx2_fields) << "escape: " << escape_char
+                                         << " max_tuples: " << max_tuples;
+      EXPECT_EQ(sse_row_ends, avx2_row_ends) << "escape: " << escape_char
+                                             << " max_tuples: " << max_tuples;
+    }
+  }
+}
+
 // TODO: expand test for other delimited text parser functions/cases.
 // Not all of them work without creating a HdfsScanNode but we can expand
 // these tests quite a bit more.
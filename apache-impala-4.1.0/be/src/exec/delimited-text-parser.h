@@ -65,11 +65,12 @@ class DelimitedTextParser {
   /// Parses a byte buffer for the field and tuple breaks.
   /// This function will write the field start & len to field_locations
   /// which can then be written out to tuples.
-  /// This function uses SSE ("Intel x86 instruction set extension
+  /// This function uses AVX2 to process 32 characters at a time if the hardware
+  /// supports it, and SSE ("Intel x86 instruction set extension
   /// 'Streaming Simd Extension') if the hardware supports SSE4.2
   /// instructions.  SSE4.2 added string processing instructions that
-  /// allow for processing 16 characters at a time.  Otherwise, this
-  /// function walks the file_buffer_ character by character.
+  /// allow for processing 16 characters at a time.  The remainder of the
+  /// buffer is walked character by character.
   /// Input Parameters:
   ///   max_tuples: The maximum number of tuples that should be parsed.
   ///               This is used to control how the batching works.
@@ -169,6 +170,15 @@ class DelimitedTextParser {
       FieldLocation* field_locations,
       int* num_tuples, int* num_fields, char** next_column_start);
 
+  /// Same as ParseSse() but processes 32 characters at a time with AVX2 byte compares.
+  /// Must only be called if the CPU supports AVX2. Leaves fewer than 32 characters
+  /// unprocessed, which the caller passes on to ParseSse() and the scalar loop.
+  template <bool PROCESS_ESCAPES>
+  Status ParseAvx2(int max_tuples, int64_t* remaining_len,
+      char** byte_buffer_ptr, char** row_end_locations_,
+      FieldLocation* field_locations,
+      int* num_tuples, int* num_fields, char** next_column_start);
+
   bool IsFieldOrCollectionItemDelimiter(char c) {
     return (!DELIMITED_TUPLES && c == field_delim_) ||
       (DELIMITED_TUPLES && field_delim_ != tuple_delim_ && c == field_delim_) ||
@@ -184,6 +194,14 @@ class DelimitedTextParser {
   /// SSE(xmm) register containing the escape search character.
   __m128i xmm_escape_search_;
 
+  /// Maximum number of characters in xmm_delim_search_: the tuple delimiter, '\r', the
+  /// field delimiter and the collection item delimiter.
+  static const int MAX_DELIMS = 4;
+
+  /// The characters in xmm_delim_search_, padded with copies of the first one. Used by
+  /// ParseAvx2(), which compares against all of them unconditionally.
+  char delim_chars_[MAX_DELIMS];
+
   /// For each col index [0, num_cols_), true if the column should be materialized.
   /// Not owned.
   const bool* is_materialized_col_;
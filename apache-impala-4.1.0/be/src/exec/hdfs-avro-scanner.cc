@@ -26,6 +26,7 @@
 #include "exec/hdfs-scan-node.h"
 #include "exec/read-write-util.h"
 #include "exec/scanner-context.inline.h"
+#include "runtime/exec-env.h"
 #include "runtime/fragment-state.h"
 #include "runtime/raw-value.h"
 #include "runtime/runtime-state.h"
@@ -65,7 +66,8 @@ static Status CheckSchema(const AvroSchemaElement& avro_schema) {
 }
 
 HdfsAvroScanner::HdfsAvroScanner(HdfsScanNodeBase* scan_node, RuntimeState* state)
-  : BaseSequenceScanner(scan_node, state) {
+  : BaseSequenceScanner(scan_node, state),
+    prefetched_block_pool_(new MemPool(scan_node->mem_tracker())) {
 }
 
 HdfsAvroScanner::HdfsAvroScanner()
@@ -76,9 +78,27 @@ HdfsAvroScanner::HdfsAvroScanner()
 Status HdfsAvroScanner::Open(ScannerContext* context) {
   RETURN_IF_ERROR(BaseSequenceScanner::Open(context));
   RETURN_IF_ERROR(CheckSchema(scan_node_->avro_schema()));
+  if (ExecEnv::GetInstance()->codec_offload_pool() != nullptr) {
+    num_blocks_decompressed_async_counter_ = ADD_COUNTER(
+        scan_node_->runtime_profile(), "NumAvroBlocksDecompressedAsync", TUnit::UNIT);
+    async_decompress_timer_ =
+        ADD_TIMER(scan_node_->runtime_profile(), "AsyncDecompressionTime");
+    async_decompress_wait_timer_ =
+        ADD_TIMER(scan_node_->runtime_profile(), "AsyncDecompressionWaitTime");
+  }
   return Status::OK();
 }
 
+void HdfsAvroScanner::Close(RowBatch* row_batch) {
+  DiscardPrefetchedBlocks();
+  if (row_batch != nullptr) {
+    row_batch->tuple_data_pool()->AcquireData(prefetched_block_pool_.get(), false);
+  } else {
+    prefetched_block_pool_->FreeAll();
+  }
+  BaseSequenceScanner::Close(row_batch);
+}
+
 Status HdfsAvroScanner::Codegen(HdfsScanPlanNode* node,
    FragmentState* state, llvm::Function** decode_avro_data_fn) {
   *decode_avro_data_fn = nullptr;
@@ -503,6 +523,7 @@ Status HdfsAvroScanner::ProcessRange(RowBatch* row_batch) {
   while (!eos_ && !scan_node_->ReachedLimitShared()) {
     if (record_pos_ == num_records_in_block_) {
       // Read new data block
+      int64_t block_offset = stream_->file_offset();
       RETURN_IF_FALSE(stream_->ReadZLong(&num_records_in_block_, &parse_status_));
       if (num_records_in_block_ < 0) {
         return Status(TErrorCode::AVRO_INVALID_RECORD_COUNT, stream_->filename(),
@@ -519,14 +540,20 @@ Status HdfsAvroScanner::ProcessRange(RowBatch* row_batch) {
           compressed_size, &compressed_data, &parse_status_));
 
       if (header_->is_compressed) {
-        if (header_->compression_type == THdfsCompression::SNAPPY) {
-          // Snappy-compressed data block includes trailing 4-byte checksum,
-          // decompressor_ doesn't expect this
-          compressed_size -= SnappyDecompressor::TRAILING_CHECKSUM_LEN;
+        bool found;
+        TakePrefetchedBlock(block_offset, compressed_size, &found);
+        if (!found) {
+          if (header_->compression_type == THdfsCompression::SNAPPY) {
+            // Snappy-compressed data block includes trailing 4-byte checksum,
+            // decompressor_ doesn't expect this
+            compressed_size -= SnappyDecompressor::TRAILING_CHECKSUM_LEN;
+          }
+          SCOPED_TIMER(decompress_timer_);
+          RETURN_IF_ERROR(decompressor_->ProcessBlock(false, compressed_size,
+              compressed_data, &data_block_len_, &data_block_));
         }
-        SCOPED_TIMER(decompress_timer_);
-        RETURN_IF_ERROR(decompressor_->ProcessBlock(false, compressed_size,
-            compressed_data, &data_block_len_, &data_block_));
+        // Decompress the next blocks while this one is decoded.
+        StartBlockPrefetch();
       } else {
         data_block_ = compressed_data;
         data_block_len_ = compressed_size;
@@ -573,10 +600,15 @@ Status HdfsAvroScanner::ProcessRange(RowBatch* row_batch) {
           // passing keep_current_chunk = false to the AcquireData() call below, so that
           // the current chunk only contains data for the current Avro block.
           data_buffer_pool_->Clear();
+          prefetched_block_pool_->FreeAll();
         } else {
           // Returned rows may reference data buffers - need to attach to batch.
           row_batch->tuple_data_pool()->AcquireData(data_buffer_pool_.get(), false);
+          row_batch->tuple_data_pool()->AcquireData(prefetched_block_pool_.get(), false);
         }
+      } else if (decompressor_.get() != nullptr) {
+        // Returned rows don't reference the data of the block.
+        prefetched_block_pool_->FreeAll();
       }
       RETURN_IF_ERROR(ReadSync());
     }
@@ -585,6 +617,117 @@ Status HdfsAvroScanner::ProcessRange(RowBatch* row_batch) {
   return Status::OK();
 }
 
+void HdfsAvroScanner::StartBlockPrefetch() {
+  CallableThreadPool* thread_pool = ExecEnv::GetInstance()->codec_offload_pool();
+  if (thread_pool == nullptr) return;
+  // Only look at the bytes that are already buffered. Peeking further would block the
+  // scanner thread on I/O and copy the blocks into the stream's boundary buffer.
+  uint8_t* buffer;
+  int64_t buffer_len;
+  stream_->PeekBufferedBytes(&buffer, &buffer_len);
+  uint8_t* buffer_end = buffer + buffer_len;
+  while (prefetched_blocks_.size() < MAX_PREFETCHED_BLOCKS) {
+    // Offset of the sync marker preceding the next block relative to the stream
+    // position, which is at the end of the current block.
+    int64_t sync_offset = prefetched_blocks_.empty() ?
+        0 : prefetched_blocks_.back()->end_offset - stream_->file_offset();
+    // The block after a sync marker that starts outside of the scan range belongs to
+    // the next scan range. This is the same test ReadSync() uses to set 'eos_'.
+    if (!SyncStartsInRange(sync_offset)) return;
+
+    // Parse the sync marker and the block header.
+    if (buffer_len < sync_offset + SYNC_HASH_SIZE) return;
+    uint8_t* pos = buffer + sync_offset;
+    if (memcmp(pos, header_->sync, SYNC_HASH_SIZE) != 0) return;
+    pos += SYNC_HASH_SIZE;
+    ReadWriteUtil::ZLongResult num_records = ReadWriteUtil::ReadZLong(&pos, buffer_end);
+    if (!num_records.ok || num_records.val < 0) return;
+    ReadWriteUtil::ZLongResult compressed_size =
+        ReadWriteUtil::ReadZLong(&pos, buffer_end);
+    // Tiny blocks are not worth decompressing ahead of time.
+    if (!compressed_size.ok || compressed_size.val <= MIN_PREFETCHED_BLOCK_SIZE) return;
+    int64_t data_offset = pos - buffer;
+
+    // Copy the compressed data so that the stream can be advanced while the block is
+    // decompressed.
+    int64_t block_len = data_offset + compressed_size.val;
+    if (buffer_len < block_len) return;
+    shared_ptr<PrefetchedBlock> block =
+        make_shared<PrefetchedBlock>(scan_node_->mem_tracker());
+    block->block_offset = stream_->file_offset() + sync_offset + SYNC_HASH_SIZE;
+    block->end_offset = stream_->file_offset() + block_len;
+    block->compressed_size = compressed_size.val;
+    if (!block->compressed_buffer.TryAllocate(block->compressed_size)) return;
+    memcpy(block->compressed_buffer.buffer(), buffer + data_offset,
+        block->compressed_size);
+    if (!thread_pool->Offer([this, block]() { DecompressPrefetchedBlock(block.get()); },
+            0)) {
+      // The pool is busy. Decompress the block on this thread when it is read.
+      return;
+    }
+    prefetched_blocks_.push_back(move(block));
+  }
+}
+
+void HdfsAvroScanner::DecompressPrefetchedBlock(PrefetchedBlock* block) {
+  Status status;
+  {
+    SCOPED_TIMER(async_decompress_timer_);
+    int64_t compressed_size = block->compressed_size;
+    if (header_->compression_type == THdfsCompression::SNAPPY) {
+      compressed_size -= SnappyDecompressor::TRAILING_CHECKSUM_LEN;
+    }
+    scoped_ptr<Codec> decompressor;
+    status = Codec::CreateDecompressor(
+        &block->pool, false, header_->compression_type, &decompressor);
+    if (status.ok()) {
+      status = decompressor->ProcessBlock(false, compressed_size,
+          block->compressed_buffer.buffer(), &block->data_len, &block->data);
+      decompressor->Close();
+    }
+    block->compressed_buffer.Release();
+  }
+  COUNTER_ADD(num_blocks_decompressed_async_counter_, 1);
+  block->status.Set(status);
+}
+
+void HdfsAvroScanner::TakePrefetchedBlock(
+    int64_t block_offset, int64_t compressed_size, bool* found) {
+  *found = false;
+  while (!prefetched_blocks_.empty()
+      && prefetched_blocks_.front()->block_offset <= block_offset) {
+    shared_ptr<PrefetchedBlock> block = move(prefetched_blocks_.front());
+    prefetched_blocks_.pop_front();
+    Status status;
+    {
+      SCOPED_TIMER(async_decompress_wait_timer_);
+      status = block->status.Get();
+    }
+    if (block->block_offset == block_offset && block->compressed_size == compressed_size
+        && status.ok()) {
+      prefetched_block_pool_->AcquireData(&block->pool, false);
+      data_block_ = block->data;
+      data_block_len_ = block->data_len;
+      *found = true;
+      return;
+    }
+    // Either the block was skipped or it failed to decompress. In the latter case the
+    // block is decompressed again on this thread, which reports the error.
+    block->pool.FreeAll();
+  }
+  // The reader is not where the prefetched blocks expected it to be, e.g. because it
+  // skipped to the next sync marker after an error.
+  DiscardPrefetchedBlocks();
+}
+
+void HdfsAvroScanner::DiscardPrefetchedBlocks() {
+  for (const shared_ptr<PrefetchedBlock>& block : prefetched_blocks_) {
+    discard_result(block->status.Get());
+    block->pool.FreeAll();
+  }
+  prefetched_blocks_.clear();
+}
+
 bool HdfsAvroScanner::MaterializeTuple(const AvroSchemaElement& record_schema,
     MemPool* pool, uint8_t** data, uint8_t* data_end, Tuple* tuple) {
   DCHECK_EQ(record_schema.schema->type, AVRO_RECORD);
@@ -70,11 +70,16 @@
 
 #include "exec/base-sequence-scanner.h"
 
+#include <deque>
+#include <memory>
+
 #include <avro/basics.h>
 
 #include "exec/read-write-util.h"
+#include "runtime/scoped-buffer.h"
 #include "runtime/tuple.h"
 #include "runtime/tuple-row.h"
+#include "util/promise.h"
 
 namespace llvm {
   class BasicBlock;
@@ -92,6 +97,7 @@ class HdfsAvroScanner : public BaseSequenceScanner {
   HdfsAvroScanner(HdfsScanNodeBase* scan_node, RuntimeState* state);
 
   virtual Status Open(ScannerContext* context) WARN_UNUSED_RESULT;
+  virtual void Close(RowBatch* row_batch);
 
   /// Codegen DecodeAvroData(). Stores the resulting function in 'decode_avro_data_fn' if
   /// codegen was successful or nullptr otherwise.
@@ -141,6 +147,51 @@ class HdfsAvroScanner : public BaseSequenceScanner {
   int64_t num_records_in_block_ = 0;
   int64_t record_pos_ = 0;
 
+  /// Maximum number of data blocks that are decompressed ahead of the current block.
+  static const int MAX_PREFETCHED_BLOCKS = 4;
+
+  /// Blocks with at most this many compressed bytes are decompressed on the scanner
+  /// thread.
+  static const int64_t MIN_PREFETCHED_BLOCK_SIZE = 1024;
+
+  /// State of a data block that is decompressed on the codec offload pool. Shared
+  /// between the scanner and the task decompressing the block.
+  struct PrefetchedBlock {
+    PrefetchedBlock(MemTracker* mem_tracker)
+      : compressed_buffer(mem_tracker), pool(mem_tracker) {}
+
+    /// File offset of the block header, i.e. the position right after the sync marker,
+    /// and file offset of the end of the compressed data.
+    int64_t block_offset;
+    int64_t end_offset;
+
+    /// Copy of the compressed data of the block. Released once it is decompressed.
+    ScopedBuffer compressed_buffer;
+    int64_t compressed_size;
+
+    /// The decompressed block, allocated from 'pool'.
+    MemPool pool;
+    uint8_t* data = nullptr;
+    int64_t data_len = 0;
+
+    /// Set by the decompression task when it is done.
+    Promise<Status> status;
+  };
+
+  /// Blocks following the current block that are being decompressed ahead of time, in
+  /// file order.
+  std::deque<std::shared_ptr<PrefetchedBlock>> prefetched_blocks_;
+
+  /// Holds the data of the current block if it was taken from 'prefetched_blocks_'.
+  /// Attached to the output batch or freed once the block is done.
+  boost::scoped_ptr<MemPool> prefetched_block_pool_;
+
+  /// Number of blocks decompressed on the codec offload pool, time spent
+  /// decompressing them and time the scanner thread waited for them.
+  RuntimeProfile::Counter* num_blocks_decompressed_async_counter_ = nullptr;
+  RuntimeProfile::Counter* async_decompress_timer_ = nullptr;
+  RuntimeProfile::Counter* async_decompress_wait_timer_ = nullptr;
+
   /// Metadata keys
   static const std::string AVRO_SCHEMA_KEY;
   static const std::string AVRO_CODEC_KEY;
@@ -160,6 +211,25 @@ class HdfsAvroScanner : public BaseSequenceScanner {
   /// Utility function for decoding and parsing file header metadata
   Status ParseMetadata() WARN_UNUSED_RESULT;
 
+  /// Peeks at the data blocks following the current block in 'stream_' and hands them
+  /// to the codec offload pool, until MAX_PREFETCHED_BLOCKS are in flight. Only blocks
+  /// that are completely buffered by the stream are considered, so this never blocks on
+  /// I/O. Stops at the first block that starts outside of the scan range. Blocks whose
+  /// header does not parse are left to ProcessRange(), which reports the error.
+  void StartBlockPrefetch();
+
+  /// Decompresses 'block' on a codec offload pool thread.
+  void DecompressPrefetchedBlock(PrefetchedBlock* block);
+
+  /// Looks for the block at 'block_offset' with 'compressed_size' bytes of compressed
+  /// data among the prefetched blocks. If it was decompressed successfully, points
+  /// 'data_block_' to its data and sets 'found' to true. Discards prefetched blocks that
+  /// precede it, or all of them if it was not prefetched.
+  void TakePrefetchedBlock(int64_t block_offset, int64_t compressed_size, bool* found);
+
+  /// Waits for all prefetched blocks and frees them.
+  void DiscardPrefetchedBlocks();
+
   /// Resolves the table schema (i.e. the reader schema) against the file schema (i.e. the
   /// writer schema), and sets the 'slot_desc' fields of the nodes of the file schema
   /// corresponding to materialized slots. Calls WriteDefaultValue() as
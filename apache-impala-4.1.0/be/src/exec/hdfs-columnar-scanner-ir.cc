@@ -44,9 +44,16 @@ int HdfsColumnarScanner::ProcessScratchBatch(RowBatch* dst_batch) {
   // Do not use batch_->AtCapacity() in this loop because it is not necessary
   // to perform the memory capacity check.
   bool* is_selected = scratch_batch_->selected_rows.get() + scratch_batch_->tuple_idx;
+  // Rows rejected by the column readers based on dictionary codes, if any.
+  const uint8_t* dict_rejected = scratch_batch_->dict_filter_rejected.get();
+  if (dict_rejected != nullptr) dict_rejected += scratch_batch_->tuple_idx;
   while (scratch_tuple != scratch_tuple_end) {
     *output_row = reinterpret_cast<Tuple*>(scratch_tuple);
     scratch_tuple += tuple_size;
+    if (dict_rejected != nullptr && *dict_rejected++ != 0) {
+      *is_selected++ = false;
+      continue;
+    }
     // Evaluate runtime filters and conjuncts. Short-circuit the evaluation if
     // the filters/conjuncts are empty to avoid function calls.
     if (!EvalRuntimeFilters(reinterpret_cast<TupleRow*>(output_row))) {
@@ -23,6 +23,7 @@
 #include "codegen/llvm-codegen.h"
 #include "exec/hdfs-scan-node-base.h"
 #include "exec/scratch-tuple-batch.h"
+#include "exprs/scalar-expr.h"
 #include "runtime/exec-env.h"
 #include "runtime/fragment-state.h"
 #include "runtime/io/disk-io-mgr.h"
@@ -106,6 +107,21 @@ Status HdfsColumnarScanner::Open(ScannerContext* context) {
   return Status::OK();
 }
 
+void HdfsColumnarScanner::InitSlotIdsForConjuncts() {
+  conjunct_slot_ids_.reserve(scan_node_->conjuncts().size() +
+    scan_node_->filter_exprs().size());
+  vector<ScalarExpr*> conjuncts;
+  conjuncts.reserve(scan_node_->conjuncts().size() +
+    scan_node_->filter_exprs().size());
+  conjuncts.insert(std::end(conjuncts), std::begin(scan_node_->conjuncts()),
+      std::end(scan_node_->conjuncts()));
+  conjuncts.insert(std::end(conjuncts), std::begin(scan_node_->filter_exprs()),
+      std::end(scan_node_->filter_exprs()));
+  for (int conjunct_idx = 0; conjunct_idx < conjuncts.size(); ++conjunct_idx) {
+    conjuncts[conjunct_idx]->GetSlotIds(&conjunct_slot_ids_);
+  }
+}
+
 int HdfsColumnarScanner::FilterScratchBatch(RowBatch* dst_batch) {
   // This function must not be called when the output batch is already full. As long as
   // we always call CommitRows() after TransferScratchTuples(), the output batch can
@@ -107,6 +107,13 @@ class HdfsColumnarScanner : public HdfsScanner {
   /// materialized tuples. This is a separate function so it can be codegened.
   int ProcessScratchBatch(RowBatch* dst_batch);
 
+  /// Initialize 'conjunct_slot_ids_' with the SlotIds used in the conjuncts.
+  void InitSlotIdsForConjuncts();
+
+  /// List of slot ids used by conjuncts and runtime filters. Columns of these slots are
+  /// materialized first when late materialization is used.
+  std::vector<SlotId> conjunct_slot_ids_;
+
   /// List of pair of (column index, reservation allocated).
   typedef std::vector<std::pair<int, int64_t>> ColumnReservations;
   /// List of column range lengths.
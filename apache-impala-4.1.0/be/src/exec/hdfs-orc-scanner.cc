@@ -324,6 +324,9 @@ Status HdfsOrcScanner::Open(ScannerContext* context) {
   num_pushed_down_runtime_filters_counter_ =
       ADD_COUNTER(scan_node_->runtime_profile(), "NumPushedDownRuntimeFilters",
           TUnit::UNIT);
+  num_rows_skipped_by_late_materialization_counter_ =
+      ADD_COUNTER(scan_node_->runtime_profile(), "NumOrcRowsSkippedByLateMaterialization",
+          TUnit::UNIT);
 
   codegend_process_scratch_batch_fn_ = scan_node_->GetCodegenFn(THdfsFileFormat::ORC);
   if (codegend_process_scratch_batch_fn_ == nullptr) {
@@ -441,6 +444,11 @@ Status HdfsOrcScanner::Open(ScannerContext* context) {
   } RETURN_ON_ORC_EXCEPTION(
       "Encountered parse error during schema selection in ORC file $0: $1");
 
+  InitSlotIdsForConjuncts();
+  use_late_materialization_ =
+      state_->query_options().orc_late_materialization_threshold >= 0
+      && orc_root_reader_->DivideFilterAndNonFilterChildren(conjunct_slot_ids_);
+
   // Set top-level template tuple.
   template_tuple_ = template_tuple_map_[scan_node_->tuple_desc()];
   return Status::OK();
@@ -972,9 +980,15 @@ Status HdfsOrcScanner::TransferTuples(RowBatch* dst_batch) {
     DCHECK(scratch_batch_->AtEnd());
     RETURN_IF_ERROR(scratch_batch_->Reset(state_));
     InitTupleBuffer(template_tuple_, scratch_batch_->tuple_mem, scratch_batch_->capacity);
-    RETURN_IF_ERROR(orc_root_reader_->TopLevelReadValueBatch(scratch_batch_.get(),
-        &scratch_batch_->aux_mem_pool));
-    int num_tuples_transferred = TransferScratchTuples(dst_batch);
+    int num_tuples_transferred;
+    if (use_late_materialization_) {
+      RETURN_IF_ERROR(
+          TransferTuplesWithLateMaterialization(dst_batch, &num_tuples_transferred));
+    } else {
+      RETURN_IF_ERROR(orc_root_reader_->TopLevelReadValueBatch(scratch_batch_.get(),
+          &scratch_batch_->aux_mem_pool));
+      num_tuples_transferred = TransferScratchTuples(dst_batch);
+    }
     row_id += num_tuples_transferred;
     VLOG_ROW << Substitute("Transfer $0 rows from scratch batch to dst_batch ($1 rows)",
         num_tuples_transferred, dst_batch->num_rows());
@@ -983,6 +997,45 @@ Status HdfsOrcScanner::TransferTuples(RowBatch* dst_batch) {
   return Status::OK();
 }
 
+Status HdfsOrcScanner::TransferTuplesWithLateMaterialization(RowBatch* dst_batch,
+    int* num_tuples_transferred) {
+  RETURN_IF_ERROR(orc_root_reader_->TopLevelReadFilterValueBatch(scratch_batch_.get(),
+      &scratch_batch_->aux_mem_pool));
+  int num_tuples = scratch_batch_->num_tuples;
+  int num_row_to_commit = FilterScratchBatch(dst_batch);
+  if (num_row_to_commit > 0) {
+    if (!scratch_batch_->AtEnd() || num_row_to_commit == num_tuples) {
+      // Either nothing was filtered out or 'dst_batch' filled up before the whole
+      // scratch batch was filtered. In the latter case the remaining rows are filtered
+      // again by TransferScratchTuples() in the next GetNext() call, which needs all
+      // columns, so materialize the entire batch.
+      ScratchMicroBatch all_rows{0, num_tuples - 1, num_tuples};
+      RETURN_IF_ERROR(orc_root_reader_->TopLevelReadNonFilterValueBatch(
+          scratch_batch_.get(), &scratch_batch_->aux_mem_pool, &all_rows, 1));
+    } else {
+      ScratchMicroBatch micro_batches[num_tuples];
+      int num_micro_batches = scratch_batch_->GetMicroBatches(
+          state_->query_options().orc_late_materialization_threshold, micro_batches);
+      int num_rows_materialized = 0;
+      for (int i = 0; i < num_micro_batches; ++i) {
+        num_rows_materialized += micro_batches[i].length;
+      }
+      COUNTER_ADD(num_rows_skipped_by_late_materialization_counter_,
+          num_tuples - num_rows_materialized);
+      RETURN_IF_ERROR(orc_root_reader_->TopLevelReadNonFilterValueBatch(
+          scratch_batch_.get(), &scratch_batch_->aux_mem_pool, micro_batches,
+          num_micro_batches));
+    }
+  } else {
+    COUNTER_ADD(num_rows_skipped_by_late_materialization_counter_, num_tuples);
+  }
+  if (scratch_batch_->tuple_byte_size != 0) {
+    scratch_batch_->FinalizeTupleTransfer(dst_batch, num_row_to_commit);
+  }
+  *num_tuples_transferred = num_row_to_commit;
+  return Status::OK();
+}
+
 Status HdfsOrcScanner::AllocateTupleMem(RowBatch* row_batch) {
   int64_t tuple_buffer_size;
   RETURN_IF_ERROR(
@@ -291,6 +291,16 @@ class HdfsOrcScanner : public HdfsColumnarScanner {
   /// Number of runtime filters that are pushed down to the ORC reader.
   RuntimeProfile::Counter* num_pushed_down_runtime_filters_counter_ = nullptr;
 
+  /// Number of rows whose columns not referenced by conjuncts were not materialized
+  /// because the rows were filtered out.
+  RuntimeProfile::Counter* num_rows_skipped_by_late_materialization_counter_ = nullptr;
+
+  /// True if the columns referenced by conjuncts and runtime filters are materialized
+  /// and filtered on before the other columns. Set in Open() based on the
+  /// ORC_LATE_MATERIALIZATION_THRESHOLD query option and the shape of the top level
+  /// reader.
+  bool use_late_materialization_ = false;
+
   /// Number of arrived runtime IN-list filters that can be pushed down.
   /// Used in ShouldUpdateSearchArgument(). Init to -1 so the check can pass at first.
   int num_pushable_in_list_filters_ = -1;
@@ -339,6 +349,14 @@ class HdfsOrcScanner : public HdfsColumnarScanner {
   /// is full.
   Status TransferTuples(RowBatch* dst_batch) WARN_UNUSED_RESULT;
 
+  /// Late materialization version of filling and filtering one scratch batch in
+  /// TransferTuples(). Materializes the columns referenced by conjuncts and runtime
+  /// filters, filters the scratch batch and then materializes the remaining columns only
+  /// for the surviving rows. Stores the number of rows to commit in
+  /// '*num_tuples_transferred'.
+  Status TransferTuplesWithLateMaterialization(RowBatch* dst_batch,
+      int* num_tuples_transferred) WARN_UNUSED_RESULT;
+
   /// Process the file footer and parse file_metadata_.  This should be called with the
   /// last ORC_FOOTER_SIZE bytes in context_.
   Status ProcessFileTail() WARN_UNUSED_RESULT;
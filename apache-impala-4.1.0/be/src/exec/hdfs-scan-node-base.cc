@@ -532,6 +532,9 @@ Status HdfsScanNodeBase::Open(RuntimeState* state) {
 
   RETURN_IF_ERROR(ClaimBufferReservation(state));
   reader_context_ = ExecEnv::GetInstance()->disk_io_mgr()->RegisterContext();
+  if (state->query_ctx().__isset.request_pool) {
+    reader_context_->set_request_pool(state->query_ctx().request_pool);
+  }
 
   // Initialize HdfsScanNode specific counters
   hdfs_read_timer_ = PROFILE_TotalRawHdfsReadTime.Instantiate(runtime_profile());
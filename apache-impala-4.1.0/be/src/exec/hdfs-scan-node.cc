@@ -204,6 +204,10 @@ void HdfsScanNode::TransferToScanNodePool(MemPool* pool) {
 
 void HdfsScanNode::AddMaterializedRowBatch(unique_ptr<RowBatch> row_batch) {
   InitNullCollectionValues(row_batch.get());
+  // Start another scanner thread if the consumer is waiting for row batches.
+  if (thread_state_.UpdateThreadTarget(scanner_io_wait_time())) {
+    ThreadTokenAvailableCb(runtime_state_->resource_pool());
+  }
   thread_state_.EnqueueBatch(move(row_batch));
 }
 
@@ -265,7 +269,8 @@ void HdfsScanNode::ThreadTokenAvailableCb(ThreadResourcePool* pool) {
   //     estimated memory consumption (include reservation and non-reserved memory).
   //  7. Don't start up a thread if it is an extra thread and we can't reserve another
   //     minimum reservation's worth of memory for the thread.
-  //  8. Don't start up more than maximum number of scanner threads configured.
+  //  8. Don't start up more than maximum number of scanner threads configured, or more
+  //     than the number of threads the scanner thread scaling controller aims to run.
   //  9. Don't start up if there are no thread tokens.
 
   // Case 4. We have not issued the initial ranges so don't start a scanner thread.
@@ -326,6 +331,7 @@ void HdfsScanNode::ThreadTokenAvailableCb(ThreadResourcePool* pool) {
       // The first thread is required to make progress on the scan.
       pool->AcquireThreadToken();
     } else if (thread_state_.GetNumActive() >= thread_state_.max_num_scanner_threads()
+        || thread_state_.GetNumActive() >= thread_state_.target_num_scanner_threads()
         || !pool->TryAcquireThreadToken()) {
       scanner_mem_limiter->ReleaseMemoryForScannerThread(this, est_mem);
       ReturnReservationFromScannerThread(lock, scanner_thread_reservation);
@@ -444,6 +450,12 @@ void HdfsScanNode::ScannerThread(bool first_thread, int64_t scanner_thread_reser
       break;
     }
 
+    // Stop an extra thread if the consumer does not keep up with the scanner threads.
+    if (!first_thread && thread_state_.TryClaimThreadExit()) {
+      VLOG_QUERY << "Scanner threads scaled down. Extra scanner thread exiting.";
+      break;
+    }
+
     if (scan_range == nullptr) COUNTER_ADD(scanner_thread_workless_loops_counter_, 1);
   }
 
@@ -155,6 +155,11 @@ Status HdfsTableSink::Prepare(RuntimeState* state, MemTracker* parent_mem_tracke
   encode_timer_ = ADD_TIMER(profile(), "EncodeTimer");
   hdfs_write_timer_ = ADD_TIMER(profile(), "HdfsWriteTimer");
   compress_timer_ = ADD_TIMER(profile(), "CompressTimer");
+  compress_wait_timer_ = ADD_TIMER(profile(), "CompressWaitTimer");
+  num_pages_compressed_async_counter_ =
+      ADD_COUNTER(profile(), "NumPagesCompressedAsync", TUnit::UNIT);
+  num_pages_not_compressed_async_counter_ =
+      ADD_COUNTER(profile(), "NumPagesNotCompressedAsync", TUnit::UNIT);
 
   return Status::OK();
 }
@@ -124,6 +124,13 @@ class HdfsTableSink : public DataSink {
   RuntimeProfile::Counter* encode_timer() { return encode_timer_; }
   RuntimeProfile::Counter* hdfs_write_timer() { return hdfs_write_timer_; }
   RuntimeProfile::Counter* compress_timer() { return compress_timer_; }
+  RuntimeProfile::Counter* compress_wait_timer() { return compress_wait_timer_; }
+  RuntimeProfile::Counter* num_pages_compressed_async_counter() {
+    return num_pages_compressed_async_counter_;
+  }
+  RuntimeProfile::Counter* num_pages_not_compressed_async_counter() {
+    return num_pages_not_compressed_async_counter_;
+  }
 
   std::string DebugString() const;
 
@@ -320,6 +327,13 @@ class HdfsTableSink : public DataSink {
   RuntimeProfile::Counter* hdfs_write_timer_;
   /// Time spent compressing data
   RuntimeProfile::Counter* compress_timer_;
+  /// Time spent waiting for pages compressed on ExecEnv::codec_offload_pool()
+  RuntimeProfile::Counter* compress_wait_timer_;
+  /// Number of data pages compressed on ExecEnv::codec_offload_pool() and number of
+  /// pages compressed on the sink thread although the pool is enabled, because the pool
+  /// was busy or there was not enough memory.
+  RuntimeProfile::Counter* num_pages_compressed_async_counter_;
+  RuntimeProfile::Counter* num_pages_not_compressed_async_counter_;
   /// Will the output of this sink be used for query results
   const bool is_result_sink_;
 };
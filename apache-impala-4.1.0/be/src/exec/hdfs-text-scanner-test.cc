@@ -0,0 +1,184 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include "exec/hdfs-text-scanner.h"
+
+#include <string.h>
+#include <utility>
+
+#include <boost/scoped_ptr.hpp>
+
+#include "gutil/strings/substitute.h"
+#include "runtime/mem-pool.h"
+#include "runtime/mem-tracker.h"
+#include "testutil/gtest-util.h"
+#include "util/codec.h"
+
+#include "common/names.h"
+
+using strings::Substitute;
+
+namespace impala {
+
+class HdfsTextScannerTest : public testing::Test {
+ public:
+  HdfsTextScannerTest() : mem_pool_(&mem_tracker_) {}
+
+  ~HdfsTextScannerTest() { mem_pool_.FreeAll(); }
+
+ protected:
+  /// Returns 'num_rows' rows of delimited text that differ between streams.
+  static string MakeText(int stream_idx, int num_rows) {
+    string text;
+    for (int i = 0; i < num_rows; ++i) {
+      text += Substitute("$0|row $1 of stream $2|$3\n", i, i * 7919 % 1009, stream_idx,
+          i * stream_idx);
+    }
+    return text;
+  }
+
+  /// Compresses each of 'texts' into a stream of its own, concatenates the streams into
+  /// 'compressed' and stores the offset of each stream in 'stream_starts'.
+  void CompressStreams(THdfsCompression::type format, const vector<string>& texts,
+      string* compressed, vector<int64_t>* stream_starts) {
+    scoped_ptr<Codec> compressor;
+    Codec::CodecInfo codec_info(format);
+    ASSERT_OK(Codec::CreateCompressor(&mem_pool_, false, codec_info, &compressor));
+    for (const string& text : texts) {
+      uint8_t* output = nullptr;
+      int64_t output_len = 0;
+      ASSERT_OK(compressor->ProcessBlock(false, text.size(),
+          reinterpret_cast<const uint8_t*>(text.data()), &output_len, &output));
+      stream_starts->push_back(compressed->size());
+      compressed->append(reinterpret_cast<char*>(output), output_len);
+    }
+    compressor->Close();
+  }
+
+  int64_t FindStart(THdfsCompression::type format, const string& buffer, int64_t from) {
+    return HdfsTextScanner::FindCompressedStreamStart(format,
+        reinterpret_cast<const uint8_t*>(buffer.data()), buffer.size(), from);
+  }
+
+  /// Decompresses 'len' bytes of 'buffer' starting at 'offset' and stores the
+  /// concatenated output in 'text'.
+  Status Decompress(THdfsCompression::type format, const string& buffer, int64_t offset,
+      int64_t len, string* text) {
+    vector<pair<uint8_t*, int64_t>> output;
+    RETURN_IF_ERROR(HdfsTextScanner::DecompressStreams(format,
+        reinterpret_cast<const uint8_t*>(buffer.data()) + offset, len, &mem_pool_,
+        &output));
+    text->clear();
+    for (const pair<uint8_t*, int64_t>& chunk : output) {
+      text->append(reinterpret_cast<char*>(chunk.first), chunk.second);
+    }
+    return Status::OK();
+  }
+
+  /// Checks that every stream start of a multi-stream file is detected and that any
+  /// range of whole streams decompresses to the original text.
+  void TestStreamBoundaries(THdfsCompression::type format) {
+    vector<string> texts;
+    for (int i = 0; i < 5; ++i) texts.push_back(MakeText(i, 1000 * (i + 1)));
+    string compressed;
+    vector<int64_t> starts;
+    CompressStreams(format, texts, &compressed, &starts);
+    starts.push_back(compressed.size());
+
+    for (int i = 0; i + 1 < starts.size(); ++i) {
+      EXPECT_EQ(starts[i], FindStart(format, compressed, starts[i]));
+      // Any match between two starts must be inside the stream, i.e. a false positive.
+      int64_t next = FindStart(format, compressed, starts[i] + 1);
+      if (i + 2 < starts.size()) {
+        EXPECT_GT(next, starts[i]);
+        EXPECT_LE(next, starts[i + 1]);
+      }
+    }
+    for (int first = 0; first + 1 < starts.size(); ++first) {
+      for (int last = first + 1; last < starts.size(); ++last) {
+        string text;
+        ASSERT_OK(Decompress(format, compressed, starts[first],
+            starts[last] - starts[first], &text));
+        string expected;
+        for (int i = first; i < last; ++i) expected += texts[i];
+        EXPECT_EQ(expected, text);
+      }
+    }
+    // A piece that stops inside a stream or starts inside a stream is rejected.
+    string text;
+    EXPECT_FALSE(Decompress(format, compressed, 0, starts[1] - 1, &text).ok());
+    EXPECT_FALSE(Decompress(format, compressed, 0, starts[1] + 1, &text).ok());
+    EXPECT_FALSE(Decompress(format, compressed, 1, starts[1] - 1, &text).ok());
+  }
+
+  /// Checks that a copy of a stream header inside other data is reported as a stream
+  /// start, but that a piece starting there fails to decompress, which makes the
+  /// scanner fall back to sequential decompression.
+  void TestFalsePositive(THdfsCompression::type format, const string& header) {
+    string compressed;
+    vector<int64_t> starts;
+    CompressStreams(format, {MakeText(0, 1000), MakeText(1, 1000)}, &compressed,
+        &starts);
+    // Overwrite bytes in the middle of the first stream with a header.
+    int64_t fake_start = starts[1] / 2;
+    compressed.replace(fake_start, header.size(), header);
+    EXPECT_LE(FindStart(format, compressed, 1), fake_start);
+    EXPECT_EQ(fake_start, FindStart(format, compressed, fake_start));
+    string text;
+    EXPECT_FALSE(Decompress(format, compressed, fake_start, starts[1] - fake_start,
+        &text).ok());
+    EXPECT_FALSE(Decompress(format, compressed, 0, fake_start, &text).ok());
+
+    // A header in uncompressed bytes that are not part of any stream.
+    string junk = string(100, 'z') + header + string(100, 'z');
+    EXPECT_EQ(100, FindStart(format, junk, 0));
+    EXPECT_EQ(-1, FindStart(format, junk, 101));
+    EXPECT_FALSE(Decompress(format, junk, 100, junk.size() - 100, &text).ok());
+  }
+
+  MemTracker mem_tracker_;
+  MemPool mem_pool_;
+};
+
+TEST_F(HdfsTextScannerTest, GzipStreamBoundaries) {
+  TestStreamBoundaries(THdfsCompression::GZIP);
+}
+
+TEST_F(HdfsTextScannerTest, Bzip2StreamBoundaries) {
+  TestStreamBoundaries(THdfsCompression::BZIP2);
+}
+
+TEST_F(HdfsTextScannerTest, GzipFalsePositive) {
+  // Magic bytes, deflate method and a flag byte with no reserved bits set.
+  TestFalsePositive(THdfsCompression::GZIP, string("\x1f\x8b\x08\x00", 4));
+}
+
+TEST_F(HdfsTextScannerTest, Bzip2FalsePositive) {
+  // "BZh", block size and the magic of the first block.
+  TestFalsePositive(THdfsCompression::BZIP2, string("BZh9\x31\x41\x59\x26\x53\x59", 10));
+}
+
+TEST_F(HdfsTextScannerTest, NoStreamStart) {
+  string text(1000, 'a');
+  EXPECT_EQ(-1, FindStart(THdfsCompression::GZIP, text, 0));
+  EXPECT_EQ(-1, FindStart(THdfsCompression::BZIP2, text, 0));
+  // A header that is cut off by the end of the buffer is not a match.
+  string truncated = text + string("\x1f\x8b\x08", 3);
+  EXPECT_EQ(-1, FindStart(THdfsCompression::GZIP, truncated, 0));
+}
+
+}
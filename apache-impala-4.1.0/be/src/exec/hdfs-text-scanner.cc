@@ -42,6 +42,7 @@
 #include "gen-cpp/ErrorCodes_types.h"
 #include "gutil/strings/substitute.h"
 #include "runtime/descriptors.h"
+#include "runtime/exec-env.h"
 #include "runtime/fragment-state.h"
 #include "runtime/io/request-context.h"
 #include "runtime/io/request-ranges.h"
@@ -53,6 +54,7 @@
 #include "runtime/tuple.h"
 #include "util/codec.h"
 #include "util/error-util.h"
+#include "util/promise.h"
 #include "util/runtime-profile-counters.h"
 #include "util/stopwatch.h"
 
@@ -82,6 +84,87 @@ const string HdfsTextScanner::LZO_INDEX_SUFFIX = ".index";
 // progress.
 const int64_t COMPRESSED_DATA_FIXED_READ_SIZE = 1 * 1024 * 1024;
 
+// Minimum number of compressed bytes in a piece that is decompressed in parallel. Small
+// streams, e.g. the 64KB members of block gzip files, are grouped into one piece.
+const int64_t MIN_PARALLEL_DECOMPRESSION_PIECE_SIZE = 256 * 1024;
+
+// The output of all pieces of a buffer that is decompressed in parallel is held in memory
+// at the same time. The buffer is only split if the scan node's memory limit leaves room
+// for this many times its compressed size.
+const int64_t PARALLEL_DECOMPRESSION_EXPECTED_RATIO = 4;
+
+DECLARE_int32(codec_offload_threads);
+
+struct HdfsTextScanner::DecompressionPiece {
+  DecompressionPiece(MemTracker* mem_tracker) : pool(mem_tracker) {}
+
+  /// The compressed data. Points into the buffer of 'stream_'.
+  const uint8_t* input = nullptr;
+  int64_t input_len = 0;
+
+  /// Decompressed output, allocated from 'pool'.
+  MemPool pool;
+  vector<std::pair<uint8_t*, int64_t>> output;
+
+  /// Set by the task decompressing the piece when it is done.
+  Promise<Status> status;
+};
+
+int64_t HdfsTextScanner::FindCompressedStreamStart(THdfsCompression::type format,
+    const uint8_t* buffer, int64_t len, int64_t from) {
+  // A gzip member starts with the magic bytes, the deflate method and a flag byte with
+  // the reserved bits unset. A bzip2 stream starts with "BZh", the block size and either
+  // the magic of the first block or the end of stream magic.
+  static const uint8_t BZIP2_BLOCK_MAGIC[] = {0x31, 0x41, 0x59, 0x26, 0x53, 0x59};
+  static const uint8_t BZIP2_EOS_MAGIC[] = {0x17, 0x72, 0x45, 0x38, 0x50, 0x90};
+  const bool is_gzip = format == THdfsCompression::GZIP;
+  const uint8_t first_byte = is_gzip ? 0x1f : 'B';
+  const int64_t header_len = is_gzip ? 4 : 10;
+  for (int64_t pos = from; pos + header_len <= len; ++pos) {
+    const uint8_t* p = reinterpret_cast<const uint8_t*>(
+        memchr(buffer + pos, first_byte, len - header_len + 1 - pos));
+    if (p == nullptr) return -1;
+    pos = p - buffer;
+    if (is_gzip) {
+      if (p[1] == 0x8b && p[2] == 0x08 && (p[3] & 0xe0) == 0) return pos;
+    } else if (p[1] == 'Z' && p[2] == 'h' && p[3] >= '1' && p[3] <= '9'
+        && (memcmp(p + 4, BZIP2_BLOCK_MAGIC, sizeof(BZIP2_BLOCK_MAGIC)) == 0
+            || memcmp(p + 4, BZIP2_EOS_MAGIC, sizeof(BZIP2_EOS_MAGIC)) == 0)) {
+      return pos;
+    }
+  }
+  return -1;
+}
+
+Status HdfsTextScanner::DecompressStreams(THdfsCompression::type format,
+    const uint8_t* input, int64_t input_len, MemPool* pool,
+    vector<pair<uint8_t*, int64_t>>* output) {
+  scoped_ptr<Codec> decompressor;
+  RETURN_IF_ERROR(Codec::CreateDecompressor(pool, false, format, &decompressor));
+  bool stream_end = false;
+  Status status;
+  while (input_len > 0) {
+    int64_t input_bytes_read = 0;
+    int64_t output_len = 0;
+    uint8_t* output_buffer = nullptr;
+    status = decompressor->ProcessBlockStreaming(input_len, input, &input_bytes_read,
+        &output_len, &output_buffer, &stream_end);
+    if (!status.ok()) break;
+    if (input_bytes_read == 0 && output_len == 0) {
+      status = Status("Decompressor did not make progress");
+      break;
+    }
+    if (output_len > 0) output->emplace_back(output_buffer, output_len);
+    input += input_bytes_read;
+    input_len -= input_bytes_read;
+  }
+  if (status.ok() && !stream_end) {
+    status = Status("Compressed piece does not end at the end of a stream");
+  }
+  decompressor->Close();
+  return status;
+}
+
 HdfsTextScanner::HdfsTextScanner(HdfsScanNodeBase* scan_node, RuntimeState* state)
     : HdfsScanner(scan_node, state),
       byte_buffer_ptr_(nullptr),
@@ -97,7 +180,8 @@ HdfsTextScanner::HdfsTextScanner(HdfsScanNodeBase* scan_node, RuntimeState* stat
       batch_start_ptr_(nullptr),
       error_in_row_(false),
       partial_tuple_(nullptr),
-      parse_delimiter_timer_(nullptr) {
+      parse_delimiter_timer_(nullptr),
+      decompressed_chunks_pool_(new MemPool(scan_node->mem_tracker())) {
 }
 
 HdfsTextScanner::~HdfsTextScanner() {
@@ -197,9 +281,11 @@ void HdfsTextScanner::Close(RowBatch* row_batch) {
     decompressor_.reset();
   }
   boundary_pool_->FreeAll();
+  decompressed_chunks_.clear();
   if (row_batch != nullptr) {
     row_batch->tuple_data_pool()->AcquireData(template_tuple_pool_.get(), false);
     row_batch->tuple_data_pool()->AcquireData(data_buffer_pool_.get(), false);
+    row_batch->tuple_data_pool()->AcquireData(decompressed_chunks_pool_.get(), false);
     if (scan_node_->HasRowBatchQueue()) {
       static_cast<HdfsScanNode*>(scan_node_)->AddMaterializedRowBatch(
           unique_ptr<RowBatch>(row_batch));
@@ -207,6 +293,7 @@ void HdfsTextScanner::Close(RowBatch* row_batch) {
   } else {
     template_tuple_pool_->FreeAll();
     data_buffer_pool_->FreeAll();
+    decompressed_chunks_pool_->FreeAll();
   }
   context_->ReleaseCompletedResources(true);
 
@@ -214,6 +301,7 @@ void HdfsTextScanner::Close(RowBatch* row_batch) {
   DCHECK_EQ(template_tuple_pool_.get()->total_allocated_bytes(), 0);
   DCHECK_EQ(data_buffer_pool_.get()->total_allocated_bytes(), 0);
   DCHECK_EQ(boundary_pool_.get()->total_allocated_bytes(), 0);
+  DCHECK_EQ(decompressed_chunks_pool_.get()->total_allocated_bytes(), 0);
   if (!only_parsing_header_) {
     scan_node_->RangeComplete(THdfsFileFormat::TEXT,
         stream_->file_desc()->file_compression);
@@ -237,6 +325,12 @@ Status HdfsTextScanner::InitNewRange() {
     compression_type = THdfsCompression::DEFAULT;
   }
   RETURN_IF_ERROR(UpdateDecompressor(compression_type));
+  // Only gzip and bzip2 define how to concatenate compressed streams in one file.
+  parallel_decompression_enabled_ =
+      ExecEnv::GetInstance()->codec_offload_pool() != nullptr
+      && (compression_type == THdfsCompression::GZIP
+          || compression_type == THdfsCompression::BZIP2);
+  at_compressed_stream_start_ = true;
 
   HdfsPartitionDescriptor* hdfs_partition = context_->partition_descriptor();
   char field_delim = hdfs_partition->field_delim();
@@ -578,6 +672,7 @@ Status HdfsTextScanner::DecompressBufferStream(int64_t bytes_to_read,
     }
     DCHECK_GE(compressed_buffer_size, compressed_buffer_bytes_read);
   }
+  at_compressed_stream_start_ = stream_end;
   // Skip the bytes in stream_ that were decompressed.
   Status status;
   if (!stream_->SkipBytes(compressed_buffer_bytes_read, &status)) {
@@ -600,13 +695,40 @@ Status HdfsTextScanner::DecompressBufferStream(int64_t bytes_to_read,
 }
 
 Status HdfsTextScanner::FillByteBufferCompressedStream(MemPool* pool, bool* eosr) {
+  // Hand out the rest of the output of the last parallel decompression round first.
+  if (!decompressed_chunks_.empty()) {
+    TakeDecompressedChunk(eosr);
+    return Status::OK();
+  }
+
   // We're about to create a new decompression buffer (if we can't reuse). Attach the
   // memory from previous decompression rounds to 'pool'.
   if (!decompressor_->reuse_output_buffer()) {
     if (pool != nullptr) {
       pool->AcquireData(data_buffer_pool_.get(), false);
+      pool->AcquireData(decompressed_chunks_pool_.get(), false);
     } else {
       data_buffer_pool_->FreeAll();
+      decompressed_chunks_pool_->FreeAll();
+    }
+  } else {
+    // The parsed output is not referenced by returned batches.
+    decompressed_chunks_pool_->FreeAll();
+  }
+
+  if (parallel_decompression_enabled_ && at_compressed_stream_start_) {
+    bool decompressed;
+    RETURN_IF_ERROR(DecompressBufferStreamParallel(&decompressed));
+    if (decompressed && !decompressed_chunks_.empty()) {
+      TakeDecompressedChunk(eosr);
+      return Status::OK();
+    }
+    if (decompressed && stream_->eosr()) {
+      // The streams at the end of the file were empty.
+      byte_buffer_read_size_ = 0;
+      *eosr = true;
+      context_->ReleaseCompletedResources(true);
+      return Status::OK();
     }
   }
 
@@ -639,6 +761,118 @@ Status HdfsTextScanner::FillByteBufferCompressedStream(MemPool* pool, bool* eosr
   return Status::OK();
 }
 
+Status HdfsTextScanner::DecompressBufferStreamParallel(bool* decompressed) {
+  DCHECK(at_compressed_stream_start_);
+  DCHECK(decompressed_chunks_.empty());
+  *decompressed = false;
+  CallableThreadPool* thread_pool = ExecEnv::GetInstance()->codec_offload_pool();
+  DCHECK(thread_pool != nullptr);
+  THdfsCompression::type format = stream_->file_desc()->file_compression;
+
+  uint8_t* buffer;
+  int64_t buffer_len;
+  RETURN_IF_ERROR(stream_->GetBuffer(true, &buffer, &buffer_len));
+  // If the buffer reaches the end of the file, its end is the end of the last stream.
+  bool reaches_end = buffer_len == stream_->bytes_left();
+  if (scan_node_->mem_tracker()->SpareCapacity(MemLimit::SOFT)
+      < buffer_len * PARALLEL_DECOMPRESSION_EXPECTED_RATIO) {
+    // Decompress this buffer a chunk at a time on this thread instead.
+    COUNTER_ADD(num_buffers_not_decompressed_in_parallel_counter_, 1);
+    return Status::OK();
+  }
+
+  // Split the buffer into about one piece per decompression thread plus one for this
+  // thread. Each piece ends where the next one starts.
+  int64_t target_piece_len = max(MIN_PARALLEL_DECOMPRESSION_PIECE_SIZE,
+      buffer_len / (FLAGS_codec_offload_threads + 1));
+  vector<int64_t> piece_starts = {0};
+  while (true) {
+    int64_t next_start = FindCompressedStreamStart(
+        format, buffer, buffer_len, piece_starts.back() + target_piece_len);
+    if (next_start == -1) break;
+    piece_starts.push_back(next_start);
+  }
+  // Without a known end, the data after the last stream start is left in 'stream_'.
+  int64_t end = reaches_end ? buffer_len : piece_starts.back();
+  if (!reaches_end) piece_starts.pop_back();
+  if (piece_starts.size() < 2) return Status::OK();
+
+  vector<shared_ptr<DecompressionPiece>> pieces;
+  for (int i = 0; i < piece_starts.size(); ++i) {
+    int64_t piece_end = i + 1 < piece_starts.size() ? piece_starts[i + 1] : end;
+    shared_ptr<DecompressionPiece> piece =
+        make_shared<DecompressionPiece>(scan_node_->mem_tracker());
+    piece->input = buffer + piece_starts[i];
+    piece->input_len = piece_end - piece_starts[i];
+    pieces.push_back(move(piece));
+  }
+  auto decompress_fn = [this, format](DecompressionPiece* piece) {
+    Status status;
+    {
+      SCOPED_TIMER(async_decompress_timer_);
+      status = DecompressStreams(format, piece->input, piece->input_len, &piece->pool,
+          &piece->output);
+    }
+    COUNTER_ADD(num_pieces_decompressed_async_counter_, 1);
+    piece->status.Set(status);
+  };
+  // Pieces that don't fit into the pool's queue are decompressed on this thread, as is
+  // the first piece.
+  vector<DecompressionPiece*> local_pieces = {pieces[0].get()};
+  for (int i = 1; i < pieces.size(); ++i) {
+    shared_ptr<DecompressionPiece> piece = pieces[i];
+    auto task = [decompress_fn, piece]() { decompress_fn(piece.get()); };
+    if (!thread_pool->Offer(move(task), 0)) local_pieces.push_back(piece.get());
+  }
+  for (DecompressionPiece* piece : local_pieces) {
+    SCOPED_TIMER(decompress_timer_);
+    piece->status.Set(DecompressStreams(format, piece->input, piece->input_len,
+        &piece->pool, &piece->output));
+  }
+  Status status;
+  {
+    SCOPED_TIMER(async_decompress_wait_timer_);
+    for (const shared_ptr<DecompressionPiece>& piece : pieces) {
+      Status piece_status = piece->status.Get();
+      if (status.ok()) status = piece_status;
+    }
+  }
+
+  if (!status.ok()) {
+    // The split points were not all stream boundaries, the data is corrupt or memory ran
+    // out. Leave the buffer to the sequential decompressor, which reports errors with
+    // more context. Only a bad split point disables parallel decompression for the rest
+    // of the scan range.
+    VLOG_FILE << "Could not decompress " << stream_->filename() << " in parallel at "
+              << "offset " << stream_->file_offset() << ": " << status.GetDetail();
+    for (const shared_ptr<DecompressionPiece>& piece : pieces) piece->pool.FreeAll();
+    COUNTER_ADD(num_buffers_not_decompressed_in_parallel_counter_, 1);
+    if (!status.IsMemLimitExceeded()) parallel_decompression_enabled_ = false;
+    return Status::OK();
+  }
+  for (const shared_ptr<DecompressionPiece>& piece : pieces) {
+    decompressed_chunks_.insert(
+        decompressed_chunks_.end(), piece->output.begin(), piece->output.end());
+    decompressed_chunks_pool_->AcquireData(&piece->pool, false);
+  }
+  Status skip_status;
+  if (!stream_->SkipBytes(end, &skip_status)) {
+    DCHECK(!skip_status.ok());
+    return skip_status;
+  }
+  *decompressed = true;
+  return Status::OK();
+}
+
+void HdfsTextScanner::TakeDecompressedChunk(bool* eosr) {
+  DCHECK(!decompressed_chunks_.empty());
+  byte_buffer_ptr_ = reinterpret_cast<char*>(decompressed_chunks_.front().first);
+  byte_buffer_read_size_ = decompressed_chunks_.front().second;
+  decompressed_chunks_.pop_front();
+  *eosr = decompressed_chunks_.empty() && stream_->eosr();
+  if (*eosr) context_->ReleaseCompletedResources(true);
+}
+
 Status HdfsTextScanner::FillByteBufferCompressedFile(bool* eosr) {
   // For other compressed text: attempt to read and decompress the entire file, point
   // to the decompressed buffer, and then continue normal processing.
@@ -809,6 +1043,17 @@ Status HdfsTextScanner::Open(ScannerContext* context) {
   RETURN_IF_ERROR(HdfsScanner::Open(context));
 
   parse_delimiter_timer_ = ADD_TIMER(scan_node_->runtime_profile(), "DelimiterParseTime");
+  if (ExecEnv::GetInstance()->codec_offload_pool() != nullptr) {
+    num_pieces_decompressed_async_counter_ = ADD_COUNTER(
+        scan_node_->runtime_profile(), "NumTextPiecesDecompressedAsync", TUnit::UNIT);
+    async_decompress_timer_ =
+        ADD_TIMER(scan_node_->runtime_profile(), "AsyncDecompressionTime");
+    async_decompress_wait_timer_ =
+        ADD_TIMER(scan_node_->runtime_profile(), "AsyncDecompressionWaitTime");
+    num_buffers_not_decompressed_in_parallel_counter_ = ADD_COUNTER(
+        scan_node_->runtime_profile(), "NumTextBuffersNotDecompressedInParallel",
+        TUnit::UNIT);
+  }
 
   // Allocate the scratch space for two pass parsing.  The most fields we can go
   // through in one parse pass is the batch size (tuples) * the number of fields per tuple
@@ -19,6 +19,9 @@
 #ifndef IMPALA_EXEC_HDFS_TEXT_SCANNER_H
 #define IMPALA_EXEC_HDFS_TEXT_SCANNER_H
 
+#include <deque>
+#include <utility>
+
 #include "exec/hdfs-scanner.h"
 #include "runtime/string-buffer.h"
 #include "util/runtime-profile-counters.h"
@@ -117,6 +120,8 @@ class HdfsTextScanner : public HdfsScanner {
   bool only_parsing_header_;
 
  private:
+  friend class HdfsTextScannerTest;
+
   const static int NEXT_BLOCK_READ_SIZE = 64 * 1024; //bytes
 
   /// The text scanner transitions through these states exactly in order.
@@ -198,6 +203,40 @@ class HdfsTextScanner : public HdfsScanner {
   Status DecompressBufferStream(int64_t bytes_to_read, uint8_t** decompressed_buffer,
       int64_t* decompressed_len, bool *eosr) WARN_UNUSED_RESULT;
 
+  /// A piece of the compressed data of a multi-stream file that starts and ends at
+  /// compressed stream boundaries. Defined in the .cc file.
+  struct DecompressionPiece;
+
+  /// Returns the offset of the first position at or after 'from' in 'buffer' that looks
+  /// like the start of a gzip member or a bzip2 stream, depending on 'format', or -1 if
+  /// there is none. The match may be a false positive inside compressed data.
+  static int64_t FindCompressedStreamStart(THdfsCompression::type format,
+      const uint8_t* buffer, int64_t len, int64_t from);
+
+  /// Decompresses the 'input_len' bytes at 'input' with a decompressor of its own and
+  /// appends the decompressed chunks, allocated from 'pool', to 'output'. Fails if the
+  /// input does not consist of complete compressed streams. Thread-safe.
+  static Status DecompressStreams(THdfsCompression::type format, const uint8_t* input,
+      int64_t input_len, MemPool* pool,
+      std::vector<std::pair<uint8_t*, int64_t>>* output) WARN_UNUSED_RESULT;
+
+  /// Used by FillByteBufferCompressedStream() to decompress the next buffer of 'stream_'
+  /// in parallel on the codec offload pool. The buffer is split into pieces at the
+  /// starts of gzip members or bzip2 streams, which are decompressed independently. A
+  /// piece that does not end exactly at the end of a compressed stream means that a
+  /// split point was a false positive. Parallel decompression is then disabled for the
+  /// rest of the scan range and the buffer is left to the sequential decompressor. The
+  /// buffer is also left to the sequential decompressor if the memory limit leaves too
+  /// little room for the output of all pieces or memory runs out while decompressing.
+  /// On success, skips the decompressed bytes in 'stream_', queues the decompressed
+  /// output in 'decompressed_chunks_' and sets 'decompressed' to true. Sets it to false
+  /// if the buffer was not decompressed in parallel.
+  Status DecompressBufferStreamParallel(bool* decompressed) WARN_UNUSED_RESULT;
+
+  /// Points the byte buffer to the next chunk in 'decompressed_chunks_' and sets 'eosr'
+  /// if it was the last chunk of the scan range.
+  void TakeDecompressedChunk(bool* eosr);
+
   /// Checks if the current buffer ends with a row delimiter spanning this and the next
   /// buffer (i.e. a "\r\n" delimiter). Does not modify byte_buffer_ptr_, etc. Always
   /// returns false if the table's row delimiter is not '\n'. This can only be called
@@ -280,6 +319,34 @@ class HdfsTextScanner : public HdfsScanner {
 
   /// Time parsing text files
   RuntimeProfile::Counter* parse_delimiter_timer_;
+
+  /// True if the file is gzip or bzip2 compressed and the codec offload pool is
+  /// enabled. Reset to false if the file turns out not to be split at stream boundaries.
+  bool parallel_decompression_enabled_ = false;
+
+  /// True if the sequential decompressor is at the start of a compressed stream, i.e.
+  /// the input it consumed so far ended exactly at the end of a stream. Parallel
+  /// decompression only starts at stream boundaries.
+  bool at_compressed_stream_start_ = true;
+
+  /// Output of the last parallel decompression round that was not handed out to the
+  /// parser yet, in file order. The memory is owned by 'decompressed_chunks_pool_'.
+  std::deque<std::pair<uint8_t*, int64_t>> decompressed_chunks_;
+
+  /// Holds the output of the last parallel decompression round until all of it has been
+  /// parsed. Then it is attached to the output batch or freed, like the buffers in
+  /// 'data_buffer_pool_'.
+  boost::scoped_ptr<MemPool> decompressed_chunks_pool_;
+
+  /// Number of compressed pieces decompressed on the codec offload pool, time
+  /// spent decompressing them and time the scanner thread waited for them.
+  RuntimeProfile::Counter* num_pieces_decompressed_async_counter_ = nullptr;
+  RuntimeProfile::Counter* async_decompress_timer_ = nullptr;
+  RuntimeProfile::Counter* async_decompress_wait_timer_ = nullptr;
+
+  /// Number of buffers at compressed stream boundaries that were decompressed
+  /// sequentially because memory was short or they could not be split.
+  RuntimeProfile::Counter* num_buffers_not_decompressed_in_parallel_counter_ = nullptr;
 };
 
 }
@@ -17,6 +17,8 @@
 
 #include "exec/kudu-scanner.h"
 
+#include <algorithm>
+#include <limits>
 #include <string>
 #include <vector>
 #include <kudu/client/row_result.h>
@@ -63,11 +65,30 @@ DEFINE_string(kudu_read_mode, "READ_LATEST", "(Advanced) Sets the Kudu scan Read
 DEFINE_int32(kudu_scanner_keep_alive_period_sec, 15,
     "The period at which Kudu Scanners should send keep-alive requests to the tablet "
     "server to ensure that scanners do not time out.");
+DEFINE_bool(kudu_scan_columnar_layout, false, "(Advanced) If true, Kudu scanners fetch "
+    "batches in Kudu's columnar layout and materialize tuples a column at a time. If "
+    "false, batches are fetched row-wise in Kudu's tuple-compatible row layout.");
 
 DECLARE_int32(kudu_operation_timeout_ms);
 
 namespace impala {
 
+/// Returns true if the bit of row 'idx' is set in the Kudu non-null bitmap 'bitmap'.
+static inline bool IsKuduValueNonNull(const uint8_t* bitmap, int idx) {
+  return (bitmap[idx >> 3] >> (idx & 7)) & 1;
+}
+
+/// Copies 'num_rows' values of SLOT_SIZE bytes from the Kudu column data 'src' into the
+/// slot at 'dst' of consecutive tuples of 'tuple_byte_size' bytes.
+template <int SLOT_SIZE>
+static void CopyFixedLengthColumn(
+    const uint8_t* src, int num_rows, int tuple_byte_size, uint8_t* dst) {
+  for (int i = 0; i < num_rows; ++i) {
+    memcpy(dst, src, SLOT_SIZE);
+    src += SLOT_SIZE;
+    dst += tuple_byte_size;
+  }
+}
 
 KuduScanner::KuduScanner(KuduScanNodeBase* scan_node, RuntimeState* state)
   : scan_node_(scan_node),
@@ -87,6 +108,21 @@ Status KuduScanner::Open() {
       varchar_slots_.push_back(slot);
     }
   }
+  // The count(*) optimization and empty projections don't read any column data, so
+  // there is nothing to gain from the columnar layout.
+  use_columnar_layout_ = FLAGS_kudu_scan_columnar_layout
+      && !scan_node_->optimize_count_star() && !scan_node_->tuple_desc()->slots().empty();
+  if (use_columnar_layout_) {
+    // The frontend projects the Kudu columns in the order of the slots' tuple offsets.
+    projected_slots_ = scan_node_->tuple_desc()->slots();
+    sort(projected_slots_.begin(), projected_slots_.end(),
+        [](const SlotDescriptor* a, const SlotDescriptor* b) {
+          return a->tuple_offset() < b->tuple_offset();
+        });
+    for (const SlotDescriptor* slot : projected_slots_) {
+      if (slot->type().IsVarLenStringType()) string_slots_.push_back(slot);
+    }
+  }
   return ScalarExprEvaluator::Clone(&obj_pool_, state_, expr_perm_pool_.get(),
       expr_results_pool_.get(), scan_node_->conjunct_evals(), &conjunct_evals_);
 }
@@ -117,7 +153,7 @@ Status KuduScanner::GetNextWithCountStarOptimization(RowBatch* row_batch, bool*
     RETURN_IF_CANCELLED(state_);
     RETURN_IF_ERROR(GetNextScannerBatch());
 
-    cur_kudu_batch_num_read_ = static_cast<int64_t>(cur_kudu_batch_.NumRows());
+    cur_kudu_batch_num_read_ = static_cast<int64_t>(CurBatchNumRows());
     counter += cur_kudu_batch_num_read_;
   }
   *eos = true;
@@ -159,8 +195,12 @@ Status KuduScanner::GetNext(RowBatch* row_batch, bool* eos) {
   while (!*eos) {
     RETURN_IF_CANCELLED(state_);
 
-    if (cur_kudu_batch_num_read_ < cur_kudu_batch_.NumRows()) {
-      RETURN_IF_ERROR(DecodeRowsIntoRowBatch(row_batch, &tuple));
+    if (cur_kudu_batch_num_read_ < CurBatchNumRows()) {
+      if (use_columnar_layout_) {
+        RETURN_IF_ERROR(DecodeColumnarRowsIntoRowBatch(row_batch, &tuple));
+      } else {
+        RETURN_IF_ERROR(DecodeRowsIntoRowBatch(row_batch, &tuple));
+      }
       if (row_batch->AtCapacity()) break;
     }
 
@@ -215,7 +255,21 @@ Status KuduScanner::OpenNextScanToken(const string& scan_token, bool* eos) {
            << " node with id=" << scan_node_->id()
            << " Kudu table=" << scan_node_->table_desc()->table_name();
 
-  if (!timestamp_slots_.empty()) {
+  if (use_columnar_layout_) {
+    // Timestamps are converted while copying them out of the columnar batch, so no
+    // padding is needed.
+    KUDU_RETURN_IF_ERROR(
+        scanner_->SetRowFormatFlags(kudu::client::KuduScanner::COLUMNAR_LAYOUT),
+        BuildErrorString("Could not request the columnar layout"));
+    // Kudu only returns a non-null bitmap for nullable columns, which is not the same
+    // as the slot being nullable.
+    KuduSchema projection = scanner_->GetProjectionSchema();
+    DCHECK_EQ(projection.num_columns(), projected_slots_.size());
+    projected_col_nullable_.clear();
+    for (int i = 0; i < projection.num_columns(); ++i) {
+      projected_col_nullable_.push_back(projection.Column(i).is_nullable());
+    }
+  } else if (!timestamp_slots_.empty()) {
     uint64_t row_format_flags =
         kudu::client::KuduScanner::PAD_UNIXTIME_MICROS_TO_16_BYTES;
     scanner_->SetRowFormatFlags(row_format_flags);
@@ -316,7 +370,7 @@ void KuduScanner::CloseCurrentClientScanner() {
 }
 
 Status KuduScanner::HandleEmptyProjection(RowBatch* row_batch) {
-  int num_rows_remaining = cur_kudu_batch_.NumRows() - cur_kudu_batch_num_read_;
+  int num_rows_remaining = CurBatchNumRows() - cur_kudu_batch_num_read_;
   int rows_to_add = std::min(row_batch->capacity() - row_batch->num_rows(),
       num_rows_remaining);
   int num_to_commit = 0;
@@ -426,14 +480,193 @@ Status KuduScanner::DecodeRowsIntoRowBatch(RowBatch* row_batch, Tuple** tuple_me
   return state_->GetQueryStatus();
 }
 
+Status KuduScanner::DecodeColumnarRowsIntoRowBatch(
+    RowBatch* row_batch, Tuple** tuple_mem) {
+  const TupleDescriptor* tuple_desc = scan_node_->tuple_desc();
+  const int tuple_byte_size = tuple_desc->byte_size();
+  const int start = cur_kudu_batch_num_read_;
+  const int num_rows = std::min(row_batch->capacity() - row_batch->num_rows(),
+      cur_kudu_columnar_batch_.NumRows() - start);
+  uint8_t* first_tuple = reinterpret_cast<uint8_t*>(*tuple_mem);
+
+  // Materialize all rows into the free part of the tuple buffer a column at a time.
+  // Zeroing the tuples up front clears their null indicators.
+  memset(first_tuple, 0, static_cast<int64_t>(num_rows) * tuple_byte_size);
+  for (int col_idx = 0; col_idx < projected_slots_.size(); ++col_idx) {
+    RETURN_IF_ERROR(MaterializeColumn(col_idx, projected_slots_[col_idx], start,
+        num_rows, first_tuple));
+  }
+
+  // Evaluate the conjuncts that haven't been pushed down to Kudu and move the surviving
+  // tuples to the front of the materialized range.
+  bool has_conjuncts = !conjunct_evals_.empty();
+  uint8_t* dst_tuple = first_tuple;
+  for (int i = 0; i < num_rows; ++i) {
+    Tuple* tuple = reinterpret_cast<Tuple*>(first_tuple + i * tuple_byte_size);
+    ++cur_kudu_batch_num_read_;
+    if (has_conjuncts && !ExecNode::EvalConjuncts(conjunct_evals_.data(),
+            conjunct_evals_.size(), reinterpret_cast<TupleRow*>(&tuple))) {
+      continue;
+    }
+    if (reinterpret_cast<uint8_t*>(tuple) != dst_tuple) {
+      memcpy(dst_tuple, tuple, tuple_byte_size);
+    }
+    TupleRow* row = row_batch->GetRow(row_batch->AddRow());
+    row->SetTuple(0, reinterpret_cast<Tuple*>(dst_tuple));
+    row_batch->CommitLastRow();
+    dst_tuple += tuple_byte_size;
+    if (scan_node_->ReachedLimitShared()) break;
+  }
+  // Like DecodeRowsIntoRowBatch(), only copy the string data of the surviving tuples.
+  int num_survivors = (dst_tuple - first_tuple) / tuple_byte_size;
+  RETURN_IF_ERROR(
+      CopyStringData(first_tuple, num_survivors, row_batch->tuple_data_pool()));
+  *tuple_mem = reinterpret_cast<Tuple*>(dst_tuple);
+  expr_results_pool_->Clear();
+
+  // Check the status in case an error status was set during conjunct evaluation.
+  return state_->GetQueryStatus();
+}
+
+Status KuduScanner::MaterializeColumn(int col_idx, const SlotDescriptor* slot,
+    int start, int num_rows, uint8_t* first_tuple) {
+  const int tuple_byte_size = scan_node_->tuple_desc()->byte_size();
+  const uint8_t* non_null_bitmap = nullptr;
+  if (projected_col_nullable_[col_idx]) {
+    DCHECK(slot->is_nullable());
+    kudu::Slice bitmap;
+    KUDU_RETURN_IF_ERROR(
+        cur_kudu_columnar_batch_.GetNonNullBitmapForColumn(col_idx, &bitmap),
+        BuildErrorString("Unable to get the non-null bitmap of a column"));
+    non_null_bitmap = bitmap.data();
+  }
+  uint8_t* dst = first_tuple + slot->tuple_offset();
+
+  switch (slot->type().type) {
+    case TYPE_STRING:
+    case TYPE_VARCHAR: {
+      kudu::Slice offsets_slice;
+      kudu::Slice data;
+      KUDU_RETURN_IF_ERROR(cur_kudu_columnar_batch_.GetVariableLengthColumn(
+          col_idx, &offsets_slice, &data),
+          BuildErrorString("Unable to get the data of a column"));
+      const uint32_t* offsets =
+          reinterpret_cast<const uint32_t*>(offsets_slice.data()) + start;
+      // The string values point into the batch until CopyStringData() copies the values
+      // of the tuples that pass the conjuncts.
+      char* values = const_cast<char*>(reinterpret_cast<const char*>(data.data()));
+      // Kudu limits VARCHAR values by characters, Impala by bytes. See the comment in
+      // DecodeRowsIntoRowBatch().
+      int max_len = slot->type().type == TYPE_VARCHAR ?
+          slot->type().len : std::numeric_limits<int>::max();
+      for (int i = 0; i < num_rows; ++i) {
+        StringValue* sv = reinterpret_cast<StringValue*>(dst);
+        sv->ptr = values + offsets[i];
+        sv->len = std::min<int>(offsets[i + 1] - offsets[i], max_len);
+        dst += tuple_byte_size;
+      }
+      break;
+    }
+    case TYPE_TIMESTAMP: {
+      kudu::Slice data;
+      KUDU_RETURN_IF_ERROR(cur_kudu_columnar_batch_.GetFixedLengthColumn(col_idx, &data),
+          BuildErrorString("Unable to get the data of a column"));
+      const int64_t* micros = reinterpret_cast<const int64_t*>(data.data()) + start;
+      for (int i = 0; i < num_rows; ++i, dst += tuple_byte_size) {
+        if (non_null_bitmap != nullptr
+            && !IsKuduValueNonNull(non_null_bitmap, start + i)) {
+          continue;
+        }
+        TimestampValue tv = TimestampValue::UtcFromUnixTimeMicros(micros[i]);
+        if (LIKELY(tv.HasDateAndTime())) {
+          *reinterpret_cast<TimestampValue*>(dst) = tv;
+        } else {
+          Tuple* tuple = reinterpret_cast<Tuple*>(dst - slot->tuple_offset());
+          tuple->SetNull(slot->null_indicator_offset());
+          RETURN_IF_ERROR(state_->LogOrReturnError(
+              ErrorMsg::Init(TErrorCode::KUDU_TIMESTAMP_OUT_OF_RANGE,
+                scan_node_->table_desc()->table_name(),
+                scanner_->GetKuduTable()->schema().Column(slot->col_pos()).name())));
+        }
+      }
+      break;
+    }
+    default: {
+      // All other types have the same fixed-length representation in Kudu and Impala.
+      kudu::Slice data;
+      KUDU_RETURN_IF_ERROR(cur_kudu_columnar_batch_.GetFixedLengthColumn(col_idx, &data),
+          BuildErrorString("Unable to get the data of a column"));
+      int slot_size = slot->type().GetSlotSize();
+      const uint8_t* src = data.data() + static_cast<int64_t>(start) * slot_size;
+      switch (slot_size) {
+        case 1: CopyFixedLengthColumn<1>(src, num_rows, tuple_byte_size, dst); break;
+        case 2: CopyFixedLengthColumn<2>(src, num_rows, tuple_byte_size, dst); break;
+        case 4: CopyFixedLengthColumn<4>(src, num_rows, tuple_byte_size, dst); break;
+        case 8: CopyFixedLengthColumn<8>(src, num_rows, tuple_byte_size, dst); break;
+        case 16: CopyFixedLengthColumn<16>(src, num_rows, tuple_byte_size, dst); break;
+        default: {
+          string msg = Substitute(
+              "Unsupported type $0 in columnar scan", slot->type().DebugString());
+          return Status(BuildErrorString(msg.c_str()));
+        }
+      }
+      break;
+    }
+  }
+
+  if (non_null_bitmap != nullptr) {
+    for (int i = 0; i < num_rows; ++i) {
+      if (!IsKuduValueNonNull(non_null_bitmap, start + i)) {
+        reinterpret_cast<Tuple*>(first_tuple + i * tuple_byte_size)
+            ->SetNull(slot->null_indicator_offset());
+      }
+    }
+  }
+  return Status::OK();
+}
+
+Status KuduScanner::CopyStringData(uint8_t* first_tuple, int num_tuples, MemPool* pool) {
+  if (string_slots_.empty() || num_tuples == 0) return Status::OK();
+  const int tuple_byte_size = scan_node_->tuple_desc()->byte_size();
+  int64_t total_len = 0;
+  for (int i = 0; i < num_tuples; ++i) {
+    Tuple* tuple = reinterpret_cast<Tuple*>(first_tuple + i * tuple_byte_size);
+    for (const SlotDescriptor* slot : string_slots_) {
+      total_len += tuple->GetStringSlot(slot->tuple_offset())->len;
+    }
+  }
+  if (total_len == 0) return Status::OK();
+  char* buffer = reinterpret_cast<char*>(pool->TryAllocateUnaligned(total_len));
+  if (UNLIKELY(buffer == nullptr)) {
+    return pool->mem_tracker()->MemLimitExceeded(state_,
+        "Failed to allocate memory for Kudu string data", total_len);
+  }
+  for (int i = 0; i < num_tuples; ++i) {
+    Tuple* tuple = reinterpret_cast<Tuple*>(first_tuple + i * tuple_byte_size);
+    for (const SlotDescriptor* slot : string_slots_) {
+      StringValue* sv = tuple->GetStringSlot(slot->tuple_offset());
+      if (sv->len == 0) continue;
+      memcpy(buffer, sv->ptr, sv->len);
+      sv->ptr = buffer;
+      buffer += sv->len;
+    }
+  }
+  return Status::OK();
+}
+
 Status KuduScanner::GetNextScannerBatch() {
   SCOPED_TIMER2(state_->total_storage_wait_timer(), scan_node_->kudu_client_time());
   int64_t now = MonotonicMicros();
-  KUDU_RETURN_IF_ERROR(scanner_->NextBatch(&cur_kudu_batch_),
-      BuildErrorString("Unable to advance iterator"));
+  if (use_columnar_layout_) {
+    KUDU_RETURN_IF_ERROR(scanner_->NextBatch(&cur_kudu_columnar_batch_),
+        BuildErrorString("Unable to advance iterator"));
+  } else {
+    KUDU_RETURN_IF_ERROR(scanner_->NextBatch(&cur_kudu_batch_),
+        BuildErrorString("Unable to advance iterator"));
+  }
   COUNTER_ADD(scan_node_->kudu_round_trips(), 1);
   cur_kudu_batch_num_read_ = 0;
-  COUNTER_ADD(scan_node_->rows_read_counter(), cur_kudu_batch_.NumRows());
+  COUNTER_ADD(scan_node_->rows_read_counter(), CurBatchNumRows());
   last_alive_time_micros_ = now;
   return Status::OK();
 }
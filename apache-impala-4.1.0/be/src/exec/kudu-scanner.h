@@ -20,6 +20,7 @@
 
 #include <boost/scoped_ptr.hpp>
 #include <kudu/client/client.h>
+#include <kudu/client/columnar_scan_batch.h>
 
 #include "common/object-pool.h"
 #include "exec/kudu-scan-node-base.h"
@@ -82,6 +83,30 @@ class KuduScanner {
   ///  - scan_node_ limit has been reached
   Status DecodeRowsIntoRowBatch(RowBatch* batch, Tuple** tuple_mem);
 
+  /// Same as DecodeRowsIntoRowBatch() but for batches fetched in Kudu's columnar layout
+  /// into 'cur_kudu_columnar_batch_'. Rows are materialized into the tuple buffer a
+  /// column at a time, then the conjuncts are evaluated and the surviving tuples are
+  /// compacted to the front.
+  Status DecodeColumnarRowsIntoRowBatch(RowBatch* batch, Tuple** tuple_mem);
+
+  /// Materializes rows ['start', 'start' + 'num_rows') of projected column 'col_idx' of
+  /// 'cur_kudu_columnar_batch_' into 'slot' of the consecutive tuples starting at
+  /// 'first_tuple'. String values point into 'cur_kudu_columnar_batch_'.
+  Status MaterializeColumn(int col_idx, const SlotDescriptor* slot, int start,
+      int num_rows, uint8_t* first_tuple);
+
+  /// Copies the string data of the 'num_tuples' consecutive tuples starting at
+  /// 'first_tuple' into 'pool' with a single allocation and points their string slots
+  /// to the copy.
+  Status CopyStringData(uint8_t* first_tuple, int num_tuples, MemPool* pool);
+
+  /// Returns the number of rows in the current batch, in whichever layout it was
+  /// fetched.
+  int CurBatchNumRows() const {
+    return use_columnar_layout_ ? cur_kudu_columnar_batch_.NumRows() :
+                                  cur_kudu_batch_.NumRows();
+  }
+
   /// Fetches the next batch of rows from the current kudu::client::KuduScanner.
   Status GetNextScannerBatch();
 
@@ -118,7 +143,26 @@ class KuduScanner {
   /// The current batch of retrieved rows.
   kudu::client::KuduScanBatch cur_kudu_batch_;
 
-  /// The number of rows already read from cur_kudu_batch_.
+  /// True if batches are fetched in Kudu's columnar layout into
+  /// 'cur_kudu_columnar_batch_' instead of row-wise into 'cur_kudu_batch_'. Set in Open()
+  /// from --kudu_scan_columnar_layout.
+  bool use_columnar_layout_ = false;
+
+  /// The current batch of retrieved rows if 'use_columnar_layout_' is true.
+  kudu::client::KuduColumnarScanBatch cur_kudu_columnar_batch_;
+
+  /// The materialized slots in the order of the projected Kudu columns, i.e. ordered by
+  /// tuple offset. Only populated if 'use_columnar_layout_' is true.
+  vector<const SlotDescriptor*> projected_slots_;
+
+  /// Whether the Kudu column of each slot in 'projected_slots_' is nullable. Set for each
+  /// scan token from the projection schema of 'scanner_'.
+  vector<bool> projected_col_nullable_;
+
+  /// The STRING and VARCHAR slots in 'projected_slots_'.
+  vector<const SlotDescriptor*> string_slots_;
+
+  /// The number of rows already read from the current batch.
   int cur_kudu_batch_num_read_;
 
   /// The last time a keepalive request or successful RPC was sent.
@@ -17,6 +17,7 @@
 
 #include "exec/orc-column-readers.h"
 
+#include <algorithm>
 #include <queue>
 
 #include "runtime/collection-value-builder.h"
@@ -191,6 +192,7 @@ Status OrcStringColumnReader::InitBlob(orc::DataBuffer<char>* blob, MemPool* poo
 
 Status OrcStringColumnReader::ReadValueBatch(int row_idx,
     ScratchTupleBatch* scratch_batch, MemPool* pool, int scratch_batch_idx) {
+  RETURN_IF_ERROR(EnsureBlob());
   switch (slot_desc_->type().type) {
     case TYPE_STRING:
       if (batch_->isEncoded) {
@@ -219,6 +221,7 @@ Status OrcStringColumnReader::ReadValueBatch(int row_idx,
 }
 
 Status OrcStringColumnReader::ReadValue(int row_idx, Tuple* tuple, MemPool* pool) {
+  RETURN_IF_ERROR(EnsureBlob());
   switch (slot_desc_->type().type) {
     case TYPE_STRING:
       if (batch_->isEncoded) {
@@ -507,6 +510,66 @@ Status OrcStructReader::ReadValue(int row_idx, Tuple* tuple, MemPool* pool) {
 
 Status OrcStructReader::TopLevelReadValueBatch(ScratchTupleBatch* scratch_batch,
     MemPool* pool) {
+  return TopLevelReadValueBatch(scratch_batch, pool, children_);
+}
+
+bool OrcStructReader::DivideFilterAndNonFilterChildren(
+    const vector<SlotId>& conjunct_slot_ids) {
+  filter_children_.clear();
+  non_filter_children_.clear();
+  if (!materialize_tuple_) return false;
+  for (OrcColumnReader* child : children_) {
+    const SlotDescriptor* slot_desc = child->slot_desc_;
+    if (child->IsComplexColumnReader() || slot_desc == nullptr ||
+        std::find(conjunct_slot_ids.begin(), conjunct_slot_ids.end(), slot_desc->id())
+            != conjunct_slot_ids.end()) {
+      filter_children_.push_back(child);
+    } else {
+      non_filter_children_.push_back(child);
+    }
+  }
+  return !filter_children_.empty() && !non_filter_children_.empty();
+}
+
+Status OrcStructReader::TopLevelReadFilterValueBatch(ScratchTupleBatch* scratch_batch,
+    MemPool* pool) {
+  DCHECK(!filter_children_.empty());
+  filter_batch_row_idx_ = row_idx_;
+  return TopLevelReadValueBatch(scratch_batch, pool, filter_children_);
+}
+
+Status OrcStructReader::TopLevelReadNonFilterValueBatch(ScratchTupleBatch* scratch_batch,
+    MemPool* pool, const ScratchMicroBatch* micro_batches, int num_micro_batches) {
+  DCHECK(!non_filter_children_.empty());
+  // Column readers read as many values as fit into the scratch batch. Limit the
+  // capacity to the end of each micro batch so that only its rows are read and restore
+  // the state of the scratch batch afterwards.
+  const int capacity = scratch_batch->capacity;
+  const int num_tuples = scratch_batch->num_tuples;
+  Status status;
+  for (OrcColumnReader* child : non_filter_children_) {
+    for (int i = 0; i < num_micro_batches && status.ok(); ++i) {
+      const ScratchMicroBatch& micro_batch = micro_batches[i];
+      DCHECK_LT(micro_batch.end, num_tuples);
+      scratch_batch->capacity = micro_batch.end + 1;
+      status = child->ReadValueBatch(filter_batch_row_idx_ + micro_batch.start,
+          scratch_batch, pool, micro_batch.start);
+      if (status.ok() && scratch_batch->num_tuples != micro_batch.end + 1) {
+        status = Status(Substitute("Corrupt ORC file '$0': Expected $1 items in col "
+            "'$2' starting at row $3, found $4", scanner_->filename(), micro_batch.length,
+            child->orc_column_id_, filter_batch_row_idx_ + micro_batch.start,
+            scratch_batch->num_tuples - micro_batch.start));
+      }
+    }
+    if (!status.ok()) break;
+  }
+  scratch_batch->capacity = capacity;
+  scratch_batch->num_tuples = num_tuples;
+  return status;
+}
+
+Status OrcStructReader::TopLevelReadValueBatch(ScratchTupleBatch* scratch_batch,
+    MemPool* pool, const vector<OrcColumnReader*>& children) {
   // Validate row batch if needed.
   if (row_validator_) DCHECK(scanner_->row_batches_need_validation_);
   if (row_validator_ && !row_validator_->IsRowBatchValid()) {
@@ -517,7 +580,7 @@ Status OrcStructReader::TopLevelReadValueBatch(ScratchTupleBatch* scratch_batch,
   // update it.
   int scratch_batch_idx = scratch_batch->num_tuples;
   int item_count = -1;
-  for (OrcColumnReader* child : children_) {
+  for (OrcColumnReader* child : children) {
     RETURN_IF_ERROR(
         child->ReadValueBatch(row_idx_, scratch_batch, pool, scratch_batch_idx));
     // Check if each column reader reads the same amount of values.
@@ -529,7 +592,7 @@ Status OrcStructReader::TopLevelReadValueBatch(ScratchTupleBatch* scratch_batch,
     }
   }
   int num_rows_read = scratch_batch->num_tuples - scratch_batch_idx;
-  if (children_.empty()) {
+  if (children.empty()) {
     // We allow empty 'children_' for original files, because we might select the
     // synthetic 'rowid' field which is not present in original files.
     // We also allow empty 'children_' when we need to validate row batches of a zero slot
@@ -230,6 +230,45 @@ class OrcPrimitiveColumnReader : public OrcBatchedReader<Final> {
     if (final->batch_ == nullptr) return 0;
     return final->batch_->numElements;
   }
+
+ protected:
+  /// Implementation of ReadValueBatch() for readers of fixed-width slots whose values
+  /// can be assigned from the 'data' array of the reader's batch as is. Writes the
+  /// values straight into the slots of the scratch batch instead of going through
+  /// ReadValue() for every row, and skips the per-row NULL check if the batch has no
+  /// NULLs.
+  template <typename T>
+  Status ReadFixedWidthValueBatch(int row_idx, ScratchTupleBatch* scratch_batch,
+      int scratch_batch_idx) WARN_UNUSED_RESULT {
+    const Final* final = this->GetFinal();
+    int num_to_read = std::min<int>(scratch_batch->capacity - scratch_batch_idx,
+        final->NumElements() - row_idx);
+    DCHECK_LE(row_idx + num_to_read, final->NumElements());
+    const auto* orc_batch = DCHECK_NOTNULL(final->batch_);
+    const int tuple_size = OrcColumnReader::scanner_->tuple_byte_size();
+    const int slot_offset = OrcColumnReader::slot_desc_->tuple_offset();
+    const NullIndicatorOffset& null_offset =
+        OrcColumnReader::slot_desc_->null_indicator_offset();
+    const auto* values = orc_batch->data.data() + row_idx;
+    uint8_t* tuple_mem = scratch_batch->tuple_mem + scratch_batch_idx * tuple_size;
+    if (!orc_batch->hasNulls) {
+      for (int i = 0; i < num_to_read; ++i) {
+        *reinterpret_cast<T*>(tuple_mem + i * tuple_size + slot_offset) = values[i];
+      }
+    } else {
+      const char* not_null = orc_batch->notNull.data() + row_idx;
+      for (int i = 0; i < num_to_read; ++i) {
+        uint8_t* tuple = tuple_mem + i * tuple_size;
+        if (not_null[i]) {
+          *reinterpret_cast<T*>(tuple + slot_offset) = values[i];
+        } else {
+          reinterpret_cast<Tuple*>(tuple)->SetNull(null_offset);
+        }
+      }
+    }
+    scratch_batch->num_tuples = scratch_batch_idx + num_to_read;
+    return Status::OK();
+  }
 };
 
 class OrcBoolColumnReader : public OrcPrimitiveColumnReader<OrcBoolColumnReader> {
@@ -248,6 +287,11 @@ class OrcBoolColumnReader : public OrcPrimitiveColumnReader<OrcBoolColumnReader>
   }
 
   Status ReadValue(int row_idx, Tuple* tuple, MemPool* pool) final WARN_UNUSED_RESULT;
+
+  Status ReadValueBatch(int row_idx, ScratchTupleBatch* scratch_batch, MemPool* pool,
+      int scratch_batch_idx) override WARN_UNUSED_RESULT {
+    return ReadFixedWidthValueBatch<bool>(row_idx, scratch_batch, scratch_batch_idx);
+  }
  private:
   friend class OrcPrimitiveColumnReader<OrcBoolColumnReader>;
 
@@ -279,6 +323,12 @@ class OrcIntColumnReader : public OrcPrimitiveColumnReader<OrcIntColumnReader<T>
     return Status::OK();
   }
 
+  Status ReadValueBatch(int row_idx, ScratchTupleBatch* scratch_batch, MemPool* pool,
+      int scratch_batch_idx) override WARN_UNUSED_RESULT {
+    return this->template ReadFixedWidthValueBatch<T>(
+        row_idx, scratch_batch, scratch_batch_idx);
+  }
+
  private:
   friend class OrcPrimitiveColumnReader<OrcIntColumnReader<T>>;
 
@@ -310,6 +360,12 @@ class OrcDoubleColumnReader : public OrcPrimitiveColumnReader<OrcDoubleColumnRea
     return Status::OK();
   }
 
+  Status ReadValueBatch(int row_idx, ScratchTupleBatch* scratch_batch, MemPool* pool,
+      int scratch_batch_idx) override WARN_UNUSED_RESULT {
+    return this->template ReadFixedWidthValueBatch<T>(
+        row_idx, scratch_batch, scratch_batch_idx);
+  }
+
  private:
   friend class OrcPrimitiveColumnReader<OrcDoubleColumnReader<T>>;
 
@@ -327,13 +383,24 @@ class OrcStringColumnReader : public OrcPrimitiveColumnReader<OrcStringColumnRea
   Status UpdateInputBatch(orc::ColumnVectorBatch* orc_batch) override WARN_UNUSED_RESULT {
     batch_ = static_cast<orc::StringVectorBatch*>(orc_batch);
     if (orc_batch == nullptr) return Status::OK();
+    if (slot_desc_->type().type == TYPE_CHAR) {
+      // CHAR values are copied into the tuple, so they can be read straight from the
+      // buffers of the ORC batch, which stay valid until the next batch is read.
+      blob_ = orc_batch->isEncoded ?
+          static_cast<orc::EncodedStringVectorBatch*>(batch_)->dictionary->
+              dictionaryBlob.data() :
+          batch_->blob.data();
+      return Status::OK();
+    }
     // We update the blob of a non-encoded batch every time, but since the dictionary blob
     // is the same for the stripe, we only reset it for every new stripe.
     // Note that this is possible since the encoding should be the same for every batch
     // through the whole stripe.
     if(!orc_batch->isEncoded) {
       DCHECK(batch_ == dynamic_cast<orc::StringVectorBatch*>(orc_batch));
-      return InitBlob(&batch_->blob, scanner_->data_batch_pool_.get());
+      // The blob is copied by EnsureBlob() when the first value is read.
+      blob_ = nullptr;
+      return Status::OK();
     }
     DCHECK(static_cast<orc::EncodedStringVectorBatch*>(batch_) ==
         dynamic_cast<orc::EncodedStringVectorBatch*>(orc_batch));
@@ -372,7 +439,7 @@ class OrcStringColumnReader : public OrcPrimitiveColumnReader<OrcStringColumnRea
 
   orc::StringVectorBatch* batch_ = nullptr;
   // We copy the blob from the batch, so the memory will be handled by Impala, and not
-  // by the ORC lib.
+  // by the ORC lib. Points into the batch itself for CHAR slots.
   char* blob_ = nullptr;
 
   // We cache the last stripe so we know when we have to update the blob (in case of
@@ -383,6 +450,15 @@ class OrcStringColumnReader : public OrcPrimitiveColumnReader<OrcStringColumnRea
   /// Unfortunately, this cannot be done in UpdateInputBatch, since we do not have
   /// access to the pool there.
   Status InitBlob(orc::DataBuffer<char>* blob, MemPool* pool);
+
+  /// Copies the blob of a non-encoded batch if it has not been copied yet. Deferred
+  /// until values are read so that the blob is not copied at all if late
+  /// materialization filters out all rows of the batch.
+  Status EnsureBlob() {
+    if (LIKELY(blob_ != nullptr)) return Status::OK();
+    DCHECK(!batch_->isEncoded);
+    return InitBlob(&batch_->blob, scanner_->data_batch_pool_.get());
+  }
 };
 
 class OrcTimestampReader : public OrcPrimitiveColumnReader<OrcTimestampReader> {
@@ -608,6 +684,25 @@ class OrcStructReader : public OrcComplexColumnReader {
   Status TopLevelReadValueBatch(ScratchTupleBatch* scratch_batch, MemPool* pool)
       WARN_UNUSED_RESULT;
 
+  /// Divides the children of the top level reader into filter children, whose slots are
+  /// in 'conjunct_slot_ids' or that read complex types, and non-filter children. Returns
+  /// true if late materialization can be used, i.e. if both groups are non-empty.
+  /// Returns false if this reader does not materialize the top level tuples itself,
+  /// e.g. for full ACID files.
+  bool DivideFilterAndNonFilterChildren(const std::vector<SlotId>& conjunct_slot_ids);
+
+  /// Same as TopLevelReadValueBatch() but only reads the values of the filter children.
+  /// Must be followed by TopLevelReadNonFilterValueBatch() for the rows that survive
+  /// filtering.
+  Status TopLevelReadFilterValueBatch(ScratchTupleBatch* scratch_batch, MemPool* pool)
+      WARN_UNUSED_RESULT;
+
+  /// Reads the values of the non-filter children into the rows of 'scratch_batch' that
+  /// are covered by 'micro_batches'. The rows are the ones read by the preceding
+  /// TopLevelReadFilterValueBatch() call.
+  Status TopLevelReadNonFilterValueBatch(ScratchTupleBatch* scratch_batch, MemPool* pool,
+      const ScratchMicroBatch* micro_batches, int num_micro_batches) WARN_UNUSED_RESULT;
+
   Status ReadValueBatch(int row_idx, ScratchTupleBatch* scratch_batch, MemPool* pool,
       int scratch_batch_idx) override WARN_UNUSED_RESULT;
 
@@ -633,8 +728,21 @@ class OrcStructReader : public OrcComplexColumnReader {
   void FillSyntheticRowId(ScratchTupleBatch* scratch_batch, int scratch_batch_idx,
       int num_rows);
 
+  /// Implementation of TopLevelReadValueBatch() and TopLevelReadFilterValueBatch() that
+  /// reads the values of 'children'.
+  Status TopLevelReadValueBatch(ScratchTupleBatch* scratch_batch, MemPool* pool,
+      const vector<OrcColumnReader*>& children) WARN_UNUSED_RESULT;
+
   orc::StructVectorBatch* batch_ = nullptr;
 
+  /// Children divided by DivideFilterAndNonFilterChildren(). Empty if late
+  /// materialization is not used.
+  vector<OrcColumnReader*> filter_children_;
+  vector<OrcColumnReader*> non_filter_children_;
+
+  /// Row index of the first row read by the last TopLevelReadFilterValueBatch() call.
+  int filter_batch_row_idx_ = 0;
+
   /// Field ids of the children reader
   std::vector<int> children_fields_;
 
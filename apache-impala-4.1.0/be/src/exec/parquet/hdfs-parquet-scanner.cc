@@ -18,7 +18,6 @@
 #include "exec/parquet/hdfs-parquet-scanner.h"
 
 #include <algorithm>
-#include <queue>
 #include <stack>
 
 #include <gflags/gflags.h>
@@ -30,6 +29,7 @@
 #include "exec/parquet/parquet-bloom-filter-util.h"
 #include "exec/parquet/parquet-collection-column-reader.h"
 #include "exec/parquet/parquet-column-readers.h"
+#include "exec/parquet/parquet-metadata-cache.h"
 #include "exec/scanner-context.inline.h"
 #include "exec/scratch-tuple-batch.h"
 #include "exprs/literal.h"
@@ -72,15 +72,31 @@ static const string PARQUET_MEM_LIMIT_EXCEEDED =
 Status HdfsParquetScanner::IssueInitialRanges(HdfsScanNodeBase* scan_node,
     const vector<HdfsFileDesc*>& files) {
   DCHECK(!files.empty());
+  ParquetMetadataCache* metadata_cache = ExecEnv::GetInstance()->parquet_metadata_cache();
+  vector<HdfsFileDesc*> cached_files;
+  vector<HdfsFileDesc*> uncached_files;
   for (HdfsFileDesc* file : files) {
     // If the file size is less than 12 bytes, it is an invalid Parquet file.
     if (file->file_length < 12) {
       return Status(Substitute("Parquet file $0 has an invalid file length: $1",
           file->filename, file->file_length));
     }
+    if (metadata_cache->ContainsFooter(file->filename, file->mtime, file->file_length)) {
+      cached_files.push_back(file);
+    } else {
+      uncached_files.push_back(file);
+    }
+  }
+  // For files with a cached footer only the fixed size trailer needs to be read to
+  // validate the file. If the footer is evicted in the meantime, ProcessFooter() reads
+  // the rest of the metadata with a separate request.
+  if (!cached_files.empty()) {
+    RETURN_IF_ERROR(IssueFooterRanges(scan_node, THdfsFileFormat::PARQUET, cached_files,
+        sizeof(int32_t) + sizeof(PARQUET_VERSION_NUMBER)));
   }
+  if (uncached_files.empty()) return Status::OK();
   return IssueFooterRanges(
-      scan_node, THdfsFileFormat::PARQUET, files, PARQUET_FOOTER_SIZE);
+      scan_node, THdfsFileFormat::PARQUET, uncached_files, PARQUET_FOOTER_SIZE);
 }
 
 HdfsParquetScanner::HdfsParquetScanner(HdfsScanNodeBase* scan_node, RuntimeState* state)
@@ -96,6 +112,11 @@ HdfsParquetScanner::HdfsParquetScanner(HdfsScanNodeBase* scan_node, RuntimeState
     num_row_groups_counter_(nullptr),
     num_minmax_filtered_pages_counter_(nullptr),
     num_dict_filtered_row_groups_counter_(nullptr),
+    num_footer_cache_hits_counter_(nullptr),
+    num_page_index_cache_hits_counter_(nullptr),
+    num_pages_decompressed_async_counter_(nullptr),
+    async_decompress_timer_(nullptr),
+    async_decompress_wait_timer_(nullptr),
     parquet_compressed_page_size_counter_(nullptr),
     parquet_uncompressed_page_size_counter_(nullptr),
     coll_items_read_counter_(0),
@@ -136,6 +157,16 @@ Status HdfsParquetScanner::Open(ScannerContext* context) {
           TUnit::UNIT);
   num_dict_filtered_row_groups_counter_ =
       ADD_COUNTER(scan_node_->runtime_profile(), "NumDictFilteredRowGroups", TUnit::UNIT);
+  num_footer_cache_hits_counter_ =
+      ADD_COUNTER(scan_node_->runtime_profile(), "NumFooterCacheHits", TUnit::UNIT);
+  num_page_index_cache_hits_counter_ =
+      ADD_COUNTER(scan_node_->runtime_profile(), "NumPageIndexCacheHits", TUnit::UNIT);
+  num_pages_decompressed_async_counter_ = ADD_COUNTER(
+      scan_node_->runtime_profile(), "NumPagesDecompressedAsync", TUnit::UNIT);
+  async_decompress_timer_ =
+      ADD_TIMER(scan_node_->runtime_profile(), "AsyncDecompressionTime");
+  async_decompress_wait_timer_ =
+      ADD_TIMER(scan_node_->runtime_profile(), "AsyncDecompressionWaitTime");
   parquet_compressed_page_size_counter_ = ADD_SUMMARY_STATS_COUNTER(
       scan_node_->runtime_profile(), "ParquetCompressedPageSize", TUnit::BYTES);
   parquet_uncompressed_page_size_counter_ = ADD_SUMMARY_STATS_COUNTER(
@@ -228,6 +259,15 @@ Status HdfsParquetScanner::Open(ScannerContext* context) {
   }
   DivideFilterAndNonFilterColumnReaders(column_readers_, &filter_readers_,
       &non_filter_readers_);
+  if (!filter_readers_.empty() && late_materialization_threshold_ >= 0
+      && filter_readers_[0]->max_rep_level() == 0) {
+    // With late materialization the non-filter columns skip the pages of rejected rows
+    // without reading their data. Don't decompress their pages ahead of time.
+    for (ParquetColumnReader* col_reader : non_filter_readers_) {
+      if (col_reader->IsCollectionReader()) continue;
+      static_cast<BaseScalarColumnReader*>(col_reader)->set_page_prefetch_enabled(false);
+    }
+  }
   return Status::OK();
 }
 
@@ -255,21 +295,6 @@ void HdfsParquetScanner::DivideFilterAndNonFilterColumnReaders(
   }
 }
 
-void HdfsParquetScanner::InitSlotIdsForConjuncts() {
-  conjunct_slot_ids_.reserve(scan_node_->conjuncts().size() +
-    scan_node_->filter_exprs().size());
-  vector<ScalarExpr*> conjuncts;
-  conjuncts.reserve(scan_node_->conjuncts().size() +
-    scan_node_->filter_exprs().size());
-  conjuncts.insert(std::end(conjuncts), std::begin(scan_node_->conjuncts()),
-      std::end(scan_node_->conjuncts()));
-  conjuncts.insert(std::end(conjuncts), std::begin(scan_node_->filter_exprs()),
-      std::end(scan_node_->filter_exprs()));
-  for (int conjunct_idx = 0; conjunct_idx < conjuncts.size(); ++conjunct_idx) {
-    conjuncts[conjunct_idx]->GetSlotIds(&conjunct_slot_ids_);
-  }
-}
-
 void HdfsParquetScanner::Close(RowBatch* row_batch) {
   DCHECK(!is_closed_);
   if (row_batch != nullptr) {
@@ -1698,6 +1723,19 @@ Status HdfsParquetScanner::InitDictFilterStructures() {
       dict_filter_tuple_map_[tuple_desc] = reinterpret_cast<Tuple*>(buffer);
     }
   }
+
+  // Let top-level columns with dictionary filter conjuncts reject rows by their
+  // dictionary codes while decoding values.
+  if (!state_->query_options().parquet_dictionary_code_filtering) return Status::OK();
+  for (BaseScalarColumnReader* col_reader : dict_filterable_readers_) {
+    if (col_reader->max_rep_level() > 0) continue;
+    const SlotDescriptor* slot_desc = col_reader->slot_desc();
+    if (slot_desc->parent()->byte_size() == 0) continue;
+    auto dict_filter_it = dict_filter_map_.find(slot_desc->id());
+    if (dict_filter_it == dict_filter_map_.end()) continue;
+    col_reader->SetDictCodeFilter(&dict_filter_it->second);
+    scratch_batch_->EnableDictFilter();
+  }
   return Status::OK();
 }
 
@@ -2629,6 +2667,18 @@ Status HdfsParquetScanner::ProcessFooter() {
   }
   uint8_t* metadata_ptr = metadata_size_ptr - metadata_size;
 
+  // Use the cached copy of the footer if there is one. The cache key includes the
+  // file's length and modification time, so the entry matches the file being read.
+  ParquetMetadataCache* metadata_cache = ExecEnv::GetInstance()->parquet_metadata_cache();
+  const HdfsFileDesc* stream_file_desc = stream_->file_desc();
+  shared_ptr<const parquet::FileMetaData> cached_metadata = metadata_cache->LookupFooter(
+      stream_file_desc->filename, stream_file_desc->mtime, file_len);
+  if (cached_metadata != nullptr) {
+    COUNTER_ADD(num_footer_cache_hits_counter_, 1);
+    file_metadata_ = *cached_metadata;
+    return ValidateFileMetadata();
+  }
+
   // If the metadata was too big, we need to read it into a contiguous buffer before
   // deserializing it.
   ScopedBuffer metadata_buffer(scan_node_->mem_tracker());
@@ -2663,6 +2713,15 @@ Status HdfsParquetScanner::ProcessFooter() {
         status.GetDetail()));
   }
 
+  RETURN_IF_ERROR(ValidateFileMetadata());
+  if (metadata_cache->enabled()) {
+    metadata_cache->InsertFooter(stream_file_desc->filename, stream_file_desc->mtime,
+        file_len, make_shared<parquet::FileMetaData>(file_metadata_), metadata_size);
+  }
+  return Status::OK();
+}
+
+Status HdfsParquetScanner::ValidateFileMetadata() {
   RETURN_IF_ERROR(ParquetMetadataUtils::ValidateFileVersion(file_metadata_, filename()));
 
   // IMPALA-3943: Do not throw an error for empty files for backwards compatibility.
@@ -2803,34 +2862,28 @@ Status HdfsParquetScanner::CreateCountingReader(const SchemaPath& parent_path,
   DCHECK(parent_path.empty() || parent_node->is_repeated());
 
   if (!parent_node->children.empty()) {
-    // Find a non-struct (i.e. collection or scalar) child of 'parent_node', which we will
-    // use to create the item reader
-    const SchemaNode* target_node = &parent_node->children[0];
-    while (!target_node->children.empty() && !target_node->is_repeated()) {
-      target_node = &target_node->children[0];
+    // Prefer a scalar descendant that is not nested in another collection: its levels
+    // map one-to-one to the items of 'parent_node', so counting them only needs a single
+    // column. With wide structs this avoids reading a nested collection (and the levels
+    // of its scalar child) just to count the outer items.
+    const SchemaNode* target_node = FindCheapestScalarDescendant(*parent_node, true);
+    if (target_node == nullptr) {
+      // Every scalar descendant is nested in a collection. Find a non-struct (i.e.
+      // collection or scalar) child of 'parent_node', which we will use to create the
+      // item reader
+      target_node = &parent_node->children[0];
+      while (!target_node->children.empty() && !target_node->is_repeated()) {
+        target_node = &target_node->children[0];
+      }
     }
 
     *reader = ParquetColumnReader::Create(
         *target_node, target_node->is_repeated(), nullptr, this);
     if (target_node->is_repeated()) {
-      // Find the closest scalar descendant of 'target_node' via breadth-first search, and
-      // create scalar reader to drive 'reader'. We find the closest (i.e. least-nested)
-      // descendant as a heuristic for picking a descendant with fewer values, so it's
-      // faster to scan.
-      // TODO: use different heuristic than least-nested? Fewest values?
-      const SchemaNode* node = nullptr;
-      queue<const SchemaNode*> nodes;
-      nodes.push(target_node);
-      while (!nodes.empty()) {
-        node = nodes.front();
-        nodes.pop();
-        if (node->children.size() > 0) {
-          for (const SchemaNode& child: node->children) nodes.push(&child);
-        } else {
-          // node is the least-nested scalar descendant of 'target_node'
-          break;
-        }
-      }
+      // Create a scalar reader for the cheapest descendant of 'target_node' to drive
+      // 'reader'.
+      const SchemaNode* node = FindCheapestScalarDescendant(*target_node, false);
+      DCHECK(node != nullptr);
       DCHECK(node->children.empty()) << node->DebugString();
       CollectionColumnReader* parent_reader =
           static_cast<CollectionColumnReader*>(*reader);
@@ -2846,6 +2899,47 @@ Status HdfsParquetScanner::CreateCountingReader(const SchemaPath& parent_path,
   return Status::OK();
 }
 
+const SchemaNode* HdfsParquetScanner::FindCheapestScalarDescendant(
+    const SchemaNode& node, bool skip_repeated) const {
+  if (node.children.empty()) return &node;
+  // Breadth-first search, one nesting level at a time. The least-nested scalar
+  // descendants are the ones with the fewest levels to decode. Among those, pick the one
+  // whose column chunks are the smallest in the file.
+  vector<const SchemaNode*> level(1, &node);
+  vector<const SchemaNode*> next_level;
+  while (!level.empty()) {
+    const SchemaNode* cheapest = nullptr;
+    int64_t cheapest_size = 0;
+    for (const SchemaNode* parent : level) {
+      for (const SchemaNode& child : parent->children) {
+        if (skip_repeated && child.is_repeated()) continue;
+        if (!child.children.empty()) {
+          next_level.push_back(&child);
+          continue;
+        }
+        int64_t size = ColumnChunksSize(child.col_idx);
+        if (cheapest == nullptr || size < cheapest_size) {
+          cheapest = &child;
+          cheapest_size = size;
+        }
+      }
+    }
+    if (cheapest != nullptr) return cheapest;
+    level.swap(next_level);
+    next_level.clear();
+  }
+  return nullptr;
+}
+
+int64_t HdfsParquetScanner::ColumnChunksSize(int col_idx) const {
+  int64_t size = 0;
+  for (const parquet::RowGroup& row_group : file_metadata_.row_groups) {
+    if (col_idx < 0 || col_idx >= row_group.columns.size()) continue;
+    size += row_group.columns[col_idx].meta_data.total_compressed_size;
+  }
+  return size;
+}
+
 void HdfsParquetScanner::InitCollectionColumns() {
   for (CollectionColumnReader* col_reader: collection_readers_) {
     col_reader->Reset();
@@ -479,9 +479,6 @@ class HdfsParquetScanner : public HdfsColumnarScanner {
   /// Mapping from Parquet column indexes to scalar readers.
   std::unordered_map<int, BaseScalarColumnReader*> scalar_reader_map_;
 
-  /// List of slot ids used by conjuncts and runtime filters.
-  std::vector<SlotId> conjunct_slot_ids_;
-
   /// Memory used to store the tuples used for dictionary filtering. Tuples owned by
   /// perm_pool_.
   std::unordered_map<const TupleDescriptor*, Tuple*> dict_filter_tuple_map_;
@@ -529,6 +526,19 @@ class HdfsParquetScanner : public HdfsColumnarScanner {
   /// and runtime bloom filters on the dictionary entries.
   RuntimeProfile::Counter* num_dict_filtered_row_groups_counter_;
 
+  /// Number of file footers and row group page indexes served from the
+  /// ParquetMetadataCache instead of being read from storage.
+  RuntimeProfile::Counter* num_footer_cache_hits_counter_;
+  RuntimeProfile::Counter* num_page_index_cache_hits_counter_;
+
+  /// Number of data pages decompressed ahead of time on the codec offload pool,
+  /// the total time spent decompressing them there and the time scanner threads spent
+  /// waiting for them. The difference between the two timers is decompression time that
+  /// overlapped with decoding.
+  RuntimeProfile::Counter* num_pages_decompressed_async_counter_;
+  RuntimeProfile::Counter* async_decompress_timer_;
+  RuntimeProfile::Counter* async_decompress_wait_timer_;
+
   /// Tracks the size of any compressed pages read. If no compressed pages are read, this
   /// counter is empty
   RuntimeProfile::SummaryStatsCounter* parquet_compressed_page_size_counter_;
@@ -774,9 +784,15 @@ class HdfsParquetScanner : public HdfsColumnarScanner {
       bool materialize_tuple, MemPool* pool, Tuple* tuple) const;
 
   /// Process the file footer and parse file_metadata_.  This should be called with the
-  /// last PARQUET_FOOTER_SIZE bytes in context_.
+  /// last PARQUET_FOOTER_SIZE bytes in context_, or only the fixed size trailer if the
+  /// footer was found in the ParquetMetadataCache when the ranges were issued. Uses the
+  /// cached footer if possible and adds newly parsed footers to the cache.
   Status ProcessFooter() WARN_UNUSED_RESULT;
 
+  /// Validates the version, row count and row groups of 'file_metadata_' and parses
+  /// 'file_version_'. Called by ProcessFooter() for both parsed and cached footers.
+  Status ValidateFileMetadata() WARN_UNUSED_RESULT;
+
   /// Populates 'column_readers' for the slots in 'tuple_desc', including creating child
   /// readers for any collections. Schema resolution is handled in this function as
   /// well. Fills in the appropriate template tuple slot with NULL for any materialized
@@ -803,6 +819,18 @@ class HdfsParquetScanner : public HdfsColumnarScanner {
       ParquetColumnReader** reader)
       WARN_UNUSED_RESULT;
 
+  /// Returns the scalar descendant of 'node' that is cheapest to read for counting the
+  /// values of 'node', or 'node' itself if it is a scalar. The least-nested descendants
+  /// are preferred, and among them the one with the smallest column chunks in the file.
+  /// If 'skip_repeated' is true, descendants below a repeated node are not considered.
+  /// Returns nullptr if there is no such descendant.
+  const SchemaNode* FindCheapestScalarDescendant(
+      const SchemaNode& node, bool skip_repeated) const;
+
+  /// Returns the total compressed size of the chunks of column 'col_idx' in all row
+  /// groups of the file.
+  int64_t ColumnChunksSize(int col_idx) const;
+
   /// Walks file_metadata_ and initiates reading the materialized columns.  This
   /// initializes 'scalar_readers_' and divides reservation between the columns but
   /// does not start any scan ranges.
@@ -849,7 +877,8 @@ class HdfsParquetScanner : public HdfsColumnarScanner {
 
   /// Divides the column readers into dict_filterable_readers_,
   /// non_dict_filterable_readers_ and collection_readers_. Allocates memory for
-  /// dict_filter_tuple_map_.
+  /// dict_filter_tuple_map_. Enables dictionary code filtering for the eligible
+  /// readers if PARQUET_DICTIONARY_CODE_FILTERING is set.
   Status InitDictFilterStructures() WARN_UNUSED_RESULT;
 
   /// Returns true if all of the data pages in the column chunk are dictionary encoded
@@ -900,9 +929,6 @@ class HdfsParquetScanner : public HdfsColumnarScanner {
   /// uncompressed page size. Called by ParquetColumnReader for each page read.
   void UpdateUncompressedPageSizeCounter(int64_t uncompressed_page_size);
 
-  /// Initialize 'conjunct_slot_ids_' with the SlotIds used in the conjuncts.
-  void InitSlotIdsForConjuncts();
-
   /// Fill 'micro_batches' with the data read by 'column_readers'.
   /// Micro batches are sub ranges in 0..num_tuples-1 which needs to be read.
   /// Tuple memory to write to is specified by 'scratch_batch->tuple_mem'.
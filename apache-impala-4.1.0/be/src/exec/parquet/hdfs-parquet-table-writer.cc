@@ -30,6 +30,7 @@
 #include "rpc/thrift-util.h"
 #include "runtime/date-value.h"
 #include "runtime/decimal-value.h"
+#include "runtime/exec-env.h"
 #include "runtime/mem-tracker.h"
 #include "runtime/raw-value.h"
 #include "runtime/row-batch.h"
@@ -45,8 +46,10 @@
 #include "util/hdfs-util.h"
 #include "util/parquet-bloom-filter.h"
 #include "util/pretty-printer.h"
+#include "util/promise.h"
 #include "util/rle-encoding.h"
 #include "util/string-util.h"
+#include "util/thread-pool.h"
 
 #include <sstream>
 #include <string>
@@ -144,12 +147,15 @@ class HdfsParquetTableWriter::BaseColumnWriter {
     values_buffer_ = parent_->reusable_col_mem_pool_->Allocate(values_buffer_len_);
   }
 
-  virtual ~BaseColumnWriter() {}
+  virtual ~BaseColumnWriter() { DiscardPendingCompression(); }
 
   // Called after the constructor to initialize the column writer.
   Status Init() WARN_UNUSED_RESULT {
     Reset();
     RETURN_IF_ERROR(Codec::CreateCompressor(nullptr, false, codec_info_, &compressor_));
+    if (compressor_.get() != nullptr) {
+      compression_pool_ = ExecEnv::GetInstance()->codec_offload_pool();
+    }
     return Status::OK();
   }
 
@@ -193,11 +199,13 @@ class HdfsParquetTableWriter::BaseColumnWriter {
   // Any data for previous row groups must be reset (e.g. dictionaries).
   // Subclasses must call this if they override this function.
   virtual void Reset() {
+    DCHECK(pending_compression_ == nullptr);
     num_values_ = 0;
     total_compressed_byte_size_ = 0;
     current_encoding_ = parquet::Encoding::PLAIN;
     next_page_encoding_ = parquet::Encoding::PLAIN;
     pages_.clear();
+    compressed_page_buffers_.clear();
     current_page_ = nullptr;
     column_encodings_.clear();
     dict_encoding_stats_.clear();
@@ -218,6 +226,8 @@ class HdfsParquetTableWriter::BaseColumnWriter {
   // Close this writer. This is only called after Flush() and no more rows will
   // be added.
   void Close() {
+    DiscardPendingCompression();
+    compressed_page_buffers_.clear();
     if (compressor_.get() != nullptr) compressor_->Close();
     if (dict_encoder_base_ != nullptr) dict_encoder_base_->Close();
     // We must release the memory consumption of this column writer.
@@ -324,6 +334,30 @@ class HdfsParquetTableWriter::BaseColumnWriter {
   // Update current_page_ to a new page, reusing pages allocated if possible.
   void NewPage();
 
+  // Adds the size of the finalized and compressed page with 'header' to the column and
+  // file size totals.
+  Status AddPageSize(const parquet::PageHeader& header) WARN_UNUSED_RESULT;
+
+  struct PendingCompression;
+
+  // Hands 'compression', which holds the uncompressed data of the current page, to
+  // 'compression_pool_'. Returns false if the pool's queue is full, in which case the
+  // caller must compress the page itself.
+  bool StartPageCompression(const std::shared_ptr<PendingCompression>& compression);
+
+  // Compresses the page of 'compression' and sets its status. Runs on a thread of
+  // 'compression_pool_'.
+  void CompressPage(PendingCompression* compression);
+  Status CompressPageInternal(PendingCompression* compression) WARN_UNUSED_RESULT;
+
+  // Waits for the page that is being compressed on 'compression_pool_', if any, and
+  // completes its page header and the size totals. Must be called before
+  // 'compressor_' is used again and before the pages are written.
+  Status WaitForPendingCompression() WARN_UNUSED_RESULT;
+
+  // Waits for the page that is being compressed, if any, and drops the result.
+  void DiscardPendingCompression();
+
   // Writes out the dictionary encoded data buffered in dict_encoder_.
   void WriteDictDataPage();
 
@@ -347,6 +381,28 @@ class HdfsParquetTableWriter::BaseColumnWriter {
     int num_non_null;
   };
 
+  // A data page that is compressed on 'compression_pool_'. Shared between the sink
+  // thread and the helper thread.
+  struct PendingCompression {
+    PendingCompression(MemTracker* mem_tracker)
+      : uncompressed_buffer(mem_tracker),
+        compressed_buffer(new ScopedBuffer(mem_tracker)) {}
+
+    // Index of the page in 'pages_'.
+    int page_idx = -1;
+
+    // The definition levels and values of the page. Released once it is compressed.
+    ScopedBuffer uncompressed_buffer;
+    int uncompressed_size = 0;
+
+    // The compressed page. Moved to 'compressed_page_buffers_' by the sink thread.
+    std::unique_ptr<ScopedBuffer> compressed_buffer;
+    int compressed_size = 0;
+
+    // Set by the helper thread once the page is compressed or compression failed.
+    Promise<Status> status;
+  };
+
   HdfsParquetTableWriter* parent_;
   ScalarExprEvaluator* expr_eval_;
 
@@ -356,6 +412,20 @@ class HdfsParquetTableWriter::BaseColumnWriter {
   // compressed.
   scoped_ptr<Codec> compressor_;
 
+  // Pool that compresses data pages off the sink thread. nullptr if the column is not
+  // compressed or --codec_offload_threads is 0. Pages of a column are compressed
+  // one at a time since they share 'compressor_', but pages of different columns are
+  // compressed in parallel.
+  CallableThreadPool* compression_pool_ = nullptr;
+
+  // The page that is currently being compressed on 'compression_pool_', if any. Its
+  // header and data are filled in by WaitForPendingCompression().
+  std::shared_ptr<PendingCompression> pending_compression_;
+
+  // Buffers holding the data of pages compressed on 'compression_pool_'. Released
+  // after the row group has been written.
+  vector<std::unique_ptr<ScopedBuffer>> compressed_page_buffers_;
+
   // Size of newly created PLAIN encoded pages. Defaults to DEFAULT_DATA_PAGE_SIZE or to
   // the value of 'write.parquet.page-size-bytes' table property for Iceberg tables.
   // Its value is increased when pages are not big enough. This only happens when there
@@ -974,6 +1044,7 @@ Status HdfsParquetTableWriter::BaseColumnWriter::Flush(int64_t* file_pos,
   }
 
   RETURN_IF_ERROR(FinalizeCurrentPage());
+  RETURN_IF_ERROR(WaitForPendingCompression());
 
   *first_dictionary_page = -1;
   // First write the dictionary page before any of the data pages.
@@ -1114,14 +1185,29 @@ Status HdfsParquetTableWriter::BaseColumnWriter::FinalizeCurrentPage() {
 
   // At this point we know all the data for the data page.  Combine them into one buffer.
   uint8_t* uncompressed_data = nullptr;
+  shared_ptr<PendingCompression> compression;
   if (compressor_.get() == nullptr) {
     uncompressed_data =
         parent_->per_file_mem_pool_->Allocate(header.uncompressed_page_size);
   } else {
-    // We have compression.  Combine into the staging buffer.
-    parent_->compression_staging_buffer_.resize(
-        header.uncompressed_page_size);
-    uncompressed_data = &parent_->compression_staging_buffer_[0];
+    // The previous page must be done before 'compressor_' can be used again.
+    RETURN_IF_ERROR(WaitForPendingCompression());
+    if (compression_pool_ != nullptr) {
+      // Combine into a buffer owned by the page so that the page can be compressed on
+      // another thread. If that fails, fall back to the staging buffer.
+      compression = make_shared<PendingCompression>(table_sink_mem_tracker_);
+      if (compression->uncompressed_buffer.TryAllocate(header.uncompressed_page_size)) {
+        uncompressed_data = compression->uncompressed_buffer.buffer();
+      } else {
+        compression.reset();
+      }
+    }
+    if (uncompressed_data == nullptr) {
+      // We have compression.  Combine into the staging buffer.
+      parent_->compression_staging_buffer_.resize(
+          header.uncompressed_page_size);
+      uncompressed_data = &parent_->compression_staging_buffer_[0];
+    }
   }
 
   BufferBuilder buffer(uncompressed_data, header.uncompressed_page_size);
@@ -1135,10 +1221,17 @@ Status HdfsParquetTableWriter::BaseColumnWriter::FinalizeCurrentPage() {
   buffer.Append(values_buffer_, buffer.capacity() - buffer.size());
 
   // Apply compression if necessary
+  bool compression_pending = false;
   if (compressor_.get() == nullptr) {
     current_page_->data = uncompressed_data;
     header.compressed_page_size = header.uncompressed_page_size;
+  } else if (compression != nullptr && StartPageCompression(compression)) {
+    compression_pending = true;
+    COUNTER_ADD(parent_->parent_->num_pages_compressed_async_counter(), 1);
   } else {
+    if (compression_pool_ != nullptr) {
+      COUNTER_ADD(parent_->parent_->num_pages_not_compressed_async_counter(), 1);
+    }
     SCOPED_TIMER(parent_->parent_->compress_timer());
     int64_t max_compressed_size =
         compressor_->MaxOutputLen(header.uncompressed_page_size);
@@ -1168,20 +1261,116 @@ Status HdfsParquetTableWriter::BaseColumnWriter::FinalizeCurrentPage() {
   RETURN_IF_ERROR(row_group_stats_base_->MaterializeStringValuesToInternalBuffers());
   row_group_stats_base_->Merge(*page_stats_base_);
 
+  current_page_->finalized = true;
+  def_levels_->Clear();
+  if (compression_pending) {
+    // The compressed size is not known yet. Count the page with its uncompressed size
+    // until WaitForPendingCompression() replaces it, which errs on the side of
+    // starting a new file too early rather than too late.
+    parent_->file_size_estimate_ += header.uncompressed_page_size;
+    return Status::OK();
+  }
+  return AddPageSize(header);
+}
+
+Status HdfsParquetTableWriter::BaseColumnWriter::AddPageSize(
+    const parquet::PageHeader& header) {
   // Add the size of the data page header
   uint8_t* header_buffer;
   uint32_t header_len = 0;
   RETURN_IF_ERROR(parent_->thrift_serializer_->SerializeToBuffer(
-      &current_page_->header, &header_len, &header_buffer));
+      &header, &header_len, &header_buffer));
 
-  current_page_->finalized = true;
   total_compressed_byte_size_ += header_len + header.compressed_page_size;
   total_uncompressed_byte_size_ += header_len + header.uncompressed_page_size;
   parent_->file_size_estimate_ += header_len + header.compressed_page_size;
-  def_levels_->Clear();
   return Status::OK();
 }
 
+bool HdfsParquetTableWriter::BaseColumnWriter::StartPageCompression(
+    const shared_ptr<PendingCompression>& compression) {
+  DCHECK(pending_compression_ == nullptr);
+  DCHECK(compression_pool_ != nullptr);
+  compression->page_idx = current_page_ - pages_.data();
+  compression->uncompressed_size = current_page_->header.uncompressed_page_size;
+  // The lambda holds a reference to 'compression' so that it stays alive even if the
+  // writer is torn down while the page is compressed. The column writer itself waits
+  // for the page before it is destroyed.
+  if (!compression_pool_->Offer(
+          [this, compression]() { CompressPage(compression.get()); }, 0)) {
+    return false;
+  }
+  pending_compression_ = compression;
+  return true;
+}
+
+void HdfsParquetTableWriter::BaseColumnWriter::CompressPage(
+    PendingCompression* compression) {
+  Status status;
+  {
+    SCOPED_TIMER(parent_->parent_->compress_timer());
+    status = CompressPageInternal(compression);
+  }
+  compression->uncompressed_buffer.Release();
+  compression->status.Set(status);
+}
+
+Status HdfsParquetTableWriter::BaseColumnWriter::CompressPageInternal(
+    PendingCompression* compression) {
+  int64_t max_compressed_size = compressor_->MaxOutputLen(compression->uncompressed_size);
+  DCHECK_GT(max_compressed_size, 0);
+  ScopedBuffer output(table_sink_mem_tracker_);
+  if (UNLIKELY(!output.TryAllocate(max_compressed_size))) {
+    string details = Substitute(PARQUET_MEM_LIMIT_EXCEEDED,
+        "BaseColumnWriter::CompressPage", max_compressed_size, "compressed data page");
+    return table_sink_mem_tracker_->MemLimitExceeded(
+        parent_->state_, details, max_compressed_size);
+  }
+  uint8_t* compressed_data = output.buffer();
+  int compressed_size = max_compressed_size;
+  const Status& status = compressor_->ProcessBlock32(true,
+      compression->uncompressed_size, compression->uncompressed_buffer.buffer(),
+      &compressed_size, &compressed_data);
+  if (!status.ok()) {
+    return Status(Substitute("Error writing parquet file '$0' column '$1': $2",
+        parent_->output_->current_file_name, column_name(), status.GetDetail()));
+  }
+  // The page is kept until the row group is written. Copy it into a buffer of the
+  // exact size instead of holding on to the worst case allocation.
+  if (UNLIKELY(!compression->compressed_buffer->TryAllocate(compressed_size))) {
+    string details = Substitute(PARQUET_MEM_LIMIT_EXCEEDED,
+        "BaseColumnWriter::CompressPage", compressed_size, "compressed data page");
+    return table_sink_mem_tracker_->MemLimitExceeded(
+        parent_->state_, details, compressed_size);
+  }
+  memcpy(compression->compressed_buffer->buffer(), compressed_data, compressed_size);
+  compression->compressed_size = compressed_size;
+  return Status::OK();
+}
+
+Status HdfsParquetTableWriter::BaseColumnWriter::WaitForPendingCompression() {
+  if (pending_compression_ == nullptr) return Status::OK();
+  shared_ptr<PendingCompression> compression = move(pending_compression_);
+  Status status;
+  {
+    SCOPED_TIMER(parent_->parent_->compress_wait_timer());
+    status = compression->status.Get();
+  }
+  DataPage& page = pages_[compression->page_idx];
+  parent_->file_size_estimate_ -= page.header.uncompressed_page_size;
+  RETURN_IF_ERROR(status);
+  page.header.compressed_page_size = compression->compressed_size;
+  page.data = compression->compressed_buffer->buffer();
+  compressed_page_buffers_.push_back(move(compression->compressed_buffer));
+  return AddPageSize(page.header);
+}
+
+void HdfsParquetTableWriter::BaseColumnWriter::DiscardPendingCompression() {
+  if (pending_compression_ == nullptr) return;
+  discard_result(pending_compression_->status.Get());
+  pending_compression_.reset();
+}
+
 void HdfsParquetTableWriter::BaseColumnWriter::NewPage() {
   pages_.push_back(DataPage());
   current_page_ = &pages_.back();
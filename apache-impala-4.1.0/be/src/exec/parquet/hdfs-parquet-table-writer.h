@@ -231,7 +231,8 @@ class HdfsParquetTableWriter : public HdfsTableWriter {
   int row_idx_;
 
   /// Staging buffer to use to compress data.  This is used only if compression is
-  /// enabled and is reused between all data pages.
+  /// enabled and is reused between all data pages that are compressed on the sink
+  /// thread.
   std::vector<uint8_t> compression_staging_buffer_;
 
   /// For each column, the on disk size written.
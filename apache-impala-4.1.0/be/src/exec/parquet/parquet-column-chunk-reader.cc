@@ -19,10 +19,12 @@
 
 #include <string>
 
+#include "runtime/exec-env.h"
 #include "runtime/mem-pool.h"
 #include "runtime/runtime-state.h"
 #include "runtime/scoped-buffer.h"
 #include "util/codec.h"
+#include "util/thread-pool.h"
 
 #include "common/names.h"
 
@@ -50,15 +52,20 @@ ParquetColumnChunkReader::ParquetColumnChunkReader(HdfsParquetScanner* parent,
     page_reader_(parent, schema_name),
     slot_id_(slot_id),
     data_page_pool_(new MemPool(parent->scan_node_->mem_tracker())),
-    value_mem_type_(value_mem_type)
+    value_mem_type_(value_mem_type),
+    prefetch_page_pool_(new MemPool(parent->scan_node_->mem_tracker()))
 {
 }
 
-ParquetColumnChunkReader::~ParquetColumnChunkReader() {}
+ParquetColumnChunkReader::~ParquetColumnChunkReader() {
+  // The decompression task references this reader.
+  DiscardPrefetchedPage();
+}
 
 Status ParquetColumnChunkReader::InitColumnChunk(const HdfsFileDesc& file_desc,
     const parquet::ColumnChunk& col_chunk, int row_group_idx,
     std::vector<io::ScanRange::SubRange>&& sub_ranges) {
+  DiscardPrefetchedPage();
   if (col_chunk.meta_data.codec != parquet::CompressionCodec::UNCOMPRESSED) {
     RETURN_IF_ERROR(Codec::CreateDecompressor(nullptr, false,
         ConvertParquetToImpalaCodec(col_chunk.meta_data.codec), &decompressor_));
@@ -71,6 +78,7 @@ Status ParquetColumnChunkReader::InitColumnChunk(const HdfsFileDesc& file_desc,
 }
 
 void ParquetColumnChunkReader::Close(MemPool* mem_pool) {
+  DiscardPrefetchedPage();
   if (mem_pool != nullptr && value_mem_type_ == ValueMemoryType::VAR_LEN_STR) {
     mem_pool->AcquireData(data_page_pool_.get(), false);
   } else {
@@ -247,22 +255,27 @@ Status ParquetColumnChunkReader::ReadDataPageData(uint8_t** data, int* data_size
 
   *data_size = uncompressed_size;
   if (decompressor_.get() != nullptr) {
-    SCOPED_TIMER(parent_->decompress_timer_);
+    bool prefetched;
     uint8_t* decompressed_buffer;
-    RETURN_IF_ERROR(AllocateUncompressedDataPage(
-        uncompressed_size, "decompressed data", &decompressed_buffer));
-    RETURN_IF_ERROR(decompressor_->ProcessBlock32(true,
-        compressed_size, compressed_data, &uncompressed_size,
-        &decompressed_buffer));
-    // TODO: can't we call stream_->ReleaseCompletedResources(false); at this point?
-    VLOG_FILE << "Decompressed " << current_page_header.compressed_page_size
-              << " to " << uncompressed_size;
-    if (current_page_header.uncompressed_page_size != uncompressed_size) {
-      return Status(Substitute("Error decompressing data page in file '$0'. "
-          "Expected $1 uncompressed bytes but got $2", filename(),
-          current_page_header.uncompressed_page_size, uncompressed_size));
+    RETURN_IF_ERROR(TakePrefetchedPage(&prefetched, &decompressed_buffer));
+    if (!prefetched) {
+      SCOPED_TIMER(parent_->decompress_timer_);
+      RETURN_IF_ERROR(AllocateUncompressedDataPage(
+          uncompressed_size, "decompressed data", &decompressed_buffer));
+      RETURN_IF_ERROR(decompressor_->ProcessBlock32(true,
+          compressed_size, compressed_data, &uncompressed_size,
+          &decompressed_buffer));
+      // TODO: can't we call stream_->ReleaseCompletedResources(false); at this point?
+      VLOG_FILE << "Decompressed " << current_page_header.compressed_page_size
+                << " to " << uncompressed_size;
+      if (current_page_header.uncompressed_page_size != uncompressed_size) {
+        return Status(Substitute("Error decompressing data page in file '$0'. "
+            "Expected $1 uncompressed bytes but got $2", filename(),
+            current_page_header.uncompressed_page_size, uncompressed_size));
+      }
     }
     *data = decompressed_buffer;
+    if (has_slot_desc) StartPagePrefetch();
 
     if (has_slot_desc) {
       parent_->scan_node_->UpdateBytesRead(slot_id_, uncompressed_size, compressed_size);
@@ -299,6 +312,92 @@ Status ParquetColumnChunkReader::ReadDataPageData(uint8_t** data, int* data_size
   return Status::OK();
 }
 
+void ParquetColumnChunkReader::StartPagePrefetch() {
+  DCHECK(decompressor_ != nullptr);
+  DCHECK(prefetched_page_ == nullptr);
+  CallableThreadPool* pool = ExecEnv::GetInstance()->codec_offload_pool();
+  if (pool == nullptr || !page_prefetch_enabled_) return;
+
+  parquet::PageHeader header;
+  uint8_t* compressed_data;
+  bool found;
+  page_reader_.PeekNextDataPage(&header, &compressed_data, &found);
+  if (!found) return;
+  if (header.compressed_page_size == 0 || header.uncompressed_page_size == 0) return;
+
+  // Copy the compressed data so that the stream can be advanced while the page is
+  // decompressed.
+  shared_ptr<PrefetchedPage> page =
+      make_shared<PrefetchedPage>(parent_->scan_node_->mem_tracker());
+  page->page_idx = page_reader_.PageHeadersRead() + 1;
+  page->compressed_size = header.compressed_page_size;
+  page->uncompressed_size = header.uncompressed_page_size;
+  if (!page->compressed_buffer.TryAllocate(page->compressed_size)) return;
+  memcpy(page->compressed_buffer.buffer(), compressed_data, page->compressed_size);
+  page->uncompressed_buffer = prefetch_page_pool_->TryAllocate(page->uncompressed_size);
+  if (page->uncompressed_buffer == nullptr) return;
+
+  if (!pool->Offer([this, page]() { DecompressPrefetchedPage(page.get()); }, 0)) {
+    // The pool is busy. Decompress the page on this thread when it is read.
+    prefetch_page_pool_->FreeAll();
+    return;
+  }
+  prefetched_page_ = move(page);
+}
+
+void ParquetColumnChunkReader::DecompressPrefetchedPage(PrefetchedPage* page) {
+  Status status;
+  {
+    SCOPED_TIMER(parent_->async_decompress_timer_);
+    int uncompressed_size = page->uncompressed_size;
+    status = decompressor_->ProcessBlock32(true, page->compressed_size,
+        page->compressed_buffer.buffer(), &uncompressed_size,
+        &page->uncompressed_buffer);
+    if (status.ok() && uncompressed_size != page->uncompressed_size) {
+      status = Status(Substitute("Error decompressing data page in file '$0'. "
+          "Expected $1 uncompressed bytes but got $2", filename(),
+          page->uncompressed_size, uncompressed_size));
+    }
+    page->compressed_buffer.Release();
+  }
+  COUNTER_ADD(parent_->num_pages_decompressed_async_counter_, 1);
+  page->status.Set(status);
+}
+
+Status ParquetColumnChunkReader::TakePrefetchedPage(bool* found, uint8_t** data) {
+  *found = false;
+  if (prefetched_page_ == nullptr) return Status::OK();
+  shared_ptr<PrefetchedPage> page = move(prefetched_page_);
+  Status status;
+  {
+    SCOPED_TIMER(parent_->async_decompress_wait_timer_);
+    status = page->status.Get();
+  }
+  const parquet::PageHeader& header = CurrentPageHeader();
+  if (page->page_idx != page_reader_.PageHeadersRead()
+      || page->compressed_size != header.compressed_page_size
+      || page->uncompressed_size != header.uncompressed_page_size) {
+    // The page was skipped or the reader was reset.
+    prefetch_page_pool_->FreeAll();
+    return Status::OK();
+  }
+  if (!status.ok()) {
+    prefetch_page_pool_->FreeAll();
+    return status;
+  }
+  data_page_pool_->AcquireData(prefetch_page_pool_.get(), false);
+  *data = page->uncompressed_buffer;
+  *found = true;
+  return Status::OK();
+}
+
+void ParquetColumnChunkReader::DiscardPrefetchedPage() {
+  if (prefetched_page_ == nullptr) return;
+  discard_result(prefetched_page_->status.Get());
+  prefetched_page_.reset();
+  prefetch_page_pool_->FreeAll();
+}
+
 Status ParquetColumnChunkReader::AllocateUncompressedDataPage(int64_t size,
     const char* err_ctx, uint8_t** buffer) {
   *buffer = data_page_pool_->TryAllocate(size);
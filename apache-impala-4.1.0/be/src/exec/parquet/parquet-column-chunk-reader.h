@@ -17,21 +17,32 @@
 
 #pragma once
 
+#include <memory>
+
 #include <boost/scoped_ptr.hpp>
 
 #include "exec/parquet/hdfs-parquet-scanner.h"
 #include "exec/parquet/parquet-page-reader.h"
+#include "runtime/scoped-buffer.h"
+#include "util/promise.h"
 
 namespace impala {
 
 class Codec;
 class MemPool;
-class ScopedBuffer;
 
 /// A class to read data from Parquet pages. It handles the page headers, decompression
 /// and the possible copying of the data buffers.
 /// Before reading, InitColumnChunk(), set_io_reservation() and StartScan() must be called
 /// in this order.
+///
+/// If the codec offload pool is enabled (--codec_offload_threads > 0), the data page
+/// following the page that was just read is decompressed on the pool while the caller
+/// decodes the current page. Only a page that is already buffered by the stream is
+/// decompressed ahead, so the scanner thread never waits for I/O to start it. The
+/// compressed data of the next page is copied out of the stream so that the stream can
+/// be advanced independently of the decompression. At most one page is decompressed
+/// ahead per reader.
 class ParquetColumnChunkReader {
  public:
 
@@ -81,6 +92,10 @@ class ParquetColumnChunkReader {
     io_reservation_ = bytes;
   }
 
+  /// Enables or disables decompressing the next data page ahead of time. Should be
+  /// disabled if the caller is likely to skip pages without reading their data.
+  void set_page_prefetch_enabled(bool enabled) { page_prefetch_enabled_ = enabled; }
+
   /// Starts the column scan range. InitColumnChunk() has to have been called and the
   /// reader must have a reservation assigned via set_io_reservation(). This must be
   /// called before any of the column data can be read (including dictionary and data
@@ -171,6 +186,55 @@ class ParquetColumnChunkReader {
       int64_t size, const char* err_ctx, uint8_t** buffer);
 
   ValueMemoryType value_mem_type_;
+
+  /// State of a data page that is decompressed on the codec offload pool. Shared between
+  /// the reader and the task decompressing the page.
+  struct PrefetchedPage {
+    PrefetchedPage(MemTracker* mem_tracker) : compressed_buffer(mem_tracker) {}
+
+    /// The value of page_reader_.PageHeadersRead() once the header of this page is read.
+    uint64_t page_idx;
+
+    /// Copy of the compressed data of the page. Released once it is decompressed.
+    ScopedBuffer compressed_buffer;
+    int compressed_size;
+
+    /// Buffer of the decompressed page, allocated from 'prefetch_page_pool_'.
+    uint8_t* uncompressed_buffer;
+    int uncompressed_size;
+
+    /// Set by the decompression task when it is done.
+    Promise<Status> status;
+  };
+
+  /// If false, StartPagePrefetch() does nothing.
+  bool page_prefetch_enabled_ = true;
+
+  /// The page that is decompressed ahead of time, if any.
+  std::shared_ptr<PrefetchedPage> prefetched_page_;
+
+  /// Pool for the decompressed buffer of 'prefetched_page_'. Transferred to
+  /// 'data_page_pool_' when the page is read.
+  boost::scoped_ptr<MemPool> prefetch_page_pool_;
+
+  /// Starts decompressing the next page on the codec offload pool if the pool is enabled,
+  /// the next page is a data page that is completely buffered by the stream and there
+  /// is enough memory. Otherwise the page is decompressed when it is read. Must be called
+  /// right after the data of a compressed data page is read.
+  void StartPagePrefetch();
+
+  /// Waits for the decompression of 'prefetched_page_' if one is in flight. If it is the
+  /// current page, sets '*data' to the decompressed buffer, '*found' to true and returns
+  /// the status of the decompression. Otherwise discards the prefetched page and sets
+  /// '*found' to false.
+  Status TakePrefetchedPage(bool* found, uint8_t** data);
+
+  /// Waits for the decompression of 'prefetched_page_' if one is in flight and discards
+  /// the page.
+  void DiscardPrefetchedPage();
+
+  /// Decompresses the page in 'page'. Runs on the codec offload pool.
+  void DecompressPrefetchedPage(PrefetchedPage* page);
 };
 
 } // namespace impala
@@ -20,6 +20,7 @@
 #include <string>
 #include <gutil/strings/substitute.h>
 
+#include "exec/exec-node.inline.h"
 #include "exec/parquet/hdfs-parquet-scanner.h"
 #include "exec/parquet/parquet-bool-decoder.h"
 #include "exec/parquet/parquet-data-converter.h"
@@ -31,6 +32,7 @@
 #include "runtime/scoped-buffer.h"
 #include "runtime/string-value.inline.h"
 #include "runtime/tuple.h"
+#include "runtime/tuple-row.h"
 #include "util/debug-util.h"
 #include "util/dict-encoding.h"
 #include "util/rle-encoding.h"
@@ -159,6 +161,7 @@ class ScalarColumnReader : public BaseScalarColumnReader {
           slot_desc_->type().DebugString(), "could not decode dictionary");
     }
     dict_decoder_init_ = true;
+    dict_entry_rejected_valid_ = false;
     *decoder = &dict_decoder_;
     return Status::OK();
   }
@@ -169,6 +172,7 @@ class ScalarColumnReader : public BaseScalarColumnReader {
 
   virtual void ClearDictionaryDecoder() override {
     dict_decoder_init_ = false;
+    dict_entry_rejected_valid_ = false;
   }
 
   virtual Status InitDataPage(uint8_t* data, int size) override;
@@ -200,6 +204,12 @@ class ScalarColumnReader : public BaseScalarColumnReader {
   /// false and set 'parse_error_' if there is an error decoding any value.
   inline ALWAYS_INLINE bool DecodeValues(
       int64_t stride, int64_t count, InternalType* RESTRICT out_vals) RESTRICT;
+
+  /// Same as DecodeValues() for dictionary-encoded pages with dictionary code filtering
+  /// enabled. Also marks the rows of the values whose dictionary entries are rejected
+  /// in 'rows_rejected'.
+  bool DecodeDictValuesAndRejectRows(int64_t stride, int64_t count,
+      InternalType* RESTRICT out_vals, uint8_t* RESTRICT rows_rejected) RESTRICT;
   /// Specialisation of DecodeValues for a particular encoding, to allow overriding
   /// specific instances via template specialisation.
   template <Encoding::type ENCODING>
@@ -752,6 +762,11 @@ bool ScalarColumnReader<InternalType, PARQUET_TYPE, MATERIALIZED>::ReadSlotsNoCo
   DCHECK(!NeedsConversionInline());
   // No conversion needed - decode directly into the output slots.
   InternalType* first_slot = reinterpret_cast<InternalType*>(tuple_mem + tuple_offset_);
+  if (dict_code_filter_evals_ != nullptr && IsDictionaryEncoding(page_encoding_)) {
+    DCHECK(!NeedsValidationInline());
+    return DecodeDictValuesAndRejectRows(tuple_size, num_to_read, first_slot,
+        GetRejectedRows(tuple_mem, tuple_size));
+  }
   if (!DecodeValues(tuple_size, num_to_read, first_slot)) return false;
   if (NeedsValidationInline()) {
     // Validate the written slots.
@@ -835,6 +850,19 @@ bool ScalarColumnReader<InternalType, PARQUET_TYPE, MATERIALIZED>::DecodeValues(
   }
 }
 
+template <typename InternalType, parquet::Type::type PARQUET_TYPE, bool MATERIALIZED>
+bool ScalarColumnReader<InternalType, PARQUET_TYPE,
+    MATERIALIZED>::DecodeDictValuesAndRejectRows(int64_t stride, int64_t count,
+    InternalType* RESTRICT out_vals, uint8_t* RESTRICT rows_rejected) RESTRICT {
+  DCHECK(IsDictionaryEncoding(page_encoding_));
+  if (UNLIKELY(!dict_decoder_.GetNextValuesAndRejectRows(
+          out_vals, stride, count, GetDictEntryRejected(), rows_rejected))) {
+    SetDictDecodeError();
+    return false;
+  }
+  return true;
+}
+
 template <typename InternalType, parquet::Type::type PARQUET_TYPE, bool MATERIALIZED>
 template <Encoding::type ENCODING>
 bool ScalarColumnReader<InternalType, PARQUET_TYPE, MATERIALIZED>::DecodeValues(
@@ -1030,6 +1058,46 @@ void BaseScalarColumnReader::Close(RowBatch* row_batch) {
   if (dict_decoder != nullptr) dict_decoder->Close();
 }
 
+const uint8_t* BaseScalarColumnReader::GetDictEntryRejected() {
+  DCHECK(dict_code_filter_evals_ != nullptr);
+  if (dict_entry_rejected_valid_) return dict_entry_rejected_.data();
+  DictDecoderBase* dictionary = GetDictionaryDecoder();
+  DCHECK(dictionary != nullptr);
+  const TupleDescriptor* tuple_desc = slot_desc_->parent();
+  auto tuple_it = parent_->dict_filter_tuple_map_.find(tuple_desc);
+  DCHECK(tuple_it != parent_->dict_filter_tuple_map_.end());
+  Tuple* dict_filter_tuple = tuple_it->second;
+  dict_filter_tuple->Init(tuple_desc->byte_size());
+  void* slot = dict_filter_tuple->GetSlot(slot_desc_->tuple_offset());
+  TupleRow row;
+  row.SetTuple(0, dict_filter_tuple);
+  const int num_entries = dictionary->num_entries();
+  dict_entry_rejected_.resize(num_entries);
+  for (int dict_idx = 0; dict_idx < num_entries; ++dict_idx) {
+    if (dict_idx % 1024 == 0) {
+      // Don't let expr result allocations accumulate too much for large dictionaries.
+      parent_->context_->expr_results_pool()->Clear();
+    }
+    dictionary->GetValue(dict_idx, slot);
+    dict_entry_rejected_[dict_idx] = !ExecNode::EvalConjuncts(
+        dict_code_filter_evals_->data(), dict_code_filter_evals_->size(), &row);
+  }
+  parent_->context_->expr_results_pool()->Clear();
+  dict_entry_rejected_valid_ = true;
+  return dict_entry_rejected_.data();
+}
+
+uint8_t* BaseScalarColumnReader::GetRejectedRows(
+    const uint8_t* tuple_mem, int tuple_size) const {
+  ScratchTupleBatch* scratch_batch = parent_->scratch_batch_.get();
+  DCHECK(scratch_batch->dict_filter_rejected != nullptr);
+  DCHECK_GE(tuple_mem, scratch_batch->tuple_mem);
+  DCHECK_EQ(tuple_size, scratch_batch->tuple_byte_size);
+  int64_t row_idx = (tuple_mem - scratch_batch->tuple_mem) / tuple_size;
+  DCHECK_LT(row_idx, scratch_batch->capacity);
+  return scratch_batch->dict_filter_rejected.get() + row_idx;
+}
+
 Status BaseScalarColumnReader::InitDictionary() {
   // Dictionary encoding is not supported for booleans.
   const bool is_boolean = node_.element->type == parquet::Type::BOOLEAN;
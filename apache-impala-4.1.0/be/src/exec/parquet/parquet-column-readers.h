@@ -300,6 +300,9 @@ class BaseScalarColumnReader : public ParquetColumnReader {
     return ConvertParquetToImpalaCodec(metadata_->codec);
   }
   void set_io_reservation(int bytes) { col_chunk_reader_.set_io_reservation(bytes); }
+  void set_page_prefetch_enabled(bool enabled) {
+    col_chunk_reader_.set_page_prefetch_enabled(enabled);
+  }
 
   /// Reads the next definition and repetition levels for this column. Initializes the
   /// next data page if necessary.
@@ -326,6 +329,16 @@ class BaseScalarColumnReader : public ParquetColumnReader {
   // need to be validated when read from disk.
   virtual bool NeedsValidation() { return false; }
 
+  /// Enables dictionary code filtering for this column: 'evals' are evaluated once per
+  /// entry of each dictionary and rows whose values come from a rejected entry are
+  /// marked in the 'dict_filter_rejected' array of the parent's scratch batch while the
+  /// values are decoded. Must only be called for top-level columns of the scratch batch
+  /// that neither need conversion nor validation. 'evals' must outlive this reader.
+  void SetDictCodeFilter(const std::vector<ScalarExprEvaluator*>* evals) {
+    DCHECK_EQ(max_rep_level(), 0);
+    dict_code_filter_evals_ = evals;
+  }
+
   // TODO: Some encodings might benefit a lot from a SkipValues(int num_rows) if
   // we know this row can be skipped. This could be very useful with stats and big
   // sections can be skipped. Implement that when we can benefit from it.
@@ -368,6 +381,18 @@ class BaseScalarColumnReader : public ParquetColumnReader {
   /// Metadata for the column for the current row group.
   const parquet::ColumnMetaData* metadata_ = nullptr;
 
+  /// Conjuncts used for dictionary code filtering. nullptr if it is disabled for this
+  /// column. See SetDictCodeFilter().
+  const std::vector<ScalarExprEvaluator*>* dict_code_filter_evals_ = nullptr;
+
+  /// One byte per entry of the current dictionary, non-zero if the entry does not pass
+  /// 'dict_code_filter_evals_'. Only valid if 'dict_entry_rejected_valid_' is true.
+  std::vector<uint8_t> dict_entry_rejected_;
+
+  /// False if 'dict_entry_rejected_' needs to be recomputed, i.e. no dictionary has been
+  /// evaluated yet or the dictionary changed since the last evaluation.
+  bool dict_entry_rejected_valid_ = false;
+
 
   /////////////////////////////////////////
   /// BEGIN: Members used for page filtering
@@ -459,6 +484,14 @@ class BaseScalarColumnReader : public ParquetColumnReader {
   /// Return true if the column has a dictionary decoder. Subclass must implement this.
   virtual bool HasDictionaryDecoder() = 0;
 
+  /// Returns 'dict_entry_rejected_' for the current dictionary, evaluating
+  /// 'dict_code_filter_evals_' over all dictionary entries first if needed.
+  const uint8_t* GetDictEntryRejected();
+
+  /// Returns the element of the parent scratch batch's 'dict_filter_rejected' array that
+  /// corresponds to the tuple at 'tuple_mem'.
+  uint8_t* GetRejectedRows(const uint8_t* tuple_mem, int tuple_size) const;
+
   /// Clear the dictionary decoder so HasDictionaryDecoder() will return false. Subclass
   /// must implement this.
   virtual void ClearDictionaryDecoder() = 0;
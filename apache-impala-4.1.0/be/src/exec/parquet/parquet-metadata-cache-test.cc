@@ -0,0 +1,130 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include <gflags/gflags.h>
+
+#include "exec/parquet/parquet-metadata-cache.h"
+#include "testutil/gtest-util.h"
+#include "testutil/scoped-flag-setter.h"
+#include "util/metrics.h"
+
+#include "common/names.h"
+
+DECLARE_string(parquet_metadata_cache_capacity);
+
+namespace impala {
+
+static shared_ptr<const parquet::FileMetaData> MakeFooter(int64_t num_rows) {
+  auto footer = make_shared<parquet::FileMetaData>();
+  footer->__set_num_rows(num_rows);
+  return footer;
+}
+
+TEST(ParquetMetadataCache, Disabled) {
+  auto flag = ScopedFlagSetter<string>::Make(&FLAGS_parquet_metadata_cache_capacity, "0");
+  MetricGroup metrics("test");
+  ParquetMetadataCache cache;
+  ASSERT_OK(cache.Init(&metrics));
+  EXPECT_FALSE(cache.enabled());
+  cache.InsertFooter("file", 1, 100, MakeFooter(10), 100);
+  EXPECT_EQ(nullptr, cache.LookupFooter("file", 1, 100));
+  EXPECT_FALSE(cache.ContainsFooter("file", 1, 100));
+}
+
+TEST(ParquetMetadataCache, InvalidCapacity) {
+  auto flag =
+      ScopedFlagSetter<string>::Make(&FLAGS_parquet_metadata_cache_capacity, "foo");
+  MetricGroup metrics("test");
+  ParquetMetadataCache cache;
+  EXPECT_FALSE(cache.Init(&metrics).ok());
+}
+
+TEST(ParquetMetadataCache, Footer) {
+  auto flag =
+      ScopedFlagSetter<string>::Make(&FLAGS_parquet_metadata_cache_capacity, "1MB");
+  MetricGroup metrics("test");
+  ParquetMetadataCache cache;
+  ASSERT_OK(cache.Init(&metrics));
+  ASSERT_TRUE(cache.enabled());
+
+  EXPECT_EQ(nullptr, cache.LookupFooter("file", 1, 100));
+  cache.InsertFooter("file", 1, 100, MakeFooter(10), 100);
+  EXPECT_TRUE(cache.ContainsFooter("file", 1, 100));
+  shared_ptr<const parquet::FileMetaData> footer = cache.LookupFooter("file", 1, 100);
+  ASSERT_TRUE(footer != nullptr);
+  EXPECT_EQ(10, footer->num_rows);
+
+  // A different modification time or length identifies a different version of the file.
+  EXPECT_EQ(nullptr, cache.LookupFooter("file", 2, 100));
+  EXPECT_EQ(nullptr, cache.LookupFooter("file", 1, 101));
+  EXPECT_EQ(nullptr, cache.LookupFooter("file2", 1, 100));
+
+  IntCounter* hits = metrics.FindMetricForTesting<IntCounter>(
+      "impala-server.parquet-metadata-cache.footer-hits");
+  ASSERT_TRUE(hits != nullptr);
+  EXPECT_EQ(1, hits->GetValue());
+}
+
+TEST(ParquetMetadataCache, PageIndex) {
+  auto flag =
+      ScopedFlagSetter<string>::Make(&FLAGS_parquet_metadata_cache_capacity, "1MB");
+  MetricGroup metrics("test");
+  ParquetMetadataCache cache;
+  ASSERT_OK(cache.Init(&metrics));
+
+  vector<uint8_t> page_index(64);
+  for (int i = 0; i < page_index.size(); ++i) page_index[i] = i;
+  vector<uint8_t> buffer(page_index.size());
+  EXPECT_FALSE(cache.LookupPageIndex(
+      "file", 1, 100, 0, buffer.data(), buffer.size()));
+  cache.InsertPageIndex("file", 1, 100, 0, page_index.data(), page_index.size());
+  ASSERT_TRUE(cache.LookupPageIndex(
+      "file", 1, 100, 0, buffer.data(), buffer.size()));
+  EXPECT_EQ(page_index, buffer);
+
+  // Other row groups and lookups with mismatching length miss.
+  EXPECT_FALSE(cache.LookupPageIndex(
+      "file", 1, 100, 1, buffer.data(), buffer.size()));
+  EXPECT_FALSE(cache.LookupPageIndex(
+      "file", 1, 100, 0, buffer.data(), buffer.size() - 1));
+}
+
+TEST(ParquetMetadataCache, Eviction) {
+  auto flag =
+      ScopedFlagSetter<string>::Make(&FLAGS_parquet_metadata_cache_capacity, "1MB");
+  MetricGroup metrics("test");
+  ParquetMetadataCache cache;
+  ASSERT_OK(cache.Init(&metrics));
+
+  // Hold on to a footer while it gets evicted by inserting much more data than fits.
+  cache.InsertFooter("file", 1, 100, MakeFooter(10), 100);
+  shared_ptr<const parquet::FileMetaData> footer = cache.LookupFooter("file", 1, 100);
+  ASSERT_TRUE(footer != nullptr);
+  vector<uint8_t> page_index(64 * 1024);
+  for (int i = 0; i < 64; ++i) {
+    cache.InsertPageIndex("file", 1, 100, i, page_index.data(), page_index.size());
+  }
+  EXPECT_FALSE(cache.ContainsFooter("file", 1, 100));
+  EXPECT_EQ(10, footer->num_rows);
+
+  IntGauge* total_bytes = metrics.FindMetricForTesting<IntGauge>(
+      "impala-server.parquet-metadata-cache.total-bytes");
+  ASSERT_TRUE(total_bytes != nullptr);
+  EXPECT_LE(total_bytes->GetValue(), 1024 * 1024);
+}
+
+}
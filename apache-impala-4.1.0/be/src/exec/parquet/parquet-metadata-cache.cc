@@ -0,0 +1,201 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include "exec/parquet/parquet-metadata-cache.h"
+
+#include <limits>
+#include <new>
+
+#include <gflags/gflags.h>
+#include <gutil/strings/substitute.h>
+
+#include "util/mem-info.h"
+#include "util/metrics.h"
+#include "util/parse-util.h"
+#include "util/pretty-printer.h"
+
+#include "common/names.h"
+
+DEFINE_string(parquet_metadata_cache_capacity, "0",
+    "(Advanced) Memory bound of the process-wide cache of parsed Parquet file footers "
+    "and page indexes, specified as a number of bytes ('<int>[bB]?'), megabytes "
+    "('<float>[mM]'), gigabytes ('<float>[gG]') or percentage of the physical memory "
+    "('<int>%'). Set to 0 to disable the cache.");
+
+namespace impala {
+
+/// Keeps the metrics in sync with the content of the cache and destroys the footer
+/// objects owned by evicted entries.
+class ParquetMetadataCache::EvictionCallback : public Cache::EvictionCallback {
+ public:
+  EvictionCallback(ParquetMetadataCache* cache) : cache_(cache) {}
+
+  virtual void EvictedEntry(Slice key, Slice value) override {
+    DCHECK_GT(key.size(), 0);
+    int64_t charge;
+    EntryType type = static_cast<EntryType>(key[key.size() - sizeof(int32_t) - 1]);
+    if (type == EntryType::FOOTER) {
+      DCHECK_EQ(value.size(), sizeof(FooterEntry));
+      FooterEntry* entry =
+          reinterpret_cast<FooterEntry*>(const_cast<uint8_t*>(value.data()));
+      charge = entry->charge;
+      entry->~FooterEntry();
+    } else {
+      DCHECK(type == EntryType::PAGE_INDEX);
+      charge = value.size();
+    }
+    cache_->total_bytes_->Increment(-charge);
+    cache_->num_entries_->Increment(-1);
+  }
+
+ private:
+  ParquetMetadataCache* const cache_;
+};
+
+ParquetMetadataCache::ParquetMetadataCache()
+  : eviction_callback_(new EvictionCallback(this)) {}
+
+ParquetMetadataCache::~ParquetMetadataCache() {
+  // Destroy the cache first so that the eviction callback releases all footers.
+  cache_.reset();
+}
+
+Status ParquetMetadataCache::Init(MetricGroup* metrics) {
+  MetricGroup* cache_metrics = metrics->GetOrCreateChildGroup("parquet-metadata-cache");
+  footer_hits_ =
+      cache_metrics->AddCounter("impala-server.parquet-metadata-cache.footer-hits", 0);
+  footer_misses_ =
+      cache_metrics->AddCounter("impala-server.parquet-metadata-cache.footer-misses", 0);
+  page_index_hits_ = cache_metrics->AddCounter(
+      "impala-server.parquet-metadata-cache.page-index-hits", 0);
+  page_index_misses_ = cache_metrics->AddCounter(
+      "impala-server.parquet-metadata-cache.page-index-misses", 0);
+  total_bytes_ =
+      cache_metrics->AddGauge("impala-server.parquet-metadata-cache.total-bytes", 0);
+  num_entries_ =
+      cache_metrics->AddGauge("impala-server.parquet-metadata-cache.num-entries", 0);
+
+  bool is_percent;
+  int64_t capacity = ParseUtil::ParseMemSpec(
+      FLAGS_parquet_metadata_cache_capacity, &is_percent, MemInfo::physical_mem());
+  if (capacity < 0) {
+    return Status(Substitute("Invalid --parquet_metadata_cache_capacity: '$0'",
+        FLAGS_parquet_metadata_cache_capacity));
+  }
+  if (capacity == 0) return Status::OK();
+
+  cache_.reset(NewCache(Cache::EvictionPolicy::LRU, capacity, "parquet-metadata-cache"));
+  RETURN_IF_ERROR(cache_->Init());
+  LOG(INFO) << "Parquet metadata cache initialized with capacity "
+            << PrettyPrinter::PrintBytes(capacity);
+  return Status::OK();
+}
+
+string ParquetMetadataCache::MakeKey(const string& filename, int64_t mtime,
+    int64_t file_length, EntryType type, int row_group_idx) {
+  // The file name is followed by fixed size fields, so keys of different files cannot
+  // collide. EvictionCallback relies on the type being at a fixed offset from the end.
+  string key;
+  key.reserve(filename.size() + 2 * sizeof(int64_t) + 1 + sizeof(int32_t));
+  key.append(filename);
+  key.append(reinterpret_cast<const char*>(&mtime), sizeof(mtime));
+  key.append(reinterpret_cast<const char*>(&file_length), sizeof(file_length));
+  key.push_back(static_cast<char>(type));
+  int32_t idx = row_group_idx;
+  key.append(reinterpret_cast<const char*>(&idx), sizeof(idx));
+  return key;
+}
+
+void ParquetMetadataCache::Insert(
+    Cache::UniquePendingHandle pending_handle, int64_t charge) {
+  // Account for the entry before inserting it: if the entry is evicted right away,
+  // the eviction callback runs before Insert() returns.
+  total_bytes_->Increment(charge);
+  num_entries_->Increment(1);
+  discard_result(cache_->Insert(move(pending_handle), eviction_callback_.get()));
+}
+
+shared_ptr<const parquet::FileMetaData> ParquetMetadataCache::LookupFooter(
+    const string& filename, int64_t mtime, int64_t file_length) {
+  if (!enabled()) return nullptr;
+  string key = MakeKey(filename, mtime, file_length, EntryType::FOOTER, 0);
+  Cache::UniqueHandle handle(cache_->Lookup(key));
+  if (handle.get() == nullptr) {
+    footer_misses_->Increment(1);
+    return nullptr;
+  }
+  footer_hits_->Increment(1);
+  Slice value = cache_->Value(handle);
+  DCHECK_EQ(value.size(), sizeof(FooterEntry));
+  return reinterpret_cast<const FooterEntry*>(value.data())->file_metadata;
+}
+
+bool ParquetMetadataCache::ContainsFooter(
+    const string& filename, int64_t mtime, int64_t file_length) {
+  if (!enabled()) return false;
+  string key = MakeKey(filename, mtime, file_length, EntryType::FOOTER, 0);
+  Cache::UniqueHandle handle(cache_->Lookup(key, Cache::NO_UPDATE));
+  return handle.get() != nullptr;
+}
+
+void ParquetMetadataCache::InsertFooter(const string& filename, int64_t mtime,
+    int64_t file_length, shared_ptr<const parquet::FileMetaData> file_metadata,
+    int64_t serialized_len) {
+  if (!enabled()) return;
+  DCHECK(file_metadata != nullptr);
+  int64_t charge = serialized_len * FOOTER_MEMORY_EXPANSION_FACTOR + sizeof(FooterEntry);
+  if (charge > numeric_limits<int32_t>::max()) return;
+  string key = MakeKey(filename, mtime, file_length, EntryType::FOOTER, 0);
+  Cache::UniquePendingHandle pending_handle(
+      cache_->Allocate(key, sizeof(FooterEntry), charge));
+  if (pending_handle.get() == nullptr) return;
+  new (cache_->MutableValue(&pending_handle))
+      FooterEntry{move(file_metadata), charge};
+  Insert(move(pending_handle), charge);
+}
+
+bool ParquetMetadataCache::LookupPageIndex(const string& filename, int64_t mtime,
+    int64_t file_length, int row_group_idx, uint8_t* buffer, int64_t len) {
+  if (!enabled()) return false;
+  string key =
+      MakeKey(filename, mtime, file_length, EntryType::PAGE_INDEX, row_group_idx);
+  Cache::UniqueHandle handle(cache_->Lookup(key));
+  if (handle.get() != nullptr) {
+    Slice value = cache_->Value(handle);
+    if (LIKELY(value.size() == len)) {
+      memcpy(buffer, value.data(), len);
+      page_index_hits_->Increment(1);
+      return true;
+    }
+  }
+  page_index_misses_->Increment(1);
+  return false;
+}
+
+void ParquetMetadataCache::InsertPageIndex(const string& filename, int64_t mtime,
+    int64_t file_length, int row_group_idx, const uint8_t* buffer, int64_t len) {
+  if (!enabled()) return;
+  if (len > numeric_limits<int32_t>::max()) return;
+  string key =
+      MakeKey(filename, mtime, file_length, EntryType::PAGE_INDEX, row_group_idx);
+  Cache::UniquePendingHandle pending_handle(cache_->Allocate(key, len, len));
+  if (pending_handle.get() == nullptr) return;
+  memcpy(cache_->MutableValue(&pending_handle), buffer, len);
+  Insert(move(pending_handle), len);
+}
+
+}
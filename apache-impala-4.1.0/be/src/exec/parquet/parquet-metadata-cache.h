@@ -0,0 +1,136 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#pragma once
+
+#include <memory>
+#include <string>
+
+#include "common/status.h"
+#include "gen-cpp/parquet_types.h"
+#include "util/cache/cache.h"
+#include "util/metrics-fwd.h"
+
+namespace impala {
+
+/// Process-wide cache of Parquet file metadata which is shared by all queries running on
+/// an executor. Two kinds of entries are cached:
+///
+/// - Parsed file footers (parquet::FileMetaData). A scanner that hits in the cache skips
+///   reading and deserializing the footer and copies the cached object instead. Entries
+///   are handed out as shared pointers, so an entry evicted while a scanner copies it
+///   stays alive until the copy is done.
+/// - The raw bytes of the page index (column indexes followed by offset indexes) of a
+///   row group. A hit avoids the extra I/O request issued by ParquetPageIndex::ReadAll().
+///
+/// Entries are keyed by the file's identity: its path, modification time and length. A
+/// file that is rewritten in place therefore gets a new key and stale entries are simply
+/// aged out by the LRU eviction policy.
+///
+/// The cache is bounded by --parquet_metadata_cache_capacity. Footers are charged an
+/// estimate of their in-memory size, page indexes their actual size. The cache is
+/// disabled if the capacity is 0, in which case all lookups miss and inserts are no-ops.
+///
+/// All functions are thread-safe.
+class ParquetMetadataCache {
+ public:
+  ParquetMetadataCache();
+  ~ParquetMetadataCache();
+
+  /// Creates the underlying cache if --parquet_metadata_cache_capacity is non-zero and
+  /// registers the cache's metrics in 'metrics'. Must be called before any other
+  /// function.
+  Status Init(MetricGroup* metrics);
+
+  bool enabled() const { return cache_ != nullptr; }
+
+  /// Returns the cached footer of the file identified by 'filename', 'mtime' and
+  /// 'file_length' or nullptr if it is not in the cache.
+  std::shared_ptr<const parquet::FileMetaData> LookupFooter(
+      const std::string& filename, int64_t mtime, int64_t file_length);
+
+  /// Returns true if the footer of the file is cached. Unlike LookupFooter(), this does
+  /// not affect the eviction priority of the entry or the hit/miss metrics.
+  bool ContainsFooter(const std::string& filename, int64_t mtime, int64_t file_length);
+
+  /// Inserts the footer 'file_metadata' of the given file into the cache.
+  /// 'serialized_len' is the size of the Thrift-serialized footer and is used to
+  /// estimate the memory consumption of the entry.
+  void InsertFooter(const std::string& filename, int64_t mtime, int64_t file_length,
+      std::shared_ptr<const parquet::FileMetaData> file_metadata,
+      int64_t serialized_len);
+
+  /// Looks up the page index of row group 'row_group_idx' of the given file. On a hit
+  /// with an entry of exactly 'len' bytes, copies the entry into 'buffer' and returns
+  /// true. Returns false otherwise.
+  bool LookupPageIndex(const std::string& filename, int64_t mtime, int64_t file_length,
+      int row_group_idx, uint8_t* buffer, int64_t len);
+
+  /// Inserts the 'len' bytes of page index at 'buffer' for row group 'row_group_idx' of
+  /// the given file into the cache.
+  void InsertPageIndex(const std::string& filename, int64_t mtime, int64_t file_length,
+      int row_group_idx, const uint8_t* buffer, int64_t len);
+
+  /// Thrift objects take up several times their serialized size in memory. This factor
+  /// is applied to the serialized size of a footer to compute its charge.
+  static const int FOOTER_MEMORY_EXPANSION_FACTOR = 4;
+
+ private:
+  class EvictionCallback;
+
+  /// Type of the cached entry, encoded into the cache key.
+  enum class EntryType : uint8_t {
+    FOOTER = 0,
+    PAGE_INDEX = 1,
+  };
+
+  /// Value stored in the cache for a footer. Constructed in place in the memory
+  /// allocated by the cache and destroyed by the eviction callback.
+  struct FooterEntry {
+    std::shared_ptr<const parquet::FileMetaData> file_metadata;
+    int64_t charge;
+  };
+
+  /// Builds the cache key for an entry of 'type' of the given file. 'row_group_idx' is
+  /// only meaningful for page index entries.
+  static std::string MakeKey(const std::string& filename, int64_t mtime,
+      int64_t file_length, EntryType type, int row_group_idx);
+
+  /// Inserts the pending entry into the cache and updates the metrics with its
+  /// charge.
+  void Insert(Cache::UniquePendingHandle pending_handle, int64_t charge);
+
+  /// The underlying cache. nullptr if the cache is disabled.
+  std::unique_ptr<Cache> cache_;
+
+  /// Called when entries are evicted from 'cache_'.
+  std::unique_ptr<EvictionCallback> eviction_callback_;
+
+  /// Metrics for footer lookups.
+  IntCounter* footer_hits_ = nullptr;
+  IntCounter* footer_misses_ = nullptr;
+
+  /// Metrics for page index lookups.
+  IntCounter* page_index_hits_ = nullptr;
+  IntCounter* page_index_misses_ = nullptr;
+
+  /// Total charge and number of entries currently in the cache.
+  IntGauge* total_bytes_ = nullptr;
+  IntGauge* num_entries_ = nullptr;
+};
+
+}
@@ -17,9 +17,11 @@
 
 #include "common/logging.h"
 #include "exec/parquet/hdfs-parquet-scanner.h"
+#include "exec/parquet/parquet-metadata-cache.h"
 #include "exec/parquet/parquet-page-index.h"
 #include "gutil/strings/substitute.h"
 #include "rpc/thrift-util.h"
+#include "runtime/exec-env.h"
 #include "runtime/io/request-context.h"
 #include "runtime/io/request-ranges.h"
 
@@ -93,6 +95,16 @@ Status ParquetPageIndex::ReadAll(int row_group_idx) {
         "page index for file '$1'.", buffer_size, scanner_->filename()));
   }
   int64_t partition_id = scanner_->context_->partition_descriptor()->id();
+  const HdfsFileDesc* file_desc =
+      scanner_->scan_node_->GetFileDesc(partition_id, scanner_->filename());
+  DCHECK(file_desc != nullptr);
+  ParquetMetadataCache* metadata_cache = ExecEnv::GetInstance()->parquet_metadata_cache();
+  if (metadata_cache->LookupPageIndex(file_desc->filename, file_desc->mtime,
+          file_desc->file_length, row_group_idx, page_index_buffer_.buffer(),
+          buffer_size)) {
+    COUNTER_ADD(scanner_->num_page_index_cache_hits_counter_, 1);
+    return Status::OK();
+  }
   int cache_options =
       scanner_->metadata_range_->cache_options() & ~BufferOpts::USE_HDFS_CACHE;
   ScanRange* object_range = scanner_->scan_node_->AllocateScanRange(
@@ -115,6 +127,8 @@ Status ParquetPageIndex::ReadAll(int row_group_idx) {
   DCHECK(io_buffer->eosr());
   scanner_->AddSyncReadBytesCounter(io_buffer->len());
   object_range->ReturnBuffer(move(io_buffer));
+  metadata_cache->InsertPageIndex(file_desc->filename, file_desc->mtime,
+      file_desc->file_length, row_group_idx, page_index_buffer_.buffer(), buffer_size);
 
   return Status::OK();
 }
@@ -110,13 +110,9 @@ Status ParquetPageReader::StartScan(int io_reservation) {
   return Status::OK();
 }
 
-Status ParquetPageReader::ReadPageHeader(bool* eos) {
-  DCHECK(state_ == State::ToReadHeader || state_ == State::ToReadData);
-  DCHECK(stream_ != nullptr);
-
+Status ParquetPageReader::PeekPageHeader(
+    parquet::PageHeader* header, uint32_t* header_size, bool* eos) {
   *eos = false;
-  if (state_ == State::ToReadData) return Status::OK();
-
   uint8_t* buffer;
   int64_t buffer_size;
   RETURN_IF_ERROR(stream_->GetBuffer(true, &buffer, &buffer_size));
@@ -128,12 +124,10 @@ Status ParquetPageReader::ReadPageHeader(bool* eos) {
   }
   // We don't know the actual header size until the thrift object is deserialized. Loop
   // until we successfully deserialize the header or exceed the maximum header size.
-  uint32_t header_size;
   Status status;
-  parquet::PageHeader header;
   while (true) {
-    header_size = buffer_size;
-    status = DeserializeThriftMsg(buffer, &header_size, true, &header);
+    *header_size = buffer_size;
+    status = DeserializeThriftMsg(buffer, header_size, true, header);
     if (status.ok()) break;
 
     if (buffer_size >= FLAGS_max_page_header_size) {
@@ -164,6 +158,20 @@ Status ParquetPageReader::ReadPageHeader(bool* eos) {
     DCHECK_GT(new_buffer_size, buffer_size);
     buffer_size = new_buffer_size;
   }
+  return Status::OK();
+}
+
+Status ParquetPageReader::ReadPageHeader(bool* eos) {
+  DCHECK(state_ == State::ToReadHeader || state_ == State::ToReadData);
+  DCHECK(stream_ != nullptr);
+
+  *eos = false;
+  if (state_ == State::ToReadData) return Status::OK();
+
+  uint32_t header_size;
+  parquet::PageHeader header;
+  RETURN_IF_ERROR(PeekPageHeader(&header, &header_size, eos));
+  if (*eos) return Status::OK();
   int data_size = header.compressed_page_size;
   if (UNLIKELY(data_size < 0)) {
     return Status(Substitute("Corrupt Parquet file '$0': negative page size $1 for "
@@ -213,6 +221,29 @@ Status ParquetPageReader::ReadPageData(uint8_t** data) {
   return Status::OK();
 }
 
+void ParquetPageReader::PeekNextDataPage(
+    parquet::PageHeader* header, uint8_t** data, bool* found) {
+  DCHECK_EQ(state_, State::ToReadHeader);
+  DCHECK(stream_ != nullptr);
+  *found = false;
+  // Only look at the bytes that are already buffered. Peeking further would block on
+  // I/O and copy the page into the stream's boundary buffer.
+  uint8_t* buffer;
+  int64_t buffer_len;
+  stream_->PeekBufferedBytes(&buffer, &buffer_len);
+  if (buffer_len == 0) return;
+  // Errors are ignored here: they are hit again and reported when the page is read.
+  uint32_t header_size = min<int64_t>(buffer_len, FLAGS_max_page_header_size);
+  if (!DeserializeThriftMsg(buffer, &header_size, true, header).ok()) return;
+  if (header->type != parquet::PageType::DATA_PAGE
+      || header->compressed_page_size < 0 || header->uncompressed_page_size < 0) {
+    return;
+  }
+  if (header_size + header->compressed_page_size > buffer_len) return;
+  *data = buffer + header_size;
+  *found = true;
+}
+
 Status ParquetPageReader::SkipPageData() {
   DCHECK_EQ(state_, State::ToReadData);
   RETURN_IF_ERROR(AdvanceStream(current_page_header_.compressed_page_size));
@@ -63,6 +63,14 @@ class ParquetPageReader {
   /// this or ReadPageData() again without reading the next header.
   Status SkipPageData();
 
+  /// Peeks at the page following the current one without advancing the stream. The data
+  /// of the current page must already be read or skipped. If the next page is a data page
+  /// that is completely contained in the bytes the stream already buffered, deserializes
+  /// its header into 'header', sets '*data' to point to its data and sets '*found' to
+  /// true. Otherwise sets '*found' to false. Never blocks on I/O. The memory pointed to
+  /// by '*data' is valid until the stream is advanced.
+  void PeekNextDataPage(parquet::PageHeader* header, uint8_t** data, bool* found);
+
   const parquet::PageHeader& CurrentPageHeader() const {
     DCHECK(header_initialized_);
     return current_page_header_;
@@ -71,6 +79,11 @@ class ParquetPageReader {
  private:
   Status AdvanceStream(int64_t bytes);
 
+  /// Deserializes the page header at the current position of the stream into 'header'
+  /// without advancing the stream and sets '*header_size' to its serialized size. Sets
+  /// '*eos' to true if the stream is at its end.
+  Status PeekPageHeader(parquet::PageHeader* header, uint32_t* header_size, bool* eos);
+
   HdfsParquetScanner* parent_;
   std::string schema_name_;
 
@@ -17,6 +17,8 @@
 
 #include "exec/scan-node.h"
 
+#include <mutex>
+
 #include <boost/algorithm/string/join.hpp>
 #include <boost/bind.hpp>
 
@@ -37,6 +39,7 @@
 #include "util/disk-info.h"
 #include "util/pretty-printer.h"
 #include "util/runtime-profile-counters.h"
+#include "util/time.h"
 
 #include "common/names.h"
 
@@ -55,6 +58,34 @@ DEFINE_int32_hidden(max_queued_row_batches_per_scanner_thread, 5,
 DEFINE_int64(max_queued_row_batch_bytes, 16L * 1024 * 1024,
     "(Advanced) the maximum bytes of queued rows per multithreaded scan node.");
 
+DEFINE_bool(scanner_thread_adaptive_scaling, false,
+    "(Experimental) If true, multithreaded scan nodes adjust the number of scanner "
+    "threads to the rate at which the row batches are consumed: threads are stopped when "
+    "they are mostly blocked on a full row batch queue and started again when the "
+    "consumer waits for row batches.");
+
+DEFINE_int32(scanner_thread_scaling_interval_ms, 100,
+    "(Advanced) Minimum interval, in ms, between two evaluations of the number of "
+    "scanner threads of a scan node. Only used if --scanner_thread_adaptive_scaling "
+    "is true.");
+
+DEFINE_double(scanner_thread_scale_down_put_wait_ratio, 0.5,
+    "(Advanced) The number of scanner threads of a scan node is lowered if they spent "
+    "more than this fraction of their time blocked on a full row batch queue. Only used "
+    "if --scanner_thread_adaptive_scaling is true.");
+
+DEFINE_double(scanner_thread_scale_up_get_wait_ratio, 0.1,
+    "(Advanced) The number of scanner threads of a scan node is raised if the consumer "
+    "spent more than this fraction of the time waiting for row batches, unless the "
+    "scanner threads are bound by I/O, see --scanner_thread_scale_up_max_io_wait_ratio. "
+    "Only used if --scanner_thread_adaptive_scaling is true.");
+
+DEFINE_double(scanner_thread_scale_up_max_io_wait_ratio, 0.5,
+    "(Advanced) The number of scanner threads of a scan node is not raised if they spent "
+    "more than this fraction of their time waiting for I/O, since more threads would "
+    "only issue more concurrent reads. Only used if --scanner_thread_adaptive_scaling is "
+    "true.");
+
 using boost::algorithm::join;
 
 namespace impala {
@@ -91,6 +122,16 @@ PROFILE_DEFINE_COUNTER(RowBatchQueuePeakMemoryUsage, DEBUG, TUnit::BYTES,
     "Peak memory consumption of row batches enqueued in the scan node's output queue.");
 PROFILE_DEFINE_COUNTER(NumScannerThreadMemUnavailable, STABLE_LOW, TUnit::UNIT,
     "Number of times scanner threads were not created because of memory not available.");
+PROFILE_DEFINE_COUNTER(NumScannerThreadScaleUps, STABLE_LOW, TUnit::UNIT,
+    "Number of times the number of scanner threads was raised because the consumer was "
+    "waiting for row batches.");
+PROFILE_DEFINE_COUNTER(NumScannerThreadScaleDowns, STABLE_LOW, TUnit::UNIT,
+    "Number of times the number of scanner threads was lowered because the scanner "
+    "threads were blocked on a full row batch queue.");
+PROFILE_DEFINE_COUNTER(ScannerThreadTarget, DEBUG, TUnit::UNIT,
+    "Number of scanner threads that the scan node currently aims to run.");
+PROFILE_DEFINE_TIME_SERIES_COUNTER(ScannerThreadTargetSeries, UNSTABLE, TUnit::UNIT,
+    "Time series of ScannerThreadTarget.");
 PROFILE_DEFINE_SAMPLING_COUNTER(AverageScannerThreadConcurrency, STABLE_LOW,
     "Average number of executing scanner threads.");
 PROFILE_DEFINE_HIGH_WATER_MARK_COUNTER(PeakScannerThreadConcurrency, STABLE_LOW,
@@ -262,6 +303,10 @@ void ScanNode::ScannerThreadState::Prepare(
       PROFILE_RowBatchQueuePeakMemoryUsage.Instantiate(profile);
   scanner_thread_mem_unavailable_counter_ =
       PROFILE_NumScannerThreadMemUnavailable.Instantiate(profile);
+  scanner_thread_scale_ups_counter_ =
+      PROFILE_NumScannerThreadScaleUps.Instantiate(profile);
+  scanner_thread_scale_downs_counter_ =
+      PROFILE_NumScannerThreadScaleDowns.Instantiate(profile);
 
   parent->runtime_state()->query_state()->scanner_mem_limiter()->RegisterScan(
       parent, estimated_per_thread_mem);
@@ -276,6 +321,7 @@ void ScanNode::ScannerThreadState::Open(
     max_num_scanner_threads_ = state->query_options().num_scanner_threads;
   }
   DCHECK_GT(max_num_scanner_threads_, 0);
+  target_num_scanner_threads_.Store(max_num_scanner_threads_);
 
   int max_row_batches = max_row_batches_override;
   if (max_row_batches_override <= 0) {
@@ -310,6 +356,15 @@ void ScanNode::ScannerThreadState::Open(
       });
   peak_concurrency_ =
       PROFILE_PeakScannerThreadConcurrency.Instantiate(parent->runtime_profile());
+  if (FLAGS_scanner_thread_adaptive_scaling) {
+    scanner_thread_target_counter_ =
+        PROFILE_ScannerThreadTarget.Instantiate(parent->runtime_profile());
+    scanner_thread_target_counter_->Set(max_num_scanner_threads_);
+    scanner_thread_target_timeseries_counter_ =
+        PROFILE_ScannerThreadTargetSeries.Instantiate(
+            parent->runtime_profile(), scanner_thread_target_counter_);
+    last_scaling_eval_ns_ = MonotonicNanos();
+  }
 }
 
 void ScanNode::ScannerThreadState::AddThread(unique_ptr<Thread> thread) {
@@ -325,6 +380,65 @@ bool ScanNode::ScannerThreadState::DecrementNumActive() {
   return num_active_.Add(-1) == 0;
 }
 
+bool ScanNode::ScannerThreadState::UpdateThreadTarget(
+    RuntimeProfile::Counter* io_wait_timer) {
+  if (!FLAGS_scanner_thread_adaptive_scaling) return false;
+  unique_lock<SpinLock> l(scaling_lock_, std::try_to_lock);
+  if (!l.owns_lock()) return false;
+  const int64_t now = MonotonicNanos();
+  const int64_t elapsed_ns = now - last_scaling_eval_ns_;
+  if (elapsed_ns
+      < FLAGS_scanner_thread_scaling_interval_ms * MICROS_PER_MILLI * NANOS_PER_MICRO) {
+    return false;
+  }
+  const int64_t get_wait_ns = row_batches_get_timer_->value();
+  const int64_t put_wait_ns = row_batches_put_timer_->value();
+  const int64_t io_wait_ns = io_wait_timer == nullptr ? 0 : io_wait_timer->value();
+  const double get_wait_ratio =
+      static_cast<double>(get_wait_ns - last_get_wait_ns_) / elapsed_ns;
+  const int32_t num_active = num_active_.Load();
+  // Aggregate wall clock time of the scanner threads during the interval.
+  const double thread_time_ns = static_cast<double>(elapsed_ns) * max(num_active, 1);
+  const double put_wait_ratio = (put_wait_ns - last_put_wait_ns_) / thread_time_ns;
+  const double io_wait_ratio = (io_wait_ns - last_io_wait_ns_) / thread_time_ns;
+  last_scaling_eval_ns_ = now;
+  last_get_wait_ns_ = get_wait_ns;
+  last_put_wait_ns_ = put_wait_ns;
+  last_io_wait_ns_ = io_wait_ns;
+  if (num_active == 0) return false;
+
+  if (put_wait_ratio > FLAGS_scanner_thread_scale_down_put_wait_ratio
+      && batch_queue_->IsFull()) {
+    // The consumer does not keep up with the scanner threads. Stop one of them so that
+    // its memory is released instead of being held by a blocked thread.
+    if (num_active == 1 || pending_thread_exits_.Load() > 0) return false;
+    target_num_scanner_threads_.Store(num_active - 1);
+    pending_thread_exits_.Store(1);
+    COUNTER_ADD(scanner_thread_scale_downs_counter_, 1);
+    scanner_thread_target_counter_->Set(num_active - 1);
+    return false;
+  }
+  if (get_wait_ratio > FLAGS_scanner_thread_scale_up_get_wait_ratio
+      && io_wait_ratio < FLAGS_scanner_thread_scale_up_max_io_wait_ratio
+      && num_active < max_num_scanner_threads_) {
+    // The consumer is waiting for the scanner threads, which are not bound by I/O.
+    const int32_t target =
+        max(target_num_scanner_threads_.Load(), min(num_active + 1,
+            max_num_scanner_threads_));
+    target_num_scanner_threads_.Store(target);
+    pending_thread_exits_.Store(0);
+    COUNTER_ADD(scanner_thread_scale_ups_counter_, 1);
+    scanner_thread_target_counter_->Set(target);
+    return true;
+  }
+  return false;
+}
+
+bool ScanNode::ScannerThreadState::TryClaimThreadExit() {
+  int32_t pending = pending_thread_exits_.Load();
+  return pending > 0 && pending_thread_exits_.CompareAndSwap(pending, pending - 1);
+}
+
 void ScanNode::ScannerThreadState::EnqueueBatch(
     unique_ptr<RowBatch> row_batch) {
   // Only need to count tuple_data_pool() bytes since after IMPALA-5307, no buffers are
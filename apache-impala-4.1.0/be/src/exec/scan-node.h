@@ -21,6 +21,7 @@
 #include "exec/exec-node.h"
 #include "exec/filter-context.h"
 #include "util/runtime-profile.h"
+#include "util/spinlock.h"
 #include "util/thread.h"
 #include "gen-cpp/ImpalaInternalService_types.h"
 
@@ -248,6 +249,26 @@ class ScanNode : public ExecNode {
     bool EnqueueBatchWithTimeout(std::unique_ptr<RowBatch>* row_batch,
         int64_t timeout_micros);
 
+    /// Re-evaluates the number of scanner threads that the scan should run, see
+    /// 'target_num_scanner_threads_'. Does nothing if --scanner_thread_adaptive_scaling
+    /// is false or if the last evaluation was less than
+    /// --scanner_thread_scaling_interval_ms ago. 'io_wait_timer' is the aggregate time
+    /// scanner threads spent waiting for I/O, or nullptr if the scan does not track it.
+    /// Returns true if the consumer is waiting for row batches and another scanner
+    /// thread should be started. Thread-safe.
+    bool UpdateThreadTarget(RuntimeProfile::Counter* io_wait_timer);
+
+    /// Returns true if the calling optional scanner thread should exit because the
+    /// number of scanner threads was scaled down. At most one thread exits per
+    /// scale-down decision. Thread-safe.
+    bool TryClaimThreadExit();
+
+    /// Returns the number of scanner threads that the scan should run. Always at least
+    /// 1. Thread-safe.
+    int32_t target_num_scanner_threads() const {
+      return target_num_scanner_threads_.Load();
+    }
+
     BlockingRowBatchQueue* batch_queue() { return batch_queue_.get(); }
     RuntimeProfile::ThreadCounters* thread_counters() const { return thread_counters_; }
     int max_num_scanner_threads() const { return max_num_scanner_threads_; }
@@ -313,6 +334,40 @@ class ScanNode : public ExecNode {
 
     /// Number of times scanner threads were not created because of memory not available.
     RuntimeProfile::Counter* scanner_thread_mem_unavailable_counter_ = nullptr;
+
+    /// Feedback controller that scales the number of scanner threads with the rate at
+    /// which the consumer drains 'batch_queue_'. Every evaluation compares the time the
+    /// consumer and the scanner threads spent waiting on the queue, and the time the
+    /// scanner threads spent waiting for I/O, since the previous evaluation. If scanner
+    /// threads are mostly blocked on a full queue, the target is lowered below the
+    /// number of active threads and one optional thread exits after its current scan
+    /// range, releasing its memory. If the consumer is waiting for row batches and the
+    /// scanner threads are not bound by I/O, the target is raised again.
+    /// Initialized to 'max_num_scanner_threads_' in Open().
+    AtomicInt32 target_num_scanner_threads_{0};
+
+    /// Number of optional scanner threads that still have to exit to reach
+    /// 'target_num_scanner_threads_'. Either 0 or 1.
+    AtomicInt32 pending_thread_exits_{0};
+
+    /// Protects the state of the last evaluation below. Only try-locked, so that threads
+    /// never wait for each other to evaluate.
+    SpinLock scaling_lock_;
+
+    /// Time of the last evaluation and values of the wait time counters at that time.
+    int64_t last_scaling_eval_ns_ = 0;
+    int64_t last_get_wait_ns_ = 0;
+    int64_t last_put_wait_ns_ = 0;
+    int64_t last_io_wait_ns_ = 0;
+
+    /// Number of times the controller raised or lowered the number of scanner threads.
+    RuntimeProfile::Counter* scanner_thread_scale_ups_counter_ = nullptr;
+    RuntimeProfile::Counter* scanner_thread_scale_downs_counter_ = nullptr;
+
+    /// Current value of 'target_num_scanner_threads_' and its time series.
+    RuntimeProfile::Counter* scanner_thread_target_counter_ = nullptr;
+    RuntimeProfile::TimeSeriesCounter* scanner_thread_target_timeseries_counter_ =
+        nullptr;
   };
 };
 }
@@ -261,6 +261,16 @@ Status ScannerContext::Stream::GetBuffer(bool peek, uint8_t** out_buffer, int64_
   return Status::OK();
 }
 
+void ScannerContext::Stream::PeekBufferedBytes(uint8_t** buffer, int64_t* out_len) const {
+  if (boundary_buffer_bytes_left_ > 0) {
+    *buffer = boundary_buffer_pos_;
+    *out_len = boundary_buffer_bytes_left_;
+  } else {
+    *buffer = io_buffer_pos_;
+    *out_len = io_buffer_ == nullptr ? 0 : io_buffer_bytes_left_;
+  }
+}
+
 Status ScannerContext::Stream::GetBytesInternal(int64_t requested_len,
     uint8_t** out_buffer, bool peek, int64_t* out_len) {
   DCHECK_GT(requested_len, boundary_buffer_bytes_left_);
@@ -124,6 +124,13 @@ class ScannerContext {
     /// If we are past the end of the scan range, no bytes are returned.
     Status GetBuffer(bool peek, uint8_t** buffer, int64_t* out_len);
 
+    /// Returns the bytes that are already buffered at the current position without
+    /// blocking, copying or advancing the stream: the rest of the boundary buffer if
+    /// it is in use, otherwise the rest of the current IO buffer. Sets '*out_len' to 0
+    /// if no bytes are buffered. Like GetBytes(), this may return bytes past the end of
+    /// the scan range. The memory is valid until the stream is advanced.
+    void PeekBufferedBytes(uint8_t** buffer, int64_t* out_len) const;
+
     /// Callback that returns the buffer size to use when reading past the end of the scan
     /// range. Reading past the end of the scan range is likely a remote read, so we want
     /// find a good trade-off between io requests and data volume. Scanners that have
@@ -73,6 +73,12 @@ struct ScratchTupleBatch {
   // 'selected_rows[i]' would be true else false.
   boost::scoped_array<bool> selected_rows;
 
+  // Array of size 'capacity' in which column readers mark the rows that are rejected
+  // based on the dictionary codes of their values. A non-zero byte means that the row
+  // fails a conjunct and does not need to be evaluated. Only allocated if dictionary
+  // code filtering is used by the scanner, see EnableDictFilter().
+  boost::scoped_array<uint8_t> dict_filter_rejected;
+
   ScratchTupleBatch(
       const RowDescriptor& row_desc, int batch_size, MemTracker* mem_tracker)
     : capacity(batch_size),
@@ -83,8 +89,17 @@ struct ScratchTupleBatch {
     DCHECK_EQ(row_desc.tuple_descriptors().size(), 1);
   }
 
+  /// Allocates 'dict_filter_rejected'.
+  void EnableDictFilter() {
+    if (dict_filter_rejected == nullptr) {
+      dict_filter_rejected.reset(new uint8_t[capacity]);
+      memset(dict_filter_rejected.get(), 0, capacity);
+    }
+  }
+
   Status Reset(RuntimeState* state) {
     tuple_idx = 0;
+    if (dict_filter_rejected != nullptr) memset(dict_filter_rejected.get(), 0, capacity);
     num_tuples = 0;
     num_tuples_transferred = 0;
     if (tuple_mem == nullptr) {
@@ -403,12 +403,109 @@ const DateTimeFormatContext* SimpleDateFormatTokenizer::GetDefaultFormatContext(
   return nullptr;
 }
 
+bool SimpleDateFormatTokenizer::IsDefaultFormatContext(
+    const DateTimeFormatContext* dt_ctx) {
+  const int num_fractional_ctxs = FRACTIONAL_MAX_LEN + 1;
+  return dt_ctx == &DEFAULT_DATE_CTX || dt_ctx == &DEFAULT_SHORT_DATE_TIME_CTX
+      || dt_ctx == &DEFAULT_SHORT_ISO_DATE_TIME_CTX
+      || (dt_ctx >= DEFAULT_DATE_TIME_CTX
+          && dt_ctx < DEFAULT_DATE_TIME_CTX + num_fractional_ctxs)
+      || (dt_ctx >= DEFAULT_ISO_DATE_TIME_CTX
+          && dt_ctx < DEFAULT_ISO_DATE_TIME_CTX + num_fractional_ctxs);
+}
+
+namespace {
+
+/// Loads 8 characters starting at 's' into a little-endian 64-bit integer.
+inline uint64_t LoadEightChars(const char* s) {
+  uint64_t chunk;
+  memcpy(&chunk, s, sizeof(chunk));
+  return chunk;
+}
+
+/// Returns true if all bytes of 'chunk' that are selected by 'digit_mask' are decimal
+/// digits. Validates all of them at once, see StringParser::ParseEightDigits().
+inline bool AreDigits(uint64_t chunk, uint64_t digit_mask) {
+  const uint64_t zeros = 0x3030303030303030ULL & digit_mask;
+  const uint64_t high_nibbles = 0xF0F0F0F0F0F0F0F0ULL & digit_mask;
+  chunk &= digit_mask;
+  return (chunk & high_nibbles) == zeros
+      && ((chunk + (0x0606060606060606ULL & digit_mask)) & high_nibbles) == zeros;
+}
+
+/// Returns the value of the digit in byte 'idx' of 'chunk'.
+inline int DigitAt(uint64_t chunk, int idx) {
+  return static_cast<int>((chunk >> (8 * idx)) & 0xFF) - '0';
+}
+
+/// Returns the value of the two digits starting at byte 'idx' of 'chunk'.
+inline int TwoDigitsAt(uint64_t chunk, int idx) {
+  return DigitAt(chunk, idx) * 10 + DigitAt(chunk, idx + 1);
+}
+
+}
+
+bool SimpleDateFormatParser::ParseDefaultFormat(const char* str,
+    const DateTimeFormatContext& dt_ctx, DateTimeParseResult* dt_result) {
+  const int DATE_LEN = SimpleDateFormatTokenizer::DEFAULT_DATE_FMT_LEN;
+  const int DATE_TIME_LEN = SimpleDateFormatTokenizer::DEFAULT_SHORT_DATE_TIME_FMT_LEN;
+  const int MAX_FRACTION_LEN = SimpleDateFormatTokenizer::FRACTIONAL_MAX_LEN;
+  // Digits of "yyyy-MM-" and of "dd" in the chunk starting at "yy-MM-dd".
+  const uint64_t DATE_DIGITS = 0x00FFFF00FFFFFFFFULL;
+  const uint64_t DAY_DIGITS = 0xFFFF000000000000ULL;
+  // Digits of "HH:mm:ss".
+  const uint64_t TIME_DIGITS = 0xFFFF00FFFF00FFFFULL;
+
+  if (str[4] != '-' || str[7] != '-') return false;
+  const uint64_t date_chunk = LoadEightChars(str);
+  const uint64_t day_chunk = LoadEightChars(str + 2);
+  if (!AreDigits(date_chunk, DATE_DIGITS) || !AreDigits(day_chunk, DAY_DIGITS)) {
+    return false;
+  }
+  dt_result->year = TwoDigitsAt(date_chunk, 0) * 100 + TwoDigitsAt(date_chunk, 2);
+  dt_result->month = TwoDigitsAt(date_chunk, 5);
+  dt_result->day = TwoDigitsAt(day_chunk, 6);
+  if (dt_ctx.fmt_len == DATE_LEN) return true;
+
+  DCHECK_GE(dt_ctx.fmt_len, DATE_TIME_LEN);
+  if (str[10] != dt_ctx.fmt[10] || str[13] != ':' || str[16] != ':') return false;
+  const uint64_t time_chunk = LoadEightChars(str + 11);
+  if (!AreDigits(time_chunk, TIME_DIGITS)) return false;
+  dt_result->hour = TwoDigitsAt(time_chunk, 0);
+  dt_result->minute = TwoDigitsAt(time_chunk, 3);
+  dt_result->second = TwoDigitsAt(time_chunk, 6);
+  if (dt_ctx.fmt_len == DATE_TIME_LEN) return true;
+
+  if (str[DATE_TIME_LEN] != '.') return false;
+  const int fraction_len = dt_ctx.fmt_len - DATE_TIME_LEN - 1;
+  DCHECK_LE(fraction_len, MAX_FRACTION_LEN);
+  const char* fraction = str + DATE_TIME_LEN + 1;
+  int32_t value = 0;
+  for (int i = 0; i < fraction_len; ++i) {
+    if (fraction[i] < '0' || fraction[i] > '9') return false;
+    value = value * 10 + (fraction[i] - '0');
+  }
+  // Scale up the fraction to nanoseconds like ParseFractionToken() does.
+  for (int i = fraction_len; i < MAX_FRACTION_LEN; ++i) value *= 10;
+  dt_result->fraction = value;
+  return true;
+}
+
 bool SimpleDateFormatParser::ParseDateTime(const char* str, int str_len,
     const DateTimeFormatContext& dt_ctx, DateTimeParseResult* dt_result) {
   DCHECK(dt_ctx.fmt_len > 0);
   DCHECK(dt_ctx.toks.size() > 0);
   DCHECK(dt_result != NULL);
   if (str_len <= 0 || str_len < dt_ctx.fmt_len || str == NULL) return false;
+  // Most strings in text files use one of the default formats, which have a fixed
+  // layout that can be validated and parsed without going through the tokens. Apply
+  // the same range checks as the token-by-token parser below.
+  if (SimpleDateFormatTokenizer::IsDefaultFormatContext(&dt_ctx)
+      && ParseDefaultFormat(str, dt_ctx, dt_result)) {
+    return dt_result->month >= 1 && dt_result->month <= 12
+        && dt_result->day >= 1 && dt_result->day <= 31
+        && dt_result->hour <= 23 && dt_result->minute <= 59 && dt_result->second <= 59;
+  }
   StringParser::ParseResult status;
   // Keep track of the number of characters we need to shift token positions by.
   // Variable-length tokens will result in values > 0;
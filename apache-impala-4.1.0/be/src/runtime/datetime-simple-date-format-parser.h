@@ -111,6 +111,10 @@ public:
   static const DateTimeFormatContext* GetDefaultFormatContext(const char* str, int len,
       bool accept_time_toks);
 
+  /// Returns true if 'dt_ctx' is one of the default format contexts returned by
+  /// GetDefaultFormatContext().
+  static bool IsDefaultFormatContext(const DateTimeFormatContext* dt_ctx);
+
   /// Return default date/time format context for a timestamp parsing.
   /// If 'time' has a fractional seconds, context with pattern
   /// "yyyy-MM-dd HH:mm:ss.SSSSSSSSS" will be returned. Otherwise, return context with
@@ -170,6 +174,17 @@ public:
   /// Return true if the date/time was successfully parsed.
   static bool ParseDateTime(const char* str, int len,
       const DateTimeFormatContext& dt_ctx, DateTimeParseResult* dt_result);
+
+private:
+  /// Fast path of ParseDateTime() for the default formats "yyyy-MM-dd",
+  /// "yyyy-MM-dd HH:mm:ss" and "yyyy-MM-dd HH:mm:ss.S+" (or with 'T' instead of ' ').
+  /// If all fixed digit positions of 'str' hold digits and all separators match,
+  /// stores the parsed values in 'dt_result' and returns true. Otherwise returns false
+  /// and the caller must fall back to the token-by-token parser, which also accepts
+  /// e.g. signs and whitespace within numeric tokens. 'str' must hold at least
+  /// 'dt_ctx.fmt_len' characters.
+  static bool ParseDefaultFormat(const char* str, const DateTimeFormatContext& dt_ctx,
+      DateTimeParseResult* dt_result);
 };
 
 }
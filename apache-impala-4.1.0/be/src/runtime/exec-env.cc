@@ -27,6 +27,7 @@
 #include "common/logging.h"
 #include "common/object-pool.h"
 #include "exec/kudu-util.h"
+#include "exec/parquet/parquet-metadata-cache.h"
 #include "kudu/rpc/service_if.h"
 #include "rpc/rpc-mgr.h"
 #include "runtime/bufferpool/buffer-pool.h"
@@ -88,6 +89,13 @@ DEFINE_int32(state_store_subscriber_port, 23000,
     "port where StatestoreSubscriberService should be exported");
 DEFINE_int32(num_hdfs_worker_threads, 16,
     "(Advanced) The number of threads in the global HDFS operation pool");
+DEFINE_int32(codec_offload_threads, 0,
+    "(Advanced) The number of threads in the global pool that compresses and "
+    "decompresses data off the scanner and sink threads: the next data pages of Parquet "
+    "scanners and Avro blocks are decompressed ahead of decoding, the data pages of "
+    "Parquet writers are compressed while the sink keeps encoding rows and the streams "
+    "of multi-stream gzip and bzip2 text files are decompressed in parallel. Set to 0 "
+    "to compress and decompress data on the scanner and sink threads only.");
 DEFINE_int32(max_concurrent_queries, 0,
     "(Deprecated) This has been replaced with --admission_control_slots, which "
     "better accounts for the higher parallelism of queries with mt_dop > 1. "
@@ -208,6 +216,7 @@ ExecEnv::ExecEnv(int krpc_port, int subscriber_port, int webserver_port,
         !FLAGS_ssl_client_ca_certificate.empty())),
     htable_factory_(new HBaseTableFactory()),
     disk_io_mgr_(new io::DiskIoMgr()),
+    parquet_metadata_cache_(new ParquetMetadataCache()),
     webserver_(new Webserver(FLAGS_webserver_interface, webserver_port, metrics_.get())),
     pool_mem_trackers_(new PoolMemTrackerRegistry),
     thread_mgr_(new ThreadResourceMgr),
@@ -246,6 +255,14 @@ ExecEnv::ExecEnv(int krpc_port, int subscriber_port, int webserver_port,
     hdfs_op_thread_pool_.reset(
         CreateHdfsOpThreadPool("hdfs-worker-pool", FLAGS_num_hdfs_worker_threads, 1024));
   }
+  if (FLAGS_codec_offload_threads > 0) {
+    // Each Parquet column reader and writer has at most one page in flight and each Avro
+    // scanner a bounded number of blocks. Callers compress or decompress the data
+    // themselves if the queue is full.
+    codec_offload_pool_.reset(new CallableThreadPool("codec-offload",
+        "codec-offload-worker", FLAGS_codec_offload_threads,
+        4 * FLAGS_codec_offload_threads));
+  }
   if (FLAGS_is_coordinator && !AdmissionServiceEnabled()) {
     // We only need a Scheduler if we're performing admission control locally, i.e. if
     // this is a coordinator and there isn't an admissiond.
@@ -297,6 +314,9 @@ Status ExecEnv::Init() {
     RETURN_IF_ERROR(hdfs_op_thread_pool_->Init());
   }
   RETURN_IF_ERROR(async_rpc_pool_->Init());
+  if (codec_offload_pool_ != nullptr) {
+    RETURN_IF_ERROR(codec_offload_pool_->Init());
+  }
 
   int64_t bytes_limit;
   RETURN_IF_ERROR(ChooseProcessMemLimit(&bytes_limit));
@@ -422,6 +442,7 @@ Status ExecEnv::Init() {
   mem_tracker_->RegisterMetrics(metrics_.get(), "mem-tracker.process");
 
   RETURN_IF_ERROR(disk_io_mgr_->Init());
+  RETURN_IF_ERROR(parquet_metadata_cache_->Init(metrics_.get()));
 
   // Start services in order to ensure that dependencies between them are met
   if (enable_webserver_) {
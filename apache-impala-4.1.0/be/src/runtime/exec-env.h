@@ -57,6 +57,7 @@ class KrpcDataStreamMgr;
 class LibCache;
 class MemTracker;
 class MetricGroup;
+class ParquetMetadataCache;
 class PoolMemTrackerRegistry;
 class ObjectPool;
 class QueryResourceMgr;
@@ -123,6 +124,9 @@ class ExecEnv {
   }
   HBaseTableFactory* htable_factory() { return htable_factory_.get(); }
   io::DiskIoMgr* disk_io_mgr() { return disk_io_mgr_.get(); }
+  ParquetMetadataCache* parquet_metadata_cache() {
+    return parquet_metadata_cache_.get();
+  }
   Webserver* webserver() { return webserver_.get(); }
   Webserver* metrics_webserver() { return metrics_webserver_.get(); }
   MetricGroup* metrics() { return metrics_.get(); }
@@ -138,6 +142,9 @@ class ExecEnv {
   }
   RequestPoolService* request_pool_service() { return request_pool_service_.get(); }
   CallableThreadPool* rpc_pool() { return async_rpc_pool_.get(); }
+  /// Pool that compresses and decompresses data for Parquet, Avro and text scanners and
+  /// Parquet writers off their own threads. nullptr if --codec_offload_threads is 0.
+  CallableThreadPool* codec_offload_pool() { return codec_offload_pool_.get(); }
   QueryExecMgr* query_exec_mgr() { return query_exec_mgr_.get(); }
   RpcMgr* rpc_mgr() const { return rpc_mgr_.get(); }
   PoolMemTrackerRegistry* pool_mem_trackers() { return pool_mem_trackers_.get(); }
@@ -203,6 +210,7 @@ class ExecEnv {
   boost::scoped_ptr<CatalogServiceClientCache> catalogd_client_cache_;
   boost::scoped_ptr<HBaseTableFactory> htable_factory_;
   boost::scoped_ptr<io::DiskIoMgr> disk_io_mgr_;
+  boost::scoped_ptr<ParquetMetadataCache> parquet_metadata_cache_;
   boost::scoped_ptr<Webserver> webserver_;
   boost::scoped_ptr<Webserver> metrics_webserver_;
   boost::scoped_ptr<MemTracker> mem_tracker_;
@@ -218,6 +226,7 @@ class ExecEnv {
   boost::scoped_ptr<Frontend> frontend_;
 
   boost::scoped_ptr<CallableThreadPool> async_rpc_pool_;
+  boost::scoped_ptr<CallableThreadPool> codec_offload_pool_;
   boost::scoped_ptr<QueryExecMgr> query_exec_mgr_;
   boost::scoped_ptr<RpcMgr> rpc_mgr_;
   boost::scoped_ptr<ControlService> control_svc_;
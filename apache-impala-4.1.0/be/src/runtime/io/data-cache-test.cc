@@ -34,8 +34,10 @@
 #include "testutil/scoped-flag-setter.h"
 #include "util/counting-barrier.h"
 #include "util/filesystem-util.h"
+#include "util/impalad-metrics.h"
 #include "util/simple-logger.h"
 #include "util/thread.h"
+#include "util/time.h"
 
 #include "common/names.h"
 
@@ -57,12 +59,19 @@
 #define NUM_CACHE_ENTRIES_NO_EVICT (NUM_CACHE_ENTRIES - 1)
 
 DECLARE_bool(cache_force_single_shard);
+DECLARE_bool(data_cache_checksum);
+DECLARE_bool(data_cache_persistent);
 DECLARE_bool(data_cache_anonymize_trace);
 DECLARE_bool(data_cache_enable_tracing);
 DECLARE_int64(data_cache_file_max_size_bytes);
 DECLARE_int32(data_cache_max_opened_files);
 DECLARE_int32(data_cache_write_concurrency);
 DECLARE_string(data_cache_eviction_policy);
+DECLARE_string(data_cache_memory_tier_capacity);
+DECLARE_bool(data_cache_direct_io);
+DECLARE_string(data_cache_admission_policy);
+DECLARE_int32(data_cache_num_async_write_threads);
+DECLARE_string(data_cache_async_write_buffer_limit);
 DECLARE_string(data_cache_trace_dir);
 DECLARE_int32(max_data_cache_trace_file_size);
 DECLARE_int32(data_cache_trace_percentage);
@@ -337,6 +346,318 @@ TEST_P(DataCacheTest, TestBasics) {
   ASSERT_EQ(0, cache.Lookup(FNAME, MTIME, 0, -5000, buffer));
 }
 
+// Tests that entries hit in the backing file are promoted into the in-memory tier and
+// that the in-memory copy is dropped when the entry is replaced.
+TEST_P(DataCacheTest, MemoryTier) {
+  FLAGS_data_cache_memory_tier_capacity = std::to_string(DEFAULT_CACHE_SIZE);
+  DataCache cache(
+      Substitute("$0:$1", data_cache_dirs()[0], std::to_string(DEFAULT_CACHE_SIZE)));
+  ASSERT_OK(cache.Init());
+  IntCounter* memory_hits = ImpaladMetrics::IO_MGR_REMOTE_DATA_CACHE_MEMORY_HIT_COUNT;
+  const int64_t initial_memory_hits = memory_hits->GetValue();
+
+  uint8_t buffer[TEMP_BUFFER_SIZE + 10];
+  ASSERT_TRUE(cache.Store(FNAME, MTIME, 0, test_buffer(), TEMP_BUFFER_SIZE));
+  // The first hit reads from the backing file and promotes the entry. Later hits are
+  // served from memory.
+  for (int i = 0; i < 3; ++i) {
+    memset(buffer, 0, TEMP_BUFFER_SIZE);
+    ASSERT_EQ(TEMP_BUFFER_SIZE,
+        cache.Lookup(FNAME, MTIME, 0, TEMP_BUFFER_SIZE, buffer));
+    ASSERT_EQ(0, memcmp(test_buffer(), buffer, TEMP_BUFFER_SIZE));
+    ASSERT_EQ(initial_memory_hits + i, memory_hits->GetValue());
+  }
+  // Partial lookups are served from memory too.
+  ASSERT_EQ(TEMP_BUFFER_SIZE - 10,
+      cache.Lookup(FNAME, MTIME, 0, TEMP_BUFFER_SIZE - 10, buffer));
+  ASSERT_EQ(0, memcmp(test_buffer(), buffer, TEMP_BUFFER_SIZE - 10));
+  ASSERT_EQ(initial_memory_hits + 3, memory_hits->GetValue());
+
+  // Replacing the entry with a longer one invalidates the copy in memory.
+  ASSERT_TRUE(cache.Store(FNAME, MTIME, 0, test_buffer(), TEMP_BUFFER_SIZE + 10));
+  ASSERT_EQ(TEMP_BUFFER_SIZE + 10,
+      cache.Lookup(FNAME, MTIME, 0, TEMP_BUFFER_SIZE + 10, buffer));
+  ASSERT_EQ(0, memcmp(test_buffer(), buffer, TEMP_BUFFER_SIZE + 10));
+  ASSERT_EQ(initial_memory_hits + 3, memory_hits->GetValue());
+}
+
+// Tests that the memory of the in-memory tier is accounted for and that a copy in memory
+// is not served once its entry is gone from the metadata cache.
+TEST_P(DataCacheTest, MemoryTierEviction) {
+  FLAGS_data_cache_memory_tier_capacity = std::to_string(DEFAULT_CACHE_SIZE);
+  IntGauge* memory_bytes = ImpaladMetrics::IO_MGR_REMOTE_DATA_CACHE_MEMORY_TOTAL_BYTES;
+  IntCounter* memory_hits = ImpaladMetrics::IO_MGR_REMOTE_DATA_CACHE_MEMORY_HIT_COUNT;
+  const int64_t initial_memory_bytes = memory_bytes->GetValue();
+  {
+    DataCache cache(
+        Substitute("$0:$1", data_cache_dirs()[0], std::to_string(DEFAULT_CACHE_SIZE)));
+    ASSERT_OK(cache.Init());
+    uint8_t buffer[TEMP_BUFFER_SIZE];
+    ASSERT_TRUE(cache.Store(FNAME, MTIME, 0, test_buffer(), TEMP_BUFFER_SIZE));
+    ASSERT_EQ(TEMP_BUFFER_SIZE, cache.Lookup(FNAME, MTIME, 0, TEMP_BUFFER_SIZE, buffer));
+    // The copy in memory is charged for its content and a small header.
+    ASSERT_GT(memory_bytes->GetValue(), initial_memory_bytes + TEMP_BUFFER_SIZE);
+    const int64_t initial_memory_hits = memory_hits->GetValue();
+    ASSERT_EQ(TEMP_BUFFER_SIZE, cache.Lookup(FNAME, MTIME, 0, TEMP_BUFFER_SIZE, buffer));
+    ASSERT_EQ(initial_memory_hits + 1, memory_hits->GetValue());
+
+    // Evict the entry from the metadata cache by inserting other entries which are
+    // never looked up. They are not promoted, so the copy stays in memory. The LIRS
+    // policy keeps the frequently hit entry, so this is only done for LRU.
+    if (FLAGS_data_cache_eviction_policy == "LRU") {
+      for (int64_t i = 1; i <= NUM_CACHE_ENTRIES; ++i) {
+        ASSERT_TRUE(cache.Store(FNAME, MTIME, i * TEMP_BUFFER_SIZE, test_buffer(),
+            TEMP_BUFFER_SIZE));
+      }
+      ASSERT_EQ(0, cache.Lookup(FNAME, MTIME, 0, TEMP_BUFFER_SIZE, buffer));
+      ASSERT_EQ(initial_memory_hits + 1, memory_hits->GetValue());
+    }
+  }
+  // Destroying the cache releases the memory of all copies.
+  ASSERT_EQ(initial_memory_bytes, memory_bytes->GetValue());
+}
+
+// Tests that entries are stored and looked up with direct I/O, both for buffers and
+// lengths that are aligned to pages and for ones that go through a bounce buffer.
+TEST_P(DataCacheTest, DirectIo) {
+  FLAGS_data_cache_direct_io = true;
+  const int64_t LARGE_ENTRY_SIZE = 9L * 1024L * 1024L + 10;
+  const int64_t cache_size = 4 * LARGE_ENTRY_SIZE;
+  DataCache cache(Substitute("$0:$1", data_cache_dirs()[0], std::to_string(cache_size)));
+  Status status = cache.Init();
+  if (!status.ok()) {
+    LOG(INFO) << "Skipping test, direct I/O is not supported: " << status.GetDetail();
+    return;
+  }
+  IntCounter* direct_bytes_read = ImpaladMetrics::IO_MGR_DIRECT_IO_BYTES_READ;
+  IntCounter* direct_bytes_written = ImpaladMetrics::IO_MGR_DIRECT_IO_BYTES_WRITTEN;
+  const int64_t initial_bytes_read = direct_bytes_read->GetValue();
+  const int64_t initial_bytes_written = direct_bytes_written->GetValue();
+
+  // A page aligned buffer of a whole page is read and written in place.
+  void* aligned = nullptr;
+  ASSERT_EQ(0, posix_memalign(&aligned, TEMP_BUFFER_SIZE, TEMP_BUFFER_SIZE));
+  unique_ptr<uint8_t, decltype(&free)> aligned_buffer(
+      reinterpret_cast<uint8_t*>(aligned), free);
+  memcpy(aligned_buffer.get(), test_buffer(), TEMP_BUFFER_SIZE);
+  ASSERT_TRUE(cache.Store(FNAME, MTIME, 0, aligned_buffer.get(), TEMP_BUFFER_SIZE));
+  memset(aligned_buffer.get(), 0, TEMP_BUFFER_SIZE);
+  ASSERT_EQ(TEMP_BUFFER_SIZE,
+      cache.Lookup(FNAME, MTIME, 0, TEMP_BUFFER_SIZE, aligned_buffer.get()));
+  ASSERT_EQ(0, memcmp(test_buffer(), aligned_buffer.get(), TEMP_BUFFER_SIZE));
+
+  // Unaligned buffers and lengths go through a bounce buffer.
+  uint8_t buffer[TEMP_BUFFER_SIZE + 10];
+  for (int64_t len : {TEMP_BUFFER_SIZE - 10, TEMP_BUFFER_SIZE, TEMP_BUFFER_SIZE + 10}) {
+    for (int64_t offset = 1; offset < 64; ++offset) {
+      ASSERT_TRUE(cache.Store(FNAME, MTIME + len, offset, test_buffer() + offset, len));
+    }
+    for (int64_t offset = 1; offset < 64; ++offset) {
+      memset(buffer, 0, sizeof(buffer));
+      ASSERT_EQ(len, cache.Lookup(FNAME, MTIME + len, offset, len, buffer + 1));
+      ASSERT_EQ(0, memcmp(test_buffer() + offset, buffer + 1, len));
+    }
+  }
+
+  // A large entry through a bounce buffer. The LIRS policy doesn't admit entries
+  // larger than its unprotected segment.
+  if (FLAGS_data_cache_eviction_policy == "LRU") {
+    vector<uint8_t> large_entry(LARGE_ENTRY_SIZE);
+    for (int64_t i = 0; i < LARGE_ENTRY_SIZE; ++i) large_entry[i] = rand();
+    ASSERT_TRUE(cache.Store(FNAME, MTIME, 1024, large_entry.data(), LARGE_ENTRY_SIZE));
+    vector<uint8_t> large_buffer(LARGE_ENTRY_SIZE);
+    ASSERT_EQ(LARGE_ENTRY_SIZE,
+        cache.Lookup(FNAME, MTIME, 1024, LARGE_ENTRY_SIZE, large_buffer.data()));
+    ASSERT_TRUE(large_entry == large_buffer);
+  }
+
+  EXPECT_GT(direct_bytes_read->GetValue(), initial_bytes_read);
+  EXPECT_GT(direct_bytes_written->GetValue(), initial_bytes_written);
+  ASSERT_OK(cache.CloseFilesAndVerifySizes());
+}
+
+// Same as MultiThreadedNoMisses but with direct I/O, so that the threads read and
+// write through bounce buffers concurrently.
+TEST_P(DataCacheTest, MultiThreadedDirectIo) {
+  FLAGS_data_cache_direct_io = true;
+  DataCache cache(
+      Substitute("$0:$1", data_cache_dirs()[0], std::to_string(DEFAULT_CACHE_SIZE)));
+  Status status = cache.Init();
+  if (!status.ok()) {
+    LOG(INFO) << "Skipping test, direct I/O is not supported: " << status.GetDetail();
+    return;
+  }
+  int64_t max_start_offset = NUM_CACHE_ENTRIES_NO_EVICT;
+  bool use_per_thread_filename = false;
+  bool expect_misses = false;
+  MultiThreadedReadWrite(&cache, max_start_offset, use_per_thread_filename,
+      expect_misses);
+}
+
+// Tests that the TinyLFU admission policy keeps frequently accessed entries in a full
+// cache while a scan of entries which are only accessed once passes through.
+TEST_P(DataCacheTest, TinyLfuAdmission) {
+  // The LIRS policy may evict entries before the cache is full.
+  if (FLAGS_data_cache_eviction_policy != "LRU") return;
+  FLAGS_data_cache_admission_policy = "TinyLFU";
+  const int64_t cache_size = 4 * TEMP_BUFFER_SIZE;
+  DataCache cache(Substitute("$0:$1", data_cache_dirs()[0], std::to_string(cache_size)));
+  ASSERT_OK(cache.Init());
+
+  // Fill the cache with entries which are looked up a few times.
+  uint8_t buffer[TEMP_BUFFER_SIZE];
+  for (int64_t offset = 0; offset < 4; ++offset) {
+    ASSERT_EQ(0, cache.Lookup(FNAME, MTIME, offset, TEMP_BUFFER_SIZE, buffer));
+    ASSERT_TRUE(cache.Store(FNAME, MTIME, offset, test_buffer() + offset,
+        TEMP_BUFFER_SIZE));
+  }
+  for (int i = 0; i < 3; ++i) {
+    for (int64_t offset = 0; offset < 4; ++offset) {
+      ASSERT_EQ(TEMP_BUFFER_SIZE,
+          cache.Lookup(FNAME, MTIME, offset, TEMP_BUFFER_SIZE, buffer));
+    }
+  }
+
+  // A scan which misses once per entry doesn't evict the frequently accessed entries.
+  const string scan_fname = "scanned";
+  for (int64_t offset = 0; offset < 64; ++offset) {
+    ASSERT_EQ(0, cache.Lookup(scan_fname, MTIME, offset, TEMP_BUFFER_SIZE, buffer));
+    ASSERT_FALSE(cache.Store(scan_fname, MTIME, offset, test_buffer() + offset,
+        TEMP_BUFFER_SIZE));
+  }
+  for (int64_t offset = 0; offset < 4; ++offset) {
+    memset(buffer, 0, TEMP_BUFFER_SIZE);
+    ASSERT_EQ(TEMP_BUFFER_SIZE,
+        cache.Lookup(FNAME, MTIME, offset, TEMP_BUFFER_SIZE, buffer));
+    ASSERT_EQ(0, memcmp(test_buffer() + offset, buffer, TEMP_BUFFER_SIZE));
+  }
+}
+
+// Tests that insertions are written by the asynchronous writers and that insertions
+// beyond the buffer limit are dropped.
+TEST_P(DataCacheTest, AsyncWrites) {
+  FLAGS_data_cache_num_async_write_threads = 2;
+  FLAGS_data_cache_async_write_buffer_limit = std::to_string(DEFAULT_CACHE_SIZE);
+  DataCache cache(
+      Substitute("$0:$1", data_cache_dirs()[0], std::to_string(DEFAULT_CACHE_SIZE)));
+  ASSERT_OK(cache.Init());
+
+  for (int64_t offset = 0; offset < NUM_CACHE_ENTRIES_NO_EVICT; ++offset) {
+    ASSERT_TRUE(cache.Store(FNAME, MTIME, offset, test_buffer() + offset,
+        TEMP_BUFFER_SIZE));
+  }
+  // An insertion larger than the buffer limit is dropped without blocking.
+  IntCounter* dropped =
+      ImpaladMetrics::IO_MGR_REMOTE_DATA_CACHE_ASYNC_WRITES_DROPPED_ENTRIES;
+  const int64_t initial_dropped = dropped->GetValue();
+  ASSERT_FALSE(cache.Store(FNAME, MTIME, TEST_BUFFER_SIZE, test_buffer(),
+      DEFAULT_CACHE_SIZE + 1));
+  ASSERT_EQ(initial_dropped + 1, dropped->GetValue());
+
+  // Wait for the queued insertions to complete.
+  IntGauge* outstanding =
+      ImpaladMetrics::IO_MGR_REMOTE_DATA_CACHE_NUM_ASYNC_WRITES_OUTSTANDING;
+  for (int i = 0; i < 1000 && outstanding->GetValue() > 0; ++i) SleepForMs(10);
+  ASSERT_EQ(0, outstanding->GetValue());
+
+  uint8_t buffer[TEMP_BUFFER_SIZE];
+  for (int64_t offset = 0; offset < NUM_CACHE_ENTRIES_NO_EVICT; ++offset) {
+    memset(buffer, 0, TEMP_BUFFER_SIZE);
+    ASSERT_EQ(TEMP_BUFFER_SIZE,
+        cache.Lookup(FNAME, MTIME, offset, TEMP_BUFFER_SIZE, buffer)) << offset;
+    ASSERT_EQ(0, memcmp(test_buffer() + offset, buffer, TEMP_BUFFER_SIZE));
+  }
+}
+
+// Tests that the insertions still queued when the cache is destroyed are dropped and
+// that their buffers are no longer counted as outstanding.
+TEST_P(DataCacheTest, AsyncWritesShutdown) {
+  FLAGS_data_cache_num_async_write_threads = 1;
+  FLAGS_data_cache_async_write_buffer_limit = std::to_string(DEFAULT_CACHE_SIZE);
+  IntGauge* outstanding =
+      ImpaladMetrics::IO_MGR_REMOTE_DATA_CACHE_NUM_ASYNC_WRITES_OUTSTANDING;
+  IntGauge* outstanding_bytes =
+      ImpaladMetrics::IO_MGR_REMOTE_DATA_CACHE_ASYNC_WRITES_OUTSTANDING_BYTES;
+  const int64_t initial_outstanding = outstanding->GetValue();
+  const int64_t initial_outstanding_bytes = outstanding_bytes->GetValue();
+  {
+    DataCache cache(
+        Substitute("$0:$1", data_cache_dirs()[0], std::to_string(DEFAULT_CACHE_SIZE)));
+    ASSERT_OK(cache.Init());
+    // Queue more insertions than a single writer completes before the cache goes away.
+    for (int64_t offset = 0; offset < NUM_CACHE_ENTRIES_NO_EVICT; ++offset) {
+      cache.Store(FNAME, MTIME, offset, test_buffer() + offset, TEMP_BUFFER_SIZE);
+    }
+  }
+  ASSERT_EQ(initial_outstanding, outstanding->GetValue());
+  ASSERT_EQ(initial_outstanding_bytes, outstanding_bytes->GetValue());
+}
+
+// Tests that a persistent cache reloads its entries after a restart and that reloaded
+// entries whose content doesn't match their checksum are dropped.
+TEST_P(DataCacheTest, Persistence) {
+  // Checkpoints are only supported with the LRU policy.
+  if (FLAGS_data_cache_eviction_policy != "LRU") return;
+  FLAGS_data_cache_persistent = true;
+  FLAGS_data_cache_checksum = true;
+  const string& config =
+      Substitute("$0:$1", data_cache_dirs()[0], std::to_string(DEFAULT_CACHE_SIZE));
+  const int num_entries = 16;
+  {
+    DataCache cache(config);
+    ASSERT_OK(cache.Init());
+    for (int64_t offset = 0; offset < num_entries; ++offset) {
+      ASSERT_TRUE(cache.Store(FNAME, MTIME, offset, test_buffer() + offset,
+          TEMP_BUFFER_SIZE));
+    }
+  }
+
+  // Overwrite the first entry in the backing file, which is the one at offset 0.
+  vector<string> entries;
+  ASSERT_OK(FileSystemUtil::Directory::GetEntryNames(data_cache_dirs()[0], &entries));
+  int num_backing_files = 0;
+  for (const string& entry : entries) {
+    if (entry.find("impala-cache-file-") != 0) continue;
+    ++num_backing_files;
+    fstream file(Substitute("$0/$1", data_cache_dirs()[0], entry),
+        ios::in | ios::out | ios::binary);
+    ASSERT_TRUE(file.is_open());
+    string garbage(TEMP_BUFFER_SIZE, 'x');
+    file.write(garbage.data(), garbage.size());
+  }
+  ASSERT_EQ(1, num_backing_files);
+
+  IntCounter* reloaded = ImpaladMetrics::IO_MGR_REMOTE_DATA_CACHE_RELOADED_ENTRIES;
+  const int64_t initial_reloaded = reloaded->GetValue();
+  {
+    DataCache cache(config);
+    ASSERT_OK(cache.Init());
+    ASSERT_EQ(initial_reloaded + num_entries, reloaded->GetValue());
+    uint8_t buffer[TEMP_BUFFER_SIZE];
+    ASSERT_EQ(0, cache.Lookup(FNAME, MTIME, 0, TEMP_BUFFER_SIZE, buffer));
+    for (int64_t offset = 1; offset < num_entries; ++offset) {
+      memset(buffer, 0, TEMP_BUFFER_SIZE);
+      ASSERT_EQ(TEMP_BUFFER_SIZE - 10,
+          cache.Lookup(FNAME, MTIME, offset, TEMP_BUFFER_SIZE - 10, buffer));
+      ASSERT_EQ(0, memcmp(test_buffer() + offset, buffer, TEMP_BUFFER_SIZE - 10));
+      ASSERT_EQ(TEMP_BUFFER_SIZE,
+          cache.Lookup(FNAME, MTIME, offset, TEMP_BUFFER_SIZE, buffer));
+      ASSERT_EQ(0, memcmp(test_buffer() + offset, buffer, TEMP_BUFFER_SIZE));
+    }
+    // The dropped entry can be stored again.
+    ASSERT_TRUE(cache.Store(FNAME, MTIME, 0, test_buffer(), TEMP_BUFFER_SIZE));
+  }
+
+  // A cache which isn't persistent deletes the backing files and the checkpoint.
+  FLAGS_data_cache_persistent = false;
+  {
+    DataCache cache(config);
+    ASSERT_OK(cache.Init());
+    uint8_t buffer[TEMP_BUFFER_SIZE];
+    ASSERT_EQ(0, cache.Lookup(FNAME, MTIME, 1, TEMP_BUFFER_SIZE, buffer));
+  }
+}
+
 // Tests backing file rotation by setting FLAGS_data_cache_file_max_size_bytes to be 1/4
 // of the cache size. This forces rotation of backing files.
 TEST_P(DataCacheTest, RotateFiles) {
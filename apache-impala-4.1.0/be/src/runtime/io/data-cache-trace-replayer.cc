@@ -53,6 +53,11 @@
 // data-cache-trace-replayer --trace_directory /path/to/trace/directory
 //     --data_cache="/cache_path:100GB" --data_cache_eviction_policy=LIRS
 //
+// To run against the same cache, but only admitting entries that are more frequently
+// accessed than the entries they would evict:
+// data-cache-trace-replayer --trace_directory /path/to/trace/directory
+//     --data_cache="/cache_path:100GB" --data_cache_admission_policy=TinyLFU
+//
 // The replayer produces two different types of cache hit statistics. The first is
 // the cache hit statistics from the original trace (i.e. the original 100GB cache
 // using LRU). This is a fixed property of a given set of trace files, and it will
@@ -19,11 +19,13 @@
 
 #include <errno.h>
 #include <fcntl.h>
+#include <limits>
 #include <mutex>
 #include <string.h>
 #include <unistd.h>
 #include <sstream>
 
+#include <boost/algorithm/string.hpp>
 #include <glog/logging.h>
 
 #include "common/compiler-util.h"
@@ -34,7 +36,9 @@
 #include "gutil/port.h"
 #include "gutil/strings/split.h"
 #include "gutil/walltime.h"
+#include "runtime/exec-env.h"
 #include "runtime/io/data-cache-trace.h"
+#include "runtime/mem-tracker.h"
 #include "util/bit-util.h"
 #include "util/cache/cache.h"
 #include "util/error-util.h"
@@ -81,6 +85,17 @@ DEFINE_int32(data_cache_max_opened_files, 1000,
 DEFINE_int32(data_cache_write_concurrency, 1,
     "(Advanced) Number of concurrent threads allowed to insert into the cache per "
     "partition.");
+DEFINE_int32(data_cache_num_async_write_threads, 0,
+    "(Advanced) Number of threads which insert entries into the data cache in the "
+    "background. If greater than 0, the data read from remote storage is copied into a "
+    "temporary buffer and written to the cache by these threads, so that the I/O "
+    "threads never wait for the writes. If 0, entries are inserted synchronously, "
+    "subject to --data_cache_write_concurrency.");
+DEFINE_string(data_cache_async_write_buffer_limit, "256MB",
+    "(Advanced) Limit on the total size of the temporary buffers of the insertions "
+    "queued for asynchronous writes into the data cache. The buffers are tracked by the "
+    "process memory tracker. Insertions which exceed this limit or the process memory "
+    "limit are dropped. Only used if --data_cache_num_async_write_threads > 0.");
 DEFINE_bool(data_cache_checksum, ENABLE_CHECKSUMMING,
     "(Advanced) Enable checksumming for the cached buffer.");
 
@@ -103,6 +118,39 @@ DEFINE_int32(max_data_cache_trace_files, 10, "Maximum number of data cache trace
     "parameter. The most recent trace files are retained. If set to 0, all trace files "
     "are retained.");
 
+DEFINE_bool(data_cache_direct_io, false,
+    "(Advanced) If true, the data cache reads and writes its backing files with direct "
+    "I/O (O_DIRECT), bypassing the operating system's page cache. This avoids caching "
+    "the same data twice and keeps the data cache from evicting other data from the page "
+    "cache. Entries whose buffer or length is not aligned to 4KB are copied through an "
+    "aligned bounce buffer.");
+
+DEFINE_string(data_cache_memory_tier_capacity, "0",
+    "(Advanced) Capacity of the in-memory tier of each data cache partition, e.g. 1GB. "
+    "Entries which are read from the data cache files are kept in memory up to this "
+    "capacity so that repeated hits don't need to read from local storage. The memory "
+    "is tracked by the process memory tracker and counted against the process memory "
+    "limit. Entries are not kept in memory if that would exceed the process memory "
+    "limit. 0 disables the in-memory tier.");
+
+DEFINE_string(data_cache_admission_policy, "ALL",
+    "(Advanced) The admission policy of the data cache. Either 'ALL' (default), which "
+    "inserts every entry read from remote storage, or 'TinyLFU', which keeps a "
+    "frequency sketch of the looked up entries and only inserts an entry into a full "
+    "partition if it's accessed more frequently than the entries being evicted. This "
+    "prevents one-off scans from evicting frequently accessed data. The sketch uses "
+    "up to 32MB of memory per partition.");
+
+DEFINE_bool(data_cache_persistent, false,
+    "(Advanced) If true, each data cache partition periodically writes a checkpoint of "
+    "its index to its directory and keeps its backing files on shutdown. On startup, "
+    "the entries in the checkpoint are reloaded so that a restarted daemon starts with "
+    "a warm cache. Reloaded entries are verified against their checksums on every read. "
+    "Requires --data_cache_checksum and the LRU eviction policy.");
+DEFINE_int32(data_cache_checkpoint_interval_s, 300,
+    "(Advanced) Interval in seconds between two checkpoints of the data cache index if "
+    "--data_cache_persistent is true. A checkpoint is also written on shutdown.");
+
 DEFINE_string(data_cache_eviction_policy, "LRU",
     "(Advanced) The cache eviction policy to use for the data cache. "
     "Either 'LRU' (default) or 'LIRS' (experimental)");
@@ -112,7 +160,14 @@ namespace io {
 
 static const int64_t PAGE_SIZE = 1L << 12;
 const char* DataCache::Partition::CACHE_FILE_PREFIX = "impala-cache-file-";
+// Must not start with CACHE_FILE_PREFIX.
+const char* DataCache::Partition::CHECKPOINT_FILE_NAME = "impala-cache-checkpoint";
+// Identifies the format of the checkpoint files.
+static const char* CHECKPOINT_MAGIC = "IMPDCCK1";
 const int MAX_FILE_DELETER_QUEUE_SIZE = 500;
+// The queued insertions are bound by --data_cache_async_write_buffer_limit. This is
+// only a bound on the number of tiny entries.
+const int MAX_STORE_TASK_QUEUE_SIZE = 1 << 20;
 static const char* PARTITION_PATH_METRIC_KEY_TEMPLATE =
     "impala-server.io-mgr.remote-data-cache-partition-$0.path";
 static const char* PARTITION_READ_LATENCY_METRIC_KEY_TEMPLATE =
@@ -152,17 +207,46 @@ class DataCache::CacheFile {
  public:
   ~CacheFile() {
     // Close file if it's not closed already.
-    DeleteFile();
+    if (keep_file_) {
+      Close();
+    } else {
+      DeleteFile();
+    }
   }
 
   static Status Create(std::string path, std::unique_ptr<CacheFile>* cache_file_ptr) {
     unique_ptr<CacheFile> cache_file(new CacheFile(path));
     KUDU_RETURN_IF_ERROR(kudu::Env::Default()->NewRWFile(path, &cache_file->file_),
         "Failed to create cache file");
+    RETURN_IF_ERROR(cache_file->OpenDirectFd());
+    *cache_file_ptr = std::move(cache_file);
+    return Status::OK();
+  }
+
+  // Opens an existing backing file, e.g. one left over from a previous run of a
+  // persistent cache. Nothing can be appended to the file.
+  static Status OpenExisting(
+      std::string path, std::unique_ptr<CacheFile>* cache_file_ptr) {
+    unique_ptr<CacheFile> cache_file(new CacheFile(path));
+    kudu::RWFileOptions opts;
+    opts.mode = Env::MUST_EXIST;
+    KUDU_RETURN_IF_ERROR(kudu::Env::Default()->NewRWFile(opts, path, &cache_file->file_),
+        "Failed to open cache file");
+    uint64_t size;
+    KUDU_RETURN_IF_ERROR(cache_file->file_->Size(&size), "Failed to get cache file size");
+    cache_file->current_offset_.Store(BitUtil::RoundUp(size, PAGE_SIZE));
+    cache_file->allow_append_ = false;
+    RETURN_IF_ERROR(cache_file->OpenDirectFd());
     *cache_file_ptr = std::move(cache_file);
     return Status::OK();
   }
 
+  // Keep the file on the filesystem when this object is destroyed.
+  void KeepFile() { keep_file_ = true; }
+
+  // Returns the size of the file up to the end of the last allocation.
+  int64_t size() const { return current_offset_.Load(); }
+
   // Close the underlying file so it cannot be read or written to anymore.
   void Close() {
     // Explicitly hold the lock in write mode to block all readers. This ensures that
@@ -176,6 +260,13 @@ class DataCache::CacheFile {
           status.ToString());
     }
     file_.reset();
+    if (direct_fd_ >= 0) {
+      if (close(direct_fd_) != 0) {
+        LOG(WARNING) << Substitute("Failed to close cache file $0: $1", path_,
+            GetStrErrMsg());
+      }
+      direct_fd_ = -1;
+    }
     allow_append_ = false;
   }
 
@@ -220,6 +311,7 @@ class DataCache::CacheFile {
     kudu::shared_lock<rw_spinlock> lock(lock_.get_lock());
     if (UNLIKELY(!file_)) return false;
     DCHECK_LE(offset + bytes_to_read, current_offset_.Load());
+    if (direct_fd_ >= 0) return DirectRead(offset, buffer, bytes_to_read);
     kudu::Status status = file_->Read(offset, Slice(buffer, bytes_to_read));
     if (UNLIKELY(!status.ok())) {
       LOG(ERROR) << Substitute("Failed to read from $0 at offset $1 for $2 bytes: $3",
@@ -239,6 +331,7 @@ class DataCache::CacheFile {
     kudu::shared_lock<rw_spinlock> lock(lock_.get_lock());
     if (UNLIKELY(!file_)) return false;
     DCHECK_LE(offset + buffer_len, current_offset_.Load());
+    if (direct_fd_ >= 0) return DirectWrite(offset, buffer, buffer_len);
     kudu::Status status = file_->Write(offset, Slice(buffer, buffer_len));
     if (UNLIKELY(!status.ok())) {
       LOG(ERROR) << Substitute("Failed to write to $0 at offset $1 for $2 bytes: $3",
@@ -271,9 +364,17 @@ class DataCache::CacheFile {
   /// The underlying backing file. NULL if the file has been closed.
   unique_ptr<RWFile> file_;
 
+  /// File descriptor of the backing file opened with O_DIRECT if
+  /// --data_cache_direct_io is true. -1 otherwise or if the file has been closed.
+  /// Hole punching still goes through 'file_'.
+  int direct_fd_ = -1;
+
   /// True iff it's okay to append to this backing file.
   bool allow_append_ = true;
 
+  /// If true, the file is closed but not deleted on destruction.
+  bool keep_file_ = false;
+
   /// The current offset in the file to append to on next insert.
   AtomicInt64 current_offset_;
 
@@ -285,9 +386,100 @@ class DataCache::CacheFile {
   /// punched after it has been closed. The only operation allowed is to deletion.
   percpu_rwlock lock_;
 
-  /// C'tor of CacheFile to be called by Create() only.
+  /// C'tor of CacheFile to be called by Create() and OpenExisting() only.
   explicit CacheFile(std::string path) : path_(move(path)) { }
 
+  /// Opens 'direct_fd_' if --data_cache_direct_io is true.
+  Status OpenDirectFd() {
+    if (!FLAGS_data_cache_direct_io) return Status::OK();
+    direct_fd_ = open(path_.c_str(), O_RDWR | O_DIRECT);
+    if (direct_fd_ < 0) {
+      return Status(Substitute("Failed to open cache file $0 with O_DIRECT: $1", path_,
+          GetStrErrMsg()));
+    }
+    return Status::OK();
+  }
+
+  typedef unique_ptr<uint8_t, decltype(&free)> AlignedBuffer;
+
+  /// Allocates a PAGE_SIZE aligned buffer of 'len' bytes for direct I/O. Returns nullptr
+  /// if the allocation fails.
+  static AlignedBuffer AllocateAlignedBuffer(int64_t len) {
+    void* buffer = nullptr;
+    if (posix_memalign(&buffer, PAGE_SIZE, len) != 0) buffer = nullptr;
+    return AlignedBuffer(reinterpret_cast<uint8_t*>(buffer), free);
+  }
+
+  /// Implementations of Read() and Write() on 'direct_fd_'. The reads and writes are
+  /// rounded up to whole pages, which are within the space reserved by Allocate().
+  /// Buffers or lengths which are not aligned to pages go through a bounce buffer which
+  /// is freed before returning. A short read or write may end in the middle of a page,
+  /// but direct I/O must start at a page boundary, so it is continued from the last page
+  /// boundary it reached. The caller must hold 'lock_' in shared mode.
+  bool DirectRead(int64_t offset, uint8_t* buffer, int64_t bytes_to_read) {
+    const int64_t aligned_len = BitUtil::RoundUp(bytes_to_read, PAGE_SIZE);
+    AlignedBuffer bounce_buffer(nullptr, free);
+    uint8_t* read_buffer = buffer;
+    if (aligned_len != bytes_to_read
+        || reinterpret_cast<uintptr_t>(buffer) % PAGE_SIZE != 0) {
+      bounce_buffer = AllocateAlignedBuffer(aligned_len);
+      if (UNLIKELY(bounce_buffer == nullptr)) return false;
+      read_buffer = bounce_buffer.get();
+    }
+    int64_t bytes_read = 0;
+    while (bytes_read < bytes_to_read) {
+      DCHECK_EQ(bytes_read % PAGE_SIZE, 0);
+      int64_t ret = pread(direct_fd_, read_buffer + bytes_read, aligned_len - bytes_read,
+          offset + bytes_read);
+      if (ret < 0 && errno == EINTR) continue;
+      int64_t aligned_bytes_read = ret > 0
+          ? BitUtil::RoundDown(bytes_read + ret, PAGE_SIZE) : bytes_read;
+      if (ret > 0 && bytes_read + ret >= bytes_to_read) break;
+      if (UNLIKELY(aligned_bytes_read == bytes_read)) {
+        LOG(ERROR) << Substitute("Failed to read from $0 at offset $1 for $2 bytes: $3",
+            path_, offset, PrettyPrinter::PrintBytes(bytes_to_read),
+            ret < 0 ? GetStrErrMsg() : "unexpected end of file");
+        return false;
+      }
+      bytes_read = aligned_bytes_read;
+    }
+    if (read_buffer != buffer) memcpy(buffer, read_buffer, bytes_to_read);
+    ImpaladMetrics::IO_MGR_DIRECT_IO_BYTES_READ->Increment(bytes_to_read);
+    return true;
+  }
+
+  bool DirectWrite(int64_t offset, const uint8_t* buffer, int64_t buffer_len) {
+    const int64_t aligned_len = BitUtil::RoundUp(buffer_len, PAGE_SIZE);
+    AlignedBuffer bounce_buffer(nullptr, free);
+    const uint8_t* write_buffer = buffer;
+    if (aligned_len != buffer_len
+        || reinterpret_cast<uintptr_t>(buffer) % PAGE_SIZE != 0) {
+      bounce_buffer = AllocateAlignedBuffer(aligned_len);
+      if (UNLIKELY(bounce_buffer == nullptr)) return false;
+      memcpy(bounce_buffer.get(), buffer, buffer_len);
+      memset(bounce_buffer.get() + buffer_len, 0, aligned_len - buffer_len);
+      write_buffer = bounce_buffer.get();
+    }
+    int64_t bytes_written = 0;
+    while (bytes_written < aligned_len) {
+      DCHECK_EQ(bytes_written % PAGE_SIZE, 0);
+      int64_t ret = pwrite(direct_fd_, write_buffer + bytes_written,
+          aligned_len - bytes_written, offset + bytes_written);
+      if (ret < 0 && errno == EINTR) continue;
+      int64_t aligned_bytes_written = ret > 0
+          ? BitUtil::RoundDown(bytes_written + ret, PAGE_SIZE) : bytes_written;
+      if (UNLIKELY(aligned_bytes_written == bytes_written)) {
+        LOG(ERROR) << Substitute("Failed to write to $0 at offset $1 for $2 bytes: $3",
+            path_, offset, PrettyPrinter::PrintBytes(buffer_len),
+            ret < 0 ? GetStrErrMsg() : "no progress");
+        return false;
+      }
+      bytes_written = aligned_bytes_written;
+    }
+    ImpaladMetrics::IO_MGR_DIRECT_IO_BYTES_WRITTEN->Increment(buffer_len);
+    return true;
+  }
+
   DISALLOW_COPY_AND_ASSIGN(CacheFile);
 };
 
@@ -295,8 +487,9 @@ class DataCache::CacheFile {
 /// Contains the whereabouts of the cached content.
 class DataCache::CacheEntry {
  public:
-  explicit CacheEntry(CacheFile* file, int64_t offset, int64_t len, uint64_t checksum)
-    : file_(file), offset_(offset), len_(len), checksum_(checksum) {
+  explicit CacheEntry(CacheFile* file, int64_t offset, int64_t len, uint64_t checksum,
+      bool reloaded = false)
+    : file_(file), offset_(offset), len_(len), checksum_(checksum), reloaded_(reloaded) {
   }
 
   // Unpack a cache's entry represented by 'slice'. This is done in place of casting
@@ -310,6 +503,7 @@ class DataCache::CacheEntry {
   int64_t offset() const { return offset_; }
   int64_t len() const { return len_; }
   uint64_t checksum() const { return checksum_; }
+  bool reloaded() const { return reloaded_; }
 
  private:
   /// The backing file holding the cached content.
@@ -323,6 +517,11 @@ class DataCache::CacheEntry {
 
   /// Optional checksum of the content computed when inserting the cache entry.
   const uint64_t checksum_ = 0;
+
+  /// True if the entry was reloaded from a checkpoint of a persistent cache. The content
+  /// of such an entry may not have made it to disk before the previous run ended, so
+  /// every read of it is verified against the checksum, including partial reads.
+  const bool reloaded_ = false;
 };
 
 /// The key used for look up in the cache.
@@ -338,7 +537,12 @@ struct DataCache::CacheKey {
   }
 
   int64_t Hash() const {
-    return HashUtil::FastHash64(key_.data(), key_.size(), 0);
+    return Hash(ToSlice());
+  }
+
+  /// Returns the hash value of the encoded cache key 'key'.
+  static int64_t Hash(const Slice& key) {
+    return HashUtil::FastHash64(key.data(), key.size(), 0);
   }
 
   Slice filename() const {
@@ -369,6 +573,111 @@ struct DataCache::CacheKey {
   faststring key_;
 };
 
+/// The header of a value in the in-memory tier. It records the entry in the metadata
+/// cache whose content was copied into memory. The content follows the header.
+struct MemoryTierHeader {
+  /// The backing file of the entry. Only compared with CacheEntry::file().
+  const void* file;
+  /// The offset of the entry in 'file'.
+  int64_t offset;
+};
+
+/// Eviction callback of the in-memory tier of a partition. The memory of an entry is
+/// freed by the cache, so this only releases it from the memory tracker and maintains
+/// the metrics.
+class DataCache::MemoryTierEvictionCallback : public Cache::EvictionCallback {
+ public:
+  explicit MemoryTierEvictionCallback(MemTracker* mem_tracker)
+    : mem_tracker_(mem_tracker) {}
+
+  virtual void EvictedEntry(Slice key, Slice value) override {
+    mem_tracker_->Release(value.size());
+    ImpaladMetrics::IO_MGR_REMOTE_DATA_CACHE_MEMORY_TOTAL_BYTES->Increment(
+        -static_cast<int64_t>(value.size()));
+  }
+
+ private:
+  MemTracker* const mem_tracker_;
+};
+
+/// An insertion into the cache which is deferred to a thread in 'storer_pool_'. Owns a
+/// copy of the data to be inserted, whose memory has already been consumed from
+/// 'mem_tracker'. The memory is released and the metrics of the outstanding writes are
+/// updated when the task is destroyed, whether it was processed or dropped from the
+/// queue on shutdown.
+class DataCache::StoreTask {
+ public:
+  StoreTask(const string& filename, int64_t mtime, int64_t offset,
+      const uint8_t* buffer, int64_t buffer_len, MemTracker* mem_tracker)
+    : key_(filename, mtime, offset),
+      buffer_(new uint8_t[buffer_len]),
+      buffer_len_(buffer_len),
+      mem_tracker_(mem_tracker) {
+    memcpy(buffer_.get(), buffer, buffer_len);
+    ImpaladMetrics::IO_MGR_REMOTE_DATA_CACHE_ASYNC_WRITES_OUTSTANDING_BYTES->Increment(
+        buffer_len_);
+    ImpaladMetrics::IO_MGR_REMOTE_DATA_CACHE_NUM_ASYNC_WRITES_OUTSTANDING->Increment(1);
+  }
+
+  ~StoreTask() {
+    ImpaladMetrics::IO_MGR_REMOTE_DATA_CACHE_ASYNC_WRITES_OUTSTANDING_BYTES->Increment(
+        -buffer_len_);
+    ImpaladMetrics::IO_MGR_REMOTE_DATA_CACHE_NUM_ASYNC_WRITES_OUTSTANDING->Increment(-1);
+    mem_tracker_->Release(buffer_len_);
+  }
+
+  const CacheKey& key() const { return key_; }
+  const uint8_t* buffer() const { return buffer_.get(); }
+  int64_t buffer_len() const { return buffer_len_; }
+
+ private:
+  const CacheKey key_;
+  const unique_ptr<uint8_t[]> buffer_;
+  const int64_t buffer_len_;
+  MemTracker* const mem_tracker_;
+
+  DISALLOW_COPY_AND_ASSIGN(StoreTask);
+};
+
+/// Returns true if the TinyLFU admission policy is configured. Any other value than
+/// 'ALL' and 'TinyLFU' is rejected by DataCache::Init().
+static bool UseTinyLfuAdmission() {
+  return boost::to_upper_copy(FLAGS_data_cache_admission_policy) == "TINYLFU";
+}
+
+/// Appends the raw bytes of 'value' to 'buf'. Checkpoints are only read back on the same
+/// host, so the native byte order is used.
+template <typename T>
+static void AppendValue(const T& value, faststring* buf) {
+  buf->append(&value, sizeof(T));
+}
+
+/// Reads values written by AppendValue() from the contents of a checkpoint. All reads
+/// fail once the end of the contents is reached.
+class CheckpointReader {
+ public:
+  CheckpointReader(const uint8_t* data, int64_t len) : pos_(data), end_(data + len) {}
+
+  template <typename T>
+  bool Read(T* value) {
+    if (end_ - pos_ < sizeof(T)) return false;
+    memcpy(value, pos_, sizeof(T));
+    pos_ += sizeof(T);
+    return true;
+  }
+
+  bool ReadBytes(int64_t len, Slice* bytes) {
+    if (len < 0 || end_ - pos_ < len) return false;
+    *bytes = Slice(pos_, len);
+    pos_ += len;
+    return true;
+  }
+
+ private:
+  const uint8_t* pos_;
+  const uint8_t* const end_;
+};
+
 static Cache::EvictionPolicy GetCacheEvictionPolicy(const std::string& policy_string) {
   Cache::EvictionPolicy policy = Cache::ParseEvictionPolicy(policy_string);
   if (policy != Cache::EvictionPolicy::LRU && policy != Cache::EvictionPolicy::LIRS) {
@@ -378,15 +687,32 @@ static Cache::EvictionPolicy GetCacheEvictionPolicy(const std::string& policy_st
 }
 
 DataCache::Partition::Partition(
-    int32_t index, const string& path, int64_t capacity, int max_opened_files,
-    bool trace_replay)
+    int32_t index, const string& path, int64_t capacity, int64_t memory_capacity,
+    MemTracker* memory_tier_mem_tracker, int max_opened_files, bool trace_replay)
   : index_(index),
     path_(path),
     capacity_(max<int64_t>(capacity, PAGE_SIZE)),
+    memory_capacity_(trace_replay ? 0 : memory_capacity),
     max_opened_files_(max_opened_files),
     trace_replay_(trace_replay),
     meta_cache_(NewCache(GetCacheEvictionPolicy(FLAGS_data_cache_eviction_policy),
-        capacity_, path_)) {}
+        capacity_, path_)),
+    memory_tier_mem_tracker_(memory_tier_mem_tracker) {
+  if (UseTinyLfuAdmission()) {
+    // Size the sketch for entries of 64KB on average, which is smaller than most
+    // entries. The number of counters is capped to bound the memory consumption.
+    admission_sketch_.reset(new FrequencySketch(
+        min<int64_t>(max<int64_t>(capacity_ / (64 * 1024), 1024), 1L << 24)));
+  }
+  if (memory_capacity_ > 0) {
+    DCHECK(memory_tier_mem_tracker_ != nullptr);
+    memory_tier_eviction_callback_.reset(
+        new MemoryTierEvictionCallback(memory_tier_mem_tracker_));
+    memory_cache_.reset(NewCache(
+        GetCacheEvictionPolicy(FLAGS_data_cache_eviction_policy), memory_capacity_,
+        path_ + "-memory"));
+  }
+}
 
 DataCache::Partition::~Partition() {
   if (!closed_) ReleaseResources();
@@ -406,11 +732,17 @@ Status DataCache::Partition::CreateCacheFile() {
 
 Status DataCache::Partition::DeleteExistingFiles() const {
   DCHECK(!trace_replay_);
+  lock_.DCheckLocked();
+  std::unordered_set<string> reloaded_files;
+  for (const auto& cache_file : cache_files_) {
+    reloaded_files.insert(kudu::BaseName(cache_file->path()));
+  }
   vector<string> entries;
   RETURN_IF_ERROR(FileSystemUtil::Directory::GetEntryNames(path_, &entries, 0,
       FileSystemUtil::Directory::EntryType::DIR_ENTRY_REG));
   for (const string& entry : entries) {
-    if (entry.find(CACHE_FILE_PREFIX) == 0) {
+    if ((entry.find(CACHE_FILE_PREFIX) == 0 && reloaded_files.count(entry) == 0)
+        || (entry.find(CHECKPOINT_FILE_NAME) == 0 && !FLAGS_data_cache_persistent)) {
       const string file_path = JoinPathSegments(path_, entry);
       KUDU_RETURN_IF_ERROR(kudu::Env::Default()->DeleteFile(file_path),
           Substitute("Failed to delete old cache file $0", file_path));
@@ -420,10 +752,176 @@ Status DataCache::Partition::DeleteExistingFiles() const {
   return Status::OK();
 }
 
+Status DataCache::Partition::Checkpoint() {
+  DCHECK(FLAGS_data_cache_persistent);
+  if (trace_replay_) return Status::OK();
+  faststring buf;
+  buf.append(CHECKPOINT_MAGIC, strlen(CHECKPOINT_MAGIC));
+
+  // Snapshot the names of the opened backing files. The files are only destroyed when
+  // the partition is released, so the pointers stay valid below even if the files are
+  // closed by DeleteOldFiles() in the meantime.
+  std::unordered_map<const CacheFile*, int32_t> file_indices;
+  {
+    std::unique_lock<SpinLock> partition_lock(lock_);
+    if (closed_) return Status::OK();
+    AppendValue<int32_t>(cache_files_.size() - oldest_opened_file_, &buf);
+    for (int i = oldest_opened_file_; i < cache_files_.size(); ++i) {
+      const string& name = kudu::BaseName(cache_files_[i]->path());
+      file_indices.emplace(cache_files_[i].get(), file_indices.size());
+      AppendValue<int32_t>(name.size(), &buf);
+      buf.append(name);
+    }
+  }
+
+  // Iterate over the entries from the least to the most recently used one without
+  // evicting any, so that reloading them in this order restores their recency. The
+  // iteration holds the lock of the metadata cache, so only copy the entries here.
+  faststring entries;
+  int64_t num_entries = 0;
+  meta_cache_->Invalidate(Cache::InvalidationControl(
+      [&file_indices, &entries, &num_entries](Slice key, Slice value) {
+        CacheEntry entry(value);
+        auto it = file_indices.find(entry.file());
+        if (it != file_indices.end()) {
+          AppendValue<int32_t>(it->second, &entries);
+          AppendValue<int64_t>(entry.offset(), &entries);
+          AppendValue<int64_t>(entry.len(), &entries);
+          AppendValue<uint64_t>(entry.checksum(), &entries);
+          AppendValue<int32_t>(key.size(), &entries);
+          entries.append(key.data(), key.size());
+          ++num_entries;
+        }
+        return true;
+      }));
+  AppendValue<int64_t>(num_entries, &buf);
+  buf.append(entries.data(), entries.size());
+  AppendValue<uint64_t>(HashUtil::FastHash64(buf.data(), buf.size(), 0), &buf);
+
+  // Replace the previous checkpoint atomically.
+  kudu::Env* env = kudu::Env::Default();
+  const string& checkpoint_path = JoinPathSegments(path_, CHECKPOINT_FILE_NAME);
+  const string& tmp_path = checkpoint_path + ".tmp";
+  KUDU_RETURN_IF_ERROR(kudu::WriteStringToFileSync(env, buf, tmp_path),
+      Substitute("Failed to write data cache checkpoint $0", tmp_path));
+  KUDU_RETURN_IF_ERROR(env->RenameFile(tmp_path, checkpoint_path),
+      Substitute("Failed to rename data cache checkpoint $0", tmp_path));
+  VLOG(1) << Substitute("Wrote checkpoint of $0 entries to $1", num_entries,
+      checkpoint_path);
+  return Status::OK();
+}
+
+void DataCache::Partition::LoadCheckpoint() {
+  DCHECK(!trace_replay_);
+  lock_.DCheckLocked();
+  DCHECK(cache_files_.empty());
+  kudu::Env* env = kudu::Env::Default();
+  const string& checkpoint_path = JoinPathSegments(path_, CHECKPOINT_FILE_NAME);
+  if (!env->FileExists(checkpoint_path)) {
+    LOG(INFO) << "No data cache checkpoint found in " << path_;
+    return;
+  }
+  faststring data;
+  kudu::Status status = kudu::ReadFileToString(env, checkpoint_path, &data);
+  if (!status.ok()) {
+    LOG(WARNING) << Substitute("Failed to read data cache checkpoint $0: $1",
+        checkpoint_path, status.ToString());
+    return;
+  }
+  const int64_t magic_len = strlen(CHECKPOINT_MAGIC);
+  uint64_t expected_hash;
+  if (data.size() < magic_len + sizeof(expected_hash)
+      || memcmp(data.data(), CHECKPOINT_MAGIC, magic_len) != 0) {
+    LOG(WARNING) << "Ignoring data cache checkpoint with unknown format "
+                 << checkpoint_path;
+    return;
+  }
+  const int64_t body_len = data.size() - sizeof(expected_hash);
+  memcpy(&expected_hash, data.data() + body_len, sizeof(expected_hash));
+  if (HashUtil::FastHash64(data.data(), body_len, 0) != expected_hash) {
+    LOG(WARNING) << "Ignoring corrupted data cache checkpoint " << checkpoint_path;
+    return;
+  }
+  CheckpointReader reader(data.data() + magic_len, body_len - magic_len);
+
+  // Open the backing files which still exist. Entries in files which can't be opened
+  // are skipped.
+  int32_t num_files;
+  if (!reader.Read(&num_files) || num_files < 0) {
+    LOG(WARNING) << "Ignoring malformed data cache checkpoint " << checkpoint_path;
+    return;
+  }
+  vector<CacheFile*> files(num_files, nullptr);
+  for (int32_t i = 0; i < num_files; ++i) {
+    int32_t name_len;
+    Slice name;
+    if (!reader.Read(&name_len) || !reader.ReadBytes(name_len, &name)) {
+      LOG(WARNING) << "Ignoring malformed data cache checkpoint " << checkpoint_path;
+      return;
+    }
+    const string& file_name = name.ToString();
+    if (file_name.find(CACHE_FILE_PREFIX) != 0 || file_name.find('/') != string::npos) {
+      continue;
+    }
+    unique_ptr<CacheFile> cache_file;
+    Status open_status =
+        CacheFile::OpenExisting(JoinPathSegments(path_, file_name), &cache_file);
+    if (!open_status.ok()) {
+      LOG(WARNING) << "Skipping entries of data cache file: " << open_status.GetDetail();
+      continue;
+    }
+    files[i] = cache_file.get();
+    cache_files_.emplace_back(move(cache_file));
+  }
+
+  // Reload the entries in the order of the checkpoint. The content of an entry may not
+  // have made it to disk before the previous run ended, so reloaded entries are
+  // verified on every read.
+  int64_t num_entries;
+  if (!reader.Read(&num_entries)) num_entries = 0;
+  int64_t num_reloaded = 0;
+  for (int64_t i = 0; i < num_entries; ++i) {
+    int32_t file_idx;
+    int64_t offset;
+    int64_t len;
+    uint64_t checksum;
+    int32_t key_len;
+    Slice key;
+    if (!reader.Read(&file_idx) || !reader.Read(&offset) || !reader.Read(&len)
+        || !reader.Read(&checksum) || !reader.Read(&key_len)
+        || !reader.ReadBytes(key_len, &key) || file_idx < 0 || file_idx >= num_files) {
+      LOG(WARNING) << "Stopped reloading malformed data cache checkpoint "
+                   << checkpoint_path;
+      break;
+    }
+    CacheFile* cache_file = files[file_idx];
+    if (cache_file == nullptr || offset < 0 || offset % PAGE_SIZE != 0 || len <= 0
+        || offset + len > cache_file->size()) {
+      continue;
+    }
+    const int64_t charge_len = BitUtil::RoundUp(len, PAGE_SIZE);
+    Cache::UniquePendingHandle pending_handle(
+        meta_cache_->Allocate(key, sizeof(CacheEntry), charge_len));
+    if (pending_handle.get() == nullptr) continue;
+    CacheEntry entry(cache_file, offset, len, checksum, /*reloaded=*/true);
+    memcpy(meta_cache_->MutableValue(&pending_handle), &entry, sizeof(CacheEntry));
+    charged_bytes_.Add(charge_len);
+    Cache::UniqueHandle handle(meta_cache_->Insert(std::move(pending_handle), this));
+    if (handle.get() == nullptr) continue;
+    ImpaladMetrics::IO_MGR_REMOTE_DATA_CACHE_TOTAL_BYTES->Increment(charge_len);
+    ImpaladMetrics::IO_MGR_REMOTE_DATA_CACHE_NUM_ENTRIES->Increment(1);
+    ++num_reloaded;
+  }
+  ImpaladMetrics::IO_MGR_REMOTE_DATA_CACHE_RELOADED_ENTRIES->Increment(num_reloaded);
+  LOG(INFO) << Substitute("Reloaded $0 of $1 entries in $2 backing files from $3",
+      num_reloaded, num_entries, cache_files_.size(), checkpoint_path);
+}
+
 Status DataCache::Partition::Init() {
   std::unique_lock<SpinLock> partition_lock(lock_);
 
   RETURN_IF_ERROR(meta_cache_->Init());
+  if (memory_cache_ != nullptr) RETURN_IF_ERROR(memory_cache_->Init());
 
   // Trace replay does not require further initialization, as it is only doing
   // metadata operations and does not do filesystem operations.
@@ -435,13 +933,20 @@ Status DataCache::Partition::Init() {
   }
   RETURN_IF_ERROR(FileSystemUtil::VerifyIsDirectory(path_));
 
-  // Delete all existing backing files left over from previous runs.
+  // Create metrics for this partition. Reloading the checkpoint may already evict.
+  InitMetrics();
+
+  // Reload the entries of the previous run into the metadata cache.
+  if (FLAGS_data_cache_persistent) LoadCheckpoint();
+
+  // Delete all other backing files left over from previous runs.
   RETURN_IF_ERROR(DeleteExistingFiles());
 
-  // Check if there is enough space available at this point in time.
+  // Check if there is enough space available at this point in time. Reloaded entries
+  // already occupy their space.
   uint64_t available_bytes;
   RETURN_IF_ERROR(FileSystemUtil::GetSpaceAvailable(path_, &available_bytes));
-  if (available_bytes < capacity_) {
+  if (available_bytes + charged_bytes_.Load() < capacity_) {
     const string& err = Substitute("Insufficient space for $0. Required $1. Only $2 is "
         "available", path_, PrettyPrinter::PrintBytes(capacity_),
         PrettyPrinter::PrintBytes(available_bytes));
@@ -475,10 +980,8 @@ Status DataCache::Partition::Init() {
     RETURN_IF_ERROR(tracer_->Init());
   }
 
-  // Create metrics for this partition
-  InitMetrics();
-
-  // Create a backing file for the partition.
+  // Create a backing file for the partition. New entries are never appended to
+  // reloaded backing files.
   RETURN_IF_ERROR(CreateCacheFile());
   oldest_opened_file_ = 0;
   return Status::OK();
@@ -557,10 +1060,15 @@ void DataCache::Partition::ReleaseResources() {
   std::unique_lock<SpinLock> partition_lock(lock_);
   if (closed_) return;
   closed_ = true;
-  // Close and delete all backing files in this partition.
+  // Close and delete all backing files in this partition. The backing files of a
+  // persistent cache are kept for the next run.
+  if (FLAGS_data_cache_persistent) {
+    for (auto& cache_file : cache_files_) cache_file->KeepFile();
+  }
   cache_files_.clear();
-  // Free all memory consumed by the metadata cache.
+  // Free all memory consumed by the metadata cache and the in-memory tier.
   meta_cache_.reset();
+  memory_cache_.reset();
 }
 
 int64_t DataCache::Partition::Lookup(const CacheKey& cache_key, int64_t bytes_to_read,
@@ -568,15 +1076,27 @@ int64_t DataCache::Partition::Lookup(const CacheKey& cache_key, int64_t bytes_to
   DCHECK(!closed_);
   DCHECK(trace_replay_ ? buffer == nullptr : buffer != nullptr);
   Slice key = cache_key.ToSlice();
+  if (admission_sketch_ != nullptr) admission_sketch_->Increment(cache_key.Hash());
   Cache::UniqueHandle handle(meta_cache_->Lookup(key));
 
   if (handle.get() == nullptr) {
     Trace(trace::EventType::MISS, cache_key, bytes_to_read, /*entry_len=*/-1);
     return 0;
   }
+  CacheEntry entry(meta_cache_->Value(handle));
+
+  // Try the in-memory tier first. The lookup in the metadata cache above keeps the
+  // entry in the backing file warm, so it can still be served from there after it has
+  // been evicted from memory.
+  if (memory_cache_ != nullptr) {
+    int64_t bytes_read = LookupMemoryTier(key, entry, bytes_to_read, buffer);
+    if (bytes_read > 0) {
+      Trace(trace::EventType::HIT, cache_key, bytes_to_read, entry.len());
+      return bytes_read;
+    }
+  }
 
   // Read from the backing file.
-  CacheEntry entry(meta_cache_->Value(handle));
 
   Trace(trace::EventType::HIT, cache_key, bytes_to_read, entry.len());
 
@@ -586,10 +1106,19 @@ int64_t DataCache::Partition::Lookup(const CacheKey& cache_key, int64_t bytes_to
     CacheFile* cache_file = entry.file();
     VLOG(3) << Substitute("Reading file $0 offset $1 len $2 checksum $3 bytes_to_read $4",
         cache_file->path(), entry.offset(), entry.len(), entry.checksum(), bytes_to_read);
+    // Partial reads of reloaded entries read the whole entry to verify its checksum.
+    unique_ptr<uint8_t[]> entry_buffer;
+    uint8_t* read_buffer = buffer;
+    int64_t read_len = bytes_to_read;
+    if (entry.reloaded() && bytes_to_read < entry.len()) {
+      entry_buffer.reset(new uint8_t[entry.len()]);
+      read_buffer = entry_buffer.get();
+      read_len = entry.len();
+    }
     bool read_success;
     {
       ScopedHistogramTimer read_timer(read_latency_);
-      read_success = cache_file->Read(entry.offset(), buffer, bytes_to_read);
+      read_success = cache_file->Read(entry.offset(), read_buffer, read_len);
     }
     if (UNLIKELY(!read_success)) {
       meta_cache_->Erase(key);
@@ -597,15 +1126,70 @@ int64_t DataCache::Partition::Lookup(const CacheKey& cache_key, int64_t bytes_to
     }
 
     // Verify checksum if enabled. Delete entry on checksum mismatch.
-    if (FLAGS_data_cache_checksum && bytes_to_read == entry.len() &&
-        !VerifyChecksum("read", entry, buffer, bytes_to_read)) {
+    if (FLAGS_data_cache_checksum && read_len == entry.len() &&
+        !VerifyChecksum("read", entry, read_buffer, read_len)) {
       meta_cache_->Erase(key);
       return 0;
     }
+    if (read_buffer != buffer) memcpy(buffer, read_buffer, bytes_to_read);
+
+    // The entry has been hit at least once since it was stored. Promote it into the
+    // in-memory tier if the whole entry was read.
+    if (memory_cache_ != nullptr && read_len == entry.len()) {
+      PromoteToMemoryTier(key, entry, read_buffer, read_len);
+    }
+  }
+  return bytes_to_read;
+}
+
+int64_t DataCache::Partition::LookupMemoryTier(const Slice& key, const CacheEntry& entry,
+    int64_t bytes_to_read, uint8_t* buffer) {
+  DCHECK(memory_cache_ != nullptr);
+  Cache::UniqueHandle handle(memory_cache_->Lookup(key));
+  if (handle.get() == nullptr) return 0;
+  Slice value = memory_cache_->Value(handle);
+  DCHECK_GE(value.size(), sizeof(MemoryTierHeader));
+  MemoryTierHeader header;
+  memcpy(&header, value.data(), sizeof(header));
+  // The copy is of an entry which has since been replaced in the metadata cache, e.g.
+  // if a longer entry was stored concurrently with the promotion of a shorter one.
+  // Remove it so that it's not served and let the caller read from the backing file.
+  if (header.file != entry.file() || header.offset != entry.offset() ||
+      value.size() - sizeof(header) != entry.len()) {
+    handle.reset();
+    memory_cache_->Erase(key);
+    return 0;
   }
+  bytes_to_read = min<int64_t>(entry.len(), bytes_to_read);
+  memcpy(buffer, value.data() + sizeof(header), bytes_to_read);
+  ImpaladMetrics::IO_MGR_REMOTE_DATA_CACHE_MEMORY_HIT_BYTES->Increment(bytes_to_read);
+  ImpaladMetrics::IO_MGR_REMOTE_DATA_CACHE_MEMORY_HIT_COUNT->Increment(1);
   return bytes_to_read;
 }
 
+void DataCache::Partition::PromoteToMemoryTier(const Slice& key,
+    const CacheEntry& entry, const uint8_t* buffer, int64_t buffer_len) {
+  DCHECK(memory_cache_ != nullptr);
+  DCHECK_EQ(buffer_len, entry.len());
+  const int64_t charge = sizeof(MemoryTierHeader) + buffer_len;
+  if (charge > memory_capacity_ || charge > std::numeric_limits<int>::max()) return;
+  if (!memory_tier_mem_tracker_->TryConsume(charge)) return;
+  Cache::UniquePendingHandle pending_handle(memory_cache_->Allocate(key, charge, charge));
+  if (pending_handle.get() == nullptr) {
+    memory_tier_mem_tracker_->Release(charge);
+    return;
+  }
+  MemoryTierHeader header{entry.file(), entry.offset()};
+  uint8_t* value = memory_cache_->MutableValue(&pending_handle);
+  memcpy(value, &header, sizeof(header));
+  memcpy(value + sizeof(header), buffer, buffer_len);
+  // A failed Insert() invokes the eviction callback, so the metric is incremented
+  // before inserting.
+  ImpaladMetrics::IO_MGR_REMOTE_DATA_CACHE_MEMORY_TOTAL_BYTES->Increment(charge);
+  Cache::UniqueHandle handle(memory_cache_->Insert(
+      move(pending_handle), memory_tier_eviction_callback_.get()));
+}
+
 bool DataCache::Partition::HandleExistingEntry(const Slice& key,
     const Cache::UniqueHandle& handle, const uint8_t* buffer, int64_t buffer_len) {
   // Unpack the cache entry.
@@ -660,9 +1244,11 @@ bool DataCache::Partition::InsertIntoCache(const Slice& key, CacheFile* cache_fi
     }
   }
 
-  // Insert the new entry into the cache.
+  // Insert the new entry into the cache. If Insert() fails, EvictedEntry() is called
+  // for the new entry, which releases its charge again.
   CacheEntry entry(cache_file, insertion_offset, buffer_len, checksum);
   memcpy(meta_cache_->MutableValue(&pending_handle), &entry, sizeof(CacheEntry));
+  charged_bytes_.Add(charge_len);
   Cache::UniqueHandle handle(meta_cache_->Insert(std::move(pending_handle), this));
   // Check for failure of Insert(), which means the entry was evicted during Insert()
   if (UNLIKELY(handle.get() == nullptr)){
@@ -677,12 +1263,14 @@ bool DataCache::Partition::InsertIntoCache(const Slice& key, CacheFile* cache_fi
     ImpaladMetrics::IO_MGR_REMOTE_DATA_CACHE_TOTAL_BYTES->Increment(charge_len);
     ImpaladMetrics::IO_MGR_REMOTE_DATA_CACHE_NUM_ENTRIES->Increment(1);
     ImpaladMetrics::IO_MGR_REMOTE_DATA_CACHE_NUM_WRITES->Increment(1);
+    // A copy of a shorter version of the entry may be in the in-memory tier.
+    if (memory_cache_ != nullptr) memory_cache_->Erase(key);
   }
   return true;
 }
 
 bool DataCache::Partition::Store(const CacheKey& cache_key, const uint8_t* buffer,
-    int64_t buffer_len, bool* start_reclaim) {
+    int64_t buffer_len, bool limit_concurrency, bool* start_reclaim) {
   DCHECK(!closed_);
   *start_reclaim = false;
   Slice key = cache_key.ToSlice();
@@ -697,6 +1285,17 @@ bool DataCache::Partition::Store(const CacheKey& cache_key, const uint8_t* buffe
     }
   }
 
+  if (admission_sketch_ != nullptr && !Admit(cache_key, charge_len)) {
+    // Trace replays do not keep metrics
+    if (LIKELY(!trace_replay_)) {
+      ImpaladMetrics::IO_MGR_REMOTE_DATA_CACHE_ADMISSION_REJECTED_BYTES->Increment(
+          buffer_len);
+      ImpaladMetrics::IO_MGR_REMOTE_DATA_CACHE_ADMISSION_REJECTED_ENTRIES->Increment(1);
+    }
+    Trace(trace::EventType::STORE_FAILED, cache_key, /*lookup_len=*/-1, buffer_len);
+    return false;
+  }
+
   CacheFile* cache_file;
   int64_t insertion_offset;
   if (LIKELY(!trace_replay_)) {
@@ -705,11 +1304,9 @@ bool DataCache::Partition::Store(const CacheKey& cache_key, const uint8_t* buffe
     // Limit the write concurrency to avoid blocking the caller (which could be calling
     // from the critical path of an IO read) when the cache becomes IO bound due to either
     // limited memory for page cache or the cache is undersized which leads to eviction.
-    //
-    // TODO: defer the writes to another thread which writes asynchronously. Need to bound
-    // the extra memory consumption for holding the temporary buffer though.
-    const bool exceed_concurrency =
-        pending_insert_set_.size() >= FLAGS_data_cache_write_concurrency;
+    // Asynchronous writes don't block the caller, so they are not limited here.
+    const bool exceed_concurrency = limit_concurrency
+        && pending_insert_set_.size() >= FLAGS_data_cache_write_concurrency;
     if (exceed_concurrency ||
         pending_insert_set_.find(key.ToString()) != pending_insert_set_.end()) {
       ImpaladMetrics::IO_MGR_REMOTE_DATA_CACHE_DROPPED_BYTES->Increment(buffer_len);
@@ -770,13 +1367,33 @@ void DataCache::Partition::DeleteOldFiles() {
   }
 }
 
+bool DataCache::Partition::Admit(const CacheKey& cache_key, int64_t charge_len) {
+  DCHECK(admission_sketch_ != nullptr);
+  // Nothing needs to be evicted while the partition has space left.
+  if (charged_bytes_.Load() + charge_len <= capacity_) return true;
+  // Compare against the current frequency of the last victim, which is at the end of
+  // the eviction policy's queue like the next victim. Before the first eviction, assume
+  // a victim which has been accessed once. An evicted entry which is looked up again is
+  // always admitted back.
+  const int64_t hash = cache_key.Hash();
+  if (!has_victim_.Load()) return admission_sketch_->Frequency(hash) > 1;
+  const int64_t victim_hash = last_victim_hash_.Load();
+  return hash == victim_hash
+      || admission_sketch_->Frequency(hash) > admission_sketch_->Frequency(victim_hash);
+}
+
 void DataCache::Partition::EvictedEntry(Slice key, Slice value) {
   if (closed_) return;
-  if (UNLIKELY(trace_replay_)) return;
-  ScopedHistogramTimer eviction_timer(eviction_latency_);
   // Unpack the cache entry.
   CacheEntry entry(value);
   int64_t eviction_len = BitUtil::RoundUp(entry.len(), PAGE_SIZE);
+  charged_bytes_.Add(-eviction_len);
+  if (admission_sketch_ != nullptr) {
+    last_victim_hash_.Store(CacheKey::Hash(key));
+    has_victim_.Store(true);
+  }
+  if (UNLIKELY(trace_replay_)) return;
+  ScopedHistogramTimer eviction_timer(eviction_latency_);
   DCHECK_EQ(entry.offset() % PAGE_SIZE, 0);
   entry.file()->PunchHole(entry.offset(), eviction_len);
   ImpaladMetrics::IO_MGR_REMOTE_DATA_CACHE_TOTAL_BYTES->Increment(-eviction_len);
@@ -794,10 +1411,17 @@ bool DataCache::Partition::VerifyChecksum(const string& ops_name, const CacheEnt
   DCHECK_GE(buffer_len, entry.len());
   int64_t checksum = Checksum(buffer, entry.len());
   if (UNLIKELY(checksum != entry.checksum())) {
-    LOG(DFATAL) << Substitute("Checksum mismatch during $0 for file $1 "
+    const string& err = Substitute("Checksum mismatch during $0 for file $1 "
         "offset: $2 len: $3 buffer len: $4. Expected $5, Got $6.", ops_name,
         entry.file()->path(), entry.offset(), entry.len(), buffer_len, entry.checksum(),
         checksum);
+    // The content of a reloaded entry is lost if the previous run crashed before it was
+    // written back to disk.
+    if (entry.reloaded()) {
+      LOG(WARNING) << err;
+    } else {
+      LOG(DFATAL) << err;
+    }
     return false;
   }
   return true;
@@ -813,6 +1437,31 @@ Status DataCache::Init() {
     return Status(Substitute("Misconfigured --data_cache_write_concurrency: $0. "
         "Must be at least 1.", FLAGS_data_cache_write_concurrency));
   }
+  const string admission_policy =
+      boost::to_upper_copy(FLAGS_data_cache_admission_policy);
+  if (admission_policy != "ALL" && admission_policy != "TINYLFU") {
+    return Status(Substitute("Misconfigured --data_cache_admission_policy: $0. Must be "
+        "'ALL' or 'TinyLFU'.", FLAGS_data_cache_admission_policy));
+  }
+  if (FLAGS_data_cache_num_async_write_threads < 0) {
+    return Status(Substitute("Misconfigured --data_cache_num_async_write_threads: $0. "
+        "Must be at least 0.", FLAGS_data_cache_num_async_write_threads));
+  }
+  if (FLAGS_data_cache_persistent) {
+    // Reloaded entries are validated with their checksums. Checkpoints iterate over the
+    // entries with Cache::Invalidate(), which is not supported by LIRS.
+    if (!FLAGS_data_cache_checksum) {
+      return Status("--data_cache_persistent requires --data_cache_checksum.");
+    }
+    if (GetCacheEvictionPolicy(FLAGS_data_cache_eviction_policy)
+        != Cache::EvictionPolicy::LRU) {
+      return Status("--data_cache_persistent requires the LRU eviction policy.");
+    }
+    if (FLAGS_data_cache_checkpoint_interval_s < 1) {
+      return Status(Substitute("Misconfigured --data_cache_checkpoint_interval_s: $0. "
+          "Must be at least 1.", FLAGS_data_cache_checkpoint_interval_s));
+    }
+  }
 
   // The expected form of the configuration string is: dir1,dir2,..,dirN:capacity
   // Example: /tmp/data1,/tmp/data2:1TB
@@ -832,6 +1481,12 @@ Status DataCache::Init() {
     return Status(Substitute("Configured data cache capacity $0 is too small",
         all_cache_configs[1]));
   }
+  int64_t memory_capacity =
+      ParseUtil::ParseMemSpec(FLAGS_data_cache_memory_tier_capacity, &is_percent, 0);
+  if (memory_capacity < 0 || is_percent) {
+    return Status(Substitute("Misconfigured --data_cache_memory_tier_capacity: $0",
+        FLAGS_data_cache_memory_tier_capacity));
+  }
 
   set<string> cache_dirs;
   SplitStringToSetUsing(all_cache_configs[0], ",", &cache_dirs);
@@ -841,13 +1496,20 @@ Status DataCache::Init() {
     return Status(Substitute("Misconfigured --data_cache_max_opened_files: $0. Must be "
         "at least $1.", FLAGS_data_cache_max_opened_files, cache_dirs.size()));
   }
+  if (memory_capacity > 0 && !trace_replay_) {
+    ExecEnv* exec_env = ExecEnv::GetInstance();
+    memory_tier_mem_tracker_.reset(new MemTracker(-1, "Data Cache Memory Tier",
+        exec_env != nullptr ? exec_env->process_mem_tracker() : nullptr));
+  }
   int32_t partition_idx = 0;
   for (const string& dir_path : cache_dirs) {
     LOG(INFO) << "Adding partition " << dir_path << " with capacity "
-              << PrettyPrinter::PrintBytes(capacity);
+              << PrettyPrinter::PrintBytes(capacity) << " and in-memory capacity "
+              << PrettyPrinter::PrintBytes(memory_capacity);
     std::unique_ptr<Partition> partition =
-        make_unique<Partition>(partition_idx, dir_path, capacity,
-            max_opened_files_per_partition, trace_replay_);
+        make_unique<Partition>(partition_idx, dir_path, capacity, memory_capacity,
+            memory_tier_mem_tracker_.get(), max_opened_files_per_partition,
+            trace_replay_);
     RETURN_IF_ERROR(partition->Init());
     partitions_.emplace_back(move(partition));
     ++partition_idx;
@@ -863,14 +1525,95 @@ Status DataCache::Init() {
         "data-cache-file-deleter", 1, MAX_FILE_DELETER_QUEUE_SIZE,
         bind<void>(&DataCache::DeleteOldFiles, this, _1, _2)));
     RETURN_IF_ERROR(file_deleter_pool_->Init());
+
+    if (FLAGS_data_cache_num_async_write_threads > 0) {
+      bool is_percent;
+      int64_t async_write_buffer_limit = ParseUtil::ParseMemSpec(
+          FLAGS_data_cache_async_write_buffer_limit, &is_percent, 0);
+      if (async_write_buffer_limit <= 0 || is_percent) {
+        return Status(Substitute("Misconfigured --data_cache_async_write_buffer_limit: "
+            "$0", FLAGS_data_cache_async_write_buffer_limit));
+      }
+      ExecEnv* exec_env = ExecEnv::GetInstance();
+      async_write_mem_tracker_.reset(new MemTracker(async_write_buffer_limit,
+          "Data Cache Async Writes",
+          exec_env != nullptr ? exec_env->process_mem_tracker() : nullptr));
+      storer_pool_.reset(new ThreadPool<shared_ptr<StoreTask>>("impala-server",
+          "data-cache-async-writer", FLAGS_data_cache_num_async_write_threads,
+          MAX_STORE_TASK_QUEUE_SIZE,
+          bind<void>(&DataCache::HandleStoreTask, this, _1, _2)));
+      RETURN_IF_ERROR(storer_pool_->Init());
+    }
+
+    if (FLAGS_data_cache_persistent) {
+      RETURN_IF_ERROR(Thread::Create("impala-server", "data-cache-checkpointer",
+          &DataCache::CheckpointLoop, this, &checkpoint_thread_));
+    }
   }
 
   return Status::OK();
 }
 
 void DataCache::ReleaseResources() {
+  // Stop the asynchronous writers before the partitions go away. Queued insertions are
+  // dropped. Destroying the pool frees their buffers.
+  if (storer_pool_) {
+    storer_pool_->Shutdown();
+    storer_pool_->Join();
+    storer_pool_.reset();
+  }
+  if (async_write_mem_tracker_ != nullptr) {
+    DCHECK_EQ(async_write_mem_tracker_->consumption(), 0);
+    if (async_write_mem_tracker_->parent() != nullptr) {
+      async_write_mem_tracker_->CloseAndUnregisterFromParent();
+    } else {
+      async_write_mem_tracker_->Close();
+    }
+    async_write_mem_tracker_.reset();
+  }
   if (file_deleter_pool_) file_deleter_pool_->Shutdown();
+  // Write a final checkpoint of the persistent cache before closing the partitions.
+  if (checkpoint_thread_) {
+    {
+      lock_guard<mutex> l(checkpoint_lock_);
+      shut_down_checkpointer_ = true;
+    }
+    checkpoint_cv_.NotifyAll();
+    checkpoint_thread_->Join();
+    checkpoint_thread_.reset();
+    CheckpointPartitions();
+  }
   for (auto& partition : partitions_) partition->ReleaseResources();
+  // All entries of the in-memory tiers have been released by now.
+  if (memory_tier_mem_tracker_ != nullptr) {
+    DCHECK_EQ(memory_tier_mem_tracker_->consumption(), 0);
+    if (memory_tier_mem_tracker_->parent() != nullptr) {
+      memory_tier_mem_tracker_->CloseAndUnregisterFromParent();
+    } else {
+      memory_tier_mem_tracker_->Close();
+    }
+    memory_tier_mem_tracker_.reset();
+  }
+}
+
+void DataCache::CheckpointLoop() {
+  unique_lock<mutex> l(checkpoint_lock_);
+  while (!shut_down_checkpointer_) {
+    checkpoint_cv_.WaitFor(l, FLAGS_data_cache_checkpoint_interval_s * MICROS_PER_SEC);
+    if (shut_down_checkpointer_) break;
+    l.unlock();
+    CheckpointPartitions();
+    l.lock();
+  }
+}
+
+void DataCache::CheckpointPartitions() {
+  for (auto& partition : partitions_) {
+    Status status = partition->Checkpoint();
+    if (!status.ok()) {
+      LOG(WARNING) << "Failed to checkpoint data cache: " << status.GetDetail();
+    }
+  }
 }
 
 int64_t DataCache::Lookup(const string& filename, int64_t mtime, int64_t offset,
@@ -907,21 +1650,58 @@ bool DataCache::Store(const string& filename, int64_t mtime, int64_t offset,
     return false;
   }
 
-  // Construct a cache key. The cache key is also hashed to compute the partition index.
-  const CacheKey key(filename, mtime, offset);
+  if (storer_pool_ != nullptr) {
+    return SubmitStoreTask(filename, mtime, offset, buffer, buffer_len);
+  }
+  return StoreInternal(CacheKey(filename, mtime, offset), buffer, buffer_len);
+}
+
+bool DataCache::StoreInternal(const CacheKey& key, const uint8_t* buffer,
+    int64_t buffer_len) {
+  // The cache key is hashed to compute the partition index. The number of concurrent
+  // asynchronous insertions is already bound by the size of 'storer_pool_'.
   int idx = key.Hash() % partitions_.size();
   bool start_reclaim;
-  bool stored = partitions_[idx]->Store(key, buffer, buffer_len, &start_reclaim);
+  bool stored = partitions_[idx]->Store(key, buffer, buffer_len,
+      /* limit_concurrency */ storer_pool_ == nullptr, &start_reclaim);
   if (VLOG_IS_ON(3)) {
     stringstream ss;
     ss << std::hex << reinterpret_cast<int64_t>(buffer);
     LOG(INFO) << Substitute("Storing $0 mtime: $1 offset: $2 bytes_to_read: $3 "
-        "buffer: 0x$4 stored: $5", filename, mtime, offset, buffer_len, ss.str(), stored);
+        "buffer: 0x$4 stored: $5", key.filename().ToString(), key.mtime(), key.offset(),
+        buffer_len, ss.str(), stored);
   }
   if (start_reclaim) file_deleter_pool_->Offer(idx);
   return stored;
 }
 
+bool DataCache::SubmitStoreTask(const string& filename, int64_t mtime, int64_t offset,
+    const uint8_t* buffer, int64_t buffer_len) {
+  // Reserve the memory for the copy of 'buffer' first.
+  if (!async_write_mem_tracker_->TryConsume(buffer_len)) {
+    ImpaladMetrics::IO_MGR_REMOTE_DATA_CACHE_ASYNC_WRITES_DROPPED_BYTES->Increment(
+        buffer_len);
+    ImpaladMetrics::IO_MGR_REMOTE_DATA_CACHE_ASYNC_WRITES_DROPPED_ENTRIES->Increment(1);
+    return false;
+  }
+  shared_ptr<StoreTask> task = make_shared<StoreTask>(filename, mtime, offset, buffer,
+      buffer_len, async_write_mem_tracker_.get());
+  // Never wait for space in the queue. A task which isn't queued releases its memory
+  // when it goes out of scope.
+  if (UNLIKELY(!storer_pool_->Offer(move(task), 0))) {
+    ImpaladMetrics::IO_MGR_REMOTE_DATA_CACHE_ASYNC_WRITES_DROPPED_BYTES->Increment(
+        buffer_len);
+    ImpaladMetrics::IO_MGR_REMOTE_DATA_CACHE_ASYNC_WRITES_DROPPED_ENTRIES->Increment(1);
+    return false;
+  }
+  return true;
+}
+
+void DataCache::HandleStoreTask(uint32_t thread_id, const shared_ptr<StoreTask>& task) {
+  // The buffer is released when the last reference to 'task' goes away.
+  StoreInternal(task->key(), task->buffer(), task->buffer_len());
+}
+
 Status DataCache::CloseFilesAndVerifySizes() {
   for (auto& partition : partitions_) {
     RETURN_IF_ERROR(partition->CloseFilesAndVerifySizes());
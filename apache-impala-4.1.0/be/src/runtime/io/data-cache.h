@@ -24,10 +24,14 @@
 #include <unordered_set>
 #include <gtest/gtest_prod.h>
 
+#include "common/atomic.h"
 #include "common/status.h"
 #include "util/cache/cache.h"
+#include "util/condition-variable.h"
+#include "util/frequency-sketch.h"
 #include "util/metrics-fwd.h"
 #include "util/spinlock.h"
+#include "util/thread.h"
 #include "util/thread-pool.h"
 #include "kudu/util/faststring.h"
 #include "kudu/util/slice.h"
@@ -80,12 +84,59 @@
 /// requires more investigation for other file formats and workloads.
 ///
 /// To probe for cached data in the cache, the interface Lookup() is used; To insert
-/// data into the cache, the interface Store() is used. Write to the backing file and
-/// eviction from it happen synchronously. Currently, Store() is limited to the
-/// concurrency of one thread per partition to prevent slowing down the caller in case
-/// the cache is thrashing and it becomes IO bound. The write concurrency can be tuned
-/// via the knob --data_cache_write_concurrency. Also, Store() has a minimum granularity
-/// of 4KB so any data inserted will be rounded up to the nearest multiple of 4KB.
+/// data into the cache, the interface Store() is used. By default, write to the backing
+/// file and eviction from it happen synchronously. In this mode, Store() is limited to
+/// the concurrency of one thread per partition to prevent slowing down the caller in
+/// case the cache is thrashing and it becomes IO bound. The write concurrency can be
+/// tuned via the knob --data_cache_write_concurrency. Also, Store() has a minimum
+/// granularity of 4KB so any data inserted will be rounded up to the nearest multiple of
+/// 4KB.
+///
+/// If --data_cache_num_async_write_threads is greater than 0, Store() instead copies
+/// the data into a temporary buffer and queues the insertion for one of the threads in
+/// 'storer_pool_', which do the writes and evictions in the background. The write
+/// concurrency is then bound by the number of those threads instead. The total size of
+/// the temporary buffers is bound by --data_cache_async_write_buffer_limit and tracked
+/// by a child of the process memory tracker. Insertions which would exceed the limit or
+/// the process memory limit are dropped so that Store() never blocks the caller. So are
+/// the insertions still queued when the cache is shut down.
+///
+/// By default, every entry passed to Store() is admitted into the cache, so a single
+/// scan of a large table can evict the whole working set. With
+/// --data_cache_admission_policy=TinyLFU, each partition keeps a frequency sketch of
+/// the cache keys looked up in it (see FrequencySketch). Once the partition is full, a
+/// new entry is only admitted if it has been looked up more often than the most
+/// recently evicted entry, which approximates the next victim of the eviction policy.
+/// Entries which are only accessed once by a scan are thus rejected while popular
+/// entries stay cached. The trace replayer (data-cache-trace-replayer) can be used to
+/// compare the admission policies on traces of real workloads.
+///
+/// Optionally, each partition can have an in-memory tier in front of its backing files,
+/// with a quota of --data_cache_memory_tier_capacity bytes per partition. An entry is
+/// promoted into the memory tier when it's read from the backing file, so entries
+/// which are hit repeatedly (e.g. Parquet footers or small dimension tables) are served
+/// by a memcpy() instead of a read from local storage. The memory tier uses the same
+/// eviction policy as the metadata cache (--data_cache_eviction_policy) and is
+/// inclusive: an entry in memory is also kept in a backing file, and hits in memory
+/// also refresh the entry in the metadata cache. Entries evicted from the memory tier
+/// are thus demoted to the backing files without any writes. A copy in memory records
+/// the location of the entry in the backing file that it was read from and is only
+/// used while that entry is still the one in the metadata cache, so copies of replaced
+/// or invalidated entries are never returned. The memory of all in-memory tiers is
+/// tracked by a child of the process memory tracker and entries are not promoted if
+/// that would exceed the process memory limit.
+///
+/// By default, the backing files are deleted on shutdown and on startup, so a restarted
+/// daemon starts with an empty cache. With --data_cache_persistent, each partition
+/// instead writes a checkpoint of its metadata cache to its directory every
+/// --data_cache_checkpoint_interval_s seconds and on shutdown. A checkpoint lists the
+/// backing files and, for each entry from the least to the most recently used, its
+/// cache key, location in a backing file and checksum. On startup, the entries are
+/// reloaded in that order and the backing files are kept. Nothing is appended to a
+/// reloaded backing file. As the cached data may not have reached the disk when a daemon
+/// crashed, reloaded entries are validated lazily: every read of such an entry, even a
+/// partial one, verifies the checksum of the whole entry and the entry is erased on
+/// mismatch. This requires --data_cache_checksum and the LRU eviction policy.
 ///
 /// The number of backing files in all partitions is bound by
 /// --data_cache_max_opened_files. Once the number of files exceeds that set limit, files
@@ -105,6 +156,9 @@
 ///
 
 namespace impala {
+
+class MemTracker;
+
 namespace io {
 
 namespace trace {
@@ -133,7 +187,9 @@ class DataCache {
   /// Return error if any of the partitions failed to be initialized.
   Status Init();
 
-  /// Releases any resources (e.g. backing files) consumed by all partitions.
+  /// Releases any resources (e.g. backing files) consumed by all partitions. If
+  /// --data_cache_persistent is true, writes a final checkpoint and keeps the backing
+  /// files instead.
   void ReleaseResources();
 
   /// Looks up a cached entry and copies any cached content from the cache into 'buffer'.
@@ -179,7 +235,9 @@ class DataCache {
   /// - the maximum write concurrency (via --data_cache_write_concurrency) is reached.
   /// - IO error when writing to the backing file.
   ///
-  /// Returns true iff the entry is installed successfully.
+  /// Returns true iff the entry is installed successfully. If asynchronous writes are
+  /// enabled, returns true iff the insertion was queued. The caller may reuse 'buffer'
+  /// as soon as Store() returns in both cases.
   ///
   bool Store(const std::string& filename, int64_t mtime, int64_t offset,
       const uint8_t* buffer, int64_t buffer_len);
@@ -198,16 +256,23 @@ class DataCache {
   class CacheFile;
   struct CacheKey;
   class CacheEntry;
+  class StoreTask;
+  class MemoryTierEvictionCallback;
 
   /// An implementation of a cache partition. Each partition maintains its own set of
   /// cache keys in a LRU cache.
   class Partition : public Cache::EvictionCallback {
    public:
     /// Creates a partition at the given directory 'path' with quota 'capacity' in bytes.
+    /// The admission policy is configured by --data_cache_admission_policy.
+    /// 'memory_capacity' is the quota of the in-memory tier in bytes, or 0 if the
+    /// partition has no in-memory tier. The memory of the in-memory tier is tracked by
+    /// 'memory_tier_mem_tracker', which must be non-NULL if 'memory_capacity' is not 0.
     /// 'max_opened_files' is the maximum number of opened files allowed per partition.
-    /// If 'trace_replay' is true, this only performs metadata operations for the
-    /// access trace functionality.
+    /// If 'trace_replay' is true, this only performs metadata operations for the access
+    /// trace functionality.
     Partition(int32_t index, const std::string& path, int64_t capacity,
+        int64_t memory_capacity, MemTracker* memory_tier_mem_tracker,
         int max_opened_files, bool trace_replay);
 
     ~Partition();
@@ -223,9 +288,14 @@ class DataCache {
     Status Init();
 
     /// Close and delete all backing files created for this partition. Also releases
-    /// the memory held by the metadata cache.
+    /// the memory held by the metadata cache. The backing files are kept if
+    /// --data_cache_persistent is true.
     void ReleaseResources();
 
+    /// Writes a checkpoint of the entries in the metadata cache into 'path_', replacing
+    /// any previous checkpoint. Returns error if the checkpoint couldn't be written.
+    Status Checkpoint();
+
     /// Looks up in the meta-data cache with key 'cache_key'. If found, try copying
     /// 'bytes_to_read' bytes from the backing file into 'buffer'. If trace_replay
     /// is enabled, the buffer is null and no bytes are copied. Returns number
@@ -234,10 +304,12 @@ class DataCache {
 
     /// Inserts a entry with key 'cache_key' and data in 'buffer' into the cache.
     /// 'buffer' is nullptr for trace replay. 'buffer_len' is the length of buffer.
+    /// If 'limit_concurrency' is true, the insertion is dropped if there are already
+    /// --data_cache_write_concurrency insertions in progress in this partition.
     /// 'start_reclaim' is set to true if the number of backing files exceeds the per
     /// partition limit. Returns true if the entry is inserted. Returns false otherwise.
     bool Store(const CacheKey& cache_key, const uint8_t* buffer, int64_t buffer_len,
-        bool* start_reclaim);
+        bool limit_concurrency, bool* start_reclaim);
 
     /// Callback invoked when evicting an entry from the cache. 'key' is the cache key
     /// of the entry being evicted and 'value' contains the cache entry which is the
@@ -276,6 +348,9 @@ class DataCache {
     /// The capacity in bytes of this partition.
     const int64_t capacity_;
 
+    /// The capacity in bytes of the in-memory tier of this partition. 0 if disabled.
+    const int64_t memory_capacity_;
+
     /// Maximum number of opened files allowed in a partition.
     const int max_opened_files_;
 
@@ -291,6 +366,9 @@ class DataCache {
     /// The prefix of the names of the cache backing files.
     static const char* CACHE_FILE_PREFIX;
 
+    /// The name of the checkpoint file of a persistent partition.
+    static const char* CHECKPOINT_FILE_NAME;
+
     /// Protects the following fields.
     SpinLock lock_;
 
@@ -319,8 +397,32 @@ class DataCache {
     /// content. Please see comments at CachedEntry for details.
     std::unique_ptr<Cache> meta_cache_;
 
+    /// Releases the memory of the entries evicted from 'memory_cache_'. Must outlive
+    /// 'memory_cache_'. NULL if the in-memory tier is disabled.
+    std::unique_ptr<MemoryTierEvictionCallback> memory_tier_eviction_callback_;
+
+    /// Tracks the memory of the entries in 'memory_cache_'. Owned by the DataCache.
+    MemTracker* const memory_tier_mem_tracker_;
+
+    /// The in-memory tier which maps cache keys to copies of the cached data. The value
+    /// of an entry is a MemoryTierHeader followed by the cached content. NULL if the
+    /// in-memory tier is disabled.
+    std::unique_ptr<Cache> memory_cache_;
+
     std::unique_ptr<trace::Tracer> tracer_;
 
+    /// Frequency sketch of the keys looked up in this partition for the TinyLFU
+    /// admission policy. NULL if all entries are admitted.
+    std::unique_ptr<FrequencySketch> admission_sketch_;
+
+    /// Total charge in bytes of the entries in 'meta_cache_'.
+    AtomicInt64 charged_bytes_;
+
+    /// Hash of the key of the most recently evicted entry and whether there has been
+    /// any eviction. Only maintained if 'admission_sketch_' is not NULL.
+    AtomicInt64 last_victim_hash_;
+    AtomicBool has_victim_;
+
     /// Metrics to track performance of the underlying filesystem for the data cache
     /// These are all latency histograms for the operations on the data cache files for
     /// this partition.
@@ -336,10 +438,18 @@ class DataCache {
     /// error on failure.
     Status CreateCacheFile();
 
-    /// Utility function to delete cache files left over from previous runs of Impala.
-    /// Returns error on failure.
+    /// Utility function to delete cache files left over from previous runs of Impala,
+    /// except for the files reloaded by LoadCheckpoint(). Also deletes the checkpoint
+    /// if the cache is not persistent. The cache partition's lock needs to be held
+    /// when calling this function. Returns error on failure.
     Status DeleteExistingFiles() const;
 
+    /// Reopens the backing files and reloads the entries listed in the checkpoint in
+    /// 'path_', if any. Entries which are not covered by their backing file anymore are
+    /// skipped. A missing or corrupted checkpoint is logged and ignored. The cache
+    /// partition's lock needs to be held when calling this function.
+    void LoadCheckpoint();
+
     /// Utility function for computing the checksum of 'buffer' with length 'buffer_len'.
     static uint64_t Checksum(const uint8_t* buffer, int64_t buffer_len);
 
@@ -366,6 +476,25 @@ class DataCache {
     bool InsertIntoCache(const kudu::Slice& key, CacheFile* cache_file,
         int64_t insertion_offset, const uint8_t* buffer, int64_t buffer_len);
 
+    /// Returns true if a new entry with key 'cache_key' and charge 'charge_len' should be
+    /// admitted into the cache under the TinyLFU admission policy.
+    bool Admit(const CacheKey& cache_key, int64_t charge_len);
+
+    /// Looks up 'key' in the in-memory tier. 'entry' is the entry of 'key' in
+    /// 'meta_cache_'. On a hit on a copy of 'entry', copies up to 'bytes_to_read' bytes
+    /// into 'buffer' and returns the number of bytes copied. A copy of any other entry
+    /// with the same key, e.g. of a shorter entry which has been replaced since, is
+    /// removed. Returns 0 if there is no copy of 'entry' in memory.
+    int64_t LookupMemoryTier(const kudu::Slice& key, const CacheEntry& entry,
+        int64_t bytes_to_read, uint8_t* buffer);
+
+    /// Inserts a copy of 'buffer', the content of 'entry' with length 'buffer_len', into
+    /// the in-memory tier under 'key', replacing any existing entry. The insertion may be
+    /// rejected by the eviction policy, if the entry is too large for the in-memory tier
+    /// or if its memory would exceed the process memory limit.
+    void PromoteToMemoryTier(const kudu::Slice& key, const CacheEntry& entry,
+        const uint8_t* buffer, int64_t buffer_len);
+
     /// Utility function for verifying that the checksum of 'buffer' with length
     /// 'buffer_len' matches the checksum recorded in the meta-data 'entry->checksum'.
     ///
@@ -387,6 +516,10 @@ class DataCache {
   /// operations, and no filesystem operations are required.
   bool trace_replay_;
 
+  /// Tracks the memory of the in-memory tiers of all partitions. A child of the process
+  /// memory tracker. NULL if the in-memory tier is disabled. Must outlive 'partitions_'.
+  std::unique_ptr<MemTracker> memory_tier_mem_tracker_;
+
   /// The set of all cache partitions.
   std::vector<std::unique_ptr<Partition>> partitions_;
 
@@ -399,6 +532,46 @@ class DataCache {
   /// in partitions_[partition_idx].
   void DeleteOldFiles(uint32_t thread_id, int partition_idx);
 
+  /// Tracks the buffers of the insertions queued in 'storer_pool_'. Its limit is
+  /// --data_cache_async_write_buffer_limit. A child of the process memory tracker. NULL
+  /// unless --data_cache_num_async_write_threads is greater than 0. Must outlive
+  /// 'storer_pool_'.
+  std::unique_ptr<MemTracker> async_write_mem_tracker_;
+
+  /// Thread pool for inserting entries into the cache asynchronously. NULL unless
+  /// --data_cache_num_async_write_threads is greater than 0.
+  std::unique_ptr<ThreadPool<std::shared_ptr<StoreTask>>> storer_pool_;
+
+  /// Inserts the entry 'key' with the data in 'buffer' into its partition. Called by
+  /// Store() or, if asynchronous writes are enabled, by a thread in 'storer_pool_'.
+  bool StoreInternal(const CacheKey& key, const uint8_t* buffer, int64_t buffer_len);
+
+  /// Copies 'buffer' and queues its insertion into the cache for 'storer_pool_'.
+  /// Returns false if the insertion was dropped because it would exceed the limit on
+  /// the buffered bytes or the process memory limit.
+  bool SubmitStoreTask(const std::string& filename, int64_t mtime, int64_t offset,
+      const uint8_t* buffer, int64_t buffer_len);
+
+  /// Thread function called by threads in 'storer_pool_' to insert the entry of 'task'.
+  void HandleStoreTask(uint32_t thread_id, const std::shared_ptr<StoreTask>& task);
+
+  /// Thread which writes checkpoints of all partitions every
+  /// --data_cache_checkpoint_interval_s seconds. NULL unless --data_cache_persistent is
+  /// true.
+  std::unique_ptr<Thread> checkpoint_thread_;
+
+  /// Protects 'shut_down_checkpointer_'. 'checkpoint_cv_' is signaled to wake up
+  /// 'checkpoint_thread_' on shutdown.
+  std::mutex checkpoint_lock_;
+  ConditionVariable checkpoint_cv_;
+  bool shut_down_checkpointer_ = false;
+
+  /// Thread function of 'checkpoint_thread_'.
+  void CheckpointLoop();
+
+  /// Writes a checkpoint of each partition. Failures are logged.
+  void CheckpointPartitions();
+
 };
 
 } // namespace io
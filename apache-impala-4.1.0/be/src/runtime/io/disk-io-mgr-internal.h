@@ -60,8 +60,17 @@ static inline bool is_file_handle_caching_enabled() {
 }
 
 /// Global queue of requests for a disk. One or more disk threads pull requests off
-/// a given queue. RequestContexts are scheduled in round-robin order to provide some
-/// level of fairness between RequestContexts.
+/// a given queue. By default, RequestContexts are scheduled in round-robin order to
+/// provide some level of fairness between RequestContexts.
+///
+/// If --disk_io_fair_scheduling is true, RequestContexts are instead scheduled with
+/// start-time fair queueing: each context is assigned a virtual start time when it is
+/// enqueued and the context with the lowest start time is dispatched next. Every
+/// dispatch advances the virtual finish time of the context by 1 / weight, so that
+/// contexts of resource pools with a higher weight (see --disk_io_pool_weights) are
+/// dispatched proportionally more often. To bound the wait of contexts with a low
+/// weight, a context that has been queued for longer than --disk_io_queue_deadline_ms
+/// is dispatched first.
 class DiskQueue {
  public:
   DiskQueue(int disk_id) : disk_id_(disk_id) {}
@@ -75,16 +84,7 @@ class DiskQueue {
   void DiskThreadLoop(DiskIoMgr* io_mgr);
 
   /// Enqueue the request context to the disk queue.
-  void EnqueueContext(RequestContext* worker) {
-    {
-      std::unique_lock<std::mutex> disk_lock(lock_);
-      // Check that the reader is not already on the queue
-      DCHECK(find(request_contexts_.begin(), request_contexts_.end(), worker) ==
-          request_contexts_.end());
-      request_contexts_.push_back(worker);
-    }
-    work_available_.NotifyAll();
-  }
+  void EnqueueContext(RequestContext* worker);
 
   /// Signals that disk threads for this queue should stop processing new work and
   /// terminate once done.
@@ -121,12 +121,29 @@ class DiskQueue {
   IntCounter* write_io_err() const { return write_io_err_; }
 
  private:
+  friend class DiskIoMgrTest;
+
   /// Called from the disk thread to get the next range to process. Wait until a scan
   /// is available to process, a write range is available, or 'shut_down_' is set to
   /// true. Returns the range to process and the RequestContext that the range belongs
   /// to. Only returns NULL if the disk thread should be shut down.
   RequestRange* GetNextRequestRange(RequestContext** request_context);
 
+  /// A request context on the queue.
+  struct QueuedContext {
+    RequestContext* context;
+
+    /// Virtual start time for fair scheduling.
+    double start_tag;
+
+    /// Value of MonotonicNanos() when the context was enqueued.
+    int64_t enqueue_time_ns;
+  };
+
+  /// Removes the next context to dispatch from 'request_contexts_' and returns it.
+  /// 'lock_' must be held and 'request_contexts_' must not be empty.
+  QueuedContext DequeueContextLocked();
+
   /// Disk id (0-based)
   const int disk_id_;
 
@@ -154,8 +171,13 @@ class DiskQueue {
   /// scan range that is not blocked on available buffers.
   ConditionVariable work_available_;
 
-  /// list of all request contexts that have work queued on this disk
-  std::list<RequestContext*> request_contexts_;
+  /// list of all request contexts that have work queued on this disk, in the order in
+  /// which they were enqueued.
+  std::list<QueuedContext> request_contexts_;
+
+  /// Virtual time of the queue for fair scheduling: the start time of the context that
+  /// was dispatched last.
+  double virtual_time_ = 0;
 
   /// True if the IoMgr should be torn down. Worker threads check this when dequeueing
   /// from 'request_contexts_' and terminate themselves once it is true. Only used in
@@ -15,6 +15,7 @@
 // specific language governing permissions and limitations
 // under the License.
 
+#include <fcntl.h>
 #include <sched.h>
 #include <boost/bind.hpp>
 #include <boost/thread/thread.hpp>
@@ -26,6 +27,8 @@
 #include "runtime/io/disk-io-mgr-internal.h"
 #include "runtime/io/disk-io-mgr-stress.h"
 #include "runtime/io/disk-io-mgr.h"
+#include "runtime/io/hedged-read-manager.h"
+#include "runtime/io/io-uring.h"
 #include "runtime/io/local-file-system-with-fault-injection.h"
 #include "runtime/io/request-context.h"
 #include "runtime/test-env.h"
@@ -35,7 +38,9 @@
 #include "testutil/rand-util.h"
 #include "testutil/scoped-flag-setter.h"
 #include "util/condition-variable.h"
+#include "util/cpu-info.h"
 #include "util/debug-util.h"
+#include "util/error-util.h"
 #include "util/filesystem-util.h"
 #include "util/histogram-metric.h"
 #include "util/thread.h"
@@ -64,6 +69,15 @@ DECLARE_int32(num_sfs_io_threads);
 DECLARE_int32(stress_disk_read_delay_ms);
 #endif
 
+DECLARE_bool(disk_io_fair_scheduling);
+DECLARE_int64(disk_io_queue_deadline_ms);
+DECLARE_string(disk_io_pool_weights);
+DECLARE_int32(fs_hedged_read_threads);
+DECLARE_int64(fs_hedged_read_min_delay_ms);
+DECLARE_string(fs_hedged_read_max_bytes_in_flight);
+DECLARE_int32(io_uring_max_op_size);
+DECLARE_int64(scan_range_coalesce_max_gap_bytes);
+DECLARE_int32(scan_range_coalesce_max_bytes);
 DECLARE_string(remote_tmp_file_size);
 DECLARE_string(remote_tmp_file_block_size);
 
@@ -121,6 +135,49 @@ class DiskIoMgrTest : public testing::Test {
     }
   }
 
+  /// Creates a scan range of 'len' bytes at 'offset' of the remote file 'file' and
+  /// registers it with 'reader' as an active range that can be coalesced. The file
+  /// system is never accessed.
+  ScanRange* AddCoalescableRange(RequestContext* reader, const char* file,
+      int64_t offset, int64_t len) {
+    ScanRange* range = pool_.Add(new ScanRange);
+    range->Reset(reinterpret_cast<hdfsFS>(1), file, len, offset, 0, false, 1,
+        BufferOpts::Uncached());
+    range->io_mgr_ = reader->parent_;
+    range->reader_ = reader;
+    EXPECT_TRUE(range->CanCoalesce());
+    unique_lock<mutex> lock(reader->lock_);
+    reader->AddActiveScanRangeLocked(lock, range);
+    return range;
+  }
+
+  /// Enqueues 'context' on 'queue' as if it was enqueued 'age_ms' milliseconds ago.
+  void EnqueueContext(DiskQueue* queue, RequestContext* context, int64_t age_ms = 0) {
+    queue->EnqueueContext(context);
+    lock_guard<mutex> l(queue->lock_);
+    queue->request_contexts_.back().enqueue_time_ns -= age_ms * NANOS_PER_MICRO
+        * MICROS_PER_MILLI;
+  }
+
+  /// Removes the next context to dispatch from 'queue' and returns it. See
+  /// DiskQueue::DequeueContextLocked().
+  RequestContext* DequeueContext(DiskQueue* queue) {
+    lock_guard<mutex> l(queue->lock_);
+    return queue->DequeueContextLocked().context;
+  }
+
+  /// Sets the virtual finish time of the last I/O of 'context' on disk 'disk_id'.
+  void SetIoFinishTag(RequestContext* context, int disk_id, double finish_tag) {
+    context->io_finish_tags_[disk_id] = finish_tag;
+  }
+
+  /// Returns the coalesced read that serves all of 'range'. See
+  /// RequestContext::GetCoalescedRead().
+  shared_ptr<CoalescedRead> GetCoalescedRead(RequestContext* reader, ScanRange* range,
+      bool* is_owner) {
+    return reader->GetCoalescedRead(range, range->offset(), range->len(), is_owner);
+  }
+
   void WriteValidateCallback(int num_writes, WriteRange** written_range,
       DiskIoMgr* io_mgr, RequestContext* reader, BufferPool::ClientHandle* client,
       int32_t* data, Status expected_status, const Status& status) {
@@ -1928,6 +1985,420 @@ TEST_F(DiskIoMgrTest, MetricsOfWriteIoError) {
   io_mgr.UnregisterContext(writer.get());
 }
 
+// Test that reads that take longer than the hedge delay are hedged, that the result of
+// the faster read is returned and that the limit on the bytes in flight is respected.
+// The read function induces the delays and failures.
+TEST_F(DiskIoMgrTest, HedgedReads) {
+  auto threads = ScopedFlagSetter<int32_t>::Make(&FLAGS_fs_hedged_read_threads, 4);
+  auto min_delay =
+      ScopedFlagSetter<int64_t>::Make(&FLAGS_fs_hedged_read_min_delay_ms, 10);
+  const int64_t SLOW_READ_MS = 2000;
+  const int64_t LEN = 64;
+  vector<uint8_t> data(LEN * 2);
+  for (int i = 0; i < data.size(); ++i) data[i] = i;
+  // Number of reads that are slow before they complete.
+  AtomicInt32 num_slow_reads;
+  AtomicBool fail_reads(false);
+  auto read_fn = [&](int64_t offset, uint8_t* buffer, int64_t len) {
+    if (fail_reads.Load()) return Status("Injected read failure");
+    if (num_slow_reads.Add(-1) >= 0) SleepForMs(SLOW_READ_MS);
+    memcpy(buffer, data.data() + offset, len);
+    return Status::OK();
+  };
+  IntCounter* num_hedged = ImpaladMetrics::IO_MGR_NUM_HEDGED_READS;
+  IntCounter* num_won = ImpaladMetrics::IO_MGR_NUM_HEDGED_READS_WON;
+  vector<uint8_t> buffer(LEN);
+
+  for (const string& max_bytes_in_flight : {"1MB", "32B"}) {
+    auto max_bytes = ScopedFlagSetter<string>::Make(
+        &FLAGS_fs_hedged_read_max_bytes_in_flight, max_bytes_in_flight);
+    HedgedReadManager hedged_reads;
+    ASSERT_OK(hedged_reads.Init());
+    // No reads are hedged until the latencies of enough reads are known.
+    EXPECT_EQ(-1, hedged_reads.hedge_delay_us());
+    for (int i = 0; i < 128; ++i) {
+      ASSERT_OK(hedged_reads.Read(read_fn, 0, buffer.data(), LEN));
+    }
+    EXPECT_GE(hedged_reads.hedge_delay_us(), 10 * MICROS_PER_MILLI);
+
+    // The first read is slow and is overtaken by its hedge, unless the hedge exceeds
+    // the limit on the bytes in flight.
+    bool expect_hedge = max_bytes_in_flight == "1MB";
+    int64_t hedged_before = num_hedged->GetValue();
+    int64_t won_before = num_won->GetValue();
+    num_slow_reads.Store(1);
+    int64_t start_ms = MonotonicMillis();
+    ASSERT_OK(hedged_reads.Read(read_fn, LEN, buffer.data(), LEN));
+    int64_t elapsed_ms = MonotonicMillis() - start_ms;
+    EXPECT_EQ(0, memcmp(buffer.data(), data.data() + LEN, LEN));
+    if (expect_hedge) {
+      EXPECT_LT(elapsed_ms, SLOW_READ_MS);
+      EXPECT_EQ(hedged_before + 1, num_hedged->GetValue());
+      EXPECT_EQ(won_before + 1, num_won->GetValue());
+    } else {
+      EXPECT_GE(elapsed_ms, SLOW_READ_MS);
+      EXPECT_EQ(hedged_before, num_hedged->GetValue());
+      EXPECT_EQ(won_before, num_won->GetValue());
+    }
+
+    // The error is returned if all reads fail.
+    fail_reads.Store(true);
+    EXPECT_FALSE(hedged_reads.Read(read_fn, 0, buffer.data(), LEN).ok());
+    fail_reads.Store(false);
+    // Wait for the slow read that lost.
+    hedged_reads.Close();
+  }
+}
+
+// Test that nearby scan ranges of the same remote file are served by a single coalesced
+// read. Ranges are merged up to the gap and size limits, the other ranges fall back to
+// their own reads if the coalesced read fails or is short, and ranges that wait for the
+// read are woken up when the reader is cancelled.
+TEST_F(DiskIoMgrTest, CoalescedReads) {
+  const int64_t MAX_GAP = 50;
+  auto max_gap =
+      ScopedFlagSetter<int64_t>::Make(&FLAGS_scan_range_coalesce_max_gap_bytes, MAX_GAP);
+  auto max_bytes =
+      ScopedFlagSetter<int32_t>::Make(&FLAGS_scan_range_coalesce_max_bytes, 1000);
+  const char* FILE = "s3a://fake-bucket/coalesced-reads";
+  DiskIoMgr io_mgr(1, 1, 1, MIN_BUFFER_SIZE, MAX_BUFFER_SIZE);
+  ASSERT_OK(io_mgr.Init());
+  MemTracker* mem_tracker = io_mgr.coalesced_read_mem_tracker();
+  vector<uint8_t> buffer(100);
+  bool is_owner;
+
+  // Ranges are merged if the gap between them is at most MAX_GAP.
+  {
+    unique_ptr<RequestContext> reader = io_mgr.RegisterContext();
+    ScanRange* first = AddCoalescableRange(reader.get(), FILE, 0, 100);
+    ScanRange* second = AddCoalescableRange(reader.get(), FILE, 100 + MAX_GAP, 100);
+    ScanRange* third = AddCoalescableRange(reader.get(), FILE, 251 + MAX_GAP, 100);
+    shared_ptr<CoalescedRead> read = GetCoalescedRead(reader.get(), first, &is_owner);
+    ASSERT_TRUE(read != nullptr);
+    EXPECT_TRUE(is_owner);
+    EXPECT_EQ(0, read->offset());
+    EXPECT_EQ(200 + MAX_GAP, read->len());
+    EXPECT_EQ(read->len(), mem_tracker->consumption());
+    EXPECT_EQ(read, GetCoalescedRead(reader.get(), second, &is_owner));
+    EXPECT_FALSE(is_owner);
+    // The third range is one byte too far away and no other ranges are left.
+    EXPECT_TRUE(GetCoalescedRead(reader.get(), third, &is_owner) == nullptr);
+    EXPECT_FALSE(is_owner);
+
+    // A short read only serves the ranges that it covers completely.
+    for (int i = 0; i < read->len(); ++i) read->buffer()[i] = i;
+    read->Done(read->len() - 1);
+    EXPECT_TRUE(read->CopyTo(first->offset(), buffer.data(), 100));
+    EXPECT_EQ(99, buffer[99]);
+    EXPECT_FALSE(read->CopyTo(second->offset(), buffer.data(), 100));
+    io_mgr.UnregisterContext(reader.get());
+    read.reset();
+    EXPECT_EQ(0, mem_tracker->consumption());
+  }
+
+  // The extent is capped at --scan_range_coalesce_max_bytes, also when growing it
+  // towards lower offsets. A failed read serves no range.
+  {
+    auto max_bytes_200 =
+        ScopedFlagSetter<int32_t>::Make(&FLAGS_scan_range_coalesce_max_bytes, 200);
+    unique_ptr<RequestContext> reader = io_mgr.RegisterContext();
+    ScanRange* first = AddCoalescableRange(reader.get(), FILE, 0, 100);
+    ScanRange* second = AddCoalescableRange(reader.get(), FILE, 100, 100);
+    ScanRange* third = AddCoalescableRange(reader.get(), FILE, 200, 100);
+    shared_ptr<CoalescedRead> read = GetCoalescedRead(reader.get(), second, &is_owner);
+    ASSERT_TRUE(read != nullptr);
+    EXPECT_TRUE(is_owner);
+    EXPECT_EQ(100, read->offset());
+    EXPECT_EQ(200, read->len());
+    EXPECT_EQ(read, GetCoalescedRead(reader.get(), third, &is_owner));
+    EXPECT_TRUE(GetCoalescedRead(reader.get(), first, &is_owner) == nullptr);
+    read->Done(0);
+    EXPECT_FALSE(read->CopyTo(second->offset(), buffer.data(), 100));
+    EXPECT_FALSE(read->CopyTo(third->offset(), buffer.data(), 100));
+    io_mgr.UnregisterContext(reader.get());
+  }
+  EXPECT_EQ(0, mem_tracker->consumption());
+
+  // A range waiting for the read of another range is woken up when the owner gives up
+  // after the reader is cancelled, and then reads on its own.
+  {
+    unique_ptr<RequestContext> reader = io_mgr.RegisterContext();
+    ScanRange* first = AddCoalescableRange(reader.get(), FILE, 0, 100);
+    ScanRange* second = AddCoalescableRange(reader.get(), FILE, 100, 100);
+    shared_ptr<CoalescedRead> read = GetCoalescedRead(reader.get(), first, &is_owner);
+    ASSERT_TRUE(read != nullptr);
+    ASSERT_EQ(read, GetCoalescedRead(reader.get(), second, &is_owner));
+    AtomicBool copied(true);
+    thread waiter([&]() {
+      copied.Store(read->CopyTo(second->offset(), buffer.data(), 100));
+    });
+    SleepForMs(10);
+    reader->Cancel();
+    read->Done(0);
+    waiter.join();
+    EXPECT_FALSE(copied.Load());
+    io_mgr.UnregisterContext(reader.get());
+    read.reset();
+    EXPECT_EQ(0, mem_tracker->consumption());
+  }
+}
+
+// Test that the handles of a file are spread over the partitions of the file handle
+// cache: handles created on CPUs of different shards are kept in different partitions
+// and are found by lookups on any CPU. With one partition per file, all handles of the
+// file share a partition, so only as many of them as fit into it stay cached.
+TEST_F(DiskIoMgrTest, FileHandleCachePartitionsPerFile) {
+  const int PARTITIONS_PER_FILE = 4;
+  const int NUM_PARTITIONS = 16;
+  const int64_t MTIME = 1;
+  // Pick a CPU for each shard of a file.
+  cpu_set_t initial_cpus;
+  ASSERT_EQ(0, sched_getaffinity(0, sizeof(initial_cpus), &initial_cpus));
+  vector<int> shard_cpus(PARTITIONS_PER_FILE, -1);
+  int num_shards = 0;
+  for (int cpu = 0; cpu < min(CPU_SETSIZE, CpuInfo::GetMaxNumCores()); ++cpu) {
+    int shard = cpu % PARTITIONS_PER_FILE;
+    if (!CPU_ISSET(cpu, &initial_cpus) || shard_cpus[shard] != -1) continue;
+    shard_cpus[shard] = cpu;
+    ++num_shards;
+  }
+  if (num_shards < PARTITIONS_PER_FILE) {
+    LOG(INFO) << "Skipping test, not enough CPUs: " << num_shards;
+    return;
+  }
+  auto run_on_cpu = [](int cpu) {
+    cpu_set_t cpus;
+    CPU_ZERO(&cpus);
+    CPU_SET(cpu, &cpus);
+    ASSERT_EQ(0, sched_setaffinity(0, sizeof(cpus), &cpus));
+    ASSERT_EQ(cpu, CpuInfo::GetCurrentCore());
+  };
+
+  hdfsFS fs = hdfsConnect("default", 0);
+  ASSERT_TRUE(fs != nullptr);
+  string fname = REMOTE_URL + "/file-handle-cache-test";
+  hdfsFile file = hdfsOpenFile(fs, fname.c_str(), O_WRONLY, 0, 0, 0);
+  ASSERT_TRUE(file != nullptr);
+  ASSERT_EQ(4, hdfsWrite(fs, file, "data", 4));
+  ASSERT_EQ(0, hdfsCloseFile(fs, file));
+  HdfsMonitor monitor;
+  ASSERT_OK(monitor.Init(1));
+
+  for (int partitions_per_file : {PARTITIONS_PER_FILE, 1}) {
+    // Each partition has room for a single handle.
+    FileHandleCache cache(NUM_PARTITIONS, NUM_PARTITIONS, partitions_per_file, 0,
+        &monitor);
+    bool cache_hit;
+    // A handle created on one CPU is found from the other CPUs.
+    {
+      FileHandleCache::Accessor accessor;
+      run_on_cpu(shard_cpus[0]);
+      ASSERT_OK(cache.GetFileHandle(fs, &fname, MTIME, false, &accessor, &cache_hit));
+      EXPECT_FALSE(cache_hit);
+    }
+    for (int cpu : shard_cpus) {
+      FileHandleCache::Accessor accessor;
+      run_on_cpu(cpu);
+      ASSERT_OK(cache.GetFileHandle(fs, &fname, MTIME, false, &accessor, &cache_hit));
+      EXPECT_TRUE(cache_hit) << cpu;
+    }
+    // Check out a handle on each CPU at the same time, which creates a new handle on
+    // all but the first of them.
+    vector<FileHandleCache::Accessor> accessors(PARTITIONS_PER_FILE);
+    for (int i = 0; i < PARTITIONS_PER_FILE; ++i) {
+      run_on_cpu(shard_cpus[i]);
+      ASSERT_OK(cache.GetFileHandle(fs, &fname, MTIME, false, &accessors[i],
+          &cache_hit));
+      EXPECT_EQ(i == 0, cache_hit) << i;
+    }
+    // Returning the handles evicts those that don't fit into their partition.
+    accessors.clear();
+    accessors.resize(PARTITIONS_PER_FILE);
+    int num_hits = 0;
+    for (int i = 0; i < PARTITIONS_PER_FILE; ++i) {
+      run_on_cpu(shard_cpus[(i + 1) % PARTITIONS_PER_FILE]);
+      ASSERT_OK(cache.GetFileHandle(fs, &fname, MTIME, false, &accessors[i],
+          &cache_hit));
+      if (cache_hit) ++num_hits;
+    }
+    EXPECT_EQ(partitions_per_file, num_hits);
+    accessors.clear();
+  }
+  ASSERT_EQ(0, sched_setaffinity(0, sizeof(initial_cpus), &initial_cpus));
+  hdfsDelete(fs, fname.c_str(), 0);
+}
+
+// Test reads and writes through io_uring: a round trip, requests that are split into
+// more operations than fit into the submission queue, short reads at the end of the
+// file and failed operations.
+TEST_F(DiskIoMgrTest, IoUringReadWrite) {
+  const int QUEUE_DEPTH = 2;
+  unique_ptr<IoUring> ring;
+  Status status = IoUring::Create(QUEUE_DEPTH, &ring);
+  if (!status.ok()) {
+    LOG(INFO) << "Skipping test, io_uring is not available: " << status.GetDetail();
+    return;
+  }
+  // Requests are split into operations of 4KB, so a request of 'LEN' bytes needs 17
+  // operations that are submitted in 9 batches.
+  auto op_size = ScopedFlagSetter<int32_t>::Make(&FLAGS_io_uring_max_op_size, 4096);
+  const int64_t LEN = 64 * 1024 + 100;
+  const char* tmp_file = "/tmp/disk_io_mgr_io_uring_test.txt";
+  int fd = open(tmp_file, O_RDWR | O_CREAT | O_TRUNC, 0644);
+  ASSERT_GE(fd, 0) << GetStrErrMsg();
+  vector<uint8_t> data(LEN);
+  for (int i = 0; i < LEN; ++i) data[i] = i * 7;
+  ASSERT_OK(ring->Write(fd, tmp_file, 0, data.data(), LEN));
+
+  vector<uint8_t> buffer(2 * LEN);
+  int64_t bytes_read = -1;
+  ASSERT_OK(ring->Read(fd, tmp_file, 0, buffer.data(), LEN, &bytes_read));
+  EXPECT_EQ(LEN, bytes_read);
+  EXPECT_EQ(0, memcmp(data.data(), buffer.data(), LEN));
+
+  // Overwrite an unaligned range in the middle and read it back.
+  const int64_t OFFSET = 1000;
+  const int64_t OVERWRITE_LEN = 20000;
+  for (int i = 0; i < OVERWRITE_LEN; ++i) data[OFFSET + i] = i * 13;
+  ASSERT_OK(ring->Write(fd, tmp_file, OFFSET, data.data() + OFFSET, OVERWRITE_LEN));
+  ASSERT_OK(ring->Read(fd, tmp_file, OFFSET - 1, buffer.data(), OVERWRITE_LEN + 2,
+      &bytes_read));
+  EXPECT_EQ(OVERWRITE_LEN + 2, bytes_read);
+  EXPECT_EQ(0, memcmp(data.data() + OFFSET - 1, buffer.data(), OVERWRITE_LEN + 2));
+
+  // A read past the end of the file returns the bytes up to the end.
+  memset(buffer.data(), 0, buffer.size());
+  ASSERT_OK(ring->Read(fd, tmp_file, OFFSET, buffer.data(), LEN, &bytes_read));
+  EXPECT_EQ(LEN - OFFSET, bytes_read);
+  EXPECT_EQ(0, memcmp(data.data() + OFFSET, buffer.data(), LEN - OFFSET));
+  ASSERT_OK(ring->Read(fd, tmp_file, LEN, buffer.data(), 4096, &bytes_read));
+  EXPECT_EQ(0, bytes_read);
+
+  // Failed operations are reported and leave the ring usable.
+  EXPECT_FALSE(ring->Read(-1, tmp_file, 0, buffer.data(), LEN, &bytes_read).ok());
+  EXPECT_FALSE(ring->Write(-1, tmp_file, 0, data.data(), LEN).ok());
+  ASSERT_OK(ring->Read(fd, tmp_file, 0, buffer.data(), LEN, &bytes_read));
+  EXPECT_EQ(LEN, bytes_read);
+  EXPECT_EQ(0, memcmp(data.data(), buffer.data(), LEN));
+
+  close(fd);
+  unlink(tmp_file);
+}
+
+// Test that weighted fair scheduling of the disk queues completes the reads of all
+// contexts and accounts them to their resource pools.
+TEST_F(DiskIoMgrTest, FairScheduling) {
+  InitRootReservation(LARGE_RESERVATION_LIMIT);
+  {
+    auto weights = ScopedFlagSetter<string>::Make(&FLAGS_disk_io_pool_weights, "a:0");
+    DiskIoMgr io_mgr(1, 1, 1, MIN_BUFFER_SIZE, MAX_BUFFER_SIZE);
+    EXPECT_FALSE(io_mgr.Init().ok());
+  }
+  auto fair = ScopedFlagSetter<bool>::Make(&FLAGS_disk_io_fair_scheduling, true);
+  auto weights = ScopedFlagSetter<string>::Make(
+      &FLAGS_disk_io_pool_weights, "root.fair-a:4, root.fair-b:1");
+  const char* tmp_file = "/tmp/disk_io_mgr_test.txt";
+  const char* data = "abcdefghijklm";
+  int len = strlen(data);
+  CreateTempFile(tmp_file, data);
+  struct stat stat_val;
+  stat(tmp_file, &stat_val);
+
+  ObjectPool tmp_pool;
+  DiskIoMgr io_mgr(1, 2, 2, MIN_BUFFER_SIZE, MAX_BUFFER_SIZE);
+  ASSERT_OK(io_mgr.Init());
+  EXPECT_EQ(4, io_mgr.GetPoolIoWeight("root.fair-a"));
+  EXPECT_EQ(1, io_mgr.GetPoolIoWeight("root.fair-b"));
+  EXPECT_EQ(1, io_mgr.GetPoolIoWeight("root.default"));
+
+  const int NUM_RANGES = 20;
+  const vector<string> pools = {"root.fair-a", "root.fair-b"};
+  vector<int64_t> requests_before;
+  vector<BufferPool::ClientHandle> clients(pools.size());
+  vector<unique_ptr<RequestContext>> readers;
+  vector<AtomicInt32> num_ranges_processed(pools.size());
+  thread_group threads;
+  for (int i = 0; i < pools.size(); ++i) {
+    requests_before.push_back(io_mgr.GetPoolIoMetrics(pools[i])->num_io_requests
+        ->GetValue());
+    RegisterBufferPoolClient(
+        LARGE_RESERVATION_LIMIT, LARGE_INITIAL_RESERVATION, &clients[i]);
+    readers.push_back(io_mgr.RegisterContext());
+    readers[i]->set_request_pool(pools[i]);
+    vector<ScanRange*> ranges;
+    for (int j = 0; j < NUM_RANGES; ++j) {
+      ranges.push_back(InitRange(&tmp_pool, tmp_file, 0, len, 0, stat_val.st_mtime));
+    }
+    ASSERT_OK(readers[i]->AddScanRanges(ranges, EnqueueLocation::TAIL));
+    threads.add_thread(new thread(ScanRangeThread, &io_mgr, readers[i].get(),
+        &clients[i], data, len, Status::OK(), 0, &num_ranges_processed[i]));
+  }
+  threads.join_all();
+
+  for (int i = 0; i < pools.size(); ++i) {
+    EXPECT_EQ(NUM_RANGES, num_ranges_processed[i].Load());
+    EXPECT_GE(io_mgr.GetPoolIoMetrics(pools[i])->num_io_requests->GetValue(),
+        requests_before[i] + NUM_RANGES);
+    io_mgr.UnregisterContext(readers[i].get());
+    EXPECT_EQ(clients[i].GetUsedReservation(), 0);
+    buffer_pool()->DeregisterClient(&clients[i]);
+  }
+  EXPECT_EQ(root_reservation_.GetChildReservations(), 0);
+}
+
+// Test the order in which a disk queue dispatches its contexts with fair scheduling:
+// contexts that always have work are dispatched in proportion to their weights, unless
+// the context at the front of the queue has waited longer than the deadline.
+TEST_F(DiskIoMgrTest, FairSchedulingDispatchOrder) {
+  auto fair = ScopedFlagSetter<bool>::Make(&FLAGS_disk_io_fair_scheduling, true);
+  auto weights = ScopedFlagSetter<string>::Make(
+      &FLAGS_disk_io_pool_weights, "root.heavy:4, root.light:1");
+  const int64_t DEADLINE_MS = 60 * 1000;
+  auto deadline =
+      ScopedFlagSetter<int64_t>::Make(&FLAGS_disk_io_queue_deadline_ms, DEADLINE_MS);
+  DiskIoMgr io_mgr(1, 1, 1, MIN_BUFFER_SIZE, MAX_BUFFER_SIZE);
+  ASSERT_OK(io_mgr.Init());
+  {
+    unique_ptr<RequestContext> heavy = io_mgr.RegisterContext();
+    unique_ptr<RequestContext> light = io_mgr.RegisterContext();
+    heavy->set_request_pool("root.heavy");
+    light->set_request_pool("root.light");
+    DiskQueue queue(0);
+    EnqueueContext(&queue, light.get());
+    EnqueueContext(&queue, heavy.get());
+    // Each context is enqueued again right after it is dispatched.
+    const int NUM_DISPATCHES = 1000;
+    int num_heavy = 0;
+    for (int i = 0; i < NUM_DISPATCHES; ++i) {
+      RequestContext* context = DequeueContext(&queue);
+      if (context == heavy.get()) ++num_heavy;
+      EnqueueContext(&queue, context);
+    }
+    EXPECT_NEAR(NUM_DISPATCHES * 4 / 5, num_heavy, 2);
+    DequeueContext(&queue);
+    DequeueContext(&queue);
+    io_mgr.UnregisterContext(heavy.get());
+    io_mgr.UnregisterContext(light.get());
+  }
+
+  // 'behind' is far ahead of 'ahead' in virtual time, so 'ahead' goes first unless
+  // 'behind' has waited past the deadline at the front of the queue.
+  for (int64_t age_ms : {int64_t(0), 2 * DEADLINE_MS}) {
+    unique_ptr<RequestContext> behind = io_mgr.RegisterContext();
+    unique_ptr<RequestContext> ahead = io_mgr.RegisterContext();
+    SetIoFinishTag(behind.get(), 0, 100);
+    DiskQueue queue(0);
+    EnqueueContext(&queue, behind.get(), age_ms);
+    EnqueueContext(&queue, ahead.get());
+    RequestContext* expected_first = age_ms > DEADLINE_MS ? behind.get() : ahead.get();
+    RequestContext* expected_second = age_ms > DEADLINE_MS ? ahead.get() : behind.get();
+    EXPECT_EQ(expected_first, DequeueContext(&queue)) << age_ms;
+    EXPECT_EQ(expected_second, DequeueContext(&queue)) << age_ms;
+    io_mgr.UnregisterContext(behind.get());
+    io_mgr.UnregisterContext(ahead.get());
+  }
+}
+
 // Issue writing operations to a remote directory.
 // Test if the temporary file can be uploaded and read correctly.
 TEST_F(DiskIoMgrTest, WriteToRemoteSuccess) {
@@ -28,6 +28,9 @@
 #include "runtime/io/error-converter.h"
 #include "runtime/io/file-writer.h"
 #include "runtime/io/handle-cache.inline.h"
+#include "runtime/io/hedged-read-manager.h"
+#include "runtime/io/io-uring.h"
+#include "runtime/mem-tracker.h"
 
 #include <boost/algorithm/string.hpp>
 #include <boost/filesystem.hpp>
@@ -35,6 +38,7 @@
 #include <boost/uuid/random_generator.hpp>
 #include <boost/uuid/uuid_io.hpp>
 
+#include "gutil/strings/numbers.h"
 #include "gutil/strings/substitute.h"
 #include "util/bit-util.h"
 #include "util/collection-metrics.h"
@@ -100,6 +104,20 @@ static const string num_io_threads_per_solid_state_disk_help_msg = Substitute("N
 DEFINE_int32(num_io_threads_per_solid_state_disk, 0,
     num_io_threads_per_solid_state_disk_help_msg.c_str());
 
+// io_uring lets a single disk thread keep several reads or writes outstanding on a
+// local disk, which is needed to reach the bandwidth of NVMe devices without a large
+// number of disk threads.
+DEFINE_bool(use_io_uring, false, "(Experimental) If true, the I/O threads of local "
+    "disks read local files and write scratch files through io_uring if the kernel "
+    "supports it. Large requests are split into operations of at most "
+    "--io_uring_max_op_size bytes that are submitted and completed together.");
+DEFINE_int32(io_uring_queue_depth, 32, "(Experimental) Number of operations that an "
+    "I/O thread can submit to its io_uring at once. Only used if --use_io_uring is "
+    "true.");
+DEFINE_int32(io_uring_max_op_size, 1024 * 1024, "(Experimental) Maximum size in bytes "
+    "of a single io_uring read or write operation. Only used if --use_io_uring is "
+    "true.");
+
 // The maximum number of remote HDFS I/O threads.  HDFS access that are expected to be
 // remote are placed on a separate remote disk queue.  This is the queue depth for that
 // queue.  If 0, then the remote queue is not used and instead ranges are round-robined
@@ -178,6 +196,16 @@ DEFINE_uint64(unused_file_handle_timeout_sec, 21600, "Maximum time, in seconds,
 DEFINE_uint64(num_file_handle_cache_partitions, 16, "Number of partitions used by the "
     "file handle cache.");
 
+// The handles of a single file are spread over several partitions so that the threads
+// reading a hot file do not all contend for the lock of the same partition.
+DEFINE_uint64(file_handle_cache_partitions_per_file, 1, "(Advanced) Number of "
+    "partitions of the file handle cache that the handles of a single file are spread "
+    "over. Threads look for a handle in the partition for their CPU first and then in "
+    "the other partitions of the file. The default of 1 keeps all handles of a file in "
+    "one partition. Larger values reduce lock contention when many threads read the "
+    "same files, see be/src/benchmarks/file-handle-cache-benchmark.cc. Capped at "
+    "--num_file_handle_cache_partitions.");
+
 // This parameter controls whether remote HDFS file handles are cached. It does not impact
 // S3, ADLS, or ABFS file handles.
 DEFINE_bool(cache_remote_file_handles, true, "Enable the file handle cache for "
@@ -191,8 +219,36 @@ DEFINE_bool(cache_s3_file_handles, true, "Enable the file handle cache for "
 DEFINE_bool(cache_abfs_file_handles, true, "Enable the file handle cache for "
     "ABFS files.");
 
+DEFINE_int64(scan_range_coalesce_max_gap_bytes, 0, "(Advanced) If greater than 0, "
+    "nearby small scan ranges of the same remote file that were issued by the same "
+    "scan are read with a single remote read if the gap between them is at most this "
+    "many bytes. The bytes in the gaps are read and discarded. 0 disables coalescing.");
+DEFINE_int32(scan_range_coalesce_max_bytes, 1024 * 1024, "(Advanced) The maximum "
+    "number of bytes read by a single coalesced read, including the gaps between the "
+    "scan ranges. Only scan ranges up to this size are coalesced. See "
+    "--scan_range_coalesce_max_gap_bytes.");
+
+DEFINE_bool(disk_io_fair_scheduling, false, "(Advanced) If true, the disk queues "
+    "schedule the I/O of different scans with weighted fair queueing instead of "
+    "round-robin, using the weights of the resource pools of the queries from "
+    "--disk_io_pool_weights.");
+DEFINE_string(disk_io_pool_weights, "", "(Advanced) Comma-separated list of "
+    "<resource pool>:<weight> pairs, e.g. 'root.etl:1,root.interactive:4'. Scans of "
+    "queries in a pool with a higher weight are scheduled proportionally more often on "
+    "the disk queues. Pools that are not listed have weight 1. Only used if "
+    "--disk_io_fair_scheduling is true.");
+DEFINE_int64(disk_io_queue_deadline_ms, 1000, "(Advanced) If "
+    "--disk_io_fair_scheduling is true, a scan that has waited in a disk queue for "
+    "longer than this many milliseconds is scheduled next regardless of its weight. "
+    "0 disables the deadline.");
+
+DECLARE_int32(fs_hedged_read_threads);
 DECLARE_int64(min_buffer_size);
 
+static const char* POOL_IO_WAIT_TIME_METRIC_KEY_TEMPLATE =
+    "impala-server.io-mgr.pool-$0.io-wait-time";
+static const char* POOL_NUM_IO_REQUESTS_METRIC_KEY_TEMPLATE =
+    "impala-server.io-mgr.pool-$0.num-io-requests";
 static const char* DEVICE_NAME_METRIC_KEY_TEMPLATE =
     "impala-server.io-mgr.queue-$0.device-name";
 static const char* READ_LATENCY_METRIC_KEY_TEMPLATE =
@@ -418,6 +474,7 @@ DiskIoMgr::DiskIoMgr() :
     file_handle_cache_(min(FLAGS_max_cached_file_handles,
         FileSystemUtil::MaxNumFileHandles()),
         FLAGS_num_file_handle_cache_partitions,
+        FLAGS_file_handle_cache_partitions_per_file,
         FLAGS_unused_file_handle_timeout_sec, &hdfs_monitor_) {
   DCHECK_LE(READ_SIZE_MIN_VALUE, FLAGS_read_size);
   int num_local_disks = DiskInfo::num_disks();
@@ -442,6 +499,7 @@ DiskIoMgr::DiskIoMgr(int num_local_disks, int threads_per_rotational_disk,
     file_handle_cache_(min(FLAGS_max_cached_file_handles,
         FileSystemUtil::MaxNumFileHandles()),
         FLAGS_num_file_handle_cache_partitions,
+        FLAGS_file_handle_cache_partitions_per_file,
         FLAGS_unused_file_handle_timeout_sec, &hdfs_monitor_) {
   if (num_local_disks == 0) num_local_disks = DiskInfo::num_disks();
   disk_queues_.resize(num_local_disks + REMOTE_NUM_DISKS);
@@ -455,12 +513,37 @@ DiskIoMgr::~DiskIoMgr() {
     if (disk_queue != nullptr) disk_queue->ShutDown();
   }
   disk_thread_group_.JoinAll();
+  // The hedged reads use the file handle cache, so finish them first.
+  if (hedged_read_manager_) hedged_read_manager_->Close();
   for (DiskQueue* disk_queue : disk_queues_) delete disk_queue;
   if (cached_read_options_ != nullptr) hadoopRzOptionsFree(cached_read_options_);
   if (remote_data_cache_) remote_data_cache_->ReleaseResources();
+  if (coalesced_read_mem_tracker_ != nullptr) {
+    if (coalesced_read_mem_tracker_->parent() != nullptr) {
+      coalesced_read_mem_tracker_->CloseAndUnregisterFromParent();
+    } else {
+      coalesced_read_mem_tracker_->Close();
+    }
+  }
 }
 
 Status DiskIoMgr::Init() {
+  if (!FLAGS_disk_io_pool_weights.empty()) {
+    vector<string> entries;
+    boost::split(entries, FLAGS_disk_io_pool_weights, boost::is_any_of(","));
+    for (string& entry : entries) {
+      boost::trim(entry);
+      if (entry.empty()) continue;
+      size_t pos = entry.rfind(':');
+      double weight;
+      if (pos == string::npos || pos == 0
+          || !safe_strtod(entry.substr(pos + 1), &weight) || weight <= 0) {
+        return Status(Substitute("Misconfigured --disk_io_pool_weights: invalid entry "
+            "'$0'", entry));
+      }
+      pool_io_weights_[entry.substr(0, pos)] = weight;
+    }
+  }
   for (int i = 0; i < disk_queues_.size(); ++i) {
     disk_queues_[i] = new DiskQueue(i);
     int num_threads_per_disk;
@@ -600,9 +683,45 @@ Status DiskIoMgr::Init() {
     remote_data_cache_.reset(new DataCache(FLAGS_data_cache));
     RETURN_IF_ERROR(remote_data_cache_->Init());
   }
+  if (FLAGS_fs_hedged_read_threads > 0) {
+    hedged_read_manager_.reset(new HedgedReadManager());
+    RETURN_IF_ERROR(hedged_read_manager_->Init());
+  }
+  ExecEnv* exec_env = ExecEnv::GetInstance();
+  coalesced_read_mem_tracker_.reset(new MemTracker(-1, "Coalesced Scan Range Reads",
+      exec_env != nullptr ? exec_env->process_mem_tracker() : nullptr));
   return Status::OK();
 }
 
+DiskIoMgr::PoolIoMetrics* DiskIoMgr::GetPoolIoMetrics(const string& pool) {
+  lock_guard<mutex> l(pool_io_metrics_lock_);
+  unique_ptr<PoolIoMetrics>& metrics = pool_io_metrics_[pool];
+  if (metrics != nullptr) return metrics.get();
+  metrics.reset(new PoolIoMetrics());
+  // Unit tests may create multiple DiskIoMgrs, so we need to avoid re-registering the
+  // same metrics.
+  if (TestInfo::is_test()) {
+    metrics->io_wait_time = ImpaladMetrics::IO_MGR_METRICS->FindMetricForTesting<
+        IntCounter>(Substitute(POOL_IO_WAIT_TIME_METRIC_KEY_TEMPLATE, pool));
+    metrics->num_io_requests = ImpaladMetrics::IO_MGR_METRICS->FindMetricForTesting<
+        IntCounter>(Substitute(POOL_NUM_IO_REQUESTS_METRIC_KEY_TEMPLATE, pool));
+  }
+  if (metrics->io_wait_time == nullptr) {
+    metrics->io_wait_time = ImpaladMetrics::IO_MGR_METRICS->AddCounter(
+        POOL_IO_WAIT_TIME_METRIC_KEY_TEMPLATE, 0, pool);
+  }
+  if (metrics->num_io_requests == nullptr) {
+    metrics->num_io_requests = ImpaladMetrics::IO_MGR_METRICS->AddCounter(
+        POOL_NUM_IO_REQUESTS_METRIC_KEY_TEMPLATE, 0, pool);
+  }
+  return metrics.get();
+}
+
+double DiskIoMgr::GetPoolIoWeight(const string& pool) const {
+  auto it = pool_io_weights_.find(pool);
+  return it == pool_io_weights_.end() ? 1 : it->second;
+}
+
 unique_ptr<RequestContext> DiskIoMgr::RegisterContext() {
   return unique_ptr<RequestContext>(new RequestContext(this, disk_queues_));
 }
@@ -691,6 +810,7 @@ RequestRange* DiskQueue::GetNextRequestRange(RequestContext** request_context) {
   // This loops returns either with work to do or when the disk IoMgr shuts down.
   while (true) {
     *request_context = nullptr;
+    int64_t wait_time_ns;
     {
       unique_lock<mutex> disk_lock(lock_);
       while (!shut_down_ && request_contexts_.empty()) {
@@ -704,25 +824,83 @@ RequestRange* DiskQueue::GetNextRequestRange(RequestContext** request_context) {
       // can't pick it up. It will be enqueued before issuing the read to HDFS
       // so this is not a big deal (i.e. multiple disk threads can read for the
       // same reader).
-      *request_context = request_contexts_.front();
-      request_contexts_.pop_front();
+      QueuedContext queued = DequeueContextLocked();
+      *request_context = queued.context;
       DCHECK(*request_context != nullptr);
+      wait_time_ns = MonotonicNanos() - queued.enqueue_time_ns;
       // Must increment refcount to keep RequestContext after dropping 'disk_lock'
       (*request_context)->IncrementDiskThreadAfterDequeue(disk_id_);
     }
     // Get the next range to process for this reader. If this context does not have a
     // range, rinse and repeat.
     RequestRange* range = (*request_context)->GetNextRequestRange(disk_id_);
-    if (range != nullptr) return range;
+    if (range != nullptr) {
+      DiskIoMgr::PoolIoMetrics* pool_metrics = (*request_context)->pool_io_metrics_;
+      if (pool_metrics != nullptr) {
+        pool_metrics->io_wait_time->Increment(wait_time_ns);
+        pool_metrics->num_io_requests->Increment(1);
+      }
+      return range;
+    }
   }
   DCHECK(shut_down_);
   return nullptr;
 }
 
+void DiskQueue::EnqueueContext(RequestContext* worker) {
+  {
+    unique_lock<mutex> disk_lock(lock_);
+    // Check that the reader is not already on the queue
+    DCHECK(find_if(request_contexts_.begin(), request_contexts_.end(),
+        [worker](const QueuedContext& queued) { return queued.context == worker; })
+        == request_contexts_.end());
+    // A context that was idle for a while starts at the current virtual time rather
+    // than at its old finish time, so that it cannot claim the disk for the time it did
+    // not use.
+    double start_tag = max(virtual_time_, worker->io_finish_tags_[disk_id_]);
+    request_contexts_.push_back(QueuedContext{worker, start_tag, MonotonicNanos()});
+  }
+  work_available_.NotifyAll();
+}
+
+DiskQueue::QueuedContext DiskQueue::DequeueContextLocked() {
+  DCHECK(!request_contexts_.empty());
+  auto it = request_contexts_.begin();
+  if (FLAGS_disk_io_fair_scheduling) {
+    // The front of the list was enqueued first, so it has waited the longest.
+    int64_t deadline_ns = FLAGS_disk_io_queue_deadline_ms * NANOS_PER_MICRO
+        * MICROS_PER_MILLI;
+    if (deadline_ns <= 0 || MonotonicNanos() - it->enqueue_time_ns < deadline_ns) {
+      it = std::min_element(request_contexts_.begin(), request_contexts_.end(),
+          [](const QueuedContext& a, const QueuedContext& b) {
+            return a.start_tag < b.start_tag;
+          });
+    }
+    // The cost of the request is not known until the range is picked, so every
+    // dispatch is charged the same amount.
+    virtual_time_ = max(virtual_time_, it->start_tag);
+    it->context->io_finish_tags_[disk_id_] = it->start_tag + 1 / it->context->io_weight_;
+  }
+  QueuedContext queued = *it;
+  request_contexts_.erase(it);
+  return queued;
+}
+
 void DiskQueue::DiskThreadLoop(DiskIoMgr* io_mgr) {
   // The thread waits until there is work or the queue is shut down. If there is work,
   // performs the read or write requested. Locks are not taken when reading from or
   // writing to disk.
+  unique_ptr<IoUring> ring;
+  if (FLAGS_use_io_uring && disk_id_ < io_mgr->num_local_disks()) {
+    Status status = IoUring::Create(FLAGS_io_uring_queue_depth, &ring);
+    if (status.ok()) {
+      IoUring::SetThreadRing(ring.get());
+    } else {
+      LOG_FIRST_N(WARNING, 1) << "Could not use io_uring for local disk I/O, falling "
+                              << "back to blocking reads and writes: "
+                              << status.GetDetail();
+    }
+  }
   while (true) {
     RequestContext* worker_context = nullptr;
     RequestRange* range = GetNextRequestRange(&worker_context);
@@ -782,8 +960,9 @@ void DiskIoMgr::Write(RequestContext* writer_context, WriteRange* write_range) {
 
   {
     ScopedHistogramTimer write_timer(queue->write_latency());
+    int oflag = O_RDWR | O_CREAT | (write_range->use_direct_io() ? O_DIRECT : 0);
     ret_status = local_file_system_->OpenForWrite(
-        write_range->file(), O_RDWR | O_CREAT, S_IRUSR | S_IWUSR, &file_handle);
+        write_range->file(), oflag, S_IRUSR | S_IWUSR, &file_handle);
     if (!ret_status.ok()) goto end;
 
     ret_status = WriteRangeHelper(file_handle, write_range);
@@ -802,18 +981,34 @@ end:
 }
 
 Status DiskIoMgr::WriteRangeHelper(FILE* file_handle, WriteRange* write_range) {
-  // Seek to the correct offset and perform the write.
-  RETURN_IF_ERROR(local_file_system_->Fseek(
-      file_handle, write_range->offset(), SEEK_SET, write_range));
-
 #ifndef NDEBUG
   if (FLAGS_stress_scratch_write_delay_ms > 0) {
     SleepForMs(FLAGS_stress_scratch_write_delay_ms);
   }
 #endif
-  RETURN_IF_ERROR(local_file_system_->Fwrite(file_handle, write_range));
+  IoUring* ring = IoUring::ThreadRing();
+  if (ring != nullptr) {
+    // The file was just opened, so nothing is buffered by 'file_handle' and the write
+    // can go directly to the file descriptor.
+    RETURN_IF_ERROR(ring->Write(fileno(file_handle), write_range->file(),
+        write_range->offset(), write_range->data(), write_range->len()));
+  } else if (write_range->use_direct_io()) {
+    // stdio would write through its own unaligned buffer, so write directly to the
+    // file descriptor.
+    DCHECK(IsDirectIoAligned(
+        write_range->data(), write_range->offset(), write_range->len()));
+    RETURN_IF_ERROR(local_file_system_->Pwrite(fileno(file_handle), write_range));
+  } else {
+    // Seek to the correct offset and perform the write.
+    RETURN_IF_ERROR(local_file_system_->Fseek(
+        file_handle, write_range->offset(), SEEK_SET, write_range));
+    RETURN_IF_ERROR(local_file_system_->Fwrite(file_handle, write_range));
+  }
 
   ImpaladMetrics::IO_MGR_BYTES_WRITTEN->Increment(write_range->len());
+  if (write_range->use_direct_io()) {
+    ImpaladMetrics::IO_MGR_DIRECT_IO_BYTES_WRITTEN->Increment(write_range->len());
+  }
   return Status::OK();
 }
 
@@ -876,17 +1071,17 @@ void DiskIoMgr::ReleaseExclusiveHdfsFileHandle(unique_ptr<ExclusiveHdfsFileHandl
 Status DiskIoMgr::GetCachedHdfsFileHandle(const hdfsFS& fs, std::string* fname,
     int64_t mtime, RequestContext* reader, FileHandleCache::Accessor* accessor) {
   bool cache_hit;
-  SCOPED_TIMER(reader->open_file_timer_);
+  SCOPED_TIMER(reader != nullptr ? reader->open_file_timer_ : nullptr);
   RETURN_IF_ERROR(
       file_handle_cache_.GetFileHandle(fs, fname, mtime, false, accessor, &cache_hit));
   if (cache_hit) {
     ImpaladMetrics::IO_MGR_CACHED_FILE_HANDLES_HIT_RATIO->Update(1L);
     ImpaladMetrics::IO_MGR_CACHED_FILE_HANDLES_HIT_COUNT->Increment(1L);
-    reader->cached_file_handles_hit_count_.Add(1L);
+    if (reader != nullptr) reader->cached_file_handles_hit_count_.Add(1L);
   } else {
     ImpaladMetrics::IO_MGR_CACHED_FILE_HANDLES_HIT_RATIO->Update(0L);
     ImpaladMetrics::IO_MGR_CACHED_FILE_HANDLES_MISS_COUNT->Increment(1L);
-    reader->cached_file_handles_miss_count_.Add(1L);
+    if (reader != nullptr) reader->cached_file_handles_miss_count_.Add(1L);
   }
   return Status::OK();
 }
@@ -922,14 +1117,14 @@ void DiskQueue::DebugString(stringstream* ss) {
   *ss << "DiskQueue id=" << disk_id_ << " ptr=" << static_cast<void*>(this) << ":" ;
   if (!request_contexts_.empty()) {
     *ss << " Readers: ";
-    for (RequestContext* req_context: request_contexts_) {
-      *ss << static_cast<void*>(req_context);
+    for (const QueuedContext& queued : request_contexts_) {
+      *ss << static_cast<void*>(queued.context);
     }
   }
 }
 
 DiskQueue::~DiskQueue() {
-  for (RequestContext* context : request_contexts_) {
-    context->UnregisterDiskQueue(disk_id_);
+  for (const QueuedContext& queued : request_contexts_) {
+    queued.context->UnregisterDiskQueue(disk_id_);
   }
 }
@@ -22,6 +22,8 @@
 #define IMPALA_RUNTIME_IO_DISK_IO_MGR_H
 
 #include <mutex>
+#include <string>
+#include <unordered_map>
 #include <vector>
 
 #include "common/atomic.h"
@@ -33,14 +35,19 @@
 #include "runtime/io/local-file-system.h"
 #include "runtime/io/request-ranges.h"
 #include "util/aligned-new.h"
+#include "util/metrics-fwd.h"
 #include "util/runtime-profile.h"
 #include "util/thread.h"
 
 namespace impala {
+
+class MemTracker;
+
 namespace io {
 
 class DataCache;
 class DiskQueue;
+class HedgedReadManager;
 
 /// Manager object that schedules IO for all queries on all disks and remote filesystems
 /// (such as S3). Each query maps to one or more RequestContext objects, each of which
@@ -364,8 +371,9 @@ class DiskIoMgr : public CacheLineAligned {
   /// CachedHdfsFileHandle accessor from the file handle cache and returns it via
   /// 'accessor'. Records the time spent opening the handle in 'reader'. On success,
   /// records statistics about whether this was a cache hit or miss in the 'reader' as
-  /// well as at the system level. In case of an error, returns status and 'accessor' is
-  /// untouched.
+  /// well as at the system level. 'reader' may be nullptr, in which case only the system
+  /// level statistics are recorded. In case of an error, returns status and 'accessor'
+  /// is untouched.
   Status GetCachedHdfsFileHandle(const hdfsFS& fs, std::string* fname, int64_t mtime,
       RequestContext* reader, FileHandleCache::Accessor* accessor) WARN_UNUSED_RESULT;
 
@@ -410,12 +418,47 @@ class DiskIoMgr : public CacheLineAligned {
   /// See "Buffer Management" in the class comment for explanation.
   static const int64_t IDEAL_MAX_SIZED_BUFFERS_PER_SCAN_RANGE = 3;
 
+  /// Alignment of the memory buffers, file offsets and lengths of reads and writes with
+  /// direct I/O (O_DIRECT). 4KB is the logical block size of all common devices.
+  static const int64_t DIRECT_IO_ALIGNMENT = 4096;
+
+  /// Returns true if a direct I/O of 'len' bytes at 'offset' in a file to or from
+  /// 'buffer' satisfies the alignment requirements of O_DIRECT.
+  static bool IsDirectIoAligned(const uint8_t* buffer, int64_t offset, int64_t len) {
+    return reinterpret_cast<uintptr_t>(buffer) % DIRECT_IO_ALIGNMENT == 0
+        && offset % DIRECT_IO_ALIGNMENT == 0 && len % DIRECT_IO_ALIGNMENT == 0;
+  }
+
   /// Validates that range is correctly initialized. Return an error status if there
   /// is something invalid about the scan range.
   Status ValidateScanRange(ScanRange* range) WARN_UNUSED_RESULT;
 
   DataCache* remote_data_cache() { return remote_data_cache_.get(); }
 
+  /// Returns the manager of hedged remote reads, or nullptr if hedged reads are
+  /// disabled.
+  HedgedReadManager* hedged_read_manager() { return hedged_read_manager_.get(); }
+
+  /// Returns the tracker of the buffers of coalesced reads (see CoalescedRead).
+  MemTracker* coalesced_read_mem_tracker() { return coalesced_read_mem_tracker_.get(); }
+
+  /// Metrics about the I/O requests of all queries of a resource pool.
+  struct PoolIoMetrics {
+    /// Total time that RequestContexts of the pool waited in the disk queues.
+    IntCounter* io_wait_time;
+
+    /// Total number of requests dispatched to the disk threads.
+    IntCounter* num_io_requests;
+  };
+
+  /// Returns the I/O metrics of resource pool 'pool', creating them if needed. The
+  /// returned object is valid for the lifetime of the DiskIoMgr.
+  PoolIoMetrics* GetPoolIoMetrics(const std::string& pool);
+
+  /// Returns the weight of the RequestContexts of resource pool 'pool' for fair I/O
+  /// scheduling, as configured by --disk_io_pool_weights. Defaults to 1.
+  double GetPoolIoWeight(const std::string& pool) const;
+
  private:
   DISALLOW_COPY_AND_ASSIGN(DiskIoMgr);
   friend class DiskIoMgrTest_Buffers_Test;
@@ -485,7 +528,8 @@ class DiskIoMgr : public CacheLineAligned {
 
   /// Helper method to write a range using the specified FILE handle. Returns Status:OK
   /// if the write succeeded, or a RUNTIME_ERROR with an appropriate message otherwise.
-  /// Does not open or close the file that is written.
+  /// Does not open or close the file that is written. If the range uses direct I/O,
+  /// 'file_handle' must have been opened with O_DIRECT.
   Status WriteRangeHelper(FILE* file_handle, WriteRange* write_range) WARN_UNUSED_RESULT;
 
   /// Helper for AllocateBuffersForRange() to compute the buffer sizes for a scan range
@@ -496,6 +540,22 @@ class DiskIoMgr : public CacheLineAligned {
   /// non-local reads and data read from remote data nodes will be stored in it. If not
   /// configured, this would be NULL.
   std::unique_ptr<DataCache> remote_data_cache_;
+
+  /// Issues hedged reads of remote files. Only set if --fs_hedged_read_threads > 0.
+  std::unique_ptr<HedgedReadManager> hedged_read_manager_;
+
+  /// Tracks the buffers of the coalesced reads of all request contexts. A child of the
+  /// process memory tracker. Created in Init().
+  std::unique_ptr<MemTracker> coalesced_read_mem_tracker_;
+
+  /// Weights of resource pools, parsed from --disk_io_pool_weights in Init().
+  std::unordered_map<std::string, double> pool_io_weights_;
+
+  /// Protects 'pool_io_metrics_'.
+  std::mutex pool_io_metrics_lock_;
+
+  /// I/O metrics by resource pool. Entries are never removed.
+  std::unordered_map<std::string, std::unique_ptr<PoolIoMetrics>> pool_io_metrics_;
 };
 }
 }
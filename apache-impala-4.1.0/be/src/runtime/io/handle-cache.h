@@ -85,6 +85,14 @@ class ExclusiveHdfsFileHandle : public HdfsFileHandle {
 /// between concurrent threads. The `capacity` is split between the partitions and is
 /// enforced independently.
 ///
+/// A file that is read by many threads at once would still make them all contend for
+/// the lock of its partition, so the handles of each file are spread over
+/// `partitions_per_file` consecutive partitions. A thread looks for an available handle
+/// in the partition that corresponds to its current CPU first and then in the other
+/// partitions of the file, and creates a new handle in the partition of its CPU only if
+/// none is available. Threads on different CPUs therefore mostly take different locks,
+/// while a handle is still shared by all threads that read the file.
+///
 /// Threads check out a file handle for exclusive access, released automatically by RAII
 /// accessor. If the file handle is not already present in the cache or all file handles
 /// for this file are checked out, the file handle is emplaced in the cache. The cache can
@@ -148,9 +156,11 @@ class FileHandleCache {
 
   /// Instantiates the cache with `capacity` split evenly across NUM_PARTITIONS
   /// partitions. If the capacity does not split evenly, then the capacity is rounded
-  /// up. The cache will age out any file handle that is unused for
-  /// `unused_handle_timeout_secs` seconds. Age out is disabled if this is set to zero.
-  FileHandleCache(size_t capacity, size_t num_partitions,
+  /// up. The handles of each file are spread over `partitions_per_file` partitions,
+  /// which is capped at `num_partitions`. The cache will age out any file handle that is
+  /// unused for `unused_handle_timeout_secs` seconds. Age out is disabled if this is set
+  /// to zero.
+  FileHandleCache(size_t capacity, size_t num_partitions, size_t partitions_per_file,
       uint64_t unused_handle_timeout_secs, HdfsMonitor* hdfs_monitor);
 
   /// Destructor is only called for backend tests
@@ -162,11 +172,12 @@ class FileHandleCache {
 
   /// Get a file handle accessor from the cache for the specified filename (fname) and
   /// last modification time (mtime). This will hash the filename to determine
-  /// which partition to use for this file handle.
+  /// which partitions to use for this file handle.
   ///
-  /// If 'require_new_handle' is false and the partition contains an available handle,
-  /// an accessor is returned and cache_hit is set to true. Otherwise, the partition will
-  /// emplace file handle, an accessor to it will be returned with cache_hit set to false.
+  /// If 'require_new_handle' is false and one of the partitions of the file contains an
+  /// available handle, an accessor is returned and cache_hit is set to true. Otherwise,
+  /// the partition of the current CPU will emplace file handle, an accessor to it will
+  /// be returned with cache_hit set to false.
   /// On failure, empty accessor will be returned. In either case, the partition may evict
   /// a file handle to make room for the new file handle.
   ///
@@ -181,6 +192,9 @@ class FileHandleCache {
 
   std::vector<FileHandleCachePartition> cache_partitions_;
 
+  /// Number of partitions that the handles of a single file are spread over.
+  const size_t partitions_per_file_;
+
   /// Maximum time before an unused file handle is aged out of the cache.
   /// Aging out is disabled if this is set to 0.
   uint64_t unused_handle_timeout_secs_;
@@ -15,10 +15,12 @@
 // specific language governing permissions and limitations
 // under the License.
 
+#include <algorithm>
 #include <tuple>
 
 #include "runtime/io/handle-cache.h"
 #include "runtime/io/hdfs-monitored-ops.h"
+#include "util/cpu-info.h"
 #include "util/hash-util.h"
 #include "util/impalad-metrics.h"
 #include "util/lru-multi-cache.inline.h"
@@ -114,8 +116,11 @@ FileHandleCache::Accessor::~Accessor() {
 }
 
 FileHandleCache::FileHandleCache(size_t capacity, size_t num_partitions,
-    uint64_t unused_handle_timeout_secs, HdfsMonitor* hdfs_monitor)
+    size_t partitions_per_file, uint64_t unused_handle_timeout_secs,
+    HdfsMonitor* hdfs_monitor)
   : cache_partitions_(num_partitions),
+    partitions_per_file_(std::max<size_t>(1, std::min(partitions_per_file,
+        num_partitions))),
     unused_handle_timeout_secs_(unused_handle_timeout_secs),
     hdfs_monitor_(hdfs_monitor) {
   DCHECK_GT(num_partitions, 0);
@@ -142,29 +147,39 @@ Status FileHandleCache::Init() {
 Status FileHandleCache::GetFileHandle(const hdfsFS& fs, std::string* fname, int64_t mtime,
     bool require_new_handle, FileHandleCache::Accessor* accessor, bool* cache_hit) {
   DCHECK_GT(mtime, 0);
-  // Hash the key and get appropriate partition
-  int index = HashUtil::Hash(fname->data(), fname->size(), 0) % cache_partitions_.size();
-  FileHandleCachePartition& p = cache_partitions_[index];
+  // Hash the key to get the first partition of the file. The partition of the current
+  // CPU is one of the 'partitions_per_file_' partitions that follow it.
+  const size_t num_partitions = cache_partitions_.size();
+  size_t first_index = HashUtil::Hash(fname->data(), fname->size(), 0) % num_partitions;
+  size_t cpu_shard = partitions_per_file_ == 1 ?
+      0 : CpuInfo::GetCurrentCore() % partitions_per_file_;
 
   auto cache_key = std::make_pair(*fname, mtime);
 
   // If this requires a new handle, skip to the creation codepath. Otherwise,
-  // find an unused entry with the same mtime
+  // find an unused entry with the same mtime, starting with the partition of this CPU.
   if (!require_new_handle) {
-    auto cache_accessor = p.cache.Get(cache_key);
-
-    if (cache_accessor.Get()) {
-      // Found a handler in cache and reserved it
-      *cache_hit = true;
-      accessor->Set(std::move(cache_accessor));
-      return Status::OK();
+    for (size_t i = 0; i < partitions_per_file_; ++i) {
+      size_t shard = (cpu_shard + i) % partitions_per_file_;
+      FileHandleCachePartition& p =
+          cache_partitions_[(first_index + shard) % num_partitions];
+      auto cache_accessor = p.cache.Get(cache_key);
+
+      if (cache_accessor.Get()) {
+        // Found a handler in cache and reserved it
+        *cache_hit = true;
+        accessor->Set(std::move(cache_accessor));
+        return Status::OK();
+      }
     }
   }
 
   // There was no entry that was free or caller asked for a new handle
   *cache_hit = false;
 
-  // Emplace a new file handle and get access
+  // Emplace a new file handle in the partition of this CPU and get access
+  FileHandleCachePartition& p =
+      cache_partitions_[(first_index + cpu_shard) % num_partitions];
   auto accessor_tmp = p.cache.EmplaceAndGet(cache_key, fs, fname, mtime);
 
   // Opening a file handle requires talking to the NameNode so it can take some time.
@@ -16,11 +16,14 @@
 // under the License.
 
 #include <algorithm>
+#include <memory>
+#include <utility>
 
 #include "gutil/strings/substitute.h"
 #include "runtime/io/data-cache.h"
 #include "runtime/io/disk-io-mgr-internal.h"
 #include "runtime/io/hdfs-file-reader.h"
+#include "runtime/io/hedged-read-manager.h"
 #include "runtime/io/request-context.h"
 #include "runtime/io/request-ranges.h"
 #include "util/debug-util.h"
@@ -30,6 +33,7 @@
 #include "util/metrics.h"
 #include "util/pretty-printer.h"
 #include "util/scope-exit-trigger.h"
+#include "util/spinlock.h"
 
 #include "common/names.h"
 
@@ -144,6 +148,52 @@ Status HdfsFileReader::ReadFromPos(DiskQueue* queue, int64_t file_offset, uint8_
       return status;
     }
 
+    // If the range is read together with nearby ranges of the same file, the bytes may
+    // already have been read by another reader.
+    bool is_coalesced_read_owner = false;
+    shared_ptr<CoalescedRead> coalesced_read;
+    if (cached_read == 0) {
+      coalesced_read = request_context->GetCoalescedRead(
+          scan_range_, file_offset, bytes_to_read, &is_coalesced_read_owner);
+    }
+    if (coalesced_read != nullptr && !is_coalesced_read_owner
+        && coalesced_read->CopyTo(file_offset, buffer, bytes_to_read)) {
+      *bytes_read = bytes_to_read;
+      if (try_data_cache) {
+        WriteDataCache(remote_data_cache, file_offset, buffer, *bytes_read, *bytes_read);
+      }
+      return status;
+    }
+
+    // Slow remote reads may be hedged by a second read of the same bytes.
+    HedgedReadManager* hedged_reads = io_mgr->hedged_read_manager();
+    if (hedged_reads != nullptr && !is_coalesced_read_owner && !expected_local_
+        && exclusive_hdfs_fh_ == nullptr && UsePread()) {
+      int64_t bytes_remaining = bytes_to_read - *bytes_read;
+      ReadStatistics stats;
+      Status hedged_status = ReadHedged(hedged_reads, queue, file_offset + *bytes_read,
+          buffer + *bytes_read, bytes_remaining, &stats);
+      int64_t hedged_bytes_read = hedged_status.ok() ? bytes_remaining : 0;
+      bool log_slow_read = LogSlowRead(req_context_read_timer.ElapsedTime(),
+          file_offset, hedged_bytes_read, *bytes_read + hedged_bytes_read,
+          bytes_to_read, hedged_status, &logged_slow_read);
+      if (hedged_status.ok()) {
+        AddHdfsStatistics(stats, log_slow_read);
+        *bytes_read = bytes_to_read;
+        if (try_data_cache) {
+          WriteDataCache(remote_data_cache, file_offset, buffer, *bytes_read,
+              bytes_remaining);
+        }
+        return status;
+      }
+    }
+
+    // Make sure that the readers waiting for the coalesced read are woken up if the
+    // read is never issued.
+    auto coalesced_read_not_issued = MakeScopeExitTrigger([&]() {
+      if (is_coalesced_read_owner) coalesced_read->Done(0);
+    });
+
     // If we get here, the next bytes are not available in data cache, so we need to get
     // file handle in order to read the rest of data from file.
     // If the reader has an exclusive file handle, use it. Otherwise, borrow
@@ -163,6 +213,15 @@ Status HdfsFileReader::ReadFromPos(DiskQueue* queue, int64_t file_offset, uint8_
     }
     req_context_read_timer.Start();
 
+    if (is_coalesced_read_owner) {
+      is_coalesced_read_owner = false;
+      // Fall back to reading the range on its own if the coalesced read fails.
+      if (ReadCoalesced(hdfs_file, queue, coalesced_read.get()).ok()
+          && coalesced_read->CopyTo(file_offset, buffer, bytes_to_read)) {
+        *bytes_read = bytes_to_read;
+      }
+    }
+
     while (*bytes_read < bytes_to_read) {
       int bytes_remaining = bytes_to_read - *bytes_read;
       DCHECK_GT(bytes_remaining, 0);
@@ -196,29 +255,9 @@ Status HdfsFileReader::ReadFromPos(DiskQueue* queue, int64_t file_offset, uint8_
             buffer + *bytes_read, bytes_remaining, &current_bytes_read);
       }
       // Log diagnostics for failed and successful reads.
-      int64_t elapsed_time = req_context_read_timer.ElapsedTime();
-      bool is_slow_read = elapsed_time
-          > FLAGS_fs_slow_read_log_threshold_ms * NANOS_PER_MICRO * MICROS_PER_MILLI;
-      bool log_slow_read = is_slow_read && (!logged_slow_read || !status.ok()
-                 || *bytes_read + current_bytes_read == bytes_to_read);
-      // Log at most two slow read errors in each invocation of this function. Always log
-      // the first read where we exceeded the threshold and the last read before exiting
-      // this loop.
-      if (log_slow_read) {
-        LOG(INFO) << "Slow FS I/O operation on " << *scan_range_->file_string() << " for "
-                  << "instance " << PrintId(scan_range_->reader_->instance_id())
-                  << " of query " << PrintId(scan_range_->reader_->query_id()) << ". "
-                  << "Last read returned "
-                  << PrettyPrinter::PrintBytes(current_bytes_read) << ". "
-                  << "This thread has read "
-                  << PrettyPrinter::PrintBytes(*bytes_read + current_bytes_read)
-                  << "/" << PrettyPrinter::PrintBytes(bytes_to_read)
-                  << " starting at offset " << file_offset << " in this I/O scheduling "
-                  << "quantum and taken "
-                  << PrettyPrinter::Print(elapsed_time, TUnit::TIME_NS) << " so far. "
-                  << "I/O status: " << (status.ok() ? "OK" : status.GetDetail());
-        logged_slow_read = true;
-      }
+      bool log_slow_read = LogSlowRead(req_context_read_timer.ElapsedTime(),
+          file_offset, current_bytes_read, *bytes_read + current_bytes_read,
+          bytes_to_read, status, &logged_slow_read);
 
       if (!status.ok()) {
         break;
@@ -263,8 +302,7 @@ Status HdfsFileReader::ReadFromPosInternal(hdfsFile hdfs_file, DiskQueue* queue,
   ScopedHistogramTimer read_timer(queue->read_latency());
   // For file handles from the cache, any of the below file operations may fail
   // due to a bad file handle.
-  if (FLAGS_use_hdfs_pread || IsS3APath(scan_range_->file_string()->c_str())
-      || IsABFSPath(scan_range_->file_string()->c_str())) {
+  if (UsePread()) {
     if (hdfsPreadFully(
           hdfs_fs_, hdfs_file, position_in_file, buffer, bytes_to_read) == -1) {
       return Status(TErrorCode::DISK_IO_ERROR, GetBackendString(),
@@ -391,28 +429,138 @@ void HdfsFileReader::Close() {
   }
 }
 
-void HdfsFileReader::GetHdfsStatistics(hdfsFile hdfs_file, bool log_stats) {
-  struct hdfsReadStatistics* stats;
-  if (IsHdfsPath(scan_range_->file())) {
-    int success = hdfsFileGetReadStatistics(hdfs_file, &stats);
-    if (success == 0) {
-      scan_range_->reader_->bytes_read_local_.Add(stats->totalLocalBytesRead);
-      scan_range_->reader_->bytes_read_short_circuit_.Add(
-          stats->totalShortCircuitBytesRead);
-      scan_range_->reader_->bytes_read_dn_cache_.Add(stats->totalZeroCopyBytesRead);
-      if (stats->totalLocalBytesRead != stats->totalBytesRead) {
-        num_remote_bytes_ += stats->totalBytesRead - stats->totalLocalBytesRead;
-      }
-      if (log_stats) {
-        LOG(INFO) << "Stats for last read by this I/O thread:"
-                  << " totalBytesRead=" << stats->totalBytesRead
-                  << " totalLocalBytesRead=" << stats->totalLocalBytesRead
-                  << " totalShortCircuitBytesRead=" << stats->totalShortCircuitBytesRead
-                  << " totalZeroCopyBytesRead=" << stats->totalZeroCopyBytesRead;
+bool HdfsFileReader::UsePread() const {
+  return FLAGS_use_hdfs_pread || IsS3APath(scan_range_->file_string()->c_str())
+      || IsABFSPath(scan_range_->file_string()->c_str());
+}
+
+Status HdfsFileReader::ReadHedged(HedgedReadManager* hedged_reads,
+    DiskQueue* disk_queue, int64_t position_in_file, uint8_t* buffer,
+    int64_t bytes_to_read, ReadStatistics* stats) {
+  ScopedHistogramTimer read_timer(disk_queue->read_latency());
+  // The reads may outlive this reader, so they only capture copies of its state and
+  // borrow their own file handles. Their HDFS read statistics are collected into
+  // 'shared_stats'.
+  DiskIoMgr* io_mgr = scan_range_->io_mgr_;
+  hdfsFS fs = hdfs_fs_;
+  string file = *scan_range_->file_string();
+  int64_t mtime = scan_range_->mtime();
+  bool is_hdfs = IsHdfsPath(scan_range_->file());
+  auto shared_stats = std::make_shared<std::pair<SpinLock, ReadStatistics>>();
+  auto read_fn = [io_mgr, fs, file, mtime, is_hdfs, shared_stats](int64_t offset,
+      uint8_t* read_buffer, int64_t len) -> Status {
+    string fname = file;
+    FileHandleCache::Accessor accessor;
+    RETURN_IF_ERROR(
+        io_mgr->GetCachedHdfsFileHandle(fs, &fname, mtime, nullptr, &accessor));
+    hdfsFile hdfs_file = accessor.Get()->file();
+    if (hdfsPreadFully(fs, hdfs_file, offset, read_buffer, len) == -1) {
+      Status status(TErrorCode::DISK_IO_ERROR, GetBackendString(),
+          GetHdfsErrorMsg("Error reading from HDFS file: ", fname));
+      // The file handle may be bad, so do not return it to the cache.
+      accessor.Destroy();
+      return status;
+    }
+    if (is_hdfs) {
+      ReadStatistics handle_stats;
+      if (CollectHdfsStatistics(hdfs_file, &handle_stats)) {
+        lock_guard<SpinLock> l(shared_stats->first);
+        ReadStatistics* total = &shared_stats->second;
+        total->total_bytes_read += handle_stats.total_bytes_read;
+        total->total_local_bytes_read += handle_stats.total_local_bytes_read;
+        total->total_short_circuit_bytes_read +=
+            handle_stats.total_short_circuit_bytes_read;
+        total->total_zero_copy_bytes_read += handle_stats.total_zero_copy_bytes_read;
       }
-      hdfsFileFreeReadStatistics(stats);
     }
-    hdfsFileClearReadStatistics(hdfs_file);
+    return Status::OK();
+  };
+  RETURN_IF_ERROR(hedged_reads->Read(read_fn, position_in_file, buffer, bytes_to_read));
+  lock_guard<SpinLock> l(shared_stats->first);
+  *stats = shared_stats->second;
+  return Status::OK();
+}
+
+bool HdfsFileReader::LogSlowRead(int64_t elapsed_time, int64_t file_offset,
+    int64_t last_bytes_read, int64_t total_bytes_read, int64_t bytes_to_read,
+    const Status& status, bool* logged_slow_read) {
+  bool is_slow_read = elapsed_time
+      > FLAGS_fs_slow_read_log_threshold_ms * NANOS_PER_MICRO * MICROS_PER_MILLI;
+  // Log at most two slow read errors in each invocation of ReadFromPos(). Always log
+  // the first read where we exceeded the threshold and the last read before exiting
+  // the read loop.
+  bool log_slow_read = is_slow_read
+      && (!*logged_slow_read || !status.ok() || total_bytes_read == bytes_to_read);
+  if (log_slow_read) {
+    LOG(INFO) << "Slow FS I/O operation on " << *scan_range_->file_string() << " for "
+              << "instance " << PrintId(scan_range_->reader_->instance_id())
+              << " of query " << PrintId(scan_range_->reader_->query_id()) << ". "
+              << "Last read returned "
+              << PrettyPrinter::PrintBytes(last_bytes_read) << ". "
+              << "This thread has read "
+              << PrettyPrinter::PrintBytes(total_bytes_read)
+              << "/" << PrettyPrinter::PrintBytes(bytes_to_read)
+              << " starting at offset " << file_offset << " in this I/O scheduling "
+              << "quantum and taken "
+              << PrettyPrinter::Print(elapsed_time, TUnit::TIME_NS) << " so far. "
+              << "I/O status: " << (status.ok() ? "OK" : status.GetDetail());
+    *logged_slow_read = true;
+  }
+  return log_slow_read;
+}
+
+Status HdfsFileReader::ReadCoalesced(hdfsFile hdfs_file, DiskQueue* disk_queue,
+    CoalescedRead* coalesced_read) {
+  int64_t bytes_read = 0;
+  Status status = Status::OK();
+  while (bytes_read < coalesced_read->len()) {
+    int current_bytes_read = -1;
+    status = ReadFromPosInternal(hdfs_file, disk_queue,
+        coalesced_read->offset() + bytes_read, coalesced_read->buffer() + bytes_read,
+        coalesced_read->len() - bytes_read, &current_bytes_read);
+    if (!status.ok() || current_bytes_read == 0) break;
+    bytes_read += current_bytes_read;
+    GetHdfsStatistics(hdfs_file, false);
+  }
+  coalesced_read->Done(status.ok() ? bytes_read : 0);
+  return status;
+}
+
+void HdfsFileReader::GetHdfsStatistics(hdfsFile hdfs_file, bool log_stats) {
+  if (IsHdfsPath(scan_range_->file())) {
+    ReadStatistics stats;
+    if (CollectHdfsStatistics(hdfs_file, &stats)) AddHdfsStatistics(stats, log_stats);
+  }
+}
+
+bool HdfsFileReader::CollectHdfsStatistics(hdfsFile hdfs_file, ReadStatistics* stats) {
+  struct hdfsReadStatistics* hdfs_stats;
+  int success = hdfsFileGetReadStatistics(hdfs_file, &hdfs_stats);
+  if (success == 0) {
+    stats->total_bytes_read += hdfs_stats->totalBytesRead;
+    stats->total_local_bytes_read += hdfs_stats->totalLocalBytesRead;
+    stats->total_short_circuit_bytes_read += hdfs_stats->totalShortCircuitBytesRead;
+    stats->total_zero_copy_bytes_read += hdfs_stats->totalZeroCopyBytesRead;
+    hdfsFileFreeReadStatistics(hdfs_stats);
+  }
+  hdfsFileClearReadStatistics(hdfs_file);
+  return success == 0;
+}
+
+void HdfsFileReader::AddHdfsStatistics(const ReadStatistics& stats, bool log_stats) {
+  scan_range_->reader_->bytes_read_local_.Add(stats.total_local_bytes_read);
+  scan_range_->reader_->bytes_read_short_circuit_.Add(
+      stats.total_short_circuit_bytes_read);
+  scan_range_->reader_->bytes_read_dn_cache_.Add(stats.total_zero_copy_bytes_read);
+  if (stats.total_local_bytes_read != stats.total_bytes_read) {
+    num_remote_bytes_ += stats.total_bytes_read - stats.total_local_bytes_read;
+  }
+  if (log_stats) {
+    LOG(INFO) << "Stats for last read by this I/O thread:"
+              << " totalBytesRead=" << stats.total_bytes_read
+              << " totalLocalBytesRead=" << stats.total_local_bytes_read
+              << " totalShortCircuitBytesRead=" << stats.total_short_circuit_bytes_read
+              << " totalZeroCopyBytesRead=" << stats.total_zero_copy_bytes_read;
   }
 }
 
@@ -23,7 +23,9 @@
 namespace impala {
 namespace io {
 
+class CoalescedRead;
 class DataCache;
+class HedgedReadManager;
 
 /// File reader class for HDFS.
 class HdfsFileReader : public FileReader {
@@ -50,6 +52,14 @@ public:
   virtual void CachedFile(uint8_t** data, int64_t* length) override;
 
 private:
+  /// HDFS read statistics of a file handle, as in hdfsReadStatistics.
+  struct ReadStatistics {
+    int64_t total_bytes_read = 0;
+    int64_t total_local_bytes_read = 0;
+    int64_t total_short_circuit_bytes_read = 0;
+    int64_t total_zero_copy_bytes_read = 0;
+  };
+
   /// Probes 'remote_data_cache' for a hit. The requested file's name and mtime
   /// are stored in 'scan_range_'. 'file_offset' is the offset into the file to read
   /// and 'bytes_to_read' is the number of bytes requested. On success, copies the
@@ -74,10 +84,43 @@ private:
   Status ReadFromPosInternal(hdfsFile hdfs_file, DiskQueue* disk_queue,
       int64_t position_in_file, uint8_t* buffer, int64_t bytes_to_read, int* bytes_read);
 
+  /// Returns true if the file is read with positional reads, i.e. hdfsPread().
+  bool UsePread() const;
+
+  /// Reads [position_in_file, position_in_file + bytes_to_read) into 'buffer' with
+  /// 'hedged_reads', using file handles from the file handle cache. Returns an error if
+  /// the bytes could not be read, in which case the caller should read them itself.
+  /// On success, 'stats' is set to the HDFS read statistics of the reads that completed
+  /// so far, which include the read whose bytes were returned.
+  Status ReadHedged(HedgedReadManager* hedged_reads, DiskQueue* disk_queue,
+      int64_t position_in_file, uint8_t* buffer, int64_t bytes_to_read,
+      ReadStatistics* stats);
+
+  /// Logs diagnostics for a read that returned 'last_bytes_read' bytes with 'status',
+  /// after which 'total_bytes_read' of the 'bytes_to_read' bytes at 'file_offset' have
+  /// been read in 'elapsed_time' ns, if that exceeds --fs_slow_read_log_threshold_ms.
+  /// Only the first slow read and the last read of an invocation of ReadFromPos() are
+  /// logged, as tracked by 'logged_slow_read'. Returns true if the read was logged.
+  bool LogSlowRead(int64_t elapsed_time, int64_t file_offset, int64_t last_bytes_read,
+      int64_t total_bytes_read, int64_t bytes_to_read, const Status& status,
+      bool* logged_slow_read);
+
+  /// Reads the extent of 'coalesced_read' from 'hdfs_file' into its buffer and calls
+  /// CoalescedRead::Done(), also if the read fails. Stops early at the end of the file.
+  Status ReadCoalesced(hdfsFile hdfs_file, DiskQueue* disk_queue,
+      CoalescedRead* coalesced_read);
+
   /// Update counters with HDFS read statistics from 'hdfs_file'. If 'log_stats' is
   /// true, the statistics are logged.
   void GetHdfsStatistics(hdfsFile hdfs_file, bool log_stats);
 
+  /// Adds the HDFS read statistics of 'hdfs_file' to 'stats' and clears them. Returns
+  /// false if the statistics could not be retrieved.
+  static bool CollectHdfsStatistics(hdfsFile hdfs_file, ReadStatistics* stats);
+
+  /// Update counters with 'stats'. If 'log_stats' is true, the statistics are logged.
+  void AddHdfsStatistics(const ReadStatistics& stats, bool log_stats);
+
   /// Return a string that contains the block indexes and list of hosts where
   /// each block resides. i.e. [0] { hdfshost1, hdfshost2, hdfshost3 }
 
@@ -0,0 +1,264 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include "runtime/io/hedged-read-manager.h"
+
+#include <string.h>
+#include <algorithm>
+#include <mutex>
+
+#include <gflags/gflags.h>
+
+#include "gutil/strings/substitute.h"
+#include "gutil/walltime.h"
+#include "runtime/exec-env.h"
+#include "runtime/mem-tracker.h"
+#include "util/condition-variable.h"
+#include "util/impalad-metrics.h"
+#include "util/metrics.h"
+#include "util/parse-util.h"
+#include "util/stopwatch.h"
+#include "util/time.h"
+
+#include "common/names.h"
+
+DEFINE_int32(fs_hedged_read_threads, 0, "(Advanced) Number of threads used to issue "
+    "hedged reads of remote files that are read with preads through the file handle "
+    "cache, e.g. files on S3 and ABFS. If a read does not complete within the hedge "
+    "delay, a second read of the same bytes is issued and the first result is used. "
+    "0 disables hedged reads. For HDFS, the hedged reads of the HDFS client can be used "
+    "instead.");
+DEFINE_double(fs_hedged_read_percentile, 95, "(Advanced) Percentile of the latencies of "
+    "recent remote reads that is used as the hedge delay. See --fs_hedged_read_threads.");
+DEFINE_int64(fs_hedged_read_min_delay_ms, 50, "(Advanced) Minimum delay in milliseconds "
+    "before a hedged read is issued. See --fs_hedged_read_threads.");
+DEFINE_string(fs_hedged_read_max_bytes_in_flight, "256MB", "(Advanced) Maximum number "
+    "of bytes of hedged reads that are outstanding at any time. No hedged reads are "
+    "issued while this limit is reached. See --fs_hedged_read_threads.");
+
+using strings::Substitute;
+
+namespace impala {
+namespace io {
+
+/// Number of latencies kept in HedgedReadManager::latencies_us_.
+static const int MAX_LATENCIES = 1024;
+
+/// Number of latencies that must be recorded before reads are hedged.
+static const int MIN_LATENCIES = 100;
+
+/// The hedge delay is recomputed after this many latencies were recorded.
+static const int DELAY_UPDATE_INTERVAL = 32;
+
+/// Indexes of the two reads of a HedgedRead.
+static const int PRIMARY = 0;
+static const int HEDGE = 1;
+
+/// The shared state of the reads of the same bytes.
+class HedgedReadManager::HedgedRead {
+ public:
+  /// The memory of each buffer must have been consumed from 'mem_tracker' before it is
+  /// allocated. It is released when the read is destroyed.
+  HedgedRead(const ReadFn& read_fn, int64_t offset, int64_t len, MemTracker* mem_tracker)
+    : read_fn(read_fn), offset(offset), len(len), mem_tracker(mem_tracker) {}
+
+  ~HedgedRead() {
+    for (const std::unique_ptr<uint8_t[]>& buffer : buffers) {
+      if (buffer != nullptr) mem_tracker->Release(len);
+    }
+  }
+
+  const ReadFn read_fn;
+  const int64_t offset;
+  const int64_t len;
+  MemTracker* const mem_tracker;
+
+  /// Buffers of the primary read and of the hedge. Each one is only written to by its
+  /// own read.
+  std::unique_ptr<uint8_t[]> buffers[2];
+
+  /// Protects the members below.
+  std::mutex lock;
+
+  /// Signalled when a read completes.
+  ConditionVariable read_done;
+
+  /// Number of reads issued and failed.
+  int num_issued = 0;
+  int num_failed = 0;
+
+  /// Index of the read that succeeded first. -1 if none did.
+  int winner = -1;
+
+  /// True once the primary read completed.
+  bool primary_done = false;
+
+  /// True if the caller returned while the primary read was still running. The bytes
+  /// of the primary are then counted in 'hedge_bytes_in_flight_' until it completes.
+  bool primary_abandoned = false;
+
+  /// Error of the last read that failed.
+  Status status;
+};
+
+HedgedReadManager::HedgedReadManager() : latencies_us_(MAX_LATENCIES) {}
+
+HedgedReadManager::~HedgedReadManager() {
+  Close();
+}
+
+Status HedgedReadManager::Init() {
+  DCHECK_GT(FLAGS_fs_hedged_read_threads, 0);
+  if (FLAGS_fs_hedged_read_percentile <= 0 || FLAGS_fs_hedged_read_percentile > 100) {
+    return Status(Substitute("Misconfigured --fs_hedged_read_percentile: $0",
+        FLAGS_fs_hedged_read_percentile));
+  }
+  bool is_percent;
+  int64_t max_bytes_in_flight = ParseUtil::ParseMemSpec(
+      FLAGS_fs_hedged_read_max_bytes_in_flight, &is_percent, 0);
+  if (max_bytes_in_flight <= 0 || is_percent) {
+    return Status(Substitute("Misconfigured --fs_hedged_read_max_bytes_in_flight: $0",
+        FLAGS_fs_hedged_read_max_bytes_in_flight));
+  }
+  max_bytes_in_flight_ = max_bytes_in_flight;
+  ExecEnv* exec_env = ExecEnv::GetInstance();
+  mem_tracker_.reset(new MemTracker(-1, "Hedged Reads",
+      exec_env != nullptr ? exec_env->process_mem_tracker() : nullptr));
+  pool_.reset(new ThreadPool<Attempt>("disk-io-mgr", "hedged-read-worker",
+      FLAGS_fs_hedged_read_threads, FLAGS_fs_hedged_read_threads,
+      [this](int thread_id, const Attempt& attempt) { RunAttempt(thread_id, attempt); }));
+  return pool_->Init();
+}
+
+void HedgedReadManager::Close() {
+  if (pool_ == nullptr) return;
+  pool_->DrainAndShutdown();
+  pool_.reset();
+  // The reads were destroyed with the pool's work items.
+  if (mem_tracker_->parent() != nullptr) {
+    mem_tracker_->CloseAndUnregisterFromParent();
+  } else {
+    mem_tracker_->Close();
+  }
+}
+
+Status HedgedReadManager::Read(
+    const ReadFn& read_fn, int64_t offset, uint8_t* buffer, int64_t len) {
+  DCHECK(pool_ != nullptr);
+  int64_t delay_us = hedge_delay_us_.Load();
+  if (delay_us < 0 || hedge_bytes_in_flight_.Load() + len > max_bytes_in_flight_
+      || !mem_tracker_->TryConsume(len)) {
+    // No hedge would be issued, so the caller waits for the read in any case and
+    // there's no need for a thread of the pool or a separate buffer.
+    MonotonicStopWatch timer;
+    timer.Start();
+    RETURN_IF_ERROR(read_fn(offset, buffer, len));
+    RecordLatency(timer.ElapsedTime() / NANOS_PER_MICRO);
+    return Status::OK();
+  }
+  shared_ptr<HedgedRead> read =
+      make_shared<HedgedRead>(read_fn, offset, len, mem_tracker_.get());
+  read->buffers[PRIMARY].reset(new uint8_t[len]);
+  read->num_issued = 1;
+  if (!pool_->Offer(Attempt{read, PRIMARY}, 0)) {
+    return Status("All hedged read threads are busy.");
+  }
+
+  unique_lock<mutex> l(read->lock);
+  timespec deadline;
+  TimeFromNowMicros(delay_us, &deadline);
+  while (read->winner == -1 && read->num_failed == 0) {
+    if (!read->read_done.WaitUntil(l, deadline)) break;
+  }
+  // Issue the hedge if the read is still outstanding and the limit allows it.
+  if (read->winner == -1 && read->num_failed == 0) {
+    if (hedge_bytes_in_flight_.Add(len) > max_bytes_in_flight_
+        || !mem_tracker_->TryConsume(len)) {
+      hedge_bytes_in_flight_.Add(-len);
+    } else {
+      read->buffers[HEDGE].reset(new uint8_t[len]);
+      if (pool_->Offer(Attempt{read, HEDGE}, 0)) {
+        ++read->num_issued;
+        ImpaladMetrics::IO_MGR_NUM_HEDGED_READS->Increment(1);
+      } else {
+        hedge_bytes_in_flight_.Add(-len);
+        read->buffers[HEDGE].reset();
+        mem_tracker_->Release(len);
+      }
+    }
+  }
+  while (read->winner == -1 && read->num_failed < read->num_issued) {
+    read->read_done.Wait(l);
+  }
+  if (read->winner == -1) return read->status;
+  if (read->winner == HEDGE) {
+    ImpaladMetrics::IO_MGR_NUM_HEDGED_READS_WON->Increment(1);
+    // The losing primary keeps its buffer until it completes.
+    if (!read->primary_done) {
+      read->primary_abandoned = true;
+      hedge_bytes_in_flight_.Add(len);
+    }
+  }
+  memcpy(buffer, read->buffers[read->winner].get(), len);
+  return Status::OK();
+}
+
+void HedgedReadManager::RunAttempt(int thread_id, const Attempt& attempt) {
+  HedgedRead* read = attempt.read.get();
+  MonotonicStopWatch timer;
+  timer.Start();
+  Status status =
+      read->read_fn(read->offset, read->buffers[attempt.index].get(), read->len);
+  if (status.ok()) RecordLatency(timer.ElapsedTime() / NANOS_PER_MICRO);
+  if (attempt.index == HEDGE) hedge_bytes_in_flight_.Add(-read->len);
+  {
+    lock_guard<mutex> l(read->lock);
+    if (attempt.index == PRIMARY) {
+      read->primary_done = true;
+      if (read->primary_abandoned) hedge_bytes_in_flight_.Add(-read->len);
+    }
+    if (!status.ok()) {
+      ++read->num_failed;
+      read->status = status;
+    } else if (read->winner == -1) {
+      read->winner = attempt.index;
+    }
+  }
+  read->read_done.NotifyAll();
+}
+
+void HedgedReadManager::RecordLatency(int64_t latency_us) {
+  vector<int64_t> latencies;
+  {
+    lock_guard<SpinLock> l(latencies_lock_);
+    latencies_us_[num_latencies_ % MAX_LATENCIES] = latency_us;
+    ++num_latencies_;
+    if (num_latencies_ < MIN_LATENCIES || num_latencies_ % DELAY_UPDATE_INTERVAL != 0) {
+      return;
+    }
+    latencies.assign(latencies_us_.begin(),
+        latencies_us_.begin() + min<int64_t>(num_latencies_, MAX_LATENCIES));
+  }
+  int64_t index = min<int64_t>(latencies.size() - 1,
+      latencies.size() * FLAGS_fs_hedged_read_percentile / 100);
+  std::nth_element(latencies.begin(), latencies.begin() + index, latencies.end());
+  int64_t min_delay_us = FLAGS_fs_hedged_read_min_delay_ms * MICROS_PER_MILLI;
+  hedge_delay_us_.Store(max(latencies[index], min_delay_us));
+}
+
+}
+}
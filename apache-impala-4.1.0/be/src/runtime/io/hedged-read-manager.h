@@ -0,0 +1,129 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#pragma once
+
+#include <functional>
+#include <memory>
+#include <vector>
+
+#include "common/atomic.h"
+#include "common/status.h"
+#include "util/spinlock.h"
+#include "util/thread-pool.h"
+
+namespace impala {
+
+class MemTracker;
+
+namespace io {
+
+/// Issues hedged reads of remote files to cut the tail latency of slow reads, which
+/// is common for object stores.
+///
+/// A read that cannot be hedged, because the hedge delay is not known yet, because a
+/// hedge would exceed the limit on the bytes in flight or because there is not enough
+/// memory for a separate buffer, is done by the calling thread directly into the
+/// caller's buffer. Otherwise, the read runs on a thread of the manager's pool. If it
+/// has not completed after the hedge delay, the same read is issued a second time on
+/// another thread and the result of whichever read succeeds first is returned. The
+/// other read keeps running in the background and its result is discarded. Since the
+/// caller may stop waiting for either read, both go into buffers owned by the manager,
+/// so the caller's buffer is never written to after Read() returns. These buffers are
+/// tracked by a child of the process MemTracker. A hedge is not issued if its buffer
+/// cannot be tracked.
+///
+/// The hedge delay is the --fs_hedged_read_percentile percentile of the latencies of
+/// recent reads, but at least --fs_hedged_read_min_delay_ms. No reads are hedged until
+/// enough latencies have been collected. The bytes of all outstanding hedges and of the
+/// primary reads that lost to their hedge and are still running are limited by
+/// --fs_hedged_read_max_bytes_in_flight.
+///
+/// Thread-safe.
+class HedgedReadManager {
+ public:
+  /// Reads 'len' bytes at 'offset' of the file into 'buffer'. Must fail if fewer bytes
+  /// can be read. Runs on a thread of the pool, possibly after Read() returned, and so
+  /// must not depend on the state of the caller.
+  typedef std::function<Status(int64_t offset, uint8_t* buffer, int64_t len)> ReadFn;
+
+  HedgedReadManager();
+  ~HedgedReadManager();
+
+  /// Starts the thread pool with --fs_hedged_read_threads threads and creates the
+  /// MemTracker for the read buffers.
+  Status Init();
+
+  /// Stops the thread pool and closes the MemTracker. Reads that are still running are
+  /// finished first.
+  void Close();
+
+  /// Reads 'len' bytes at 'offset' into 'buffer' with 'read_fn', issuing a hedged
+  /// read if needed. Returns the error of the last read that failed if no read
+  /// succeeded. Also returns an error without reading anything if the read could be
+  /// hedged but the work queue of the pool is full. In both cases, the caller should
+  /// read the bytes itself.
+  Status Read(const ReadFn& read_fn, int64_t offset, uint8_t* buffer, int64_t len);
+
+  /// Returns the current hedge delay in microseconds, or -1 if reads are not hedged
+  /// yet.
+  int64_t hedge_delay_us() const { return hedge_delay_us_.Load(); }
+
+ private:
+  class HedgedRead;
+
+  /// A read or hedge of a HedgedRead that is run by a thread of 'pool_'.
+  struct Attempt {
+    std::shared_ptr<HedgedRead> read;
+    int index;
+  };
+
+  /// Runs 'attempt' and records its latency. Called by the threads of 'pool_'.
+  void RunAttempt(int thread_id, const Attempt& attempt);
+
+  /// Adds the latency of a successful read to 'latencies_us_' and updates
+  /// 'hedge_delay_us_' from time to time.
+  void RecordLatency(int64_t latency_us);
+
+  /// Runs the reads and hedges.
+  std::unique_ptr<ThreadPool<Attempt>> pool_;
+
+  /// Tracks the buffers of the reads and hedges run by 'pool_'.
+  std::unique_ptr<MemTracker> mem_tracker_;
+
+  /// Limit on 'hedge_bytes_in_flight_', from --fs_hedged_read_max_bytes_in_flight.
+  int64_t max_bytes_in_flight_ = 0;
+
+  /// Bytes of the hedges that were issued and have not completed yet, plus the bytes of
+  /// the primary reads that are still running after their hedge won.
+  AtomicInt64 hedge_bytes_in_flight_;
+
+  /// See hedge_delay_us().
+  AtomicInt64 hedge_delay_us_{-1};
+
+  /// Protects 'latencies_us_' and 'num_latencies_'.
+  SpinLock latencies_lock_;
+
+  /// Ring buffer with the latencies of the most recent successful reads.
+  std::vector<int64_t> latencies_us_;
+
+  /// Total number of latencies recorded.
+  int64_t num_latencies_ = 0;
+};
+
+}
+}
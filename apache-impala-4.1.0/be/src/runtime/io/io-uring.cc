@@ -0,0 +1,332 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include "runtime/io/io-uring.h"
+
+#include <errno.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <algorithm>
+
+#include <gflags/gflags.h>
+
+#if defined(__linux__) && defined(__has_include)
+#if __has_include(<linux/io_uring.h>)
+#include <linux/io_uring.h>
+#define IMPALA_HAVE_IO_URING 1
+#endif
+#endif
+
+#include "gutil/strings/numbers.h"
+#include "gutil/strings/substitute.h"
+#include "runtime/io/error-converter.h"
+#include "util/error-util.h"
+#include "util/time.h"
+
+#include "common/names.h"
+
+DECLARE_int32(io_uring_max_op_size);
+
+#ifdef IMPALA_HAVE_IO_URING
+// The system call numbers are the same on all architectures, but older C library
+// headers do not define them.
+#ifndef __NR_io_uring_setup
+#define __NR_io_uring_setup 425
+#endif
+#ifndef __NR_io_uring_enter
+#define __NR_io_uring_enter 426
+#endif
+#endif
+
+namespace impala {
+namespace io {
+
+static thread_local IoUring* thread_ring = nullptr;
+
+void IoUring::SetThreadRing(IoUring* ring) {
+  thread_ring = ring;
+}
+
+IoUring* IoUring::ThreadRing() {
+  return thread_ring;
+}
+
+#ifdef IMPALA_HAVE_IO_URING
+
+Status IoUring::Create(int queue_depth, unique_ptr<IoUring>* ring) {
+  DCHECK_GT(queue_depth, 0);
+  unique_ptr<IoUring> new_ring(new IoUring());
+  RETURN_IF_ERROR(new_ring->Init(queue_depth));
+  *ring = move(new_ring);
+  return Status::OK();
+}
+
+Status IoUring::Init(int queue_depth) {
+  struct io_uring_params params;
+  memset(&params, 0, sizeof(params));
+  ring_fd_ = syscall(__NR_io_uring_setup, queue_depth, &params);
+  if (ring_fd_ < 0) {
+    return Status(Substitute("io_uring_setup() failed: $0", GetStrErrMsg()));
+  }
+  sq_entries_ = params.sq_entries;
+  sq_ring_size_ = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+  cq_ring_size_ = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+  bool single_mmap = false;
+#ifdef IORING_FEAT_SINGLE_MMAP
+  if (params.features & IORING_FEAT_SINGLE_MMAP) {
+    // The submission and completion rings share one mapping.
+    sq_ring_size_ = max(sq_ring_size_, cq_ring_size_);
+    single_mmap = true;
+  }
+#endif
+  sq_ring_ = mmap(nullptr, sq_ring_size_, PROT_READ | PROT_WRITE,
+      MAP_SHARED | MAP_POPULATE, ring_fd_, IORING_OFF_SQ_RING);
+  if (sq_ring_ == MAP_FAILED) {
+    sq_ring_ = nullptr;
+    return Status(Substitute("Could not map io_uring submission ring: $0",
+        GetStrErrMsg()));
+  }
+  if (single_mmap) {
+    cq_ring_ = sq_ring_;
+  } else {
+    cq_ring_ = mmap(nullptr, cq_ring_size_, PROT_READ | PROT_WRITE,
+        MAP_SHARED | MAP_POPULATE, ring_fd_, IORING_OFF_CQ_RING);
+    if (cq_ring_ == MAP_FAILED) {
+      cq_ring_ = nullptr;
+      return Status(Substitute("Could not map io_uring completion ring: $0",
+          GetStrErrMsg()));
+    }
+  }
+  sqes_size_ = params.sq_entries * sizeof(struct io_uring_sqe);
+  sqes_ = mmap(nullptr, sqes_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+      ring_fd_, IORING_OFF_SQES);
+  if (sqes_ == MAP_FAILED) {
+    sqes_ = nullptr;
+    return Status(Substitute("Could not map io_uring submission entries: $0",
+        GetStrErrMsg()));
+  }
+
+  uint8_t* sq = reinterpret_cast<uint8_t*>(sq_ring_);
+  sq_head_ = reinterpret_cast<unsigned*>(sq + params.sq_off.head);
+  sq_tail_ = reinterpret_cast<unsigned*>(sq + params.sq_off.tail);
+  sq_ring_mask_ = reinterpret_cast<unsigned*>(sq + params.sq_off.ring_mask);
+  sq_array_ = reinterpret_cast<unsigned*>(sq + params.sq_off.array);
+  uint8_t* cq = reinterpret_cast<uint8_t*>(cq_ring_);
+  cq_head_ = reinterpret_cast<unsigned*>(cq + params.cq_off.head);
+  cq_tail_ = reinterpret_cast<unsigned*>(cq + params.cq_off.tail);
+  cq_ring_mask_ = reinterpret_cast<unsigned*>(cq + params.cq_off.ring_mask);
+  cqes_ = cq + params.cq_off.cqes;
+  return Status::OK();
+}
+
+IoUring::~IoUring() {
+  if (sqes_ != nullptr) munmap(sqes_, sqes_size_);
+  if (cq_ring_ != nullptr && cq_ring_ != sq_ring_) munmap(cq_ring_, cq_ring_size_);
+  if (sq_ring_ != nullptr) munmap(sq_ring_, sq_ring_size_);
+  if (ring_fd_ >= 0) close(ring_fd_);
+}
+
+Status IoUring::SubmitAndWait(
+    int opcode, int fd, int64_t offset, uint8_t* buffer, int64_t len) {
+  // Keep the operations aligned to 4KB so that they can be used with O_DIRECT files.
+  const int64_t max_op_size = max(FLAGS_io_uring_max_op_size / 4096 * 4096, 4096);
+  ops_.clear();
+  for (int64_t pos = 0; pos < len; pos += max_op_size) {
+    Op op;
+    op.iov.iov_base = buffer + pos;
+    op.iov.iov_len = min(max_op_size, len - pos);
+    op.offset = offset + pos;
+    op.result = 0;
+    ops_.push_back(op);
+  }
+
+  // Submit the operations in batches that fit into the submission queue and wait for
+  // each batch to complete.
+  for (int batch_start = 0; batch_start < ops_.size(); batch_start += sq_entries_) {
+    const int batch_end = min<int>(ops_.size(), batch_start + sq_entries_);
+    const unsigned mask = *sq_ring_mask_;
+    unsigned tail = *sq_tail_;
+    for (int i = batch_start; i < batch_end; ++i) {
+      unsigned index = tail & mask;
+      struct io_uring_sqe* sqe = reinterpret_cast<struct io_uring_sqe*>(sqes_) + index;
+      memset(sqe, 0, sizeof(*sqe));
+      sqe->opcode = opcode;
+      sqe->fd = fd;
+      sqe->off = ops_[i].offset;
+      sqe->addr = reinterpret_cast<uint64_t>(&ops_[i].iov);
+      sqe->len = 1;
+      sqe->user_data = i;
+      sq_array_[index] = index;
+      ++tail;
+    }
+    // Publish the entries before the kernel reads the new tail.
+    __atomic_store_n(sq_tail_, tail, __ATOMIC_RELEASE);
+
+    int to_submit = batch_end - batch_start;
+    int to_complete = to_submit;
+    while (to_complete > 0) {
+      int ret = syscall(__NR_io_uring_enter, ring_fd_, to_submit, to_complete,
+          IORING_ENTER_GETEVENTS, nullptr, 0);
+      if (ret < 0) {
+        if (errno == EINTR || errno == EAGAIN) continue;
+        Status status(Substitute("io_uring_enter() failed: $0", GetStrErrMsg()));
+        DrainAfterFailure(to_complete);
+        return status;
+      }
+      to_submit -= min(ret, to_submit);
+      to_complete -= ReapCompletions();
+    }
+  }
+  return Status::OK();
+}
+
+int IoUring::ReapCompletions() {
+  int num_reaped = 0;
+  unsigned head = *cq_head_;
+  const unsigned cq_mask = *cq_ring_mask_;
+  while (head != __atomic_load_n(cq_tail_, __ATOMIC_ACQUIRE)) {
+    struct io_uring_cqe* cqe =
+        reinterpret_cast<struct io_uring_cqe*>(cqes_) + (head & cq_mask);
+    DCHECK_LT(cqe->user_data, ops_.size());
+    ops_[cqe->user_data].result = cqe->res;
+    ++head;
+    ++num_reaped;
+  }
+  __atomic_store_n(cq_head_, head, __ATOMIC_RELEASE);
+  return num_reaped;
+}
+
+void IoUring::DrainAfterFailure(int to_complete) {
+  // Take back the entries that the kernel has not consumed yet, so that they are not
+  // submitted by the next request. Only this thread submits to the ring, so the kernel
+  // does not consume entries outside of io_uring_enter().
+  const unsigned sq_head = __atomic_load_n(sq_head_, __ATOMIC_ACQUIRE);
+  const int num_unsubmitted = *sq_tail_ - sq_head;
+  DCHECK_LE(num_unsubmitted, to_complete);
+  to_complete -= num_unsubmitted;
+  __atomic_store_n(sq_tail_, sq_head, __ATOMIC_RELEASE);
+
+  // The kernel may still transfer data to or from the caller's buffer for the entries
+  // that were submitted, so wait for them before returning.
+  while (to_complete > 0) {
+    int ret = syscall(__NR_io_uring_enter, ring_fd_, 0, to_complete,
+        IORING_ENTER_GETEVENTS, nullptr, 0);
+    if (ret < 0 && errno != EINTR && errno != EAGAIN) {
+      // Completions are posted to the ring without io_uring_enter(), so poll for them.
+      LOG_EVERY_N(WARNING, 1000) << "Waiting for " << to_complete << " io_uring "
+                                 << "operations failed: " << GetStrErrMsg();
+      SleepForMs(1);
+    }
+    to_complete -= ReapCompletions();
+  }
+}
+
+Status IoUring::Read(int fd, const char* file, int64_t offset, uint8_t* buffer,
+    int64_t len, int64_t* bytes_read) {
+  *bytes_read = 0;
+  RETURN_IF_ERROR(SubmitAndWait(IORING_OP_READV, fd, offset, buffer, len));
+  bool short_read = false;
+  for (const Op& op : ops_) {
+    if (op.result < 0) {
+      return ErrorConverter::GetErrorStatusFromErrno("io_uring read", file,
+          -op.result, {{"offset", SimpleItoa(op.offset)}});
+    }
+    *bytes_read += op.result;
+    if (op.result < static_cast<int64_t>(op.iov.iov_len)) {
+      short_read = true;
+      break;
+    }
+  }
+  if (!short_read) return Status::OK();
+  // A short read is usually the end of the file, but could also be interrupted. Read
+  // the rest with pread() until the end of the file to return contiguous data.
+  while (*bytes_read < len) {
+    int64_t ret = pread(fd, buffer + *bytes_read, len - *bytes_read,
+        offset + *bytes_read);
+    if (ret < 0) {
+      if (errno == EINTR) continue;
+      return ErrorConverter::GetErrorStatusFromErrno("pread()", file, errno,
+          {{"offset", SimpleItoa(offset + *bytes_read)}});
+    }
+    if (ret == 0) break;
+    *bytes_read += ret;
+  }
+  return Status::OK();
+}
+
+Status IoUring::Write(int fd, const char* file, int64_t offset, const uint8_t* buffer,
+    int64_t len) {
+  RETURN_IF_ERROR(
+      SubmitAndWait(IORING_OP_WRITEV, fd, offset, const_cast<uint8_t*>(buffer), len));
+  for (const Op& op : ops_) {
+    if (op.result < 0) {
+      return ErrorConverter::GetErrorStatusFromErrno("io_uring write", file,
+          -op.result, {{"offset", SimpleItoa(op.offset)}});
+    }
+    // Complete short writes with pwrite().
+    int64_t written = op.result;
+    const uint8_t* data = reinterpret_cast<const uint8_t*>(op.iov.iov_base);
+    while (written < static_cast<int64_t>(op.iov.iov_len)) {
+      int64_t ret = pwrite(fd, data + written, op.iov.iov_len - written,
+          op.offset + written);
+      if (ret < 0) {
+        if (errno == EINTR) continue;
+        return ErrorConverter::GetErrorStatusFromErrno("pwrite()", file, errno,
+            {{"offset", SimpleItoa(op.offset + written)}});
+      }
+      written += ret;
+    }
+  }
+  return Status::OK();
+}
+
+#else
+
+Status IoUring::Create(int queue_depth, unique_ptr<IoUring>* ring) {
+  return Status("io_uring is not supported by this build.");
+}
+
+Status IoUring::Init(int queue_depth) {
+  return Status("io_uring is not supported by this build.");
+}
+
+IoUring::~IoUring() {}
+
+Status IoUring::SubmitAndWait(
+    int opcode, int fd, int64_t offset, uint8_t* buffer, int64_t len) {
+  DCHECK(false);
+  return Status("io_uring is not supported by this build.");
+}
+
+Status IoUring::Read(int fd, const char* file, int64_t offset, uint8_t* buffer,
+    int64_t len, int64_t* bytes_read) {
+  DCHECK(false);
+  return Status("io_uring is not supported by this build.");
+}
+
+Status IoUring::Write(int fd, const char* file, int64_t offset, const uint8_t* buffer,
+    int64_t len) {
+  DCHECK(false);
+  return Status("io_uring is not supported by this build.");
+}
+
+#endif
+
+}
+}
@@ -0,0 +1,129 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#pragma once
+
+#include <memory>
+#include <vector>
+
+#include <sys/uio.h>
+
+#include "common/status.h"
+
+namespace impala {
+namespace io {
+
+/// Minimal wrapper around a Linux io_uring submission/completion ring, implemented on
+/// top of the raw system calls since liburing is not part of the toolchain.
+///
+/// A ring is owned by a single disk thread (see SetThreadRing()) and is used to split
+/// one large read or write into several operations of at most --io_uring_max_op_size
+/// bytes that are submitted with a single system call and completed together. This
+/// keeps up to --io_uring_queue_depth requests outstanding on the device per disk
+/// thread, instead of one request per thread with pread()/write().
+///
+/// The ring is only available if Impala was built against kernel headers that provide
+/// <linux/io_uring.h> and the running kernel supports io_uring (Linux 5.1 or later).
+/// Otherwise Create() fails and callers use the blocking system calls.
+///
+/// Not thread-safe.
+class IoUring {
+ public:
+  ~IoUring();
+
+  /// Creates a ring with room for 'queue_depth' outstanding operations. Returns an error
+  /// if io_uring is not supported by the build or the kernel.
+  static Status Create(int queue_depth, std::unique_ptr<IoUring>* ring);
+
+  /// Reads up to 'len' bytes at 'offset' of 'fd' into 'buffer'. Sets '*bytes_read' to
+  /// the number of bytes read, which is only less than 'len' if the end of the file was
+  /// reached. 'file' is only used for error messages.
+  Status Read(int fd, const char* file, int64_t offset, uint8_t* buffer, int64_t len,
+      int64_t* bytes_read);
+
+  /// Writes 'len' bytes from 'buffer' at 'offset' of 'fd'. 'file' is only used for
+  /// error messages.
+  Status Write(int fd, const char* file, int64_t offset, const uint8_t* buffer,
+      int64_t len);
+
+  /// Sets the ring that the calling thread uses for local disk I/O. The thread keeps
+  /// ownership of 'ring', which must outlive all calls to ThreadRing().
+  static void SetThreadRing(IoUring* ring);
+
+  /// Returns the ring of the calling thread or nullptr if the thread does not use
+  /// io_uring.
+  static IoUring* ThreadRing();
+
+ private:
+  IoUring() {}
+
+  /// Read or write of a part of a buffer.
+  struct Op {
+    struct iovec iov;
+    int64_t offset;
+    /// Result of the operation: bytes transferred or negative errno.
+    int64_t result;
+  };
+
+  /// Maps the rings of 'ring_fd_' into memory. Called from Create().
+  Status Init(int queue_depth);
+
+  /// Splits 'len' bytes at 'offset' and 'buffer' into 'ops_', submits them with opcode
+  /// 'opcode' and waits for all of them to complete. Returns an error if the ring
+  /// itself fails. Failures of individual operations are returned in 'ops_'. No
+  /// operation is in flight when this returns, also if it fails.
+  Status SubmitAndWait(int opcode, int fd, int64_t offset, uint8_t* buffer,
+      int64_t len);
+
+  /// Moves the available completions into 'ops_'. Returns the number of completions.
+  int ReapCompletions();
+
+  /// Called if io_uring_enter() failed while 'to_complete' operations of the current
+  /// batch are not complete. Removes the operations that were not submitted from the
+  /// submission queue and waits for the submitted ones to complete.
+  void DrainAfterFailure(int to_complete);
+
+  /// File descriptor of the ring. -1 if not set up.
+  int ring_fd_ = -1;
+
+  /// Number of entries of the submission queue.
+  unsigned sq_entries_ = 0;
+
+  /// Memory mapped rings and submission queue entries, and their sizes.
+  void* sq_ring_ = nullptr;
+  size_t sq_ring_size_ = 0;
+  void* cq_ring_ = nullptr;
+  size_t cq_ring_size_ = 0;
+  void* sqes_ = nullptr;
+  size_t sqes_size_ = 0;
+
+  /// Pointers into the mapped rings.
+  unsigned* sq_head_ = nullptr;
+  unsigned* sq_tail_ = nullptr;
+  unsigned* sq_ring_mask_ = nullptr;
+  unsigned* sq_array_ = nullptr;
+  unsigned* cq_head_ = nullptr;
+  unsigned* cq_tail_ = nullptr;
+  unsigned* cq_ring_mask_ = nullptr;
+  void* cqes_ = nullptr;
+
+  /// Operations of the current request. Reused to avoid allocations.
+  std::vector<Op> ops_;
+};
+
+}
+}
@@ -16,9 +16,12 @@
 // under the License.
 
 #include <algorithm>
+#include <fcntl.h>
 #include <stdio.h>
+#include <unistd.h>
 
 #include "runtime/io/disk-io-mgr-internal.h"
+#include "runtime/io/io-uring.h"
 #include "runtime/io/local-file-reader.h"
 #include "runtime/io/request-ranges.h"
 #include "util/histogram-metric.h"
@@ -41,7 +44,15 @@ Status LocalFileReader::Open(bool use_file_handle_cache) {
   if (file_ != nullptr)
     return Status::OK();
 
-  file_ = fopen(scan_range_->file(), "r");
+  if (scan_range_->use_direct_io()) {
+    int fd = open(scan_range_->file(), O_RDONLY | O_DIRECT);
+    if (fd >= 0) {
+      file_ = fdopen(fd, "r");
+      if (file_ == nullptr) close(fd);
+    }
+  } else {
+    file_ = fopen(scan_range_->file(), "r");
+  }
   if (file_ == nullptr) {
     return Status(TErrorCode::DISK_IO_ERROR, GetBackendString(),
         Substitute("Could not open file: $0: $1", *scan_range_->file_string(),
@@ -68,6 +79,47 @@ Status LocalFileReader::ReadFromPos(DiskQueue* queue, int64_t file_offset,
   *bytes_read = 0;
 
   DCHECK(file_ != nullptr);
+  IoUring* ring = IoUring::ThreadRing();
+  if (ring != nullptr) {
+    // Read directly from the file descriptor. 'file_' is never read through stdio in
+    // this case, so it does not buffer any data.
+    {
+      ScopedHistogramTimer read_timer(queue->read_latency());
+      RETURN_IF_ERROR(ring->Read(fileno(file_), scan_range_->file(), file_offset,
+          buffer, bytes_to_read, bytes_read));
+    }
+    queue->read_size()->Update(*bytes_read);
+    if (scan_range_->use_direct_io()) {
+      ImpaladMetrics::IO_MGR_DIRECT_IO_BYTES_READ->Increment(*bytes_read);
+    }
+    *eof = *bytes_read < bytes_to_read;
+    return Status::OK();
+  }
+  if (scan_range_->use_direct_io()) {
+    // stdio would read through its own unaligned buffer, so read directly from the file
+    // descriptor.
+    DCHECK(DiskIoMgr::IsDirectIoAligned(buffer, file_offset, bytes_to_read));
+    {
+      ScopedHistogramTimer read_timer(queue->read_latency());
+      while (*bytes_read < bytes_to_read) {
+        int64_t ret = pread(fileno(file_), buffer + *bytes_read,
+            bytes_to_read - *bytes_read, file_offset + *bytes_read);
+        if (ret < 0) {
+          if (errno == EINTR) continue;
+          return Status(TErrorCode::DISK_IO_ERROR, GetBackendString(),
+              Substitute("Error reading from $0 at byte offset: $1: $2",
+                  *scan_range_->file_string(), file_offset + *bytes_read,
+                  GetStrErrMsg()));
+        }
+        if (ret == 0) break;
+        *bytes_read += ret;
+      }
+    }
+    queue->read_size()->Update(*bytes_read);
+    ImpaladMetrics::IO_MGR_DIRECT_IO_BYTES_READ->Increment(*bytes_read);
+    *eof = *bytes_read < bytes_to_read;
+    return Status::OK();
+  }
   if (fseek(file_, file_offset, SEEK_SET) == -1) {
     fclose(file_);
     file_ = nullptr;
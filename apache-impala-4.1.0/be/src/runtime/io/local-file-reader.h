@@ -23,7 +23,8 @@ namespace impala {
 namespace io {
 
 /// File reader class for the local file system.
-/// It uses the standard C APIs from stdio.h
+/// It uses the standard C APIs from stdio.h, or the io_uring of the calling disk
+/// thread if there is one (see --use_io_uring).
 class LocalFileReader : public FileReader {
  public:
   LocalFileReader(ScanRange* scan_range) : FileReader(scan_range) {}
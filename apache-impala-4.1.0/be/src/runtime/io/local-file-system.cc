@@ -130,5 +130,22 @@ Status LocalFileSystem::Write(int file_desc, const WriteRange* range) {
   }
   return Status::OK();
 }
+
+Status LocalFileSystem::Pwrite(int file_desc, const WriteRange* range) {
+  DCHECK(range != nullptr);
+  int64_t written = 0;
+  while (written < range->len()) {
+    int64_t ret = pwrite(file_desc, range->data() + written, range->len() - written,
+        range->offset() + written);
+    if (ret < 0) {
+      if (errno == EINTR) continue;
+      return ErrorConverter::GetErrorStatusFromErrno("pwrite()", range->file(), errno,
+          {{"range_length", SimpleItoa(range->len())},
+           {"offset", SimpleItoa(range->offset() + written)}});
+    }
+    written += ret;
+  }
+  return Status::OK();
+}
 }
 }
@@ -46,6 +46,10 @@ public:
  // Wrapper function to use write() to write the bytes.
  Status Write(int file_desc, const WriteRange* range);
 
+ // Wrapper function to use pwrite() to write the bytes at the offset of 'range'.
+ // Retries short writes.
+ Status Pwrite(int file_desc, const WriteRange* range);
+
 protected:
   // Wrapper functions around open(), fdopen(), fseek(), fwrite() and fclose().
   // Introduced so that fault injection can be implemented through inheritance.
@@ -74,8 +74,9 @@ Status LocalFileWriter::WriteOne(WriteRange* write_range) {
 
   {
     ScopedHistogramTimer write_timer(queue->write_latency());
+    int oflag = O_RDWR | O_CREAT | (write_range->use_direct_io() ? O_DIRECT : 0);
     ret_status = io_mgr_->local_file_system_->OpenForWrite(
-        write_range->file(), O_RDWR | O_CREAT, S_IRUSR | S_IWUSR, &file_handle);
+        write_range->file(), oflag, S_IRUSR | S_IWUSR, &file_handle);
     if (!ret_status.ok()) goto end;
 
     ret_status = io_mgr_->WriteRangeHelper(file_handle, write_range);
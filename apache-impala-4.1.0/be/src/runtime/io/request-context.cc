@@ -15,9 +15,13 @@
 // specific language governing permissions and limitations
 // under the License.
 
+#include <cstring>
+
 #include "runtime/io/disk-io-mgr-internal.h"
 
 #include "runtime/exec-env.h"
+#include "runtime/mem-tracker.h"
+#include "util/impalad-metrics.h"
 
 #include "common/names.h"
 #include "common/thread-debug-info.h"
@@ -25,6 +29,9 @@
 using namespace impala;
 using namespace impala::io;
 
+DECLARE_int64(scan_range_coalesce_max_gap_bytes);
+DECLARE_int32(scan_range_coalesce_max_bytes);
+
 // Cancelled status with an error message to distinguish from user-initiated cancellation.
 static const Status& CONTEXT_CANCELLED =
     Status::CancelledInternal("IoMgr RequestContext");
@@ -299,6 +306,11 @@ void RequestContext::Cancel() {
       range->CancelInternal(CONTEXT_CANCELLED, false);
     }
     active_scan_ranges_.clear();
+    {
+      lock_guard<mutex> coalesce_lock(coalesce_lock_);
+      coalescable_ranges_.clear();
+      coalesced_reads_.clear();
+    }
     for (PerDiskState& disk_state : disk_states_) {
       RequestRange* range;
       while ((range = disk_state.in_flight_ranges()->Dequeue()) != nullptr) {
@@ -582,6 +594,10 @@ void RequestContext::AddActiveScanRangeLocked(
   DCHECK(lock.mutex() == &lock_ && lock.owns_lock());
   DCHECK(state_ == Active);
   active_scan_ranges_.insert(range);
+  if (range->CanCoalesce()) {
+    lock_guard<mutex> coalesce_lock(coalesce_lock_);
+    coalescable_ranges_[*range->file_string()].emplace(range->offset(), range);
+  }
 }
 
 void RequestContext::RemoveActiveScanRange(ScanRange* range) {
@@ -593,6 +609,115 @@ void RequestContext::RemoveActiveScanRangeLocked(
     const unique_lock<mutex>& lock, ScanRange* range) {
   DCHECK(lock.mutex() == &lock_ && lock.owns_lock());
   active_scan_ranges_.erase(range);
+  lock_guard<mutex> coalesce_lock(coalesce_lock_);
+  UnregisterCoalescableRange(range);
+  coalesced_reads_.erase(range);
+}
+
+void RequestContext::UnregisterCoalescableRange(ScanRange* range) {
+  auto file_it = coalescable_ranges_.find(*range->file_string());
+  if (file_it == coalescable_ranges_.end()) return;
+  auto range_it = file_it->second.find(range->offset());
+  if (range_it == file_it->second.end() || range_it->second != range) return;
+  file_it->second.erase(range_it);
+  if (file_it->second.empty()) coalescable_ranges_.erase(file_it);
+}
+
+shared_ptr<CoalescedRead> RequestContext::GetCoalescedRead(
+    ScanRange* range, int64_t file_offset, int64_t len, bool* is_owner) {
+  *is_owner = false;
+  lock_guard<mutex> coalesce_lock(coalesce_lock_);
+  auto read_it = coalesced_reads_.find(range);
+  if (read_it != coalesced_reads_.end()) {
+    const shared_ptr<CoalescedRead>& read = read_it->second;
+    if (file_offset >= read->offset()
+        && file_offset + len <= read->offset() + read->len()) {
+      return read;
+    }
+    return nullptr;
+  }
+
+  auto file_it = coalescable_ranges_.find(*range->file_string());
+  if (file_it == coalescable_ranges_.end()) return nullptr;
+  map<int64_t, ScanRange*>& ranges = file_it->second;
+  auto range_it = ranges.find(range->offset());
+  if (range_it == ranges.end() || range_it->second != range
+      || file_offset != range->offset()) {
+    UnregisterCoalescableRange(range);
+    return nullptr;
+  }
+
+  // Grow the extent of the read around 'range' as long as the next range is close
+  // enough and the read does not get too large.
+  const int64_t max_gap = FLAGS_scan_range_coalesce_max_gap_bytes;
+  const int64_t max_bytes = FLAGS_scan_range_coalesce_max_bytes;
+  int64_t begin = range->offset();
+  int64_t end = range->offset() + range->len();
+  auto first = range_it;
+  auto last = std::next(range_it);
+  while (last != ranges.end() && last->first - end <= max_gap) {
+    int64_t new_end = max(end, last->first + last->second->len());
+    if (new_end - begin > max_bytes) break;
+    end = new_end;
+    ++last;
+  }
+  while (first != ranges.begin()) {
+    auto prev_it = std::prev(first);
+    int64_t prev_end = prev_it->first + prev_it->second->len();
+    if (begin - prev_end > max_gap || end - prev_it->first > max_bytes) break;
+    begin = prev_it->first;
+    first = prev_it;
+  }
+  if (std::next(first) == last) {
+    // There are no ranges nearby.
+    UnregisterCoalescableRange(range);
+    return nullptr;
+  }
+
+  MemTracker* mem_tracker = parent_->coalesced_read_mem_tracker();
+  if (!mem_tracker->TryConsume(end - begin)) {
+    UnregisterCoalescableRange(range);
+    return nullptr;
+  }
+  auto read = make_shared<CoalescedRead>(begin, end - begin, mem_tracker);
+  int num_ranges = 0;
+  for (auto it = first; it != last; ++it) {
+    if (it->second != range) coalesced_reads_.emplace(it->second, read);
+    ++num_ranges;
+  }
+  ranges.erase(first, last);
+  if (ranges.empty()) coalescable_ranges_.erase(file_it);
+  ImpaladMetrics::IO_MGR_NUM_COALESCED_READS->Increment(1);
+  ImpaladMetrics::IO_MGR_NUM_COALESCED_SCAN_RANGES->Increment(num_ranges);
+  *is_owner = true;
+  return read;
+}
+
+CoalescedRead::~CoalescedRead() {
+  mem_tracker_->Release(len_);
+}
+
+void CoalescedRead::Done(int64_t bytes_read) {
+  DCHECK_LE(bytes_read, len_);
+  {
+    lock_guard<mutex> l(lock_);
+    DCHECK(!done_);
+    done_ = true;
+    bytes_read_ = bytes_read;
+  }
+  done_cv_.NotifyAll();
+}
+
+bool CoalescedRead::CopyTo(int64_t file_offset, uint8_t* buffer, int64_t len) {
+  DCHECK_GE(file_offset, offset_);
+  {
+    unique_lock<mutex> l(lock_);
+    while (!done_) done_cv_.Wait(l);
+  }
+  // 'buffer_' is not modified after the read is done.
+  if (file_offset + len > offset_ + bytes_read_) return false;
+  memcpy(buffer, buffer_.get() + file_offset - offset_, len);
+  return true;
 }
 
 // This function gets the next RequestRange to work on for this RequestContext and disk
@@ -676,7 +801,8 @@ RequestRange* RequestContext::GetNextRequestRange(int disk_id) {
 
 RequestContext::RequestContext(
     DiskIoMgr* parent, const std::vector<DiskQueue*>& disk_queues)
-  : parent_(parent), disk_states_(disk_queues.size()) {
+  : parent_(parent), disk_states_(disk_queues.size()),
+    io_finish_tags_(disk_queues.size(), 0) {
   // PerDiskState is not movable, so we need to initialize the vector in this awkward way.
   for (int i = 0; i < disk_queues.size(); ++i) {
     disk_states_[i].set_disk_queue(disk_queues[i]);
@@ -688,6 +814,11 @@ RequestContext::RequestContext(
   }
 }
 
+void RequestContext::set_request_pool(const string& pool) {
+  io_weight_ = parent_->GetPoolIoWeight(pool);
+  pool_io_metrics_ = parent_->GetPoolIoMetrics(pool);
+}
+
 RequestContext::~RequestContext() {
   DCHECK_EQ(state_, Inactive) << "Must be unregistered. " << DebugString();
 }
@@ -18,6 +18,12 @@
 #ifndef IMPALA_RUNTIME_IO_REQUEST_CONTEXT_H
 #define IMPALA_RUNTIME_IO_REQUEST_CONTEXT_H
 
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
 #include <boost/unordered_set.hpp>
 
 #include "runtime/io/disk-io-mgr.h"
@@ -25,6 +31,8 @@
 
 namespace impala {
 
+class MemTracker;
+
 /// Location at which a new ScanRange would be enqueued.
 enum class EnqueueLocation { HEAD, TAIL };
 
@@ -34,6 +42,53 @@ namespace io {
 enum class ScheduleMode {
   IMMEDIATELY, UPON_GETNEXT_HEAD, UPON_GETNEXT_TAIL, BY_CALLER
 };
+/// A single read of a contiguous extent of a remote file that is shared by several
+/// nearby scan ranges of the same RequestContext. The reader that created it reads the
+/// extent into 'buffer()' and calls Done(). The other scan ranges copy their bytes out
+/// of the buffer with CopyTo(). See RequestContext::GetCoalescedRead().
+class CoalescedRead {
+ public:
+  /// The memory of the buffer must have been consumed from 'mem_tracker' by the caller.
+  /// It is released when the read is destroyed.
+  CoalescedRead(int64_t offset, int64_t len, MemTracker* mem_tracker)
+    : offset_(offset), len_(len), buffer_(new uint8_t[len]), mem_tracker_(mem_tracker) {}
+
+  ~CoalescedRead();
+
+  int64_t offset() const { return offset_; }
+  int64_t len() const { return len_; }
+  uint8_t* buffer() { return buffer_.get(); }
+
+  /// Marks the read as finished and wakes up the threads waiting in CopyTo().
+  /// 'bytes_read' is the number of valid bytes at the start of the buffer and must be 0
+  /// if the read failed.
+  void Done(int64_t bytes_read);
+
+  /// Waits until the read is finished and copies 'len' bytes at 'file_offset' into
+  /// 'buffer'. Returns false if these bytes were not read, e.g. because the read failed.
+  /// The caller must then read the bytes itself.
+  bool CopyTo(int64_t file_offset, uint8_t* buffer, int64_t len);
+
+ private:
+  /// The extent of the file that is read.
+  const int64_t offset_;
+  const int64_t len_;
+  const std::unique_ptr<uint8_t[]> buffer_;
+
+  /// Tracks the memory of 'buffer_'.
+  MemTracker* const mem_tracker_;
+
+  /// Protects the members below.
+  std::mutex lock_;
+
+  /// Signalled when 'done_' is set.
+  ConditionVariable done_cv_;
+  bool done_ = false;
+
+  /// Number of bytes at the start of 'buffer_' that were read.
+  int64_t bytes_read_ = 0;
+};
+
 /// A request context is used to group together I/O requests belonging to a client of the
 /// I/O manager for management and scheduling.
 ///
@@ -218,6 +273,12 @@ class RequestContext {
     query_id_ = query_id;
   }
 
+  /// Sets the resource pool of the query that this context belongs to. The pool
+  /// determines the weight of the context when --disk_io_fair_scheduling is enabled
+  /// and the time spent waiting in the disk queues is added to the pool's metrics.
+  /// Must be called before any ranges are added.
+  void set_request_pool(const std::string& pool);
+
  private:
   DISALLOW_COPY_AND_ASSIGN(RequestContext);
   class PerDiskState;
@@ -230,6 +291,7 @@ class RequestContext {
   friend class WriteRange;
   friend class RemoteOperRange;
   friend class LocalFileWriter;
+  friend class DiskIoMgrTest;
 
   enum State {
     /// Reader is initialized and maps to a client
@@ -325,6 +387,20 @@ class RequestContext {
   void RemoveActiveScanRangeLocked(
       const std::unique_lock<std::mutex>& lock, ScanRange* range);
 
+  /// Returns the coalesced read that serves the read of 'len' bytes at 'file_offset' of
+  /// 'range', or nullptr if the range is read on its own. If no coalesced read covers
+  /// the range yet, a new one is created for the range and all registered ranges of the
+  /// same file within --scan_range_coalesce_max_gap_bytes of each other, up to a total
+  /// of --scan_range_coalesce_max_bytes. In that case '*is_owner' is set to true and the
+  /// caller must issue the read and call CoalescedRead::Done(). The buffer of the read
+  /// is tracked by DiskIoMgr::coalesced_read_mem_tracker(). The range is read on its own
+  /// if that would exceed a memory limit.
+  std::shared_ptr<CoalescedRead> GetCoalescedRead(
+      ScanRange* range, int64_t file_offset, int64_t len, bool* is_owner);
+
+  /// Removes 'range' from 'coalescable_ranges_'. Caller must hold 'coalesce_lock_'.
+  void UnregisterCoalescableRange(ScanRange* range);
+
   /// Try to read the scan range from the cache. '*read_succeeded' is set to true if the
   /// scan range can be found in the cache, otherwise false.
   /// If '*needs_buffers' is returned as true, the caller must call
@@ -415,6 +491,18 @@ class RequestContext {
   /// a second time or cancelling after eos is safe and has no effect.
   boost::unordered_set<ScanRange*> active_scan_ranges_;
 
+  /// Protects 'coalescable_ranges_' and 'coalesced_reads_'. Can be acquired while
+  /// holding 'lock_', but no other lock may be acquired while holding it.
+  std::mutex coalesce_lock_;
+
+  /// Active scan ranges that can be coalesced (see ScanRange::CanCoalesce()) and have
+  /// not been read yet, by file name and offset. Only one range per offset is tracked.
+  std::unordered_map<std::string, std::map<int64_t, ScanRange*>> coalescable_ranges_;
+
+  /// Scan ranges that are read by a coalesced read that was issued by another range.
+  /// The entry is removed when the range is removed from 'active_scan_ranges_'.
+  std::unordered_map<ScanRange*, std::shared_ptr<CoalescedRead>> coalesced_reads_;
+
   /// The number of disks with scan ranges remaining (always equal to the sum of
   /// disks with ranges).
   int num_disks_with_ranges_ = 0;
@@ -441,6 +529,17 @@ class RequestContext {
   /// context. One state per IoMgr disk queue.
   std::vector<PerDiskState> disk_states_;
 
+  /// Weight of this context for fair scheduling on the disk queues. Contexts with a
+  /// higher weight are dispatched proportionally more often. Set by set_request_pool().
+  double io_weight_ = 1;
+
+  /// Virtual finish time of the last request of this context that was dispatched by each
+  /// disk queue. Only accessed by the DiskQueue with the same disk id under its lock.
+  std::vector<double> io_finish_tags_;
+
+  /// I/O metrics of the resource pool. nullptr if no pool was set.
+  DiskIoMgr::PoolIoMetrics* pool_io_metrics_ = nullptr;
+
   TUniqueId instance_id_;
   TUniqueId query_id_;
 };
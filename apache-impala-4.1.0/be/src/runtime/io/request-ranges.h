@@ -302,6 +302,13 @@ class ScanRange : public RequestRange {
   bool read_in_flight() const { return read_in_flight_; }
   bool expected_local() const { return expected_local_; }
   int64_t bytes_to_read() const { return bytes_to_read_; }
+
+  /// If true, the local file is read with O_DIRECT, bypassing the page cache. The
+  /// offset, length and client buffer of the range must then be aligned, see
+  /// DiskIoMgr::IsDirectIoAligned(). Reset() clears the flag, so it must be set after
+  /// Reset() and before the range is started.
+  bool use_direct_io() const { return use_direct_io_; }
+  void set_use_direct_io(bool use_direct_io) { use_direct_io_ = use_direct_io; }
   bool use_local_buffer() const { return use_local_buffer_; }
   bool is_cancelled() const { return !cancel_status_.ok(); }
   bool is_blocked_on_buffer() const { return blocked_on_buffer_; }
@@ -368,6 +375,11 @@ class ScanRange : public RequestRange {
   /// Initialize internal fields
   void InitInternal(DiskIoMgr* io_mgr, RequestContext* reader);
 
+  /// Returns true if the range may be read together with nearby ranges of the same file
+  /// in a single coalesced read (see RequestContext::GetCoalescedRead()). Only small
+  /// remote ranges without sub-ranges are coalesced.
+  bool CanCoalesce() const;
+
   /// If data is cached, returns ok() and * read_succeeded is set to true. Also enqueues
   /// a ready buffer from the cached data.
   /// If the data is not cached, returns ok() and *read_succeeded is set to false.
@@ -503,6 +515,9 @@ class ScanRange : public RequestRange {
   /// TODO: we can do more with this
   bool expected_local_ = false;
 
+  /// True if the local file is read with O_DIRECT. See set_use_direct_io().
+  bool use_direct_io_ = false;
+
   /// Last modified time of the file associated with the scan range. Set in Reset().
   int64_t mtime_;
 
@@ -631,6 +646,13 @@ class WriteRange : public RequestRange {
   /// Caller should guarantee the thread safe of calling the function.
   void SetOffset(int64_t file_offset);
 
+  /// If true, the data is written to a local file with O_DIRECT, bypassing the page
+  /// cache. The offset, length and data of the range must then be aligned, see
+  /// DiskIoMgr::IsDirectIoAligned(). Can only be called when the write is not in
+  /// flight.
+  void SetUseDirectIo(bool use_direct_io) { use_direct_io_ = use_direct_io; }
+  bool use_direct_io() const { return use_direct_io_; }
+
   /// Set the DiskFile pointer which the WriteRange belongs to.
   /// Can only be called when the write is not in flight (i.e. before AddWriteRange()
   /// is called or after the write callback was called).
@@ -679,6 +701,9 @@ class WriteRange : public RequestRange {
   /// A DiskFile can have multiple WriteRanges.
   DiskFile* disk_file_ = nullptr;
 
+  /// True if the data is written with O_DIRECT. See SetUseDirectIo().
+  bool use_direct_io_ = false;
+
   /// Indicate if the file which the write range belongs to is full after writing.
   bool is_full_ = false;
 };
@@ -34,6 +34,8 @@ using std::unique_lock;
 DECLARE_bool(cache_remote_file_handles);
 DECLARE_bool(cache_s3_file_handles);
 DECLARE_bool(cache_abfs_file_handles);
+DECLARE_int64(scan_range_coalesce_max_gap_bytes);
+DECLARE_int32(scan_range_coalesce_max_bytes);
 
 // Implementation of the ScanRange functionality. Each ScanRange contains a queue
 // of ready buffers. For each ScanRange, there is only a single producer and
@@ -461,6 +463,7 @@ void ScanRange::Reset(hdfsFS fs, const char* file, int64_t len, int64_t offset,
   }
 
   expected_local_ = expected_local;
+  use_direct_io_ = false;
   io_mgr_ = nullptr;
   reader_ = nullptr;
   sub_ranges_.clear();
@@ -534,6 +537,12 @@ void ScanRange::InitInternal(DiskIoMgr* io_mgr, RequestContext* reader) {
   DCHECK(Validate(scan_range_lock)) << DebugString();
 }
 
+bool ScanRange::CanCoalesce() const {
+  return FLAGS_scan_range_coalesce_max_gap_bytes > 0 && fs_ != nullptr
+      && !expected_local_ && disk_file_ == nullptr && !HasSubRanges()
+      && !UseHdfsCache() && len_ <= FLAGS_scan_range_coalesce_max_bytes;
+}
+
 void ScanRange::SetFileReader(unique_ptr<FileReader> file_reader) {
   file_reader_ = move(file_reader);
 }
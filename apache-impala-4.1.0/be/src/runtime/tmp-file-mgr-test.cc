@@ -15,6 +15,8 @@
 // specific language governing permissions and limitations
 // under the License.
 
+#include <fcntl.h>
+#include <unistd.h>
 #include <cstdio>
 #include <cstdlib>
 #include <limits>
@@ -39,7 +41,9 @@
 #include "util/collection-metrics.h"
 #include "util/condition-variable.h"
 #include "util/cpu-info.h"
+#include "util/error-util.h"
 #include "util/filesystem-util.h"
+#include "util/impalad-metrics.h"
 #include "util/metrics.h"
 
 #include "gen-cpp/Types_types.h"  // for TUniqueId
@@ -53,6 +57,7 @@ DECLARE_bool(disk_spill_encryption);
 DECLARE_int64(disk_spill_compression_buffer_limit_bytes);
 DECLARE_string(disk_spill_compression_codec);
 DECLARE_bool(disk_spill_punch_holes);
+DECLARE_bool(disk_spill_direct_io);
 #ifndef NDEBUG
 DECLARE_int32(stress_scratch_write_delay_ms);
 #endif
@@ -81,6 +86,7 @@ class TmpFileMgrTest : public ::testing::Test {
     FLAGS_disk_spill_encryption = false;
     FLAGS_disk_spill_compression_codec = "";
     FLAGS_disk_spill_punch_holes = false;
+    FLAGS_disk_spill_direct_io = false;
 #ifndef NDEBUG
     FLAGS_stress_scratch_write_delay_ms = 0;
 #endif
@@ -555,6 +561,70 @@ TEST_F(TmpFileMgrTest, TestScratchRangeHolePunching) {
   TestScratchRangeRecycling(true);
 }
 
+// Test that pages whose buffer and size are aligned are spilled with direct I/O if
+// --disk_spill_direct_io is true, that other pages are spilled through the page cache
+// and that both are read back correctly.
+TEST_F(TmpFileMgrTest, TestDirectIo) {
+  vector<string> tmp_dirs({"/tmp/tmp-file-mgr-test.1", "/tmp/tmp-file-mgr-test.2"});
+  RemoveAndCreateDirs(tmp_dirs);
+  const string probe_path = tmp_dirs[0] + "/direct-io-probe";
+  int probe_fd = open(probe_path.c_str(), O_RDWR | O_CREAT | O_DIRECT, 0600);
+  if (probe_fd < 0) {
+    LOG(INFO) << "Skipping test, direct I/O is not supported: " << GetStrErrMsg();
+    return;
+  }
+  close(probe_fd);
+  unlink(probe_path.c_str());
+
+  FLAGS_disk_spill_direct_io = true;
+  TmpFileMgr tmp_file_mgr;
+  ASSERT_OK(tmp_file_mgr.InitCustom(tmp_dirs, false, "", false, metrics_.get()));
+  TUniqueId id;
+  TmpFileGroup file_group(&tmp_file_mgr, io_mgr(), profile_, id);
+  IntCounter* direct_bytes_written = ImpaladMetrics::IO_MGR_DIRECT_IO_BYTES_WRITTEN;
+  IntCounter* direct_bytes_read = ImpaladMetrics::IO_MGR_DIRECT_IO_BYTES_READ;
+
+  WriteRange::WriteDoneCallback callback =
+      bind(mem_fn(&TmpFileMgrTest::SignalCallback), this, _1);
+  const int64_t BUFFER_SIZE = 128 * KILOBYTE;
+  for (int64_t len : {4 * KILOBYTE, 64 * KILOBYTE, 100L, 6000L}) {
+    const bool aligned_len = len % DiskIoMgr::DIRECT_IO_ALIGNMENT == 0;
+    for (int buffer_offset : {0, 8}) {
+      // 'buffer_offset' bytes into a page aligned buffer.
+      void* data = nullptr;
+      void* read_data = nullptr;
+      ASSERT_EQ(0, posix_memalign(&data, DiskIoMgr::DIRECT_IO_ALIGNMENT, BUFFER_SIZE));
+      ASSERT_EQ(
+          0, posix_memalign(&read_data, DiskIoMgr::DIRECT_IO_ALIGNMENT, BUFFER_SIZE));
+      unique_ptr<uint8_t, decltype(&free)> buffer(
+          reinterpret_cast<uint8_t*>(data), free);
+      unique_ptr<uint8_t, decltype(&free)> read_buffer(
+          reinterpret_cast<uint8_t*>(read_data), free);
+      uint8_t* write_ptr = buffer.get() + buffer_offset;
+      uint8_t* read_ptr = read_buffer.get() + buffer_offset;
+      std::iota(write_ptr, write_ptr + len, len + buffer_offset);
+
+      const int64_t written_before = direct_bytes_written->GetValue();
+      const int64_t read_before = direct_bytes_read->GetValue();
+      cb_counter_ = 0;
+      unique_ptr<TmpWriteHandle> handle;
+      ASSERT_OK(file_group.Write(MemRange(write_ptr, len), callback, &handle));
+      WaitForCallbacks(1);
+      memset(read_ptr, 0, len);
+      ASSERT_OK(file_group.Read(handle.get(), MemRange(read_ptr, len)));
+      EXPECT_EQ(0, memcmp(write_ptr, read_ptr, len));
+      file_group.DestroyWriteHandle(move(handle));
+
+      const int64_t expected_direct_bytes = aligned_len && buffer_offset == 0 ? len : 0;
+      EXPECT_EQ(written_before + expected_direct_bytes,
+          direct_bytes_written->GetValue()) << len << " " << buffer_offset;
+      EXPECT_EQ(read_before + expected_direct_bytes, direct_bytes_read->GetValue())
+          << len << " " << buffer_offset;
+    }
+  }
+  file_group.Close();
+}
+
 void TmpFileMgrTest::TestScratchRangeRecycling(bool punch_holes) {
   vector<string> tmp_dirs({"/tmp/tmp-file-mgr-test.1", "/tmp/tmp-file-mgr-test.2"});
   RemoveAndCreateDirs(tmp_dirs);
@@ -72,6 +72,13 @@ DEFINE_int64(disk_spill_compression_buffer_limit_bytes, 512L * 1024L * 1024L,
     "(Advanced) Limit on the total bytes of compression buffers that will be used for "
     "spill-to-disk compression across all queries. If this limit is exceeded, some data "
     "may be spilled to disk in uncompressed form.");
+DEFINE_bool(disk_spill_direct_io, false,
+    "(Advanced) If true, pages spilled to files in local --scratch_dirs are written and "
+    "read back with direct I/O (O_DIRECT), bypassing the operating system's page cache. "
+    "Spilled data is already accounted for in the buffer pool, so caching it again in "
+    "the page cache only evicts other data. Scratch ranges are aligned to 4KB in this "
+    "mode. Pages whose size is not a multiple of 4KB, e.g. compressed pages, still go "
+    "through the page cache.");
 DEFINE_bool(disk_spill_punch_holes, false,
     "(Advanced) changes the free space management strategy for files created in "
     "--scratch_dirs to punch holes in the file when space is unused. This can reduce "
@@ -1078,11 +1085,22 @@ static int64_t RoundUpToScratchRangeSize(bool punch_holes, int64_t bytes) {
     // free the backing storage for the entire range.
     return BitUtil::RoundUpToPowerOf2(bytes, TmpFileMgr::HOLE_PUNCH_BLOCK_SIZE_BYTES);
   } else {
-    // We recycle scratch ranges, which must be positive power-of-two sizes.
-    return max<int64_t>(1L, BitUtil::RoundUpToPowerOfTwo(bytes));
+    // We recycle scratch ranges, which must be positive power-of-two sizes. With direct
+    // I/O, every range must start at an aligned offset.
+    const int64_t min_bytes = FLAGS_disk_spill_direct_io ?
+        DiskIoMgr::DIRECT_IO_ALIGNMENT : 1L;
+    return max<int64_t>(min_bytes, BitUtil::RoundUpToPowerOfTwo(bytes));
   }
 }
 
+// Returns true if reading or writing 'len' bytes at 'offset' of 'file' from or to
+// 'buffer' should bypass the page cache.
+static bool UseScratchDirectIo(
+    TmpFile* file, const uint8_t* buffer, int64_t offset, int64_t len) {
+  return FLAGS_disk_spill_direct_io && file->is_local()
+      && DiskIoMgr::IsDirectIoAligned(buffer, offset, len);
+}
+
 void TmpFileGroup::UpdateScratchSpaceMetrics(int64_t num_bytes, bool is_remote) {
   scratch_space_bytes_used_counter_->Add(num_bytes);
   tmp_file_mgr_->scratch_bytes_used_metric_->Increment(num_bytes);
@@ -1371,6 +1389,8 @@ Status TmpFileGroup::ReadAsync(TmpWriteHandle* handle, MemRange buffer) {
         handle->write_range_->disk_id(), false, ScanRange::INVALID_MTIME,
         BufferOpts::ReadInto(
             read_buffer.data(), read_buffer.len(), BufferOpts::NO_CACHING));
+    handle->read_range_->set_use_direct_io(UseScratchDirectIo(handle->file_,
+        read_buffer.data(), handle->write_range_->offset(), handle->write_range_->len()));
   }
 
   read_counter_->Add(1);
@@ -1652,6 +1672,8 @@ Status TmpWriteHandle::Write(RequestContext* io_ctx, MemRange buffer,
   write_range_.reset(new WriteRange(tmp_file->path(), file_offset,
       tmp_file->AssignDiskQueue(!tmp_file->is_local()), callback));
   write_range_->SetData(buffer_to_write.data(), buffer_to_write.len());
+  write_range_->SetUseDirectIo(UseScratchDirectIo(
+      tmp_file, buffer_to_write.data(), file_offset, buffer_to_write.len()));
   // For remote files, we write the range to the local buffer.
   write_range_->SetDiskFile(tmp_file->GetWriteFile());
   VLOG(3) << "Write " << tmp_file->path() << " " << file_offset << " "
@@ -1718,6 +1740,8 @@ Status TmpWriteHandle::RetryWrite(RequestContext* io_ctx, TmpFile* file, int64_t
   DCHECK(write_in_flight_);
   file_ = file;
   write_range_->SetRange(file->path(), offset, file->AssignDiskQueue());
+  write_range_->SetUseDirectIo(
+      UseScratchDirectIo(file, write_range_->data(), offset, write_range_->len()));
   write_range_->SetDiskFile(file->GetWriteFile());
   Status status = io_ctx->AddWriteRange(write_range_.get());
   if (!status.ok()) {
@@ -1220,6 +1220,33 @@ Status impala::SetQueryOption(const string& key, const string& value,
         query_options->__set_test_replan(IsTrue(value));
         break;
       }
+      case TImpalaQueryOptions::NUM_ANALYTIC_EVAL_THREADS: {
+        StringParser::ParseResult result;
+        const int32_t num_threads =
+            StringParser::StringToInt<int32_t>(value.c_str(), value.length(), &result);
+        if (result != StringParser::PARSE_SUCCESS || num_threads < 0
+            || num_threads > 64) {
+          return Status(Substitute("$0 is not valid for num_analytic_eval_threads. "
+              "Valid values are in [0, 64].", value));
+        }
+        query_options->__set_num_analytic_eval_threads(num_threads);
+        break;
+      }
+      case TImpalaQueryOptions::PARQUET_DICTIONARY_CODE_FILTERING: {
+        query_options->__set_parquet_dictionary_code_filtering(IsTrue(value));
+        break;
+      }
+      case TImpalaQueryOptions::ORC_LATE_MATERIALIZATION_THRESHOLD: {
+        StringParser::ParseResult result;
+        const int32_t threshold =
+            StringParser::StringToInt<int32_t>(value.c_str(), value.length(), &result);
+        if (result != StringParser::PARSE_SUCCESS || threshold < -1) {
+          return Status(Substitute("Invalid ORC late materialization threshold: "
+              "'$0'. Only integer value -1 and above is allowed.", value));
+        }
+        query_options->__set_orc_late_materialization_threshold(threshold);
+        break;
+      }
       default:
         if (IsRemovedQueryOption(key)) {
           LOG(WARNING) << "Ignoring attempt to set removed query option '" << key << "'";
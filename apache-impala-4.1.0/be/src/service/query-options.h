@@ -50,7 +50,7 @@ typedef std::unordered_map<string, beeswax::TQueryOptionLevel::type>
 // time we add or remove a query option to/from the enum TImpalaQueryOptions.
 #define QUERY_OPTS_TABLE\
   DCHECK_EQ(_TImpalaQueryOptions_VALUES_TO_NAMES.size(),\
-      TImpalaQueryOptions::LOCK_MAX_WAIT_TIME_S + 1);\
+      TImpalaQueryOptions::ORC_LATE_MATERIALIZATION_THRESHOLD + 1);\
   REMOVED_QUERY_OPT_FN(abort_on_default_limit_exceeded, ABORT_ON_DEFAULT_LIMIT_EXCEEDED)\
   QUERY_OPT_FN(abort_on_error, ABORT_ON_ERROR, TQueryOptionLevel::REGULAR)\
   REMOVED_QUERY_OPT_FN(allow_unsupported_formats, ALLOW_UNSUPPORTED_FORMATS)\
@@ -282,6 +282,12 @@ typedef std::unordered_map<string, beeswax::TQueryOptionLevel::type>
   QUERY_OPT_FN(test_replan, TEST_REPLAN,\
       TQueryOptionLevel::ADVANCED)\
   QUERY_OPT_FN(lock_max_wait_time_s, LOCK_MAX_WAIT_TIME_S, TQueryOptionLevel::REGULAR)\
+  QUERY_OPT_FN(num_analytic_eval_threads, NUM_ANALYTIC_EVAL_THREADS,\
+      TQueryOptionLevel::ADVANCED)\
+  QUERY_OPT_FN(parquet_dictionary_code_filtering, PARQUET_DICTIONARY_CODE_FILTERING,\
+      TQueryOptionLevel::ADVANCED)\
+  QUERY_OPT_FN(orc_late_materialization_threshold, ORC_LATE_MATERIALIZATION_THRESHOLD,\
+      TQueryOptionLevel::ADVANCED)\
   ;
 
 /// Enforce practical limits on some query options to avoid undesired query state.
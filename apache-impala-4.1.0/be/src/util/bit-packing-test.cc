@@ -26,6 +26,7 @@
 #include "testutil/mem-util.h"
 #include "util/bit-packing.h"
 #include "util/bit-stream-utils.inline.h"
+#include "util/cpu-info.h"
 
 #include "common/names.h"
 
@@ -201,6 +202,13 @@ TEST(BitPackingTest, RandomUnpack64) {
   RandomUnpackTest<uint64_t>();
 }
 
+// Unpacking into uint32_t uses AVX2 if supported. Also test the scalar code on the same
+// machine.
+TEST(BitPackingTest, RandomUnpack32Scalar) {
+  CpuInfo::TempDisable disable_avx2(CpuInfo::AVX2);
+  RandomUnpackTest<uint32_t>();
+}
+
 // This is not the full dictionary encoding, only a big bit-packed literal run, no RLE is
 // used.
 template <typename T>
@@ -319,4 +327,45 @@ TEST(BitPackingTest, RandomUnpackAndDecode64) {
   RandomUnpackAndDecodeTest<uint64_t>();
 }
 
+TEST(BitPackingTest, RandomUnpackAndDecode32Scalar) {
+  CpuInfo::TempDisable disable_avx2(CpuInfo::AVX2);
+  RandomUnpackAndDecodeTest<uint32_t>();
+}
+
+// Test that out of range dictionary indexes are detected in full and partial batches
+// and that the in-range values around them are decoded.
+TEST(BitPackingTest, UnpackAndDecodeOutOfRange) {
+  constexpr int BIT_WIDTH = 5;
+  constexpr int DICT_LEN = 20;
+  const std::vector<uint32_t> dict = GenerateRandomInput<uint32_t>(
+      DICT_LEN, 0, std::numeric_limits<uint32_t>::max());
+  for (const int num_values : {NUM_IN_VALUES, NUM_IN_VALUES - 19, 31}) {
+    for (const int bad_idx : {0, num_values / 2, num_values - 1}) {
+      std::vector<uint32_t> indexes = GenerateRandomInput<uint32_t>(
+          num_values, 0, DICT_LEN - 1);
+      indexes[bad_idx] = DICT_LEN;
+      const int bytes_required = BitUtil::RoundUpNumBytes(BIT_WIDTH * num_values);
+      std::vector<uint8_t> data(bytes_required);
+      BitWriter writer(data.data(), bytes_required);
+      for (const uint32_t index : indexes) {
+        ASSERT_TRUE(writer.PutValue(index, BIT_WIDTH));
+      }
+      writer.Flush();
+
+      std::vector<uint32_t> out(num_values, 0);
+      bool decode_error = false;
+      std::pair<const uint8_t*, int64_t> res =
+          BitPacking::UnpackAndDecodeValues<uint32_t>(BIT_WIDTH, data.data(),
+              data.size(), const_cast<uint32_t*>(dict.data()), dict.size(), num_values,
+              out.data(), sizeof(uint32_t), &decode_error);
+      EXPECT_TRUE(decode_error);
+      EXPECT_EQ(num_values, res.second);
+      for (int i = 0; i < num_values; ++i) {
+        if (i == bad_idx) continue;
+        EXPECT_EQ(dict[indexes[i]], out[i]) << "Wrong value at " << i;
+      }
+    }
+  }
+}
+
 }
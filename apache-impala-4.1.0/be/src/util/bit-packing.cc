@@ -17,13 +17,178 @@
 
 #include "util/bit-packing.inline.h"
 
+#ifndef __aarch64__
+  #include <immintrin.h>
+#endif
+
+#include <limits>
+
 #include "runtime/date-value.h"
 #include "runtime/decimal-value.h"
 #include "runtime/string-value.h"
 #include "runtime/timestamp-value.h"
+#include "util/cpu-info.h"
 
 namespace impala {
 
+int64_t BitPacking::NumSimdBatches(
+    int bit_width, int64_t in_bytes, int64_t num_values) {
+  constexpr int BATCH_SIZE = 32;
+  constexpr int LOAD_BYTES = 32;
+  const int64_t batches = NumValuesToUnpack(bit_width, in_bytes, num_values) / BATCH_SIZE;
+  // A batch is 4 * 'bit_width' bytes long and its last group of 8 values starts at byte
+  // 3 * 'bit_width'.
+  const int64_t last_load_end = 3 * bit_width + LOAD_BYTES;
+  if (in_bytes < last_load_end) return 0;
+  return std::min(batches, (in_bytes - last_load_end) / (4 * bit_width) + 1);
+}
+
+int64_t BitPacking::UnpackBatchesSimd(int bit_width, const uint8_t* __restrict__ in,
+    int64_t in_bytes, int64_t num_values, uint32_t* __restrict__ out) {
+#ifndef __aarch64__
+  if (bit_width == 0 || !CpuInfo::IsSupported(CpuInfo::AVX2)) return 0;
+  const int64_t num_batches = NumSimdBatches(bit_width, in_bytes, num_values);
+  if (num_batches == 0) return 0;
+  UnpackBatchesAVX2(bit_width, in, num_batches, out);
+  return num_batches * 32;
+#else
+  return 0;
+#endif
+}
+
+int64_t BitPacking::UnpackAndDecode4ByteBatchesSimd(int bit_width,
+    const uint8_t* __restrict__ in, int64_t in_bytes, const uint8_t* __restrict__ dict,
+    int64_t dict_len, int64_t num_values, uint8_t* __restrict__ out, int64_t stride,
+    bool* __restrict__ decode_error) {
+#ifndef __aarch64__
+  // The gather instruction takes signed 32-bit indexes, so larger dictionaries are left
+  // to the scalar code. So are empty ones, for which every index is an error.
+  if (bit_width == 0 || dict_len == 0 || dict_len > std::numeric_limits<int32_t>::max()
+      || !CpuInfo::IsSupported(CpuInfo::AVX2)) {
+    return 0;
+  }
+  const int64_t num_batches = NumSimdBatches(bit_width, in_bytes, num_values);
+  if (num_batches == 0) return 0;
+  UnpackAndDecode4ByteBatchesAVX2(
+      bit_width, in, dict, dict_len, num_batches, out, stride, decode_error);
+  return num_batches * 32;
+#else
+  return 0;
+#endif
+}
+
+#ifndef __aarch64__
+namespace {
+
+// Permutation, shift and mask vectors that extract 8 values of a given bit width from
+// 32 bytes of packed data that start at the first of those values. Value j starts at
+// bit j * bit_width, i.e. at bit 'lo_shift[j]' of 32-bit word 'lo_perm[j]' and may
+// continue in the next word. The bits in the next word are shifted into place by
+// 'hi_shift[j]', which is 32 (shifting everything out) if the value starts at a word
+// boundary.
+struct UnpackVectors {
+  __m256i lo_perm;
+  __m256i hi_perm;
+  __m256i lo_shift;
+  __m256i hi_shift;
+  __m256i mask;
+};
+
+__attribute__((target("avx2")))
+UnpackVectors MakeUnpackVectors(int bit_width) {
+  DCHECK_GE(bit_width, 1);
+  DCHECK_LE(bit_width, 32);
+  int32_t lo_perm[8], hi_perm[8], lo_shift[8], hi_shift[8];
+  for (int j = 0; j < 8; ++j) {
+    const int first_bit = j * bit_width;
+    lo_perm[j] = first_bit / 32;
+    // The index wraps around for the last word, which is harmless: a value that does
+    // not span two words has all the bits taken from the next word masked out.
+    hi_perm[j] = lo_perm[j] + 1;
+    lo_shift[j] = first_bit % 32;
+    hi_shift[j] = 32 - lo_shift[j];
+  }
+  const uint32_t mask = bit_width == 32 ? ~0U : (1U << bit_width) - 1;
+  return UnpackVectors{
+      _mm256_loadu_si256(reinterpret_cast<const __m256i*>(lo_perm)),
+      _mm256_loadu_si256(reinterpret_cast<const __m256i*>(hi_perm)),
+      _mm256_loadu_si256(reinterpret_cast<const __m256i*>(lo_shift)),
+      _mm256_loadu_si256(reinterpret_cast<const __m256i*>(hi_shift)),
+      _mm256_set1_epi32(static_cast<int32_t>(mask))};
+}
+
+// Unpacks the 8 values that start at 'in'. Reads 32 bytes from 'in'.
+__attribute__((target("avx2")))
+inline __m256i Unpack8ValuesAVX2(const uint8_t* in, const UnpackVectors& v) {
+  const __m256i words = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(in));
+  const __m256i lo =
+      _mm256_srlv_epi32(_mm256_permutevar8x32_epi32(words, v.lo_perm), v.lo_shift);
+  const __m256i hi =
+      _mm256_sllv_epi32(_mm256_permutevar8x32_epi32(words, v.hi_perm), v.hi_shift);
+  return _mm256_and_si256(_mm256_or_si256(lo, hi), v.mask);
+}
+
+}
+
+__attribute__((target("avx2")))
+void BitPacking::UnpackBatchesAVX2(int bit_width, const uint8_t* __restrict__ in,
+    int64_t num_batches, uint32_t* __restrict__ out) {
+  const UnpackVectors v = MakeUnpackVectors(bit_width);
+  // 8 values take up exactly 'bit_width' bytes.
+  for (int64_t i = 0; i < num_batches * 4; ++i) {
+    _mm256_storeu_si256(
+        reinterpret_cast<__m256i*>(out), Unpack8ValuesAVX2(in, v));
+    in += bit_width;
+    out += 8;
+  }
+  _mm256_zeroupper();
+}
+
+__attribute__((target("avx2")))
+void BitPacking::UnpackAndDecode4ByteBatchesAVX2(int bit_width,
+    const uint8_t* __restrict__ in, const uint8_t* __restrict__ dict, int64_t dict_len,
+    int64_t num_batches, uint8_t* __restrict__ out, int64_t stride,
+    bool* __restrict__ decode_error) {
+  DCHECK_GE(dict_len, 1);
+  DCHECK_LE(dict_len, std::numeric_limits<int32_t>::max());
+  const UnpackVectors v = MakeUnpackVectors(bit_width);
+  const __m256i max_idx = _mm256_set1_epi32(static_cast<int32_t>(dict_len - 1));
+  const int* dict_words = reinterpret_cast<const int*>(dict);
+  uint32_t tmp[8];
+  for (int64_t i = 0; i < num_batches * 4; ++i) {
+    const __m256i idx = Unpack8ValuesAVX2(in, v);
+    in += bit_width;
+    // Compare the indexes as unsigned values: 'idx' is valid iff max(idx, max_idx) is
+    // 'max_idx'.
+    const __m256i valid = _mm256_cmpeq_epi32(_mm256_max_epu32(idx, max_idx), max_idx);
+    if (LIKELY(_mm256_movemask_epi8(valid) == -1)) {
+      const __m256i values = _mm256_i32gather_epi32(dict_words, idx, sizeof(uint32_t));
+      if (stride == sizeof(uint32_t)) {
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(out), values);
+      } else {
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(tmp), values);
+        for (int j = 0; j < 8; ++j) {
+          memcpy(out + j * stride, &tmp[j], sizeof(uint32_t));
+        }
+      }
+    } else {
+      // Decode the values one by one to set 'decode_error' and skip the invalid indexes
+      // exactly like the scalar code does.
+      _mm256_storeu_si256(reinterpret_cast<__m256i*>(tmp), idx);
+      for (int j = 0; j < 8; ++j) {
+        if (tmp[j] >= dict_len) {
+          *decode_error = true;
+        } else {
+          memcpy(out + j * stride, dict + tmp[j] * sizeof(uint32_t), sizeof(uint32_t));
+        }
+      }
+    }
+    out += 8 * stride;
+  }
+  _mm256_zeroupper();
+}
+#endif
+
 // Instantiate all of the templated functions needed by the rest of Impala.
 #define INSTANTIATE_UNPACK_VALUES(OUT_TYPE)                                       \
   template std::pair<const uint8_t*, int64_t> BitPacking::UnpackValues<OUT_TYPE>( \
@@ -44,6 +44,10 @@ namespace impala {
 /// The batched unpacking functions operate on batches of 32 values. This batch size
 /// is convenient because for every supported bit width, the end of a 32 value batch
 /// falls on a byte boundary. It is also large enough to amortise loop overheads.
+///
+/// UnpackValues() into uint32_t and UnpackAndDecodeValues() with 4-byte dictionary
+/// values unpack full batches with AVX2 instructions if the CPU supports them. The
+/// remaining values are unpacked with the scalar code.
 class BitPacking {
  public:
   static constexpr int MAX_BITWIDTH = sizeof(uint64_t) * 8;
@@ -131,5 +135,51 @@ class BitPacking {
   /// Compute the number of values with the given bit width that can be unpacked from
   /// an input buffer of 'in_bytes' into an output buffer with space for 'num_values'.
   static int64_t NumValuesToUnpack(int bit_width, int64_t in_bytes, int64_t num_values);
+
+  /// Unpacks as many full batches of 32 values as possible from 'in' to 'out' using
+  /// SIMD instructions and returns the number of values unpacked. Returns 0 if there is
+  /// no SIMD implementation for OutType or the CPU. Values that are not unpacked by this
+  /// function must be unpacked by the scalar code. The arguments are the same as for
+  /// UnpackValues().
+  template <typename OutType>
+  static int64_t UnpackBatchesSimd(int bit_width, const uint8_t* __restrict__ in,
+      int64_t in_bytes, int64_t num_values, OutType* __restrict__ out) {
+    return 0;
+  }
+  static int64_t UnpackBatchesSimd(int bit_width, const uint8_t* __restrict__ in,
+      int64_t in_bytes, int64_t num_values, uint32_t* __restrict__ out);
+
+  /// Same as UnpackBatchesSimd() with dictionary decoding. Only 4-byte dictionary values
+  /// are supported. The arguments are the same as for UnpackAndDecodeValues().
+  template <typename OutType>
+  static int64_t UnpackAndDecodeBatchesSimd(int bit_width, const uint8_t* __restrict__ in,
+      int64_t in_bytes, OutType* __restrict__ dict, int64_t dict_len, int64_t num_values,
+      OutType* __restrict__ out, int64_t stride, bool* __restrict__ decode_error) {
+    if (sizeof(OutType) != sizeof(uint32_t)) return 0;
+    return UnpackAndDecode4ByteBatchesSimd(bit_width, in, in_bytes,
+        reinterpret_cast<const uint8_t*>(dict), dict_len, num_values,
+        reinterpret_cast<uint8_t*>(out), stride, decode_error);
+  }
+  static int64_t UnpackAndDecode4ByteBatchesSimd(int bit_width,
+      const uint8_t* __restrict__ in, int64_t in_bytes, const uint8_t* __restrict__ dict,
+      int64_t dict_len, int64_t num_values, uint8_t* __restrict__ out, int64_t stride,
+      bool* __restrict__ decode_error);
+
+  /// Returns the number of full batches of 32 values that the SIMD kernels can unpack
+  /// from 'in_bytes' bytes. The kernels load 32 bytes for every 8 values, so the last
+  /// load of a batch may extend past the end of the batch. Batches for which that load
+  /// would read past the end of the input are left to the scalar code.
+  static int64_t NumSimdBatches(int bit_width, int64_t in_bytes, int64_t num_values);
+
+  /// AVX2 implementations of the above. Unpack 'num_batches' full batches of 32 values.
+  /// 'bit_width' must be between 1 and 32 and the input must be long enough for
+  /// 'num_batches' as returned by NumSimdBatches(). For the dictionary decoding version,
+  /// 'dict_len' must be between 1 and INT32_MAX.
+  static void UnpackBatchesAVX2(int bit_width, const uint8_t* __restrict__ in,
+      int64_t num_batches, uint32_t* __restrict__ out);
+  static void UnpackAndDecode4ByteBatchesAVX2(int bit_width,
+      const uint8_t* __restrict__ in, const uint8_t* __restrict__ dict, int64_t dict_len,
+      int64_t num_batches, uint8_t* __restrict__ out, int64_t stride,
+      bool* __restrict__ decode_error);
 };
 }
@@ -63,10 +63,23 @@ std::pair<const uint8_t*, int64_t> BitPacking::UnpackValues(int bit_width,
   static_assert(IsSupportedUnpackingType<OutType>(),
       "Only unsigned integers are supported.");
 
+  // Unpack as many full batches as possible with SIMD instructions. The remaining values
+  // are unpacked with the scalar code below.
+  const int64_t simd_values = UnpackBatchesSimd(bit_width, in, in_bytes, num_values, out);
+  if (simd_values > 0) {
+    const int64_t simd_bytes = (simd_values * bit_width) / CHAR_BIT;
+    in += simd_bytes;
+    in_bytes -= simd_bytes;
+    num_values -= simd_values;
+    out += simd_values;
+  }
+
+  std::pair<const uint8_t*, int64_t> result;
 #pragma push_macro("UNPACK_VALUES_CASE")
 #define UNPACK_VALUES_CASE(ignore1, i, ignore2) \
   case i:                                       \
-    return UnpackValues<OutType, i>(in, in_bytes, num_values, out);
+    result = UnpackValues<OutType, i>(in, in_bytes, num_values, out); \
+    break;
 
   switch (bit_width) {
     // Expand cases from 0 to 64.
@@ -76,6 +89,8 @@ std::pair<const uint8_t*, int64_t> BitPacking::UnpackValues(int bit_width,
       return std::make_pair(nullptr, -1);
   }
 #pragma pop_macro("UNPACK_VALUES_CASE")
+  result.second += simd_values;
+  return result;
 }
 
 template <typename OutType, int BIT_WIDTH>
@@ -112,11 +127,26 @@ std::pair<const uint8_t*, int64_t> BitPacking::UnpackAndDecodeValues(int bit_wid
     const uint8_t* __restrict__ in, int64_t in_bytes, OutType* __restrict__ dict,
     int64_t dict_len, int64_t num_values, OutType* __restrict__ out, int64_t stride,
     bool* __restrict__ decode_error) {
+  // Unpack and decode as many full batches as possible with SIMD instructions. The
+  // remaining values are handled by the scalar code below.
+  const int64_t simd_values = UnpackAndDecodeBatchesSimd(bit_width, in, in_bytes, dict,
+      dict_len, num_values, out, stride, decode_error);
+  if (simd_values > 0) {
+    const int64_t simd_bytes = (simd_values * bit_width) / CHAR_BIT;
+    in += simd_bytes;
+    in_bytes -= simd_bytes;
+    num_values -= simd_values;
+    out = reinterpret_cast<OutType*>(reinterpret_cast<uint8_t*>(out)
+        + simd_values * stride);
+  }
+
+  std::pair<const uint8_t*, int64_t> result;
 #pragma push_macro("UNPACK_VALUES_CASE")
 #define UNPACK_VALUES_CASE(ignore1, i, ignore2) \
   case i:                                       \
-    return UnpackAndDecodeValues<OutType, i>(   \
-        in, in_bytes, dict, dict_len, num_values, out, stride, decode_error);
+    result = UnpackAndDecodeValues<OutType, i>( \
+        in, in_bytes, dict, dict_len, num_values, out, stride, decode_error); \
+    break;
 
   switch (bit_width) {
     // Expand cases from 0 to MAX_DICT_BITWIDTH.
@@ -126,6 +156,8 @@ std::pair<const uint8_t*, int64_t> BitPacking::UnpackAndDecodeValues(int bit_wid
       return std::make_pair(nullptr, -1);
   }
 #pragma pop_macro("UNPACK_VALUES_CASE")
+  result.second += simd_values;
+  return result;
 }
 template <typename OutType, int BIT_WIDTH>
 std::pair<const uint8_t*, int64_t> BitPacking::UnpackAndDecodeValues(
@@ -282,7 +314,8 @@ const uint8_t* BitPacking::UnpackAndDecode32Values(const uint8_t* __restrict__ i
   static_assert(BIT_WIDTH <= MAX_BITWIDTH, "BIT_WIDTH too high");
   constexpr int BYTES_TO_READ = BitUtil::RoundUpNumBytes(32 * BIT_WIDTH);
   DCHECK_GE(in_bytes, BYTES_TO_READ);
-  // TODO: this could be optimised further by using SIMD instructions.
+  // TODO: UnpackAndDecodeValues() uses AVX2 instructions for 4-byte dictionary values.
+  // Other value sizes could be optimised similarly.
   // https://lemire.me/blog/2016/08/25/faster-dictionary-decoding-with-simd-instructions/
 
   static_assert(BIT_WIDTH <= MAX_DICT_BITWIDTH,
@@ -377,6 +377,15 @@ class DictDecoder : public DictDecoderBase {
   /// be successfully read. 'stride' is the stride in bytes between each subsequent value.
   bool GetNextValues(T* first_value, int64_t stride, int count) WARN_UNUSED_RESULT;
 
+  /// Same as GetNextValues(), but also looks up the dictionary index of each value in
+  /// 'entry_rejected', which must have num_entries() elements, and sets the i'th byte
+  /// of 'rows_rejected' if the entry of the i'th value is rejected. Bytes of
+  /// 'rows_rejected' are never cleared, so the results of multiple columns accumulate.
+  /// Values that were already buffered by a previous call of GetNextValue() or
+  /// GetNextValues() are returned without being checked.
+  bool GetNextValuesAndRejectRows(T* first_value, int64_t stride, int count,
+      const uint8_t* entry_rejected, uint8_t* rows_rejected) WARN_UNUSED_RESULT;
+
   /// This function returns the size in bytes of the dictionary vector.
   /// It is used by dict-test.cc for validation of bytes consumed against
   /// memory tracked.
@@ -556,6 +565,56 @@ ALWAYS_INLINE inline bool DictDecoder<T>::GetNextValues(
   return true;
 }
 
+template <typename T>
+inline bool DictDecoder<T>::GetNextValuesAndRejectRows(T* first_value, int64_t stride,
+    int count, const uint8_t* entry_rejected, uint8_t* rows_rejected) {
+  DCHECK_GE(count, 0);
+  // The dictionary indexes of buffered values are not known anymore.
+  int num_buffered = num_repeats_ > 0 ?
+      std::min<int64_t>(num_repeats_, count) :
+      std::min(num_literal_values_ - next_literal_idx_, count);
+  if (num_buffered > 0) {
+    if (UNLIKELY(!GetNextValues(first_value, stride, num_buffered))) return false;
+    first_value = reinterpret_cast<T*>(reinterpret_cast<uint8_t*>(first_value)
+        + num_buffered * stride);
+    rows_rejected += num_buffered;
+    count -= num_buffered;
+  }
+  StrideWriter<T> out(first_value, stride);
+  const int dict_len = dict_.size();
+  IndexType indexes[DICT_DECODER_BUFFER_SIZE];
+  while (count > 0) {
+    uint32_t num_repeats = data_decoder_.NextNumRepeats();
+    if (num_repeats > 0) {
+      uint32_t num_to_consume = std::min<uint32_t>(num_repeats, count);
+      const IndexType idx = data_decoder_.GetRepeatedValue(num_to_consume);
+      if (UNLIKELY(idx >= dict_len)) return false;
+      out.SetNext(dict_[idx], num_to_consume);
+      if (entry_rejected[idx]) memset(rows_rejected, 1, num_to_consume);
+      rows_rejected += num_to_consume;
+      count -= num_to_consume;
+      continue;
+    }
+    uint32_t num_literals = data_decoder_.NextNumLiterals();
+    if (UNLIKELY(num_literals == 0)) return false;
+    int num_to_consume = std::min<uint32_t>(
+        std::min<uint32_t>(num_literals, count), DICT_DECODER_BUFFER_SIZE);
+    if (UNLIKELY(!data_decoder_.GetLiteralValues(num_to_consume, indexes))) return false;
+    // Validate the indexes first so that the loop below has no early exit and can be
+    // vectorized.
+    IndexType max_idx = 0;
+    for (int i = 0; i < num_to_consume; ++i) max_idx = std::max(max_idx, indexes[i]);
+    if (UNLIKELY(max_idx >= dict_len)) return false;
+    for (int i = 0; i < num_to_consume; ++i) {
+      rows_rejected[i] |= entry_rejected[indexes[i]];
+    }
+    for (int i = 0; i < num_to_consume; ++i) out.SetNext(dict_[indexes[i]]);
+    rows_rejected += num_to_consume;
+    count -= num_to_consume;
+  }
+  return true;
+}
+
 template <typename T>
 ALWAYS_INLINE inline bool DictDecoder<T>::SkipValues(int64_t num_values) {
   int64_t num_remaining = num_values;
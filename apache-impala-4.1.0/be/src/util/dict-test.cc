@@ -418,6 +418,132 @@ TEST(DictTest, TestGetNextValuesAndSkippingFuzzy) {
   }
 }
 
+// Checks that GetNextValuesAndRejectRows() returns the same values as GetNextValues()
+// and marks exactly the rows whose values come from rejected entries, also when mixed
+// with the other functions that buffer decoded values.
+TEST(DictTest, TestGetNextValuesAndRejectRowsFuzzy) {
+  const int values_size = 8192;
+  const int rounds = 100;
+  MemTracker tracker;
+  MemTracker track_encoder;
+  MemTracker track_decoder;
+  MemPool pool(&tracker);
+  DictEncoder<int> dict_encoder(&pool, sizeof(int), &track_encoder);
+
+  std::default_random_engine random_eng;
+  RandTestUtil::SeedRng("DICT_TEST_SEED", &random_eng);
+
+  // Generates random number between 'bottom' and 'top' (inclusive intervals).
+  auto GetRandom = [&random_eng](int bottom, int top) {
+    std::uniform_int_distribution<int> uni_dist(bottom, top);
+    return uni_dist(random_eng);
+  };
+
+  vector<int> values = MakeRandomSequence(random_eng, values_size, 200, 10);
+  for (int val : values) {
+    dict_encoder.Put(val);
+  }
+
+  vector<uint8_t> data_buffer(dict_encoder.EstimatedDataEncodedSize() * 2);
+  int data_len = dict_encoder.WriteData(data_buffer.data(), data_buffer.size());
+  ASSERT_GT(data_len, 0);
+
+  vector<uint8_t> dict_buffer(dict_encoder.dict_encoded_size());
+  dict_encoder.WriteDict(dict_buffer.data());
+  dict_encoder.Close();
+
+  DictDecoder<int> decoder(&track_decoder);
+  ASSERT_TRUE(decoder.template Reset<parquet::Type::INT32>(
+      dict_buffer.data(), dict_buffer.size(), sizeof(int)));
+
+  // Reject the entries with odd values.
+  vector<uint8_t> entry_rejected(decoder.num_entries());
+  for (int i = 0; i < decoder.num_entries(); ++i) {
+    int val;
+    decoder.GetValue(i, &val);
+    entry_rejected[i] = val % 2 != 0;
+  }
+
+  vector<int32_t> decoded_values(values.size());
+  vector<uint8_t> rows_rejected(values.size());
+  for (int round = 0; round < rounds; ++round) {
+    ASSERT_OK(decoder.SetData(data_buffer.data(), data_buffer.size()));
+    std::fill(rows_rejected.begin(), rows_rejected.end(), 0);
+    int i = 0;
+    while (i < values.size()) {
+      int length = GetRandom(1, 200);
+      if (i + length > values.size()) length = values.size() - i;
+      int method = GetRandom(0, 2);
+      if (method == 0) {
+        ASSERT_TRUE(decoder.GetNextValue(&decoded_values[i]));
+        length = 1;
+      } else if (method == 1) {
+        ASSERT_TRUE(decoder.GetNextValues(&decoded_values[i], sizeof(int32_t), length));
+      } else {
+        ASSERT_TRUE(decoder.GetNextValuesAndRejectRows(&decoded_values[i],
+            sizeof(int32_t), length, entry_rejected.data(), &rows_rejected[i]));
+        for (int j = 0; j < length; ++j) {
+          // Rows of buffered values may not be marked, but a marked row must always
+          // hold a rejected value.
+          if (rows_rejected[i + j]) EXPECT_NE(0, values[i + j] % 2);
+        }
+      }
+      for (int j = 0; j < length; ++j) {
+        EXPECT_EQ(values[i + j], decoded_values[i + j]);
+      }
+      i += length;
+    }
+  }
+}
+
+// Checks that all rejected rows are marked if the decoder did not buffer values.
+TEST(DictTest, TestGetNextValuesAndRejectRows) {
+  MemTracker tracker;
+  MemTracker track_encoder;
+  MemTracker track_decoder;
+  MemPool pool(&tracker);
+  DictEncoder<int> dict_encoder(&pool, sizeof(int), &track_encoder);
+  vector<int> values;
+  // Mix repeated runs and literal runs.
+  for (int i = 0; i < 100; ++i) values.push_back(1);
+  for (int i = 0; i < 1000; ++i) values.push_back(i % 7);
+  for (int i = 0; i < 50; ++i) values.push_back(2);
+  for (int val : values) dict_encoder.Put(val);
+
+  vector<uint8_t> data_buffer(dict_encoder.EstimatedDataEncodedSize() * 2);
+  int data_len = dict_encoder.WriteData(data_buffer.data(), data_buffer.size());
+  ASSERT_GT(data_len, 0);
+  vector<uint8_t> dict_buffer(dict_encoder.dict_encoded_size());
+  dict_encoder.WriteDict(dict_buffer.data());
+  dict_encoder.Close();
+
+  DictDecoder<int> decoder(&track_decoder);
+  ASSERT_TRUE(decoder.template Reset<parquet::Type::INT32>(
+      dict_buffer.data(), dict_buffer.size(), sizeof(int)));
+  vector<uint8_t> entry_rejected(decoder.num_entries());
+  for (int i = 0; i < decoder.num_entries(); ++i) {
+    int val;
+    decoder.GetValue(i, &val);
+    entry_rejected[i] = val != 2;
+  }
+
+  ASSERT_OK(decoder.SetData(data_buffer.data(), data_len));
+  vector<int32_t> decoded_values(values.size());
+  vector<uint8_t> rows_rejected(values.size(), 0);
+  // Use batch sizes that end in the middle of runs.
+  int i = 0;
+  while (i < values.size()) {
+    int length = min<int>(values.size() - i, 77);
+    ASSERT_TRUE(decoder.GetNextValuesAndRejectRows(&decoded_values[i], sizeof(int32_t),
+        length, entry_rejected.data(), &rows_rejected[i]));
+    i += length;
+  }
+  for (int j = 0; j < values.size(); ++j) {
+    EXPECT_EQ(values[j], decoded_values[j]) << j;
+    EXPECT_EQ(values[j] != 2, rows_rejected[j] != 0) << j;
+  }
+}
+
 TEST(DictTest, TestSkippingValues) {
   auto ValidateSkipping = [](const vector<int32_t>& values,
       const vector<int32_t>& dict_values, int skip_at, int skip_count,
@@ -0,0 +1,65 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include "testutil/gtest-util.h"
+#include "util/frequency-sketch.h"
+#include "util/hash-util.h"
+
+#include "common/names.h"
+
+namespace impala {
+
+static uint64_t Hash(int64_t key) {
+  return HashUtil::FastHash64(&key, sizeof(key), 0);
+}
+
+TEST(FrequencySketch, Basic) {
+  FrequencySketch sketch(1024);
+  EXPECT_EQ(0, sketch.Frequency(Hash(1)));
+  for (int i = 0; i < 5; ++i) sketch.Increment(Hash(1));
+  EXPECT_EQ(5, sketch.Frequency(Hash(1)));
+  // Counters saturate.
+  for (int i = 0; i < 100; ++i) sketch.Increment(Hash(2));
+  EXPECT_EQ(FrequencySketch::MAX_FREQUENCY, sketch.Frequency(Hash(2)));
+}
+
+// Frequent keys stand out from a scan of keys that are each accessed once, and the
+// counters of the frequent keys are aged as the scan goes on.
+TEST(FrequencySketch, ScanResistance) {
+  FrequencySketch sketch(1024);
+  for (int i = 0; i < 8; ++i) {
+    for (int key = 0; key < 10; ++key) sketch.Increment(Hash(key));
+  }
+  // Less than the sample size of 10240 increments, so there is no aging yet.
+  for (int key = 1000; key < 3000; ++key) sketch.Increment(Hash(key));
+  int scanned_max = 0;
+  for (int key = 1000; key < 3000; ++key) {
+    scanned_max = max(scanned_max, sketch.Frequency(Hash(key)));
+  }
+  for (int key = 0; key < 10; ++key) {
+    EXPECT_GE(sketch.Frequency(Hash(key)), 8);
+    EXPECT_GT(sketch.Frequency(Hash(key)), scanned_max);
+  }
+  // Reaching the sample size halves all counters, including the saturated ones.
+  for (int key = 3000; key < 11160; ++key) sketch.Increment(Hash(key));
+  for (int key = 0; key < 10; ++key) {
+    EXPECT_GE(sketch.Frequency(Hash(key)), 4);
+    EXPECT_LT(sketch.Frequency(Hash(key)), 8);
+  }
+}
+
+}
@@ -0,0 +1,88 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include "util/frequency-sketch.h"
+
+#include <algorithm>
+
+#include "common/logging.h"
+#include "util/bit-util.h"
+
+#include "common/names.h"
+
+namespace impala {
+
+// Odd multipliers to derive independent hash values for the rows from one hash value.
+static const uint64_t ROW_SEEDS[] = {
+    0x97cb3127e2b3d01bULL, 0xc2b2ae3d27d4eb4fULL, 0x165667b19e3779f9ULL,
+    0x9e3779b97f4a7c15ULL};
+
+FrequencySketch::FrequencySketch(int64_t num_counters)
+  : num_counters_(BitUtil::RoundUpToPowerOfTwo(
+        max<int64_t>(num_counters, COUNTERS_PER_WORD))),
+    sample_size_(10 * num_counters_),
+    table_(new std::atomic<uint64_t>[DEPTH * num_counters_ / COUNTERS_PER_WORD]) {
+  static_assert(sizeof(ROW_SEEDS) / sizeof(ROW_SEEDS[0]) == DEPTH, "One seed per row");
+  for (int64_t i = 0; i < DEPTH * num_counters_ / COUNTERS_PER_WORD; ++i) {
+    table_[i].store(0, std::memory_order_relaxed);
+  }
+}
+
+int64_t FrequencySketch::CounterIndex(uint64_t hash, int row) const {
+  uint64_t h = hash * ROW_SEEDS[row];
+  h ^= h >> 32;
+  return row * num_counters_ + (h & (num_counters_ - 1));
+}
+
+void FrequencySketch::Increment(uint64_t hash) {
+  for (int row = 0; row < DEPTH; ++row) {
+    int64_t idx = CounterIndex(hash, row);
+    std::atomic<uint64_t>* word = &table_[idx / COUNTERS_PER_WORD];
+    const int shift = (idx % COUNTERS_PER_WORD) * 4;
+    uint64_t old_word = word->load(std::memory_order_relaxed);
+    while (((old_word >> shift) & 0xf) < MAX_FREQUENCY
+        && !word->compare_exchange_weak(old_word, old_word + (1ULL << shift),
+            std::memory_order_relaxed)) {
+    }
+  }
+  // Only the thread which reaches the sample size ages the counters.
+  if (num_increments_.fetch_add(1, std::memory_order_relaxed) + 1 == sample_size_) Age();
+}
+
+int FrequencySketch::Frequency(uint64_t hash) const {
+  int frequency = MAX_FREQUENCY;
+  for (int row = 0; row < DEPTH; ++row) {
+    int64_t idx = CounterIndex(hash, row);
+    uint64_t word = table_[idx / COUNTERS_PER_WORD].load(std::memory_order_relaxed);
+    frequency = min<int>(frequency, (word >> ((idx % COUNTERS_PER_WORD) * 4)) & 0xf);
+  }
+  return frequency;
+}
+
+void FrequencySketch::Age() {
+  for (int64_t i = 0; i < DEPTH * num_counters_ / COUNTERS_PER_WORD; ++i) {
+    // Halve all 16 counters of the word at once by shifting and masking out the bit
+    // shifted in from the next counter.
+    uint64_t old_word = table_[i].load(std::memory_order_relaxed);
+    while (!table_[i].compare_exchange_weak(old_word,
+        (old_word >> 1) & 0x7777777777777777ULL, std::memory_order_relaxed)) {
+    }
+  }
+  num_increments_.store(sample_size_ / 2, std::memory_order_relaxed);
+}
+
+}
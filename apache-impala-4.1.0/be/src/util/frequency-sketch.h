@@ -0,0 +1,80 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+
+#include "gutil/macros.h"
+
+namespace impala {
+
+/// Approximate counter of the access frequencies of a large set of keys in a small,
+/// fixed amount of memory. This is the frequency sketch of the TinyLFU cache admission
+/// policy: a count-min sketch with 'DEPTH' rows of 4-bit saturating counters. The
+/// frequency of a key is the minimum of its counters in all rows.
+///
+/// To let the frequencies reflect recent accesses, all counters are halved after every
+/// 'sample_size' increments ("aging"). The sample size is 10 times the number of
+/// counters per row, which bounds the error of the estimates.
+///
+/// Thread-safe. Concurrent increments of a counter are never lost, but increments
+/// racing with the halving of the counters may be. This is acceptable for an estimate.
+class FrequencySketch {
+ public:
+  /// Creates a sketch with 'num_counters' counters per row, rounded up to a power of
+  /// two. The sketch uses DEPTH * num_counters / 2 bytes of memory.
+  explicit FrequencySketch(int64_t num_counters);
+
+  /// Records an access to the key with hash value 'hash'.
+  void Increment(uint64_t hash);
+
+  /// Returns the estimated number of accesses to the key with hash value 'hash' since
+  /// the counters were last halved, between 0 and MAX_FREQUENCY.
+  int Frequency(uint64_t hash) const;
+
+  static constexpr int MAX_FREQUENCY = 15;
+
+ private:
+  static constexpr int DEPTH = 4;
+  static constexpr int COUNTERS_PER_WORD = 16;
+
+  /// Returns the index of the counter of 'hash' in row 'row'.
+  int64_t CounterIndex(uint64_t hash, int row) const;
+
+  /// Halves all counters.
+  void Age();
+
+  /// Number of counters per row, a power of two.
+  const int64_t num_counters_;
+
+  /// Number of increments after which the counters are halved.
+  const int64_t sample_size_;
+
+  /// The counters of all rows. Row 'i' holds the counters
+  /// [i * num_counters_, (i + 1) * num_counters_), packed 16 per word.
+  std::unique_ptr<std::atomic<uint64_t>[]> table_;
+
+  /// Number of increments since the counters were last halved.
+  std::atomic<int64_t> num_increments_{0};
+
+  DISALLOW_COPY_AND_ASSIGN(FrequencySketch);
+};
+
+}
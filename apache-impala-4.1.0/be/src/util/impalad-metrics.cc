@@ -79,8 +79,40 @@ const char* ImpaladMetricKeys::IO_MGR_REMOTE_DATA_CACHE_DROPPED_ENTRIES =
     "impala-server.io-mgr.remote-data-cache-dropped-entries";
 const char* ImpaladMetricKeys::IO_MGR_REMOTE_DATA_CACHE_INSTANT_EVICTIONS =
     "impala-server.io-mgr.remote-data-cache-instant-evictions";
+const char* ImpaladMetricKeys::IO_MGR_REMOTE_DATA_CACHE_ADMISSION_REJECTED_BYTES =
+    "impala-server.io-mgr.remote-data-cache-admission-rejected-bytes";
+const char* ImpaladMetricKeys::IO_MGR_REMOTE_DATA_CACHE_ADMISSION_REJECTED_ENTRIES =
+    "impala-server.io-mgr.remote-data-cache-admission-rejected-entries";
+const char* ImpaladMetricKeys::IO_MGR_REMOTE_DATA_CACHE_RELOADED_ENTRIES =
+    "impala-server.io-mgr.remote-data-cache-reloaded-entries";
+const char* ImpaladMetricKeys::IO_MGR_REMOTE_DATA_CACHE_MEMORY_HIT_BYTES =
+    "impala-server.io-mgr.remote-data-cache-memory-hit-bytes";
+const char* ImpaladMetricKeys::IO_MGR_REMOTE_DATA_CACHE_MEMORY_HIT_COUNT =
+    "impala-server.io-mgr.remote-data-cache-memory-hit-count";
+const char* ImpaladMetricKeys::IO_MGR_REMOTE_DATA_CACHE_MEMORY_TOTAL_BYTES =
+    "impala-server.io-mgr.remote-data-cache-memory-total-bytes";
+const char* ImpaladMetricKeys::IO_MGR_REMOTE_DATA_CACHE_NUM_ASYNC_WRITES_OUTSTANDING =
+    "impala-server.io-mgr.remote-data-cache-num-async-writes-outstanding";
+const char* ImpaladMetricKeys::IO_MGR_REMOTE_DATA_CACHE_ASYNC_WRITES_OUTSTANDING_BYTES =
+    "impala-server.io-mgr.remote-data-cache-async-writes-outstanding-bytes";
+const char* ImpaladMetricKeys::IO_MGR_REMOTE_DATA_CACHE_ASYNC_WRITES_DROPPED_BYTES =
+    "impala-server.io-mgr.remote-data-cache-async-writes-dropped-bytes";
+const char* ImpaladMetricKeys::IO_MGR_REMOTE_DATA_CACHE_ASYNC_WRITES_DROPPED_ENTRIES =
+    "impala-server.io-mgr.remote-data-cache-async-writes-dropped-entries";
 const char* ImpaladMetricKeys::IO_MGR_BYTES_WRITTEN =
     "impala-server.io-mgr.bytes-written";
+const char* ImpaladMetricKeys::IO_MGR_DIRECT_IO_BYTES_READ =
+    "impala-server.io-mgr.direct-io-bytes-read";
+const char* ImpaladMetricKeys::IO_MGR_DIRECT_IO_BYTES_WRITTEN =
+    "impala-server.io-mgr.direct-io-bytes-written";
+const char* ImpaladMetricKeys::IO_MGR_NUM_COALESCED_READS =
+    "impala-server.io-mgr.num-coalesced-reads";
+const char* ImpaladMetricKeys::IO_MGR_NUM_COALESCED_SCAN_RANGES =
+    "impala-server.io-mgr.num-coalesced-scan-ranges";
+const char* ImpaladMetricKeys::IO_MGR_NUM_HEDGED_READS =
+    "impala-server.io-mgr.num-hedged-reads";
+const char* ImpaladMetricKeys::IO_MGR_NUM_HEDGED_READS_WON =
+    "impala-server.io-mgr.num-hedged-reads-won";
 const char* ImpaladMetricKeys::IO_MGR_NUM_CACHED_FILE_HANDLES =
     "impala-server.io.mgr.num-cached-file-handles";
 const char* ImpaladMetricKeys::IO_MGR_NUM_FILE_HANDLES_OUTSTANDING =
@@ -175,7 +207,22 @@ IntCounter* ImpaladMetrics::IO_MGR_REMOTE_DATA_CACHE_NUM_WRITES = nullptr;
 IntCounter* ImpaladMetrics::IO_MGR_REMOTE_DATA_CACHE_DROPPED_BYTES = nullptr;
 IntCounter* ImpaladMetrics::IO_MGR_REMOTE_DATA_CACHE_DROPPED_ENTRIES = nullptr;
 IntCounter* ImpaladMetrics::IO_MGR_REMOTE_DATA_CACHE_INSTANT_EVICTIONS = nullptr;
+IntCounter* ImpaladMetrics::IO_MGR_REMOTE_DATA_CACHE_ADMISSION_REJECTED_BYTES = nullptr;
+IntCounter* ImpaladMetrics::IO_MGR_REMOTE_DATA_CACHE_ADMISSION_REJECTED_ENTRIES =
+    nullptr;
+IntCounter* ImpaladMetrics::IO_MGR_REMOTE_DATA_CACHE_RELOADED_ENTRIES = nullptr;
+IntCounter* ImpaladMetrics::IO_MGR_REMOTE_DATA_CACHE_MEMORY_HIT_BYTES = nullptr;
+IntCounter* ImpaladMetrics::IO_MGR_REMOTE_DATA_CACHE_MEMORY_HIT_COUNT = nullptr;
+IntCounter* ImpaladMetrics::IO_MGR_REMOTE_DATA_CACHE_ASYNC_WRITES_DROPPED_BYTES = nullptr;
+IntCounter* ImpaladMetrics::IO_MGR_REMOTE_DATA_CACHE_ASYNC_WRITES_DROPPED_ENTRIES =
+    nullptr;
 IntCounter* ImpaladMetrics::IO_MGR_BYTES_WRITTEN = nullptr;
+IntCounter* ImpaladMetrics::IO_MGR_DIRECT_IO_BYTES_READ = nullptr;
+IntCounter* ImpaladMetrics::IO_MGR_DIRECT_IO_BYTES_WRITTEN = nullptr;
+IntCounter* ImpaladMetrics::IO_MGR_NUM_COALESCED_READS = nullptr;
+IntCounter* ImpaladMetrics::IO_MGR_NUM_COALESCED_SCAN_RANGES = nullptr;
+IntCounter* ImpaladMetrics::IO_MGR_NUM_HEDGED_READS = nullptr;
+IntCounter* ImpaladMetrics::IO_MGR_NUM_HEDGED_READS_WON = nullptr;
 IntCounter* ImpaladMetrics::IO_MGR_CACHED_FILE_HANDLES_REOPENED = nullptr;
 IntCounter* ImpaladMetrics::HEDGED_READ_OPS = nullptr;
 IntCounter* ImpaladMetrics::HEDGED_READ_OPS_WIN = nullptr;
@@ -207,6 +254,10 @@ IntGauge* ImpaladMetrics::IO_MGR_CACHED_FILE_HANDLES_HIT_COUNT = nullptr;
 IntGauge* ImpaladMetrics::IO_MGR_CACHED_FILE_HANDLES_MISS_COUNT = nullptr;
 IntGauge* ImpaladMetrics::IO_MGR_REMOTE_DATA_CACHE_TOTAL_BYTES = nullptr;
 IntGauge* ImpaladMetrics::IO_MGR_REMOTE_DATA_CACHE_NUM_ENTRIES = nullptr;
+IntGauge* ImpaladMetrics::IO_MGR_REMOTE_DATA_CACHE_MEMORY_TOTAL_BYTES = nullptr;
+IntGauge* ImpaladMetrics::IO_MGR_REMOTE_DATA_CACHE_NUM_ASYNC_WRITES_OUTSTANDING = nullptr;
+IntGauge* ImpaladMetrics::IO_MGR_REMOTE_DATA_CACHE_ASYNC_WRITES_OUTSTANDING_BYTES =
+    nullptr;
 IntGauge* ImpaladMetrics::NUM_FILES_OPEN_FOR_INSERT = nullptr;
 IntGauge* ImpaladMetrics::NUM_QUERIES_REGISTERED = nullptr;
 IntGauge* ImpaladMetrics::RESULTSET_CACHE_TOTAL_NUM_ROWS = nullptr;
@@ -345,6 +396,18 @@ void ImpaladMetrics::CreateMetrics(MetricGroup* m) {
       ImpaladMetricKeys::IO_MGR_SHORT_CIRCUIT_BYTES_READ, 0);
   IO_MGR_BYTES_WRITTEN = IO_MGR_METRICS->AddCounter(
       ImpaladMetricKeys::IO_MGR_BYTES_WRITTEN, 0);
+  IO_MGR_DIRECT_IO_BYTES_READ = IO_MGR_METRICS->AddCounter(
+      ImpaladMetricKeys::IO_MGR_DIRECT_IO_BYTES_READ, 0);
+  IO_MGR_DIRECT_IO_BYTES_WRITTEN = IO_MGR_METRICS->AddCounter(
+      ImpaladMetricKeys::IO_MGR_DIRECT_IO_BYTES_WRITTEN, 0);
+  IO_MGR_NUM_COALESCED_READS = IO_MGR_METRICS->AddCounter(
+      ImpaladMetricKeys::IO_MGR_NUM_COALESCED_READS, 0);
+  IO_MGR_NUM_COALESCED_SCAN_RANGES = IO_MGR_METRICS->AddCounter(
+      ImpaladMetricKeys::IO_MGR_NUM_COALESCED_SCAN_RANGES, 0);
+  IO_MGR_NUM_HEDGED_READS = IO_MGR_METRICS->AddCounter(
+      ImpaladMetricKeys::IO_MGR_NUM_HEDGED_READS, 0);
+  IO_MGR_NUM_HEDGED_READS_WON = IO_MGR_METRICS->AddCounter(
+      ImpaladMetricKeys::IO_MGR_NUM_HEDGED_READS_WON, 0);
 
   IO_MGR_REMOTE_DATA_CACHE_HIT_BYTES = IO_MGR_METRICS->AddCounter(
       ImpaladMetricKeys::IO_MGR_REMOTE_DATA_CACHE_HIT_BYTES, 0);
@@ -366,6 +429,26 @@ void ImpaladMetrics::CreateMetrics(MetricGroup* m) {
       ImpaladMetricKeys::IO_MGR_REMOTE_DATA_CACHE_DROPPED_ENTRIES, 0);
   IO_MGR_REMOTE_DATA_CACHE_INSTANT_EVICTIONS = IO_MGR_METRICS->AddCounter(
       ImpaladMetricKeys::IO_MGR_REMOTE_DATA_CACHE_INSTANT_EVICTIONS, 0);
+  IO_MGR_REMOTE_DATA_CACHE_ADMISSION_REJECTED_BYTES = IO_MGR_METRICS->AddCounter(
+      ImpaladMetricKeys::IO_MGR_REMOTE_DATA_CACHE_ADMISSION_REJECTED_BYTES, 0);
+  IO_MGR_REMOTE_DATA_CACHE_ADMISSION_REJECTED_ENTRIES = IO_MGR_METRICS->AddCounter(
+      ImpaladMetricKeys::IO_MGR_REMOTE_DATA_CACHE_ADMISSION_REJECTED_ENTRIES, 0);
+  IO_MGR_REMOTE_DATA_CACHE_RELOADED_ENTRIES = IO_MGR_METRICS->AddCounter(
+      ImpaladMetricKeys::IO_MGR_REMOTE_DATA_CACHE_RELOADED_ENTRIES, 0);
+  IO_MGR_REMOTE_DATA_CACHE_MEMORY_HIT_BYTES = IO_MGR_METRICS->AddCounter(
+      ImpaladMetricKeys::IO_MGR_REMOTE_DATA_CACHE_MEMORY_HIT_BYTES, 0);
+  IO_MGR_REMOTE_DATA_CACHE_MEMORY_HIT_COUNT = IO_MGR_METRICS->AddCounter(
+      ImpaladMetricKeys::IO_MGR_REMOTE_DATA_CACHE_MEMORY_HIT_COUNT, 0);
+  IO_MGR_REMOTE_DATA_CACHE_MEMORY_TOTAL_BYTES = IO_MGR_METRICS->AddGauge(
+      ImpaladMetricKeys::IO_MGR_REMOTE_DATA_CACHE_MEMORY_TOTAL_BYTES, 0);
+  IO_MGR_REMOTE_DATA_CACHE_NUM_ASYNC_WRITES_OUTSTANDING = IO_MGR_METRICS->AddGauge(
+      ImpaladMetricKeys::IO_MGR_REMOTE_DATA_CACHE_NUM_ASYNC_WRITES_OUTSTANDING, 0);
+  IO_MGR_REMOTE_DATA_CACHE_ASYNC_WRITES_OUTSTANDING_BYTES = IO_MGR_METRICS->AddGauge(
+      ImpaladMetricKeys::IO_MGR_REMOTE_DATA_CACHE_ASYNC_WRITES_OUTSTANDING_BYTES, 0);
+  IO_MGR_REMOTE_DATA_CACHE_ASYNC_WRITES_DROPPED_BYTES = IO_MGR_METRICS->AddCounter(
+      ImpaladMetricKeys::IO_MGR_REMOTE_DATA_CACHE_ASYNC_WRITES_DROPPED_BYTES, 0);
+  IO_MGR_REMOTE_DATA_CACHE_ASYNC_WRITES_DROPPED_ENTRIES = IO_MGR_METRICS->AddCounter(
+      ImpaladMetricKeys::IO_MGR_REMOTE_DATA_CACHE_ASYNC_WRITES_DROPPED_ENTRIES, 0);
 
   IO_MGR_CACHED_FILE_HANDLES_HIT_RATIO =
       StatsMetric<uint64_t, StatsType::MEAN>::CreateAndRegister(IO_MGR_METRICS,
@@ -108,9 +108,54 @@ class ImpaladMetricKeys {
   /// Total number of entries evicted immediately from the remote data cache.
   static const char* IO_MGR_REMOTE_DATA_CACHE_INSTANT_EVICTIONS;
 
+  /// Total number of bytes and entries not inserted into the remote data cache because
+  /// the admission policy rejected them.
+  static const char* IO_MGR_REMOTE_DATA_CACHE_ADMISSION_REJECTED_BYTES;
+  static const char* IO_MGR_REMOTE_DATA_CACHE_ADMISSION_REJECTED_ENTRIES;
+
+  /// Total number of entries reloaded from checkpoints of the persistent remote data
+  /// cache.
+  static const char* IO_MGR_REMOTE_DATA_CACHE_RELOADED_ENTRIES;
+
+  /// Total number of bytes read from the in-memory tier of the remote data cache.
+  static const char* IO_MGR_REMOTE_DATA_CACHE_MEMORY_HIT_BYTES;
+
+  /// Total number of cache hits in the in-memory tier of the remote data cache.
+  static const char* IO_MGR_REMOTE_DATA_CACHE_MEMORY_HIT_COUNT;
+
+  /// Current byte size of the in-memory tier of the remote data cache.
+  static const char* IO_MGR_REMOTE_DATA_CACHE_MEMORY_TOTAL_BYTES;
+
+  /// Current number and total size in bytes of the insertions queued for asynchronous
+  /// writes into the remote data cache.
+  static const char* IO_MGR_REMOTE_DATA_CACHE_NUM_ASYNC_WRITES_OUTSTANDING;
+  static const char* IO_MGR_REMOTE_DATA_CACHE_ASYNC_WRITES_OUTSTANDING_BYTES;
+
+  /// Total number of bytes and entries not queued for asynchronous writes into the
+  /// remote data cache due to the limit on buffered bytes.
+  static const char* IO_MGR_REMOTE_DATA_CACHE_ASYNC_WRITES_DROPPED_BYTES;
+  static const char* IO_MGR_REMOTE_DATA_CACHE_ASYNC_WRITES_DROPPED_ENTRIES;
+
   /// Total number of bytes written to disk by the io mgr (for spilling)
   static const char* IO_MGR_BYTES_WRITTEN;
 
+  /// Total number of bytes of scratch files and data cache files read and written with
+  /// direct I/O, i.e. without going through the page cache.
+  static const char* IO_MGR_DIRECT_IO_BYTES_READ;
+  static const char* IO_MGR_DIRECT_IO_BYTES_WRITTEN;
+
+  /// Number of coalesced reads of remote scan ranges
+  static const char* IO_MGR_NUM_COALESCED_READS;
+
+  /// Number of remote scan ranges that were read as part of a coalesced read
+  static const char* IO_MGR_NUM_COALESCED_SCAN_RANGES;
+
+  /// Number of hedged reads of remote files issued by Impala
+  static const char* IO_MGR_NUM_HEDGED_READS;
+
+  /// Number of hedged reads that completed before the original read
+  static const char* IO_MGR_NUM_HEDGED_READS_WON;
+
   /// Number of unbuffered file handles cached by the io mgr
   static const char* IO_MGR_NUM_CACHED_FILE_HANDLES;
 
@@ -266,8 +311,21 @@ class ImpaladMetrics {
   static IntCounter* IO_MGR_REMOTE_DATA_CACHE_DROPPED_BYTES;
   static IntCounter* IO_MGR_REMOTE_DATA_CACHE_DROPPED_ENTRIES;
   static IntCounter* IO_MGR_REMOTE_DATA_CACHE_INSTANT_EVICTIONS;
+  static IntCounter* IO_MGR_REMOTE_DATA_CACHE_ADMISSION_REJECTED_BYTES;
+  static IntCounter* IO_MGR_REMOTE_DATA_CACHE_ADMISSION_REJECTED_ENTRIES;
+  static IntCounter* IO_MGR_REMOTE_DATA_CACHE_RELOADED_ENTRIES;
+  static IntCounter* IO_MGR_REMOTE_DATA_CACHE_MEMORY_HIT_BYTES;
+  static IntCounter* IO_MGR_REMOTE_DATA_CACHE_MEMORY_HIT_COUNT;
+  static IntCounter* IO_MGR_REMOTE_DATA_CACHE_ASYNC_WRITES_DROPPED_BYTES;
+  static IntCounter* IO_MGR_REMOTE_DATA_CACHE_ASYNC_WRITES_DROPPED_ENTRIES;
   static IntCounter* IO_MGR_SHORT_CIRCUIT_BYTES_READ;
   static IntCounter* IO_MGR_BYTES_WRITTEN;
+  static IntCounter* IO_MGR_DIRECT_IO_BYTES_READ;
+  static IntCounter* IO_MGR_DIRECT_IO_BYTES_WRITTEN;
+  static IntCounter* IO_MGR_NUM_COALESCED_READS;
+  static IntCounter* IO_MGR_NUM_COALESCED_SCAN_RANGES;
+  static IntCounter* IO_MGR_NUM_HEDGED_READS;
+  static IntCounter* IO_MGR_NUM_HEDGED_READS_WON;
   static IntCounter* IO_MGR_CACHED_FILE_HANDLES_REOPENED;
   static IntCounter* HEDGED_READ_OPS;
   static IntCounter* HEDGED_READ_OPS_WIN;
@@ -303,6 +361,9 @@ class ImpaladMetrics {
   static IntGauge* IO_MGR_CACHED_FILE_HANDLES_MISS_COUNT;
   static IntGauge* IO_MGR_REMOTE_DATA_CACHE_TOTAL_BYTES;
   static IntGauge* IO_MGR_REMOTE_DATA_CACHE_NUM_ENTRIES;
+  static IntGauge* IO_MGR_REMOTE_DATA_CACHE_MEMORY_TOTAL_BYTES;
+  static IntGauge* IO_MGR_REMOTE_DATA_CACHE_NUM_ASYNC_WRITES_OUTSTANDING;
+  static IntGauge* IO_MGR_REMOTE_DATA_CACHE_ASYNC_WRITES_OUTSTANDING_BYTES;
   static IntGauge* NUM_FILES_OPEN_FOR_INSERT;
   static IntGauge* NUM_QUERIES_REGISTERED;
   static IntGauge* RESULTSET_CACHE_TOTAL_NUM_ROWS;
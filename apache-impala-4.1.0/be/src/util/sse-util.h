@@ -42,6 +42,9 @@ namespace SSEUtil {
   static const int CHARS_PER_64_BIT_REGISTER = 8;
   static const int CHARS_PER_128_BIT_REGISTER = 16;
 
+  /// Number of characters that fit in a 256 bit AVX register.
+  static const int CHARS_PER_256_BIT_REGISTER = 32;
+
   /// SSE4.2 adds instructions for text processing.  The instructions have a control
   /// byte that determines some of functionality of the instruction.  (Equivalent to
   /// GCC's _SIDD_CMP_EQUAL_ANY, etc).
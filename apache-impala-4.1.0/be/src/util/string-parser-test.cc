@@ -257,6 +257,46 @@ TEST(StringToInt, Int8_Exhaustive) {
   }
 }
 
+TEST(StringToInt, EightDigitChunks) {
+  uint32_t val;
+  EXPECT_TRUE(StringParser::ParseEightDigits("00000000", &val));
+  EXPECT_EQ(0, val);
+  EXPECT_TRUE(StringParser::ParseEightDigits("12345678", &val));
+  EXPECT_EQ(12345678, val);
+  EXPECT_TRUE(StringParser::ParseEightDigits("99999999", &val));
+  EXPECT_EQ(99999999, val);
+  for (const char* s : {"1234567 ", "/1234567", "1234:678", "12a45678", "1234567\xff"}) {
+    EXPECT_FALSE(StringParser::ParseEightDigits(s, &val)) << s;
+  }
+
+  // Values that are parsed partly in chunks of 8 digits.
+  TestIntValue<int32_t>("12345678", 12345678, StringParser::PARSE_SUCCESS);
+  TestIntValue<int32_t>("-123456789", -123456789, StringParser::PARSE_SUCCESS);
+  TestIntValue<int64_t>("123456789012345678", 123456789012345678LL,
+      StringParser::PARSE_SUCCESS);
+  TestIntValue<int64_t>("-000000001234567890", -1234567890,
+      StringParser::PARSE_SUCCESS);
+  TestIntValue<int32_t>("1234567x", 0, StringParser::PARSE_FAILURE);
+  TestIntValue<int32_t>("12345678x", 0, StringParser::PARSE_FAILURE);
+  TestIntValue<int64_t>("12345678 9", 0, StringParser::PARSE_FAILURE);
+}
+
+TEST(StringToDecimal, EightDigitChunks) {
+  StringParser::ParseResult result;
+  const char* s = "1234567890123456.78";
+  Decimal8Value d8 = StringParser::StringToDecimal<int64_t>(
+      s, strlen(s), 18, 2, false, &result);
+  EXPECT_EQ(StringParser::PARSE_SUCCESS, result);
+  EXPECT_EQ(123456789012345678LL, d8.value());
+  s = "-12.34567890";
+  d8 = StringParser::StringToDecimal<int64_t>(s, strlen(s), 18, 8, false, &result);
+  EXPECT_EQ(StringParser::PARSE_SUCCESS, result);
+  EXPECT_EQ(-1234567890LL, d8.value());
+  s = "12345678901";
+  StringParser::StringToDecimal<int32_t>(s, strlen(s), 9, 0, false, &result);
+  EXPECT_EQ(StringParser::PARSE_OVERFLOW, result);
+}
+
 TEST(StringToIntWithBase, Basic) {
   TestIntValue<int8_t>("123", 10, 123, StringParser::PARSE_SUCCESS);
   TestIntValue<int16_t>("123", 10, 123, StringParser::PARSE_SUCCESS);
@@ -592,6 +632,8 @@ TEST(StringToDate, Basic) {
   TestDateValue("2018-01-0", invalid_date, StringParser::PARSE_FAILURE);
   TestDateValue("2018-01-32", invalid_date, StringParser::PARSE_FAILURE);
   TestDateValue("2019-02-39", invalid_date, StringParser::PARSE_FAILURE);
+  TestDateValue("2019-0a-10", invalid_date, StringParser::PARSE_FAILURE);
+  TestDateValue("2019-02-1:", invalid_date, StringParser::PARSE_FAILURE);
 
   // Leap year tests: 2100-02-29 doesn't exist but 2000-02-29 does.
   TestDateValue("2100-02-29", invalid_date, StringParser::PARSE_FAILURE);
@@ -19,6 +19,7 @@
 #ifndef IMPALA_UTIL_STRING_PARSER_H
 #define IMPALA_UTIL_STRING_PARSER_H
 
+#include <cstring>
 #include <limits>
 #include <boost/type_traits.hpp>
 #include "common/compiler-util.h"
@@ -48,12 +49,14 @@ namespace impala {
 /// for that data type.  This is different from hive, which returns NULL for overflow
 /// slots for int types and inf/-inf for float types.
 //
+/// Runs of 8 digits in integers and decimals are validated and converted at once with
+/// 64-bit arithmetic (see ParseEightDigits()), which is portable and can be cross
+/// compiled to IR.
+///
 /// Things we tried that did not work:
 ///  - lookup table for converting character to digit
 /// Improvements (TODO):
 ///  - Validate input using _sidd_compare_ranges
-///  - Since we know the length, we can parallelize this: i.e. result = 100*s[0] +
-///    10*s[1] + s[2]
 ///
 /// TODO: people went crazy with huge inline functions in this file - most should be
 /// moved out-of-line.
@@ -103,6 +106,28 @@ class StringParser {
     return StringToBoolInternal(s + i, len - i, result);
   }
 
+  /// Returns true if the 8 characters at 's' are all decimal digits and stores their
+  /// value in '*val'. All 8 characters are validated and converted at once by treating
+  /// them as a little-endian 64-bit integer, i.e. SIMD within a register.
+  static inline bool ParseEightDigits(const char* s, uint32_t* val) {
+    const uint64_t ZEROS = 0x3030303030303030ULL;
+    const uint64_t HIGH_NIBBLES = 0xF0F0F0F0F0F0F0F0ULL;
+    uint64_t chunk;
+    memcpy(&chunk, s, sizeof(chunk));
+    // A byte is a digit if its high nibble is 3 both before and after adding 6. Adding
+    // 6 cannot carry into the next byte once the first check passed.
+    if ((chunk & HIGH_NIBBLES) != ZEROS) return false;
+    if (((chunk + 0x0606060606060606ULL) & HIGH_NIBBLES) != ZEROS) return false;
+    chunk -= ZEROS;
+    // Combine adjacent digits into 2-digit values in every other byte, then 2-digit
+    // values into 4-digit values and finally the two 4-digit values into the result.
+    chunk = (chunk * 10) + (chunk >> 8);
+    chunk = (((chunk & 0x000000FF000000FFULL) * (100 + (1000000ULL << 32)))
+        + (((chunk >> 16) & 0x000000FF000000FFULL) * (1 + (10000ULL << 32)))) >> 32;
+    *val = static_cast<uint32_t>(chunk);
+    return true;
+  }
+
   /// Parse a TimestampValue from s.
   static inline TimestampValue StringToTimestamp(const char* s, int len,
       ParseResult* result) {
@@ -191,6 +216,17 @@ class StringParser {
     int first_truncated_digit = 0;
     T value = 0;
     for (int i = 0; i < len; ++i) {
+      // Consume 8 digits at once if they all fit into the type's precision.
+      uint32_t eight_digits;
+      if (total_digits_count + 8 <= type_precision && len - i >= 8
+          && ParseEightDigits(s + i, &eight_digits)) {
+        found_value = true;
+        value = (value * 100000000) + eight_digits;
+        total_digits_count += 8;
+        digits_after_dot_count += 8 * found_dot;
+        i += 7;
+        continue;
+      }
       const char c = s[i];
       if (LIKELY('0' <= c && c <= '9')) {
         found_value = true;
@@ -639,14 +675,25 @@ class StringParser {
       *result = PARSE_SUCCESS;
       return val;
     }
-    // Factor out the first char for error handling speeds up the loop.
-    if (LIKELY(s[0] >= '0' && s[0] <= '9')) {
-      val = s[0] - '0';
-    } else {
-      *result = PARSE_FAILURE;
-      return 0;
+    int i = 0;
+    // Consume leading runs of 8 digits at once. The loop below handles the rest,
+    // including a chunk that contains a non-digit.
+    uint32_t eight_digits;
+    while (len - i >= 8 && ParseEightDigits(s + i, &eight_digits)) {
+      val = val * 100000000 + eight_digits;
+      i += 8;
+    }
+    if (i == 0) {
+      // Factor out the first char for error handling speeds up the loop.
+      if (LIKELY(s[0] >= '0' && s[0] <= '9')) {
+        val = s[0] - '0';
+      } else {
+        *result = PARSE_FAILURE;
+        return 0;
+      }
+      i = 1;
     }
-    for (int i = 1; i < len; ++i) {
+    for (; i < len; ++i) {
       if (LIKELY(s[i] >= '0' && s[i] <= '9')) {
         T digit = s[i] - '0';
         val = val * 10 + digit;
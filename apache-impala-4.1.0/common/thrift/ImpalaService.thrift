@@ -733,6 +733,25 @@ enum TImpalaQueryOptions {
 
   // Maximum wait time on HMS ACID lock in seconds.
   LOCK_MAX_WAIT_TIME_S = 145
+
+  // Number of helper threads an analytic eval node may use to evaluate complete
+  // partitions of an input batch in parallel. Only applies to analytic functions
+  // evaluated over an entire partition (PARTITION BY without ORDER BY or window).
+  // Set to 0 to evaluate all partitions in the fragment instance thread. The threads
+  // are included in the thread reservation of the query and are only started if the
+  // thread quota of the impalad allows it.
+  NUM_ANALYTIC_EVAL_THREADS = 146
+
+  // If true, the Parquet scanner evaluates dictionary filter conjuncts once per
+  // dictionary entry of a dictionary-encoded column and rejects rows by their
+  // dictionary code before evaluating the scan's conjuncts on them. Only has an effect
+  // if PARQUET_DICTIONARY_FILTERING is also enabled.
+  PARQUET_DICTIONARY_CODE_FILTERING = 147
+
+  // Number of minimum consecutive rows when filtered out, will avoid materialization
+  // of the columns not referenced by conjuncts or runtime filters in ORC. Set it to -1
+  // to turn off late materialization for ORC.
+  ORC_LATE_MATERIALIZATION_THRESHOLD = 148
 }
 
 // The summary of a DML statement.
@@ -591,6 +591,15 @@ struct TQueryOptions {
 
   // See comment in ImpalaService.thrift
   146: optional i32 lock_max_wait_time_s = 300
+
+  // See comment in ImpalaService.thrift
+  147: optional i32 num_analytic_eval_threads = 0;
+
+  // See comment in ImpalaService.thrift
+  148: optional bool parquet_dictionary_code_filtering = true;
+
+  // See comment in ImpalaService.thrift
+  149: optional i32 orc_late_materialization_threshold = 20;
 }
 
 // Impala currently has three types of sessions: Beeswax, HiveServer2 and external
@@ -373,7 +373,24 @@ public class AnalyticEvalNode extends PlanNode {
     nodeResourceProfile_ = new ResourceProfileBuilder()
         .setMemEstimateBytes(perInstanceMemEstimate)
         .setMinMemReservationBytes(perInstanceMinMemReservation)
-        .setSpillableBufferBytes(bufferSize).setMaxRowBufferBytes(bufferSize).build();
+        .setSpillableBufferBytes(bufferSize).setMaxRowBufferBytes(bufferSize)
+        .setThreadReservation(getNumEvalHelperThreads(queryOptions)).build();
+  }
+
+  /**
+   * Returns the number of helper threads that the backend starts to evaluate complete
+   * partitions in parallel (see NUM_ANALYTIC_EVAL_THREADS). Helpers are only used if
+   * the functions are evaluated over entire partitions, i.e. there is a PARTITION BY
+   * clause but no ORDER BY clause or window. Must be kept in sync with
+   * AnalyticEvalNode::Open() in be.
+   */
+  private int getNumEvalHelperThreads(TQueryOptions queryOptions) {
+    if (!queryOptions.isSetNum_analytic_eval_threads()) return 0;
+    if (partitionByEq_ == null || !orderByElements_.isEmpty()
+        || analyticWindow_ != null) {
+      return 0;
+    }
+    return Math.max(0, queryOptions.getNum_analytic_eval_threads());
   }
 
   public static class LimitPushdownInfo {
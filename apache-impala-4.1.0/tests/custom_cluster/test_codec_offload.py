@@ -0,0 +1,145 @@
+# Licensed to the Apache Software Foundation (ASF) under one
+# or more contributor license agreements.  See the NOTICE file
+# distributed with this work for additional information
+# regarding copyright ownership.  The ASF licenses this file
+# to you under the Apache License, Version 2.0 (the
+# "License"); you may not use this file except in compliance
+# with the License.  You may obtain a copy of the License at
+#
+#   http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing,
+# software distributed under the License is distributed on an
+# "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+# KIND, either express or implied.  See the License for the
+# specific language governing permissions and limitations
+# under the License.
+#
+# Tests for compressing and decompressing data on the codec offload pool.
+
+import bz2
+import hashlib
+import re
+import zlib
+
+from tests.common.custom_cluster_test_suite import CustomClusterTestSuite
+
+
+class TestCodecOffload(CustomClusterTestSuite):
+  """Checks that scanners and writers return the same results when they hand
+  compression and decompression to the codec offload pool (--codec_offload_threads)
+  and that the pool is actually used."""
+
+  @classmethod
+  def get_workload(cls):
+    return 'functional-query'
+
+  def _get_counter_sum(self, profile, counter_name):
+    """Returns the sum of all values of 'counter_name' in 'profile'."""
+    return sum(int(value) for value in
+        re.findall(r'\b%s: [^\n]*\((\d+)\)' % counter_name, profile))
+
+  def _check_same_results(self, query, table, baseline_table, query_options=None):
+    """Runs 'query' against 'table' and 'baseline_table' and checks that both return the
+    same rows. Returns the profile of the query against 'table'."""
+    result = self.execute_query(query.format(table), query_options)
+    baseline = self.execute_query(query.format(baseline_table), query_options)
+    assert sorted(result.data) == sorted(baseline.data), query
+    return result.runtime_profile
+
+  @CustomClusterTestSuite.with_args("--codec_offload_threads=4")
+  def test_parquet_page_decompression(self, vector):
+    """Compares snappy compressed Parquet scans with the text table, with and without
+    late materialization of the non-filter columns."""
+    queries = [
+        "select count(*), sum(l_quantity), max(l_comment), min(l_shipdate) from {0}",
+        "select l_orderkey, l_linenumber, l_comment from {0} "
+        "where l_orderkey % 10007 = 3",
+        "select count(*), sum(l_extendedprice), max(l_comment) from {0} "
+        "where l_shipmode = 'AIR' and l_quantity > 45"]
+    for query in queries:
+      for threshold in [-1, 20]:
+        profile = self._check_same_results(query, "tpch_parquet.lineitem",
+            "tpch.lineitem", {'parquet_late_materialization_threshold': threshold})
+        if threshold < 0:
+          assert self._get_counter_sum(profile, "NumPagesDecompressedAsync") > 0, query
+
+  @CustomClusterTestSuite.with_args("--codec_offload_threads=4")
+  def test_parquet_page_compression(self, vector, unique_database):
+    """Writes Parquet tables with each codec and checks that they read back the same
+    data as the source table."""
+    query = ("select count(*), sum(o_orderkey), sum(o_custkey), sum(o_totalprice), "
+        "min(o_orderdate), max(o_orderpriority), sum(o_shippriority), "
+        "count(distinct o_clerk), sum(length(o_comment)), sum(fnv_hash(o_comment)) "
+        "from {0}")
+    for codec in ['snappy', 'gzip', 'zstd', 'lz4', 'none']:
+      table = "{0}.orders_{1}".format(unique_database, codec)
+      result = self.execute_query("create table {0} stored as parquet as "
+          "select * from tpch.orders".format(table), {'compression_codec': codec})
+      if codec != 'none':
+        assert self._get_counter_sum(result.runtime_profile,
+            "NumPagesCompressedAsync") > 0, codec
+      self._check_same_results(query, table, "tpch.orders")
+
+  @CustomClusterTestSuite.with_args("--codec_offload_threads=1")
+  def test_parquet_page_compression_pool_busy(self, vector, unique_database):
+    """Writes a wide table with a single pool thread. All columns finalize their pages
+    when the row group is flushed, which fills the queue of the pool, so that most pages
+    are compressed on the sink thread."""
+    table = "{0}.widetable".format(unique_database)
+    result = self.execute_query("create table {0} stored as parquet as "
+        "select * from functional_parquet.widetable_1000_cols".format(table),
+        {'compression_codec': 'snappy'})
+    assert self._get_counter_sum(result.runtime_profile,
+        "NumPagesCompressedAsync") > 0
+    assert self._get_counter_sum(result.runtime_profile,
+        "NumPagesNotCompressedAsync") > 0
+    self._check_same_results("select * from {0}", table,
+        "functional_parquet.widetable_1000_cols")
+
+  @CustomClusterTestSuite.with_args("--codec_offload_threads=4")
+  def test_avro_block_decompression(self, vector):
+    """Compares scans of a multi-block snappy compressed Avro table with the text table.
+    The memory limit makes sure that blocks are only decompressed ahead from buffered
+    data instead of buffering the rest of the scan range."""
+    query_options = {'mem_limit': '256m', 'num_scanner_threads': 4}
+    queries = [
+        "select count(*), sum(l_quantity), max(l_comment), min(l_shipdate) from {0}",
+        "select l_orderkey, l_linenumber, l_comment from {0} "
+        "where l_orderkey % 10007 = 3"]
+    for query in queries:
+      profile = self._check_same_results(query, "tpch_avro_snap.lineitem",
+          "tpch.lineitem", query_options)
+      assert self._get_counter_sum(profile, "NumAvroBlocksDecompressedAsync") > 0, query
+
+  @CustomClusterTestSuite.with_args("--codec_offload_threads=4")
+  def test_text_multi_stream_decompression(self, vector, unique_database):
+    """Scans gzip and bzip2 text files that consist of many concatenated members or
+    streams and checks that they are decompressed in parallel."""
+    NUM_ROWS = 200000
+    ROWS_PER_STREAM = 20000
+
+    def compress_gzip(data):
+      compressor = zlib.compressobj(6, zlib.DEFLATED, 16 + zlib.MAX_WBITS)
+      return compressor.compress(data) + compressor.flush()
+
+    for extension, compress in [('.gz', compress_gzip), ('.bz2', bz2.compress)]:
+      table_name = "multi_stream" + extension.replace('.', '_')
+      self.execute_query("create table {0}.{1} (id bigint, s string) row format "
+          "delimited fields terminated by ','".format(unique_database, table_name))
+      streams = []
+      for start in range(0, NUM_ROWS, ROWS_PER_STREAM):
+        rows = ["%d,%s\n" % (i, hashlib.md5(str(i)).hexdigest())
+            for i in range(start, start + ROWS_PER_STREAM)]
+        streams.append(compress("".join(rows)))
+      self.filesystem_client.create_file(
+          "test-warehouse/{0}.db/{1}/data{2}".format(unique_database, table_name,
+              extension), "".join(streams))
+      self.execute_query("refresh {0}.{1}".format(unique_database, table_name))
+      result = self.execute_query("select count(*), sum(id), count(distinct s), "
+          "max(s) from {0}.{1}".format(unique_database, table_name))
+      max_s = max(hashlib.md5(str(i)).hexdigest() for i in range(NUM_ROWS))
+      assert result.data == ["%d\t%d\t%d\t%s" % (NUM_ROWS,
+          NUM_ROWS * (NUM_ROWS - 1) / 2, NUM_ROWS, max_s)]
+      assert self._get_counter_sum(result.runtime_profile,
+          "NumTextPiecesDecompressedAsync") > 0
@@ -18,7 +18,10 @@
 import logging
 import os
 import pytest
+from datetime import datetime
 from kudu.schema import INT32
+from kudu.util import to_unixtime_micros
+from pytz import utc
 from time import sleep
 
 from tests.beeswax.impala_beeswax import ImpalaBeeswaxException
@@ -136,6 +139,99 @@ class TestKuduClientTimeout(CustomKuduTest):
     self.run_test_case('QueryTest/kudu-timeouts-impalad', vector)
 
 
+class TestKuduColumnarScan(CustomKuduTest):
+  """Runs the same Kudu scans with the columnar (--kudu_scan_columnar_layout=true) and
+  the row-wise layout and checks their results."""
+
+  def _check_same_results(self, query, table, ref_table, query_options):
+    """Runs 'query' against the Kudu table 'table' and 'ref_table' and checks that both
+    return the same rows."""
+    result = self.execute_query(query.format(table), query_options)
+    baseline = self.execute_query(query.format(ref_table), query_options)
+    assert sorted(result.data) == sorted(baseline.data), query
+
+  def _check_scans(self, kudu_client, unique_database):
+    ref_table = "%s.ref" % unique_database
+    table = "%s.scan" % unique_database
+    # Each column has its own pattern of NULLs. 'b' is NOT NULL in Kudu, so Kudu returns
+    # no non-null bitmap for it although its slot is nullable.
+    self.execute_query("""create table {0} stored as parquet as
+        select id, if(id % 7 = 0, null, concat(string_col, date_string_col)) s,
+          if(id % 5 = 0, null, cast(date_string_col as varchar(5))) vc,
+          if(id % 3 = 0, null, timestamp_col) ts, bigint_col b,
+          if(id % 11 = 0, null, double_col) d, if(id % 13 = 0, null, tinyint_col) t
+        from functional.alltypes""".format(ref_table))
+    self.execute_query("""create table {0} (id int primary key, s string,
+        vc varchar(5), ts timestamp, b bigint not null, d double, t tinyint)
+        partition by hash(id) partitions 3 stored as kudu""".format(table))
+    self.execute_query("insert into {0} select * from {1}".format(table, ref_table))
+
+    # The conjuncts with LIKE, OR and length() are not pushed down to Kudu. A small
+    # batch size makes the row batches end in the middle of the Kudu batches.
+    queries = [
+        "select * from {0}",
+        "select id, s, vc from {0} where s like '%1%' or d > 50",
+        "select count(*), count(s), count(vc), count(ts), sum(b), max(s), min(ts) "
+        "from {0} where t is null or length(s) > 12"]
+    for batch_size in [0, 7]:
+      query_options = {'kudu_read_mode': 'READ_AT_SNAPSHOT', 'batch_size': batch_size}
+      for query in queries:
+        self._check_same_results(query, table, ref_table, query_options)
+
+      # The rows returned with a LIMIT depend on the scan order. Check that they are
+      # rows that pass the conjuncts.
+      query = "select id, s, ts from {0} where id % 4 = 1 and length(vc) = 5"
+      result = self.execute_query(query.format(table) + " limit 23", query_options)
+      baseline = self.execute_query(query.format(ref_table), query_options)
+      assert len(result.data) == 23
+      assert set(result.data) <= set(baseline.data)
+
+    # VARCHAR values that are longer in bytes than the column allows and timestamps
+    # that are outside of Impala's range can only be written with the Kudu client.
+    special_table = "%s.special" % unique_database
+    self.execute_query("""create table {0} (id int primary key, vc varchar(3),
+        ts timestamp) partition by hash(id) partitions 3
+        stored as kudu""".format(special_table))
+    kudu_table = kudu_client.table(
+        KuduTestSuite.to_kudu_table_name(unique_database, "special"))
+    session = kudu_client.new_session()
+    session.apply(kudu_table.new_insert(
+        (0, u'\u00e4\u00f6\u00fc', datetime(1987, 5, 19, 0, 0, tzinfo=utc))))
+    session.apply(kudu_table.new_insert(
+        (1, u'abc', datetime(1300, 1, 1, 0, 0, tzinfo=utc))))
+    session.apply(kudu_table.new_insert((2, None, None)))
+    session.flush()
+    query_options = {'kudu_read_mode': 'READ_AT_SNAPSHOT', 'abort_on_error': 0,
+        'kudu_snapshot_read_timestamp_micros':
+            to_unixtime_micros(kudu_client.latest_observed_timestamp())}
+    # The three 2-byte characters are truncated to 3 bytes and the out of range
+    # timestamp is returned as NULL.
+    result = self.execute_query(
+        "select id, length(vc), ts from {0} order by id".format(special_table),
+        query_options)
+    assert result.data == ["0\t3\t1987-05-19 00:00:00", "1\t3\tNULL", "2\tNULL\tNULL"]
+    query_options['abort_on_error'] = 1
+    try:
+      self.execute_query("select * from {0}".format(special_table), query_options)
+      assert False, "Expected an out of range timestamp error"
+    except ImpalaBeeswaxException as e:
+      assert "contains an out of range timestamp" in str(e)
+
+  @pytest.mark.execute_serially
+  @SkipIfKudu.no_hybrid_clock
+  @SkipIfKudu.hms_integration_enabled
+  @CustomClusterTestSuite.with_args(impalad_args="--kudu_scan_columnar_layout=true")
+  def test_columnar_layout(self, kudu_client, unique_database):
+    self._check_scans(kudu_client, unique_database)
+
+  @pytest.mark.execute_serially
+  @SkipIfKudu.no_hybrid_clock
+  @SkipIfKudu.hms_integration_enabled
+  @CustomClusterTestSuite.with_args(impalad_args="--kudu_scan_columnar_layout=false")
+  def test_row_layout(self, kudu_client, unique_database):
+    self._check_scans(kudu_client, unique_database)
+
+
 class TestKuduHMSIntegration(CustomKuduTest):
   # TODO(IMPALA-8614): parameterize the common tests in query_test/test_kudu.py
   # to run with HMS integration enabled. Also avoid restarting Impala to reduce
@@ -0,0 +1,60 @@
+# Licensed to the Apache Software Foundation (ASF) under one
+# or more contributor license agreements.  See the NOTICE file
+# distributed with this work for additional information
+# regarding copyright ownership.  The ASF licenses this file
+# to you under the Apache License, Version 2.0 (the
+# "License"); you may not use this file except in compliance
+# with the License.  You may obtain a copy of the License at
+#
+#   http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing,
+# software distributed under the License is distributed on an
+# "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+# KIND, either express or implied.  See the License for the
+# specific language governing permissions and limitations
+# under the License.
+
+import re
+
+from tests.common.custom_cluster_test_suite import CustomClusterTestSuite
+
+
+class TestScannerThreadScaling(CustomClusterTestSuite):
+  """Tests for --scanner_thread_adaptive_scaling. The thresholds are set so that any
+  time spent waiting on the row batch queue triggers a scaling decision."""
+
+  @classmethod
+  def get_workload(cls):
+    return 'functional-query'
+
+  def _get_counter_sum(self, profile, counter_name):
+    return sum(int(value) for value in
+        re.findall(r'\b%s: [^\n]*\((\d+)\)' % counter_name, profile))
+
+  @CustomClusterTestSuite.with_args(
+      "--scanner_thread_adaptive_scaling=true "
+      "--scanner_thread_scaling_interval_ms=1 "
+      "--scanner_thread_scale_down_put_wait_ratio=0 "
+      "--scanner_thread_scale_up_get_wait_ratio=0 "
+      "--scanner_thread_scale_up_max_io_wait_ratio=1")
+  def test_scale_down_and_up(self, vector):
+    query_options = {'mt_dop': 0, 'num_nodes': 1, 'num_scanner_threads': 4,
+        'spool_query_results': False}
+    # The client fetches the rows much more slowly than the scanner threads produce
+    # them, so the scanner threads block on the full row batch queue and are scaled
+    # down.
+    result = self.execute_query("select o_orderkey from tpch.orders", query_options)
+    assert len(result.data) == 1500000
+    assert self._get_counter_sum(result.runtime_profile,
+        "NumScannerThreadScaleDowns") > 0
+
+    # An aggregation consumes the rows quickly. The scan starts with one scanner thread
+    # and the consumer waits for the first row batches, so threads are added.
+    result = self.execute_query(
+        "select count(*), sum(l_quantity) from tpch.lineitem", query_options)
+    baseline = self.execute_query(
+        "select count(*), sum(l_quantity) from tpch_parquet.lineitem")
+    assert result.data == baseline.data
+    assert self._get_counter_sum(result.runtime_profile,
+        "NumScannerThreadScaleUps") > 0
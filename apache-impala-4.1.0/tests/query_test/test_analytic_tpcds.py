@@ -17,6 +17,8 @@
 #
 # Targeted tests to validate analytic functions use TPCDS dataset.
 
+import re
+
 from tests.common.impala_test_suite import ImpalaTestSuite
 from tests.common.test_dimensions import create_parquet_dimension, ImpalaTestDimension
 
@@ -49,3 +51,30 @@ class TestAnalyticTpcds(ImpalaTestSuite):
     """Targeted tests for the partitioned top-n operator."""
     vector.get_value('exec_option')['batch_size'] = vector.get_value('batch_size')
     self.run_test_case('QueryTest/analytic-fns-tpcds-partitioned-topn', vector)
+
+  def test_parallel_partition_evaluation(self, vector):
+    """Analytic functions over entire partitions are evaluated on helper threads if
+    NUM_ANALYTIC_EVAL_THREADS is set. Checks that the results match the serial
+    evaluation, including string results, NULL partition keys and partitions that span
+    row batches."""
+    queries = [
+        """select ss_customer_sk, ss_item_sk,
+             sum(ss_net_paid) over (partition by ss_customer_sk),
+             count(*) over (partition by ss_customer_sk),
+             max(ss_sold_date_sk) over (partition by ss_customer_sk)
+           from tpcds_parquet.store_sales where ss_store_sk = 1""",
+        """select c_customer_sk,
+             min(c_last_name) over (partition by c_birth_country, c_birth_year),
+             max(c_first_name) over (partition by c_birth_country, c_birth_year),
+             avg(c_birth_day) over (partition by c_birth_country, c_birth_year)
+           from tpcds_parquet.customer"""]
+    for query in queries:
+      serial = self.execute_query(query, {'num_analytic_eval_threads': 0})
+      for batch_size in [0, 100]:
+        parallel = self.execute_query(query,
+            {'num_analytic_eval_threads': 4, 'batch_size': batch_size})
+        assert sorted(parallel.data) == sorted(serial.data)
+        # The counter is printed like "PartitionsEvaluatedInParallel: 1.23K (1234)".
+        num_parallel = re.findall(r'PartitionsEvaluatedInParallel: (\S+)',
+            parallel.runtime_profile)
+        assert any(n != '0' for n in num_parallel), parallel.runtime_profile
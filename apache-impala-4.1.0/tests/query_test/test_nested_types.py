@@ -18,6 +18,7 @@
 import os
 from copy import deepcopy
 import pytest
+import re
 from subprocess import check_call
 from pytest import skip
 
@@ -311,6 +312,55 @@ class TestNestedTypesNoMtDop(ImpalaTestSuite):
     self.client.execute("select s.UppercasenamE from %s" % table_name)
     self.client.execute("select s.* from %s" % table_name)
 
+  @SkipIfIsilon.hive
+  @SkipIfS3.hive
+  @SkipIfGCS.hive
+  @SkipIfCOS.hive
+  @SkipIfABFS.hive
+  @SkipIfADLS.hive
+  @SkipIfLocal.hive
+  def test_count_items_from_cheapest_column(self, vector, unique_database):
+    """Tests that the items of a collection whose item slots are not materialized are
+    counted from its cheapest scalar descendant, which here is neither the first leaf
+    nor in the first child of the items."""
+    if vector.get_value('table_format').file_format != 'parquet':
+      pytest.skip('This test is specific to Parquet')
+    table_name = "%s.cheapest_leaf" % unique_database
+    self.run_stmt_in_hive("""create table %s (id int,
+        arr array<struct<nested: array<string>, big: string, small: int>>)
+        stored as parquet tblproperties('parquet.compression'='UNCOMPRESSED')"""
+        % table_name)
+    # Even rows have three items and odd rows have one.
+    self.run_stmt_in_hive("""insert into %s
+        select id, if(id %% 2 = 0, array(s, s, s), array(s)) from (
+          select id, named_struct(
+              'nested', array(concat(repeat('y', 1000), cast(id as string))),
+              'big', concat(repeat('x', 1000), cast(id as string)),
+              'small', id) s
+          from functional.alltypes where id < 100) v""" % table_name)
+    self.client.execute("invalidate metadata %s" % table_name)
+
+    def bytes_read(query, expected):
+      result = self.execute_query(query)
+      assert result.data == [expected], query
+      return sum(int(n) for n in
+          re.findall(r'\bBytesRead: [^\n]*\((\d+)\)', result.runtime_profile))
+
+    big_bytes = bytes_read(
+        "select count(a.big) from %s t, t.arr a" % table_name, "200")
+    nested_bytes = bytes_read(
+        "select count(n.item) from %s t, t.arr a, a.nested n" % table_name, "200")
+    for query, expected in [
+        ("select count(*) from %s.arr" % table_name, "200"),
+        ("select count(*) from %s t, t.arr" % table_name, "200"),
+        ("select count(*), sum(a.pos) from %s t, t.arr a" % table_name, "200\t150"),
+        ("select count(a.pos) from %s t, t.arr a where t.id < 10" % table_name,
+         "20")]:
+      # Only the 'small' column is read to count the items.
+      count_bytes = bytes_read(query, expected)
+      assert count_bytes * 10 < big_bytes, query
+      assert count_bytes * 10 < nested_bytes, query
+
   def test_partitioned_table(self, vector, unique_database):
     """IMPALA-6370: Test that a partitioned table with nested types can be scanned."""
     table = "complextypes_partitioned"
@@ -0,0 +1,103 @@
+# Licensed to the Apache Software Foundation (ASF) under one
+# or more contributor license agreements.  See the NOTICE file
+# distributed with this work for additional information
+# regarding copyright ownership.  The ASF licenses this file
+# to you under the Apache License, Version 2.0 (the
+# "License"); you may not use this file except in compliance
+# with the License.  You may obtain a copy of the License at
+#
+#   http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing,
+# software distributed under the License is distributed on an
+# "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+# KIND, either express or implied.  See the License for the
+# specific language governing permissions and limitations
+# under the License.
+
+import re
+
+from tests.common.impala_test_suite import ImpalaTestSuite
+
+
+class TestOrcLateMaterialization(ImpalaTestSuite):
+  """
+  This suite tests late materialization optimization for orc. Every query is run with
+  late materialization disabled (ORC_LATE_MATERIALIZATION_THRESHOLD=-1) and with a few
+  thresholds, and must return the same rows.
+  """
+
+  THRESHOLDS = [0, 1, 20]
+
+  @classmethod
+  def get_workload(cls):
+    return 'functional-query'
+
+  @classmethod
+  def add_test_dimensions(cls):
+    super(TestOrcLateMaterialization, cls).add_test_dimensions()
+    cls.ImpalaTestMatrix.add_constraint(
+      lambda v: v.get_value('table_format').file_format == 'orc')
+
+  def _get_rows_skipped(self, profile):
+    return sum(int(value) for value in re.findall(
+        r'\bNumOrcRowsSkippedByLateMaterialization: [^\n]*\((\d+)\)', profile))
+
+  def _check_same_results(self, query):
+    """Runs 'query' with and without late materialization and checks that the results
+    match. Returns the number of rows skipped by late materialization for each
+    threshold."""
+    baseline = self.execute_query(query,
+        {'orc_late_materialization_threshold': -1})
+    assert self._get_rows_skipped(baseline.runtime_profile) == 0, query
+    rows_skipped = []
+    for threshold in self.THRESHOLDS:
+      result = self.execute_query(query,
+          {'orc_late_materialization_threshold': threshold})
+      assert sorted(result.data) == sorted(baseline.data), query
+      rows_skipped.append(self._get_rows_skipped(result.runtime_profile))
+    return rows_skipped
+
+  def test_orc_late_materialization(self, vector):
+    # Selective predicates on a single column.
+    for query in [
+        "select * from tpch_orc_def.lineitem where l_orderkey = 3209632",
+        "select * from tpch_orc_def.lineitem "
+        "where l_comment like '%unusual courts. blithely final theodolit%'",
+        "select l_orderkey, l_comment, l_shipinstruct from tpch_orc_def.lineitem "
+        "where l_quantity = 1 and l_discount = 0.1"]:
+      assert all(skipped > 0 for skipped in self._check_same_results(query)), query
+
+    # All rows pass the predicate.
+    for skipped in self._check_same_results(
+        "select count(*), max(l_comment) from tpch_orc_def.lineitem "
+        "where l_orderkey > 0"):
+      assert skipped == 0
+
+  def test_orc_late_materialization_wide_table(self, vector):
+    # Predicates on columns at the start, middle and end of wide tables, so that the
+    # filter columns are not always the first children of the top level reader.
+    for table in ["widetable_250_cols", "widetable_1000_cols"]:
+      for predicate in ["int_col1 % 3 = 0", "string_col20 like '%1'",
+          "bool_col1 and bigint_col31 > 5"]:
+        self._check_same_results("select * from functional_orc_def.{0} where {1}"
+            .format(table, predicate))
+
+  def test_orc_late_materialization_nested(self, vector):
+    # Complex columns are always read together with the filter columns, only the
+    # primitive top level columns are materialized late.
+    rows_skipped = self._check_same_results(
+        "select * from tpch_nested_orc_def.customer where c_custkey = 12345")
+    assert all(skipped > 0 for skipped in rows_skipped)
+    for query in [
+        "select c_custkey, c_name, c_address, o.o_orderkey, o.o_totalprice "
+        "from tpch_nested_orc_def.customer c, c.c_orders o "
+        "where c_nationkey = 3 and c_acctbal > 9000",
+        "select c_custkey, c_comment, count(l.l_linenumber) "
+        "from tpch_nested_orc_def.customer c, c.c_orders o, o.o_lineitems l "
+        "where c_mktsegment = 'COMEDY' and c_custkey % 100 = 7 "
+        "group by c_custkey, c_comment",
+        "select c_custkey, c_phone from tpch_nested_orc_def.customer c "
+        "where c_acctbal < 0 and exists (select 1 from c.c_orders o "
+        "where o.o_orderpriority = '1-URGENT')"]:
+      self._check_same_results(query)
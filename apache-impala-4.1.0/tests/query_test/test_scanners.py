@@ -893,6 +893,48 @@ class TestParquet(ImpalaTestSuite):
     create_table_from_parquet(self.client, unique_database, TABLE_NAME)
     self.run_test_case("QueryTest/parquet-rle-dictionary", vector, unique_database)
 
+  def test_dictionary_code_filtering(self, vector, unique_database):
+    """Test that rejecting rows by dictionary code returns the same rows as evaluating
+       the conjuncts on every row. Covers predicates on dictionary encoded columns,
+       NULLs and a column chunk whose dictionary overflows, so that it contains both
+       dictionary encoded and plain encoded pages."""
+    TABLE_NAME = "{0}.dict_code_filtering".format(unique_database)
+    self.execute_query(
+        "create table {0} (id bigint, s string, i int) sort by (id) "
+        "stored as parquet".format(TABLE_NAME))
+    # The first ~250K rows of 's' only take 10 distinct values. After them every value
+    # is distinct, so the writer falls back to plain encoding once the dictionary is
+    # full. A single writer keeps all rows in one file and row group.
+    self.execute_query(
+        "insert into {0} select o_orderkey, "
+        "if(o_orderkey < 1000000, concat('v', cast(o_orderkey % 10 as string)), "
+        "cast(o_orderkey as string)), "
+        "if(o_orderkey % 7 = 0, NULL, cast(o_orderkey % 13 as int)) "
+        "from tpch_parquet.orders".format(TABLE_NAME), {'num_nodes': 1})
+    queries = [
+        "select count(*), min(id), max(id) from {0} where s = 'v3'",
+        "select count(*), min(id), max(id) from {0} where s in ('v1', 'v7', '4000003')",
+        "select count(*), min(id), max(id) from {0} where s = '4000003'",
+        "select count(*), min(id), max(id) from {0} where s != 'v1'",
+        "select count(*), min(id), max(id) from {0} where s like 'v%' and i = 5",
+        "select count(*), min(id), max(id) from {0} where i < 3",
+        "select count(*), min(id), max(id) from {0} where i is null",
+        "select count(*), min(id), max(id) from {0} where nvl(i, 100) > 11",
+        "select id, s, i from {0} where s = 'v9' and i = 4 order by id limit 20",
+        "select count(*) from functional_parquet.alltypes where string_col = '3'",
+        "select count(*), sum(id) from functional_parquet.alltypesagg "
+        "where int_col < 50 and tinyint_col = 3",
+        "select count(*), sum(id) from functional_parquet.alltypesagg "
+        "where smallint_col is null or smallint_col > 90"]
+    for query in queries:
+      query = query.format(TABLE_NAME)
+      filtered = self.execute_query(query, {'parquet_dictionary_code_filtering': True})
+      unfiltered = self.execute_query(query, {'parquet_dictionary_code_filtering': False})
+      assert filtered.data == unfiltered.data, query
+    result = self.execute_query("select count(*) from functional_parquet.alltypes "
+        "where string_col = '3'", {'parquet_dictionary_code_filtering': True})
+    assert result.data == ['730']
+
   def test_type_widening(self, vector, unique_database):
     """IMPALA-6373: Test that Impala can read parquet file with column types smaller than
        the schema with larger types"""
@@ -1723,6 +1765,52 @@ class TestOrc(ImpalaTestSuite):
 
     self.run_test_case('QueryTest/hive2-pre-gregorian-date-orc', vector, unique_database)
 
+  @SkipIfABFS.hive
+  @SkipIfADLS.hive
+  @SkipIfIsilon.hive
+  @SkipIfLocal.hive
+  @SkipIfS3.hive
+  @SkipIfGCS.hive
+  @SkipIfCOS.hive
+  def test_fixed_width_and_char_columns(self, vector, unique_database):
+    """Tests reading fixed-width and CHAR columns, whose values are written straight into
+    the scratch batch, from ORC batches with and without NULLs and with plain and
+    dictionary encoded CHAR values. Late materialization reads the columns that are not
+    filtered into the scratch batch starting at non-zero indexes."""
+    columns = ["bool_col", "tinyint_col", "smallint_col", "int_col", "bigint_col",
+        "float_col", "double_col", "cast(date_string_col as char(5))"]
+    for encoding, threshold in [("plain", "0"), ("dict", "1")]:
+      for with_nulls in [False, True]:
+        if with_nulls:
+          exprs = ["if(id % 7 = 0, NULL, {0})".format(col) for col in columns]
+        else:
+          exprs = columns
+        select_list = "id, " + ", ".join(exprs)
+        tbl = "{0}.fixed_width_{1}{2}".format(
+            unique_database, encoding, "_nulls" if with_nulls else "")
+        self.run_stmt_in_hive("""create table {0} (id int, bool_col boolean,
+            tinyint_col tinyint, smallint_col smallint, int_col int, bigint_col bigint,
+            float_col float, double_col double, char_col char(5)) stored as orc
+            tblproperties('orc.dictionary.key.threshold'='{1}')""".format(
+            tbl, threshold))
+        self.run_stmt_in_hive("insert into {0} select {1} from functional.alltypes"
+            .format(tbl, select_list))
+        self.client.execute("invalidate metadata {0}".format(tbl))
+
+        for where in ["", "where id % 10 = 3"]:
+          expected = self.execute_query(
+              "select {0} from functional.alltypes {1}".format(select_list, where))
+          actual_query = "select * from {0} {1}".format(tbl, where)
+          for late_materialization_threshold in [-1, 1]:
+            result = self.execute_query(actual_query,
+                {'orc_late_materialization_threshold': late_materialization_threshold})
+            assert sorted(result.data) == sorted(expected.data), actual_query
+            if where and late_materialization_threshold > 0:
+              rows_skipped = re.findall(
+                  r'NumOrcRowsSkippedByLateMaterialization: [^\n]*\((\d+)\)',
+                  result.runtime_profile)
+              assert sum(int(n) for n in rows_skipped) > 0, actual_query
+
 
 class TestScannerReservation(ImpalaTestSuite):
   @classmethod